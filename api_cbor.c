@@ -0,0 +1,152 @@
+#include "api_cbor.h"
+#include "api_json.h"
+#include "history_query.h"
+
+void api_cbor_status(cbor_writer_t *w, const ipc_snapshot_t *snap) {
+    cbor_map(w, (uint32_t)api_status_field_count);
+    cbor_write_fields(w, api_status_fields, api_status_field_count, snap);
+}
+
+void api_cbor_log_begin(api_cbor_log_ctx_t *ctx) {
+    ctx->count = 0;
+}
+
+void api_cbor_log_event(cbor_writer_t *w, api_cbor_log_ctx_t *ctx, const log_record_t *rec) {
+    log_arg_t args[LOG_MAX_ARGS];
+    size_t nargs = log_record_args(rec, args);
+    const log_site_t *site = rec->site;
+
+    cbor_array(w, 6 + (uint32_t)nargs);
+    cbor_uint(w, rec->seq);
+    cbor_uint(w, rec->t_us);
+    cbor_uint(w, site->level);
+    cbor_uint(w, site->module);
+    cbor_uint(w, rec->core);
+
+    // Formato já enviado nesta resposta: só o índice
+    int index = -1;
+    bool added = false;
+    for (int i = 0; i < ctx->count; i++) {
+        if (ctx->sites[i] == site) {
+            index = i;
+            break;
+        }
+    }
+    if (index >= 0) {
+        cbor_uint(w, (uint32_t)index);
+    } else {
+        // Tabela cheia: o formato vai como texto sempre, sem entrar nela
+        if (ctx->count < API_CBOR_LOG_FORMATS) {
+            ctx->sites[ctx->count++] = site;
+            added = true;
+        }
+        cbor_text(w, site->fmt);
+    }
+
+    for (size_t i = 0; i < nargs; i++) {
+        switch (args[i].type) {
+            case LOG_ARG_INT:   cbor_int(w, (int32_t)args[i].u); break;
+            case LOG_ARG_UINT:  cbor_uint(w, args[i].u); break;
+            case LOG_ARG_FLOAT: cbor_float(w, args[i].f); break;
+            default:            cbor_text(w, args[i].s); break;
+        }
+    }
+    // Evento descartado pelo chamador: o formato não chegou ao cliente
+    if (added && !cbor_writer_ok(w)) {
+        ctx->count--;
+    }
+}
+
+// --- Esquema (JSON) ---
+
+static const char *const field_types[] = { "uint", "int", "fixed", "bool", "text" };
+static const uint32_t scales[] = { 1, 10, 100, 1000, 10000, 100000, 1000000 };
+
+static void schema_field(json_writer_t *w, uint32_t key, const char *name, const char *type, uint8_t decimals) {
+    json_obj_begin(w);
+    json_key(w, "key");
+    json_uint(w, key);
+    json_key(w, "name");
+    json_str(w, name);
+    json_key(w, "type");
+    json_str(w, type);
+    if (decimals > 0) {
+        json_key(w, "scale");
+        json_uint(w, scales[decimals < 6 ? decimals : 6]);
+    }
+    json_obj_end(w);
+}
+
+static void schema_fields(json_writer_t *w, const json_field_t *fields, size_t count) {
+    json_arr_begin(w);
+    for (size_t i = 0; i < count; i++) {
+        const json_field_t *f = &fields[i];
+        schema_field(w, (uint32_t)i, f->key, f->type < 5 ? field_types[f->type] : "null",
+                     f->type == JSON_FIELD_FLOAT ? f->decimals : 0);
+    }
+    json_arr_end(w);
+}
+
+static void schema_names(json_writer_t *w, const char *const *names, size_t count) {
+    json_arr_begin(w);
+    for (size_t i = 0; i < count; i++) {
+        json_str(w, names[i]);
+    }
+    json_arr_end(w);
+}
+
+void api_cbor_schema(json_writer_t *w) {
+    static const char *const history_header[] = { "v", "tier", "step", "from", "to" };
+    static const char *const history_end[] = { "cursor", "points" };
+    static const char *const log_event[] = { "seq", "t_us", "level", "module", "core", "fmt" };
+    static const char *const log_levels[] = { "none", "error", "warn", "info", "debug" };
+
+    json_obj_begin(w);
+    json_key(w, "version");
+    json_uint(w, CBOR_SCHEMA_VERSION);
+
+    // "fixed": inteiro / scale; NaN vira null e valores fora de 32 bits, float32
+    json_key(w, "status");
+    json_obj_begin(w);
+    json_key(w, "media");
+    json_str(w, "application/cbor");
+    json_key(w, "map");
+    schema_fields(w, api_status_fields, api_status_field_count);
+    json_obj_end(w);
+
+    json_key(w, "history");
+    json_obj_begin(w);
+    json_key(w, "media");
+    json_str(w, history_format_mime(HISTORY_FMT_CBOR));
+    json_key(w, "header");
+    schema_names(w, history_header, 5);
+    json_key(w, "row");
+    json_arr_begin(w);
+    for (int i = 0; i < HISTORY_COLUMNS; i++) {
+        // Coluna 0 é o índice da janela: tempo = from + window * step
+        schema_field(w, (uint32_t)i, i == 0 ? "window" : history_columns[i].name,
+                     history_columns[i].decimals ? "fixed" : "int", history_columns[i].decimals);
+    }
+    json_arr_end(w);
+    json_key(w, "end");
+    schema_names(w, history_end, 2);
+    json_obj_end(w);
+
+    json_key(w, "logs");
+    json_obj_begin(w);
+    json_key(w, "media");
+    json_str(w, "application/cbor");
+    json_key(w, "event");
+    schema_names(w, log_event, 6);
+    json_key(w, "levels");
+    schema_names(w, log_levels, 5);
+    json_key(w, "modules");
+    json_arr_begin(w);
+    for (uint8_t m = 0; m < LOG_MOD_COUNT; m++) {
+        json_str(w, log_module_name(m));
+    }
+    json_arr_end(w);
+    json_obj_end(w);
+
+    json_obj_end(w);
+}
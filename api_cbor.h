@@ -0,0 +1,35 @@
+#ifndef API_CBOR_H
+#define API_CBOR_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "cbor_writer.h"
+#include "json_writer.h"
+#include "logger.h"
+#include "ipc.h"
+
+// Variantes CBOR da API (Accept: application/cbor ou ?format=cbor)
+// Montadas direto das mesmas structs e tabelas do JSON (api_json.h), com o
+// índice do campo como chave e floats em inteiros escalados. O histórico tem
+// o próprio formato (history_query.h). GET /api/schema descreve tudo em JSON,
+// gerado das tabelas - não há como o esquema publicado divergir do enviado.
+//
+// /api/logs: array de eventos [seq, t_us, nível, módulo, core, formato,
+// args...], com os argumentos do registro em tipos nativos (sem formatar).
+// O formato vai como texto na primeira vez que aparece na resposta; depois,
+// como o índice (uint) dessa primeira aparição.
+
+#define API_CBOR_LOG_FORMATS 24   // Formatos distintos lembrados por resposta
+
+typedef struct {
+    const log_site_t *sites[API_CBOR_LOG_FORMATS];
+    uint8_t count;
+} api_cbor_log_ctx_t;
+
+// Funções públicas
+void api_cbor_status(cbor_writer_t *w, const ipc_snapshot_t *snap);   // GET /api/status
+void api_cbor_log_begin(api_cbor_log_ctx_t *ctx);
+void api_cbor_log_event(cbor_writer_t *w, api_cbor_log_ctx_t *ctx, const log_record_t *rec);
+void api_cbor_schema(json_writer_t *w);                               // GET /api/schema
+
+#endif // API_CBOR_H
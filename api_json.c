@@ -0,0 +1,84 @@
+#include "api_json.h"
+#include "control.h"
+#include "autotune.h"
+
+const json_field_t api_status_fields[] = {
+    JSON_FIELD(ipc_snapshot_t, zones[CONTROL_ZONE_HEATER].filtered, "heater", JSON_FIELD_FLOAT, 1),
+    JSON_FIELD(ipc_snapshot_t, zones[CONTROL_ZONE_CONSERVATIVE].filtered, "freezer", JSON_FIELD_FLOAT, 1),
+    JSON_FIELD(ipc_snapshot_t, shaken, "shaken", JSON_FIELD_BOOL, 0),
+    JSON_FIELD(ipc_snapshot_t, config_version, "config_version", JSON_FIELD_UINT, 0),
+};
+
+const size_t api_status_field_count = sizeof(api_status_fields) / sizeof(api_status_fields[0]);
+
+// "name" e "state" saem antes da tabela (o estado vira texto)
+const json_field_t api_zone_fields[] = {
+    JSON_FIELD(control_zone_t, target, "target", JSON_FIELD_FLOAT, 1),
+    JSON_FIELD(control_zone_t, filtered, "temp", JSON_FIELD_FLOAT, 2),
+    JSON_FIELD(control_zone_t, raw, "raw", JSON_FIELD_FLOAT, 2),
+    JSON_FIELD(control_zone_t, relay_on, "relay", JSON_FIELD_BOOL, 0),
+    JSON_FIELD(control_zone_t, stats.actuations, "actuations", JSON_FIELD_UINT, 0),
+    JSON_FIELD(control_zone_t, stats.on_time_ms, "on_time", JSON_FIELD_UINT, 0),
+    JSON_FIELD(control_zone_t, stats.wait_time_ms, "wait_time", JSON_FIELD_UINT, 0),
+    JSON_FIELD(control_zone_t, stats.on_target_ms, "on_target", JSON_FIELD_UINT, 0),
+    JSON_FIELD(control_zone_t, stats.preemptions, "preemptions", JSON_FIELD_UINT, 0),
+    JSON_FIELD(control_zone_t, stats.min_temp, "min", JSON_FIELD_FLOAT, 1),
+    JSON_FIELD(control_zone_t, stats.max_temp, "max", JSON_FIELD_FLOAT, 1),
+};
+
+const size_t api_zone_field_count = sizeof(api_zone_fields) / sizeof(api_zone_fields[0]);
+
+static const json_field_t autotune_fields[] = {
+    JSON_FIELD(autotune_status_t, setpoint, "setpoint", JSON_FIELD_FLOAT, 1),
+    JSON_FIELD(autotune_status_t, cycles, "cycles", JSON_FIELD_UINT, 0),
+    JSON_FIELD(autotune_status_t, cycles_target, "cycles_target", JSON_FIELD_UINT, 0),
+    JSON_FIELD(autotune_status_t, last_amplitude, "amplitude", JSON_FIELD_FLOAT, 2),
+    JSON_FIELD(autotune_status_t, last_period_s, "period", JSON_FIELD_FLOAT, 1),
+    JSON_FIELD(autotune_status_t, elapsed_ms, "elapsed", JSON_FIELD_UINT, 0),
+    JSON_FIELD(autotune_status_t, relay_on, "relay", JSON_FIELD_BOOL, 0),
+    JSON_FIELD(autotune_status_t, message, "message", JSON_FIELD_STR, 0),
+};
+
+static const json_field_t params_fields[] = {
+    JSON_FIELD(controller_params_t, tuned, "tuned", JSON_FIELD_BOOL, 0),
+    JSON_FIELD(controller_params_t, hysteresis_c, "hysteresis", JSON_FIELD_FLOAT, 2),
+    JSON_FIELD(controller_params_t, min_off_ms, "min_off", JSON_FIELD_UINT, 0),
+    JSON_FIELD(controller_params_t, kp, "kp", JSON_FIELD_FLOAT, 3),
+    JSON_FIELD(controller_params_t, ki, "ki", JSON_FIELD_FLOAT, 5),
+    JSON_FIELD(controller_params_t, kd, "kd", JSON_FIELD_FLOAT, 2),
+};
+
+#define COUNT(a) (sizeof(a) / sizeof((a)[0]))
+
+void api_json_status(json_writer_t *w, const ipc_snapshot_t *snap) {
+    json_obj_begin(w);
+    json_write_fields(w, api_status_fields, api_status_field_count, snap);
+    json_obj_end(w);
+}
+
+void api_json_zones(json_writer_t *w, const ipc_snapshot_t *snap) {
+    json_arr_begin(w);
+    for (int z = 0; z < CONTROL_ZONE_COUNT; z++) {
+        const control_zone_t *zone = &snap->zones[z];
+        json_obj_begin(w);
+        json_key(w, "name");
+        json_str(w, zone->name);
+        json_key(w, "state");
+        json_str(w, control_zone_state_name(zone->state));
+        json_write_fields(w, api_zone_fields, api_zone_field_count, zone);
+        json_obj_end(w);
+    }
+    json_arr_end(w);
+}
+
+void api_json_autotune(json_writer_t *w, const ipc_snapshot_t *snap) {
+    const autotune_status_t *at = &snap->autotune;
+    json_obj_begin(w);
+    json_key(w, "state");
+    json_str(w, autotune_state_name(at->state));
+    json_key(w, "zone");
+    json_str(w, autotune_zone_name(at->zone));
+    json_write_fields(w, autotune_fields, COUNT(autotune_fields), at);
+    json_write_fields(w, params_fields, COUNT(params_fields), &snap->params[at->zone]);
+    json_obj_end(w);
+}
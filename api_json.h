@@ -0,0 +1,22 @@
+#ifndef API_JSON_H
+#define API_JSON_H
+
+#include <stddef.h>
+#include "json_writer.h"
+#include "ipc.h"
+
+// Corpos JSON da API montados direto do snapshot do core 1 (json_writer.h)
+// Cada endpoint tem a tabela de campos da struct de origem; as chaves são as
+// mesmas de antes, e os números saem com as mesmas casas decimais.
+
+extern const json_field_t api_status_fields[];
+extern const size_t api_status_field_count;
+extern const json_field_t api_zone_fields[];
+extern const size_t api_zone_field_count;
+
+// Funções públicas
+void api_json_status(json_writer_t *w, const ipc_snapshot_t *snap);     // GET /api/status
+void api_json_zones(json_writer_t *w, const ipc_snapshot_t *snap);      // GET /api/zones
+void api_json_autotune(json_writer_t *w, const ipc_snapshot_t *snap);   // GET /api/autotune
+
+#endif // API_JSON_H
@@ -0,0 +1,334 @@
+#include "autotune.h"
+#include <stddef.h>
+#include <string.h>
+#include <math.h>
+#include "pico/stdlib.h"
+#include "hardware/flash.h"
+#include "kv_store.h"
+#include "hal.h"
+#include "logger.h"
+
+// Configuração do ensaio de relé
+#define AUTOTUNE_HYSTERESIS_C 0.3f         // Banda de ruído do LM35 (°C)
+#define AUTOTUNE_RELAY_AMPLITUDE 50.0f     // d: saída oscila 0-100% (meia amplitude = 50%)
+#define AUTOTUNE_SKIP_CYCLES 1             // Ciclos iniciais descartados (transitório)
+#define AUTOTUNE_CYCLES 4                  // Ciclos usados na média
+#define AUTOTUNE_MIN_SWITCH_MS 5000        // Proteção do Peltier entre comutações
+#define AUTOTUNE_TIMEOUT_MS (3u * 3600u * 1000u)      // 3 horas no total
+#define AUTOTUNE_HALF_CYCLE_TIMEOUT_MS (45u * 60u * 1000u)  // 45 min sem comutar
+#define AUTOTUNE_TEMP_MIN -10.0f           // Limites de segurança (°C)
+#define AUTOTUNE_TEMP_MAX 75.0f
+
+// Parâmetros padrão (comportamento original: banda de 0.5°C e espera de 20s)
+#define DEFAULT_HYSTERESIS_C 0.5f
+#define DEFAULT_MIN_OFF_MS 20000
+
+// Limites dos parâmetros derivados
+#define TUNED_HYSTERESIS_MIN_C 0.2f
+#define TUNED_HYSTERESIS_MAX_C 2.0f
+#define TUNED_MIN_OFF_MIN_MS 5000
+#define TUNED_MIN_OFF_MAX_MS 120000
+
+// Registro antigo no último setor da flash (antes do kv_store); lido uma
+// vez para migrar os parâmetros já sintonizados
+#define AUTOTUNE_LEGACY_OFFSET (PICO_FLASH_SIZE_BYTES - FLASH_SECTOR_SIZE)
+#define AUTOTUNE_LEGACY_MAGIC 0x4E555441  // "ATUN"
+#define AUTOTUNE_LEGACY_VERSION 1
+
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    controller_params_t params[AUTOTUNE_ZONE_COUNT];
+    uint32_t crc;
+} autotune_legacy_record_t;
+
+// Parâmetros ativos de cada zona
+static controller_params_t zone_params[AUTOTUNE_ZONE_COUNT];
+
+// Estado do ensaio
+static autotune_state_t state = AUTOTUNE_IDLE;
+static autotune_zone_t tune_zone = AUTOTUNE_ZONE_HEATER;
+static float tune_setpoint = 0.0f;
+static uint32_t start_time = 0;
+static uint32_t end_time = 0;
+static uint32_t last_switch_time = 0;
+static uint32_t cycle_start_time = 0;
+static bool relay_state = false;
+static bool has_cycle_start = false;
+static float cycle_max = 0.0f;
+static float cycle_min = 0.0f;
+static uint8_t cycles_seen = 0;       // Inclui os descartados
+static uint8_t cycles_measured = 0;   // Apenas os usados na média
+static float sum_amplitude = 0.0f;
+static float sum_period_s = 0.0f;
+static float last_amplitude = 0.0f;
+static float last_period_s = 0.0f;
+static const char *status_message = "ok";
+
+static void set_default_params(controller_params_t *p) {
+    memset(p, 0, sizeof(*p));
+    p->hysteresis_c = DEFAULT_HYSTERESIS_C;
+    p->min_off_ms = DEFAULT_MIN_OFF_MS;
+}
+
+// Gravação adiada: o kv_store grava na flash a partir do core 0
+static void autotune_save(void) {
+    kv_set(KV_KEY_CONTROLLER, zone_params, sizeof(zone_params));
+    LOG_I(LOG_MOD_CTRL, "[AUTOTUNE] Parâmetros enviados para a flash");
+}
+
+static bool autotune_load_legacy(void) {
+    const autotune_legacy_record_t *record =
+        (const autotune_legacy_record_t *)(XIP_BASE + AUTOTUNE_LEGACY_OFFSET);
+
+    if (record->magic != AUTOTUNE_LEGACY_MAGIC || record->version != AUTOTUNE_LEGACY_VERSION ||
+        record->crc != kv_crc32(record, offsetof(autotune_legacy_record_t, crc))) {
+        return false;
+    }
+    memcpy(zone_params, record->params, sizeof(zone_params));
+    LOG_I(LOG_MOD_CTRL, "[AUTOTUNE] Parâmetros migrados do registro antigo");
+    autotune_save();
+    return true;
+}
+
+static void autotune_load(void) {
+    if (!kv_get(KV_KEY_CONTROLLER, zone_params, sizeof(zone_params)) && !autotune_load_legacy()) {
+        LOG_I(LOG_MOD_CTRL, "[AUTOTUNE] Nenhum parâmetro salvo - usando padrão (%.1f°C / %d ms)",
+              DEFAULT_HYSTERESIS_C, DEFAULT_MIN_OFF_MS);
+        return;
+    }
+
+    for (int z = 0; z < AUTOTUNE_ZONE_COUNT; z++) {
+        // Registro do log tem LOG_ARG_WORDS palavras: uma linha por metade
+        LOG_I(LOG_MOD_CTRL, "[AUTOTUNE] %s: banda=±%.2f°C espera=%lu ms sintonizado=%d",
+              autotune_zone_name((autotune_zone_t)z), zone_params[z].hysteresis_c,
+              (unsigned long)zone_params[z].min_off_ms, zone_params[z].tuned ? 1 : 0);
+        LOG_I(LOG_MOD_CTRL, "[AUTOTUNE] %s: Kp=%.2f Ki=%.4f Kd=%.1f", autotune_zone_name((autotune_zone_t)z),
+              zone_params[z].kp, zone_params[z].ki, zone_params[z].kd);
+    }
+}
+
+void autotune_init(void) {
+    for (int z = 0; z < AUTOTUNE_ZONE_COUNT; z++) {
+        set_default_params(&zone_params[z]);
+    }
+    autotune_load();
+}
+
+static void autotune_fail(const char *reason) {
+    state = AUTOTUNE_FAILED;
+    end_time = hal_time_ms();
+    relay_state = false;
+    status_message = reason;
+    LOG_W(LOG_MOD_CTRL, "❌ [AUTOTUNE] Abortado: %s", reason);
+}
+
+bool autotune_setpoint_valid(float setpoint) {
+    return setpoint > AUTOTUNE_TEMP_MIN && setpoint < AUTOTUNE_TEMP_MAX;
+}
+
+bool autotune_start(autotune_zone_t zone, float setpoint, uint32_t now_ms) {
+    if (autotune_is_running() || zone >= AUTOTUNE_ZONE_COUNT) {
+        return false;
+    }
+    if (!autotune_setpoint_valid(setpoint)) {
+        return false;
+    }
+
+    state = AUTOTUNE_APPROACH;
+    tune_zone = zone;
+    tune_setpoint = setpoint;
+    start_time = now_ms;
+    last_switch_time = now_ms - AUTOTUNE_MIN_SWITCH_MS;  // Permite comutar de imediato
+    relay_state = false;
+    has_cycle_start = false;
+    cycles_seen = 0;
+    cycles_measured = 0;
+    sum_amplitude = 0.0f;
+    sum_period_s = 0.0f;
+    last_amplitude = 0.0f;
+    last_period_s = 0.0f;
+    status_message = "ok";
+
+    LOG_I(LOG_MOD_CTRL, "🎛️  [AUTOTUNE] Iniciando ensaio de relé: zona %s, setpoint %.1f°C",
+          autotune_zone_name(zone), setpoint);
+    LOG_I(LOG_MOD_CTRL, "    Ciclos: %d descartados + %d medidos, histerese ±%.2f°C",
+          AUTOTUNE_SKIP_CYCLES, AUTOTUNE_CYCLES, AUTOTUNE_HYSTERESIS_C);
+    return true;
+}
+
+void autotune_cancel(void) {
+    if (autotune_is_running()) {
+        autotune_fail("cancelado");
+    }
+}
+
+bool autotune_is_running(void) {
+    return state == AUTOTUNE_APPROACH || state == AUTOTUNE_RELAY;
+}
+
+autotune_zone_t autotune_get_zone(void) {
+    return tune_zone;
+}
+
+static float clampf(float v, float lo, float hi) {
+    return v < lo ? lo : (v > hi ? hi : v);
+}
+
+// Calcular ganhos a partir dos ciclos medidos
+static void autotune_finish(void) {
+    float a = sum_amplitude / cycles_measured;
+    float tu = sum_period_s / cycles_measured;
+    float h = AUTOTUNE_HYSTERESIS_C;
+
+    if (a <= h) {
+        autotune_fail("amplitude menor que a histerese");
+        return;
+    }
+
+    controller_params_t *p = &zone_params[tune_zone];
+    p->ku = (4.0f * AUTOTUNE_RELAY_AMPLITUDE) / (3.14159265f * sqrtf(a * a - h * h));
+    p->tu_s = tu;
+
+    // Ziegler-Nichols clássico para PID
+    p->kp = 0.6f * p->ku;
+    p->ki = p->kp / (0.5f * tu);
+    p->kd = p->kp * (0.125f * tu);
+
+    // Controle liga/desliga: banda de metade da amplitude medida e espera de
+    // ~Tu/4 (ordem do tempo morto da planta) em vez dos valores fixos
+    p->hysteresis_c = clampf(0.5f * a, TUNED_HYSTERESIS_MIN_C, TUNED_HYSTERESIS_MAX_C);
+    p->min_off_ms = (uint32_t)clampf(tu * 1000.0f / 4.0f, TUNED_MIN_OFF_MIN_MS, TUNED_MIN_OFF_MAX_MS);
+    p->tuned = true;
+
+    state = AUTOTUNE_DONE;
+    end_time = hal_time_ms();
+    relay_state = false;
+    status_message = "ok";
+
+    LOG_I(LOG_MOD_CTRL, "✅ [AUTOTUNE] Concluído (%s)", autotune_zone_name(tune_zone));
+    LOG_I(LOG_MOD_CTRL, "   Amplitude: %.2f°C | Período: %.1f s", a, tu);
+    LOG_I(LOG_MOD_CTRL, "   Ku=%.2f Kp=%.2f Ki=%.4f Kd=%.1f", p->ku, p->kp, p->ki, p->kd);
+    LOG_I(LOG_MOD_CTRL, "   Banda: ±%.2f°C | Espera: %lu ms", p->hysteresis_c, (unsigned long)p->min_off_ms);
+
+    autotune_save();
+}
+
+// Fim de um ciclo completo (início de nova fase de subida)
+static void autotune_cycle_boundary(float temp_c, uint32_t now_ms) {
+    if (has_cycle_start) {
+        last_amplitude = (cycle_max - cycle_min) / 2.0f;
+        last_period_s = (now_ms - cycle_start_time) / 1000.0f;
+        cycles_seen++;
+
+        if (cycles_seen > AUTOTUNE_SKIP_CYCLES) {
+            sum_amplitude += last_amplitude;
+            sum_period_s += last_period_s;
+            cycles_measured++;
+        }
+        LOG_I(LOG_MOD_CTRL, "[AUTOTUNE] Ciclo %d: amplitude=%.2f°C período=%.1f s%s",
+              cycles_seen, last_amplitude, last_period_s,
+              cycles_seen > AUTOTUNE_SKIP_CYCLES ? "" : " (descartado)");
+    }
+
+    has_cycle_start = true;
+    cycle_start_time = now_ms;
+    cycle_max = temp_c;
+    cycle_min = temp_c;
+}
+
+bool autotune_update(float temp_c, uint32_t now_ms) {
+    if (!autotune_is_running()) {
+        return false;
+    }
+
+    // Limites de segurança
+    if (temp_c < AUTOTUNE_TEMP_MIN || temp_c > AUTOTUNE_TEMP_MAX) {
+        autotune_fail("temperatura fora dos limites de segurança");
+        return false;
+    }
+    if (now_ms - start_time > AUTOTUNE_TIMEOUT_MS) {
+        autotune_fail("tempo total excedido");
+        return false;
+    }
+    if (now_ms - last_switch_time > AUTOTUNE_HALF_CYCLE_TIMEOUT_MS) {
+        autotune_fail("sem oscilação (setpoint inalcançável?)");
+        return false;
+    }
+
+    if (has_cycle_start) {
+        if (temp_c > cycle_max) cycle_max = temp_c;
+        if (temp_c < cycle_min) cycle_min = temp_c;
+    }
+
+    if (now_ms - last_switch_time < AUTOTUNE_MIN_SWITCH_MS) {
+        return relay_state;
+    }
+
+    // Fase de subida: relé ligado no aquecedor, desligado no conservador
+    bool rising = (tune_zone == AUTOTUNE_ZONE_HEATER) ? relay_state : !relay_state;
+    bool switch_to_rising = !rising && temp_c < tune_setpoint - AUTOTUNE_HYSTERESIS_C;
+    bool switch_to_falling = rising && temp_c > tune_setpoint + AUTOTUNE_HYSTERESIS_C;
+
+    if (!switch_to_rising && !switch_to_falling) {
+        return relay_state;
+    }
+
+    relay_state = !relay_state;
+    last_switch_time = now_ms;
+
+    if (state == AUTOTUNE_APPROACH) {
+        state = AUTOTUNE_RELAY;
+        LOG_I(LOG_MOD_CTRL, "[AUTOTUNE] Setpoint alcançado, iniciando oscilação");
+    }
+
+    if (switch_to_rising) {
+        autotune_cycle_boundary(temp_c, now_ms);
+        if (cycles_measured >= AUTOTUNE_CYCLES) {
+            autotune_finish();
+        }
+    }
+
+    return relay_state;
+}
+
+void autotune_get_status(autotune_status_t *status) {
+    status->state = state;
+    status->zone = tune_zone;
+    status->setpoint = tune_setpoint;
+    status->cycles = cycles_measured;
+    status->cycles_target = AUTOTUNE_CYCLES;
+    status->last_amplitude = last_amplitude;
+    status->last_period_s = last_period_s;
+    if (state == AUTOTUNE_IDLE) {
+        status->elapsed_ms = 0;
+    } else if (autotune_is_running()) {
+        status->elapsed_ms = hal_time_ms() - start_time;
+    } else {
+        status->elapsed_ms = end_time - start_time;
+    }
+    status->relay_on = relay_state;
+    status->message = status_message;
+}
+
+const controller_params_t *autotune_get_params(autotune_zone_t zone) {
+    if (zone >= AUTOTUNE_ZONE_COUNT) {
+        zone = AUTOTUNE_ZONE_HEATER;
+    }
+    return &zone_params[zone];
+}
+
+const char *autotune_state_name(autotune_state_t s) {
+    switch (s) {
+        case AUTOTUNE_IDLE: return "idle";
+        case AUTOTUNE_APPROACH: return "approach";
+        case AUTOTUNE_RELAY: return "relay";
+        case AUTOTUNE_DONE: return "done";
+        case AUTOTUNE_FAILED: return "failed";
+    }
+    return "unknown";
+}
+
+const char *autotune_zone_name(autotune_zone_t zone) {
+    return zone == AUTOTUNE_ZONE_CONSERVATIVE ? "freezer" : "heater";
+}
@@ -0,0 +1,66 @@
+#ifndef AUTOTUNE_H
+#define AUTOTUNE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// Autotune por realimentação de relé (Åström–Hägglund)
+// O relé é forçado a oscilar em torno do setpoint; do período (Tu) e da
+// amplitude (a) da oscilação obtém-se o ganho último Ku = 4d / (π·√(a² - h²))
+// e, a partir dele, os parâmetros do controlador de cada zona.
+
+// Zonas que podem ser sintonizadas
+typedef enum {
+    AUTOTUNE_ZONE_HEATER = 0,        // Compartimento quente (relé liga = esquenta)
+    AUTOTUNE_ZONE_CONSERVATIVE = 1,  // Compartimento frio (relé liga = esfria)
+    AUTOTUNE_ZONE_COUNT
+} autotune_zone_t;
+
+typedef enum {
+    AUTOTUNE_IDLE = 0,   // Nunca executado nesta sessão
+    AUTOTUNE_APPROACH,   // Levando a temperatura até o setpoint
+    AUTOTUNE_RELAY,      // Oscilando e medindo ciclos
+    AUTOTUNE_DONE,       // Parâmetros calculados e salvos
+    AUTOTUNE_FAILED,     // Abortado (timeout, limite de segurança ou cancelado)
+} autotune_state_t;
+
+// Parâmetros do controlador de uma zona (padrão ou derivados do autotune)
+typedef struct {
+    float hysteresis_c;    // Meia-banda em torno do alvo (°C)
+    uint32_t min_off_ms;   // Tempo mínimo desligado após atingir a meta
+    float kp;              // Ganho proporcional (%/°C)
+    float ki;              // Ganho integral (%/(°C·s))
+    float kd;              // Ganho derivativo (%·s/°C)
+    float ku;              // Ganho último medido
+    float tu_s;            // Período último medido (s)
+    bool tuned;            // true se veio de um autotune concluído
+} controller_params_t;
+
+// Progresso do autotune em andamento (ou resultado do último)
+typedef struct {
+    autotune_state_t state;
+    autotune_zone_t zone;
+    float setpoint;
+    uint8_t cycles;          // Ciclos completos medidos
+    uint8_t cycles_target;   // Ciclos necessários
+    float last_amplitude;    // Amplitude do último ciclo (°C)
+    float last_period_s;     // Período do último ciclo (s)
+    uint32_t elapsed_ms;
+    bool relay_on;
+    const char *message;     // Motivo de falha ou "ok"
+} autotune_status_t;
+
+// Funções públicas
+void autotune_init(void);  // Carregar parâmetros salvos na flash
+bool autotune_setpoint_valid(float setpoint);
+bool autotune_start(autotune_zone_t zone, float setpoint, uint32_t now_ms);
+void autotune_cancel(void);
+bool autotune_is_running(void);
+autotune_zone_t autotune_get_zone(void);
+bool autotune_update(float temp_c, uint32_t now_ms);  // Retorna o estado desejado do relé
+void autotune_get_status(autotune_status_t *status);
+const controller_params_t *autotune_get_params(autotune_zone_t zone);
+const char *autotune_state_name(autotune_state_t state);
+const char *autotune_zone_name(autotune_zone_t zone);
+
+#endif // AUTOTUNE_H
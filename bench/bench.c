@@ -0,0 +1,175 @@
+#include "bench.h"
+#include <stdio.h>
+#include <string.h>
+
+#if IBAG_HOST
+#include <time.h>
+#if defined(__x86_64__)
+#include <x86intrin.h>
+#endif
+#else
+#include "pico/stdlib.h"
+#include "hardware/clocks.h"
+#include "prof.h"
+#endif
+
+typedef struct {
+    uint64_t ns;
+    uint64_t cycles;
+} bench_sample_t;
+
+// Uma rodada de iters operações
+#if IBAG_HOST
+
+static uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+
+static uint64_t now_cycles(void) {
+#if defined(__x86_64__)
+    return __rdtsc();
+#else
+    return 0;
+#endif
+}
+
+const char *bench_platform(void) {
+#if defined(__x86_64__)
+    return "host-x86_64";
+#elif defined(__aarch64__)
+    return "host-aarch64";
+#else
+    return "host";
+#endif
+}
+
+void bench_platform_init(void) {
+}
+
+static bench_sample_t measure_run(const bench_case_t *c, uint32_t iters) {
+    uint64_t t0 = now_ns();
+    uint64_t c0 = now_cycles();
+    c->fn(c->ctx, iters);
+    uint64_t c1 = now_cycles();
+    uint64_t t1 = now_ns();
+    return (bench_sample_t){ t1 - t0, c1 - c0 };
+}
+
+#else
+
+static uint32_t cycles_per_us;
+
+const char *bench_platform(void) {
+    static char name[24];
+    snprintf(name, sizeof(name), "rp2350@%luMHz", (unsigned long)(clock_get_hz(clk_sys) / 1000000u));
+    return name;
+}
+
+void bench_platform_init(void) {
+    prof_core_init();   // DWT do core que mede
+    cycles_per_us = clock_get_hz(clk_sys) / 1000000u;
+}
+
+// CYCCNT tem 32 bits: uma rodada de BENCH_RUN_US a 150 MHz fica longe da volta
+static bench_sample_t measure_run(const bench_case_t *c, uint32_t iters) {
+    uint32_t c0 = prof_cycles();
+    c->fn(c->ctx, iters);
+    uint32_t cycles = prof_cycles() - c0;
+    return (bench_sample_t){ (uint64_t)cycles * 1000u / cycles_per_us, cycles };
+}
+
+#endif
+
+// N tal que uma rodada dure ~BENCH_RUN_US
+static uint32_t calibrate(const bench_case_t *c) {
+    uint32_t iters = 1;
+    for (;;) {
+        bench_sample_t s = measure_run(c, iters);
+        if (s.ns >= BENCH_RUN_US * 100u || iters >= (1u << 30)) {
+            // Já mediu 10% da rodada: extrapolar
+            uint64_t n = (uint64_t)iters * BENCH_RUN_US * 1000u / (s.ns ? s.ns : 1);
+            return n < 1 ? 1 : n > (1u << 30) ? (1u << 30) : (uint32_t)n;
+        }
+        iters *= 2;
+    }
+}
+
+static void sort_doubles(double *v, int n) {
+    for (int i = 1; i < n; i++) {
+        double x = v[i];
+        int j = i - 1;
+        while (j >= 0 && v[j] > x) {
+            v[j + 1] = v[j];
+            j--;
+        }
+        v[j + 1] = x;
+    }
+}
+
+void bench_measure(const bench_case_t *c, bench_result_t *out) {
+    if (c->setup) {
+        c->setup(c->ctx);
+    }
+    uint32_t iters = calibrate(c);
+    measure_run(c, iters);   // Aquecer caches e preditores
+
+    double ns[BENCH_RUNS];
+    double cycles[BENCH_RUNS];
+    for (int r = 0; r < BENCH_RUNS; r++) {
+        bench_sample_t s = measure_run(c, iters);
+        ns[r] = (double)s.ns / iters;
+        cycles[r] = (double)s.cycles / iters;
+    }
+    sort_doubles(ns, BENCH_RUNS);
+    sort_doubles(cycles, BENCH_RUNS);
+
+    out->iters = iters;
+    out->ns_median = ns[BENCH_RUNS / 2];
+    out->ns_min = ns[0];
+    out->cycles_median = cycles[BENCH_RUNS / 2];
+    out->spread_pct = out->ns_median > 0
+        ? 100.0 * (ns[(3 * BENCH_RUNS) / 4] - ns[BENCH_RUNS / 4]) / out->ns_median : 0;
+}
+
+static bool matches(const bench_case_t *c, const char *filter) {
+    if (filter == NULL || filter[0] == '\0') {
+        return true;
+    }
+    char full[64];
+    snprintf(full, sizeof(full), "%s/%s", c->group, c->name);
+    return strstr(full, filter) != NULL;
+}
+
+void bench_run_all(const char *filter) {
+    static bench_result_t results[64];
+    const char *platform = bench_platform();
+
+    printf("# iBag microbenchmarks | %s | %d rodadas de %u ms, mediana\n",
+           platform, BENCH_RUNS, (unsigned)(BENCH_RUN_US / 1000));
+    printf("%-34s %10s %10s %10s %10s %7s\n", "caso", "iters", "ns/op", "min ns", "ciclos/op", "disp.");
+    for (size_t i = 0; i < bench_case_count && i < sizeof(results) / sizeof(results[0]); i++) {
+        const bench_case_t *c = &bench_cases[i];
+        if (!matches(c, filter)) {
+            continue;
+        }
+        bench_result_t *r = &results[i];
+        bench_measure(c, r);
+        char full[64];
+        snprintf(full, sizeof(full), "%s/%s", c->group, c->name);
+        printf("%-34s %10lu %10.1f %10.1f %10.1f %6.1f%%\n", full, (unsigned long)r->iters,
+               r->ns_median, r->ns_min, r->cycles_median, r->spread_pct);
+    }
+
+    // Linhas para tools/bench_compare.py
+    for (size_t i = 0; i < bench_case_count && i < sizeof(results) / sizeof(results[0]); i++) {
+        const bench_case_t *c = &bench_cases[i];
+        if (!matches(c, filter)) {
+            continue;
+        }
+        const bench_result_t *r = &results[i];
+        printf("bench,%s,%s,%s,%lu,%.2f,%.2f,%.2f,%.1f\n", platform, c->group, c->name,
+               (unsigned long)r->iters, r->ns_median, r->ns_min, r->cycles_median, r->spread_pct);
+    }
+}
@@ -0,0 +1,57 @@
+#ifndef BENCH_H
+#define BENCH_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+// Microbenchmarks dos caminhos quentes (por amostra ou por requisição)
+// Cada caso roda a operação num laço de N iterações; o harness calibra N
+// para que uma rodada dure BENCH_RUN_US, repete BENCH_RUNS rodadas e
+// reporta a mediana (robusta a interrupções e preempção) e a dispersão.
+//
+// Alvo: ciclos pelo DWT CYCCNT do core 1 (sem interrupções; o core 0 fica
+// com o USB), ns = ciclos / clk_sys. Host: ns pelo CLOCK_MONOTONIC e
+// ciclos pelo TSC em x86-64 (ciclos de referência, não do núcleo).
+//
+// Saída: tabela legível e, por caso, uma linha "bench,..." em CSV que
+// tools/bench_compare.py compara entre duas execuções (antes/depois,
+// host/alvo).
+
+#define BENCH_RUNS 11
+#ifndef BENCH_RUN_US
+#define BENCH_RUN_US 20000
+#endif
+
+// Impedir que o compilador descarte um resultado ou tire algo do laço
+#define BENCH_KEEP(x) __asm__ volatile("" : : "g"(x) : "memory")
+#define BENCH_CLOBBER() __asm__ volatile("" : : : "memory")
+
+typedef void (*bench_fn)(void *ctx, uint32_t iters);
+
+typedef struct {
+    const char *group;    // fmt, parse, conv, detect, history, dhcp, log
+    const char *name;
+    bench_fn fn;
+    void *ctx;
+    void (*setup)(void *ctx);   // Opcional, antes da calibração
+} bench_case_t;
+
+typedef struct {
+    uint32_t iters;
+    double ns_median;     // Por operação
+    double ns_min;
+    double cycles_median; // Por operação; 0 = sem contador de ciclos
+    double spread_pct;    // (p75 - p25) / mediana
+} bench_result_t;
+
+// Funções públicas
+extern const bench_case_t bench_cases[];
+extern const size_t bench_case_count;
+
+const char *bench_platform(void);          // "host-x86_64", "rp2350@150MHz"...
+void bench_platform_init(void);            // No core que vai medir
+void bench_measure(const bench_case_t *c, bench_result_t *out);
+void bench_run_all(const char *filter);    // NULL = todos; filtro por substring de grupo/nome
+
+#endif // BENCH_H
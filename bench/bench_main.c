@@ -0,0 +1,59 @@
+// Executável dos microbenchmarks (ibag_bench)
+// Host: ./ibag_bench [filtro] imprime a tabela e sai. Alvo: espera o
+// terminal abrir o USB serial, mede no core 1 (sem interrupções) e repete
+// com 'r'; o core 0 só atende o USB.
+
+#include <stdio.h>
+#include "pico/stdlib.h"
+#include "bench.h"
+
+#if IBAG_HOST
+
+int main(int argc, char **argv) {
+    bench_platform_init();
+    bench_run_all(argc > 1 ? argv[1] : NULL);
+    return 0;
+}
+
+#else
+
+#include <stdatomic.h>
+#include "pico/multicore.h"
+#include "pico/stdio_usb.h"
+
+static _Atomic bool run_requested;
+static _Atomic bool running;
+
+static void core1_bench(void) {
+    bench_platform_init();
+    for (;;) {
+        if (!atomic_exchange(&run_requested, false)) {
+            tight_loop_contents();
+            continue;
+        }
+        atomic_store(&running, true);
+        bench_run_all(NULL);
+        printf("# 'r' repete\n");
+        atomic_store(&running, false);
+    }
+}
+
+int main(void) {
+    stdio_init_all();
+    while (!stdio_usb_connected()) {
+        sleep_ms(100);
+    }
+    sleep_ms(500);   // Terminal pronto para receber
+
+    atomic_store(&run_requested, true);
+    multicore_launch_core1(core1_bench);
+
+    for (;;) {
+        int c = getchar_timeout_us(100 * 1000);
+        if (c == 'r' && !atomic_load(&running)) {
+            atomic_store(&run_requested, true);
+        }
+    }
+}
+
+#endif
@@ -0,0 +1,12 @@
+// dhcp_server.c com os logs de depuração compilados (IBAG_LOG_LEVEL DEBUG),
+// para o caso log/dhcp_request_debug comparar com a cópia normal (INFO)
+// Funções públicas renomeadas; a porta é efêmera porque a cópia normal
+// já ocupa a 67.
+
+#define IBAG_LOG_LEVEL LOG_LEVEL_DEBUG
+#include "lwip/udp.h"
+#define udp_bind(pcb, ipaddr, port) udp_bind(pcb, ipaddr, 0)
+#define dhcp_server_init dhcp_server_init_log_debug
+#define dhcp_server_parse dhcp_server_parse_log_debug
+#define dhcp_server_handle dhcp_server_handle_log_debug
+#include "dhcp_server.c"
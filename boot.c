@@ -0,0 +1,44 @@
+#include "boot.h"
+#include <stdatomic.h>
+#include "pico/stdlib.h"
+#include "pico/multicore.h"
+#include "hal.h"
+#include "logger.h"
+
+static boot_stage_t stages[BOOT_MAX_STAGES];
+static _Atomic uint32_t next_slot;
+static _Atomic uint32_t ready_mask;   // Bit por etapa já preenchida
+static atomic_flag first_http_flag = ATOMIC_FLAG_INIT;
+
+void boot_mark(const char *name) {
+    uint32_t slot = atomic_fetch_add_explicit(&next_slot, 1, memory_order_relaxed);
+    if (slot >= BOOT_MAX_STAGES) {
+        return;
+    }
+    stages[slot].name = name;
+    stages[slot].us = hal_time_us();
+    stages[slot].core = (uint8_t)get_core_num();
+    atomic_fetch_or_explicit(&ready_mask, 1u << slot, memory_order_release);
+    LOG_I(LOG_MOD_MAIN, "[BOOT] %-12s %6lu ms (core %u)", name, (unsigned long)(stages[slot].us / 1000),
+          stages[slot].core);
+}
+
+void boot_mark_first_http(void) {
+    if (!atomic_flag_test_and_set(&first_http_flag)) {
+        boot_mark("first_http");
+    }
+}
+
+int boot_stage_count(void) {
+    uint32_t count = atomic_load_explicit(&next_slot, memory_order_relaxed);
+    return count < BOOT_MAX_STAGES ? (int)count : BOOT_MAX_STAGES;
+}
+
+// NULL se a etapa ainda está sendo escrita pelo outro core
+const boot_stage_t *boot_get_stage(int index) {
+    if (index < 0 || index >= BOOT_MAX_STAGES) {
+        return NULL;
+    }
+    uint32_t mask = atomic_load_explicit(&ready_mask, memory_order_acquire);
+    return (mask & (1u << index)) ? &stages[index] : NULL;
+}
@@ -0,0 +1,24 @@
+#ifndef BOOT_H
+#define BOOT_H
+
+#include <stdint.h>
+
+// Tempos do boot
+// Cada etapa registra quando terminou (µs desde o reset). Os dois cores
+// podem marcar etapas; a posição no vetor é reservada com um contador atômico.
+
+#define BOOT_MAX_STAGES 16
+
+typedef struct {
+    const char *name;
+    uint32_t us;       // Fim da etapa, em µs desde o reset
+    uint8_t core;
+} boot_stage_t;
+
+// Funções públicas
+void boot_mark(const char *name);           // Qualquer core
+void boot_mark_first_http(void);            // Primeira página servida (só a primeira chamada conta)
+int boot_stage_count(void);
+const boot_stage_t *boot_get_stage(int index);
+
+#endif // BOOT_H
@@ -0,0 +1,209 @@
+#include "captive_portal.h"
+#include <string.h>
+#include <stdio.h>
+#include "lwip/udp.h"
+#include "lwip/tcp.h"
+#include "lwip/inet.h"
+#include "pico/stdlib.h"
+#include "dhcp_leases.h"
+#include "logger.h"
+#include "prof.h"
+#include "hal.h"
+
+#define DNS_PORT 53
+#define DNS_HEADER_LEN 12
+#define DNS_MAX_NAME 255
+#define DNS_TTL_S 60
+#define REDIRECT_PORT 80
+
+// Flags DNS
+#define DNS_FLAG_QR     0x8000
+#define DNS_FLAG_AA     0x0400
+#define DNS_FLAG_RD     0x0100
+#define DNS_FLAG_RA     0x0080
+#define DNS_OPCODE_MASK 0x7800
+
+#define DNS_TYPE_A  1
+#define DNS_CLASS_IN 1
+
+static captive_stats_t stats;
+
+// Cabeçalho + pergunta (nome até 255 bytes + tipo/classe) + uma resposta A
+static uint8_t dns_reply[DNS_HEADER_LEN + DNS_MAX_NAME + 4 + 16];
+
+static const char redirect_response[] =
+    "HTTP/1.1 302 Found\r\n"
+    "Location: " CAPTIVE_PORTAL_URL "\r\n"
+    "Cache-Control: no-store\r\n"
+    "Content-Length: 0\r\n"
+    "Connection: close\r\n"
+    "\r\n";
+
+static uint16_t read_u16(const struct pbuf *p, u16_t off) {
+    return (uint16_t)((pbuf_get_at(p, off) << 8) | pbuf_get_at(p, (u16_t)(off + 1)));
+}
+
+static uint8_t *put_u16(uint8_t *out, uint16_t v) {
+    *out++ = (uint8_t)(v >> 8);
+    *out++ = (uint8_t)v;
+    return out;
+}
+
+// Montar a resposta em dns_reply; retorna o tamanho, 0 = descartar
+static int dns_build_reply(const struct pbuf *p) {
+    if (p->tot_len < DNS_HEADER_LEN + 5) return 0;
+    
+    uint16_t flags = read_u16(p, 2);
+    if ((flags & DNS_FLAG_QR) || (flags & DNS_OPCODE_MASK) != 0) return 0;  // Só consultas padrão
+    if (read_u16(p, 4) != 1) return 0;                                    // Uma pergunta
+    
+    // Nome: sequência de rótulos terminada em 0, sem ponteiros de compressão
+    u16_t pos = DNS_HEADER_LEN;
+    int name_len = 0;
+    for (;;) {
+        int label = pbuf_try_get_at(p, pos);
+        if (label < 0 || (label & 0xC0) != 0) return 0;
+        name_len += label + 1;
+        if (name_len > DNS_MAX_NAME) return 0;
+        pos = (u16_t)(pos + label + 1);
+        if (label == 0) break;
+    }
+    if ((uint32_t)pos + 4 > p->tot_len) return 0;
+    uint16_t qtype = read_u16(p, pos);
+    uint16_t qclass = read_u16(p, (u16_t)(pos + 2));
+    u16_t question_len = (u16_t)(pos + 4 - DNS_HEADER_LEN);
+    bool answer_a = (qtype == DNS_TYPE_A && qclass == DNS_CLASS_IN);
+    
+    // Cabeçalho: mesmo ID; AAAA e outros tipos recebem NOERROR sem registros,
+    // o que faz o cliente usar o A em vez de esperar timeout
+    uint8_t *out = dns_reply;
+    pbuf_copy_partial(p, out, 2, 0);
+    out += 2;
+    out = put_u16(out, DNS_FLAG_QR | DNS_FLAG_AA | (flags & DNS_FLAG_RD) | DNS_FLAG_RA);
+    out = put_u16(out, 1);                  // QDCOUNT
+    out = put_u16(out, answer_a ? 1 : 0);   // ANCOUNT
+    out = put_u16(out, 0);                  // NSCOUNT
+    out = put_u16(out, 0);                  // ARCOUNT
+    
+    // Pergunta ecoada
+    pbuf_copy_partial(p, out, question_len, DNS_HEADER_LEN);
+    out += question_len;
+    
+    if (answer_a) {
+        out = put_u16(out, 0xC000 | DNS_HEADER_LEN);   // Ponteiro para o nome da pergunta
+        out = put_u16(out, DNS_TYPE_A);
+        out = put_u16(out, DNS_CLASS_IN);
+        out = put_u16(out, 0);
+        out = put_u16(out, DNS_TTL_S);
+        out = put_u16(out, 4);
+        *out++ = 192; *out++ = 168; *out++ = 4; *out++ = 1;
+        stats.dns_answers++;
+    }
+    return (int)(out - dns_reply);
+}
+
+static void dns_recv(void *arg, struct udp_pcb *pcb, struct pbuf *p, const ip_addr_t *addr, u16_t port) {
+    PROF_SCOPE("dns_recv");
+    stats.dns_queries++;
+    int len = dns_build_reply(p);
+    pbuf_free(p);
+    if (len == 0) {
+        stats.dns_dropped++;
+        return;
+    }
+    
+    // PBUF_REF aponta para o buffer estático; se o ARP precisar enfileirar,
+    // o lwIP copia os dados
+    struct pbuf *reply = pbuf_alloc(PBUF_TRANSPORT, (u16_t)len, PBUF_REF);
+    if (reply == NULL) {
+        stats.dns_dropped++;
+        return;
+    }
+    reply->payload = dns_reply;
+    udp_sendto(pcb, reply, addr, port);
+    pbuf_free(reply);
+}
+
+static err_t redirect_recv(void *arg, struct tcp_pcb *pcb, struct pbuf *p, err_t err) {
+    if (p == NULL) {
+        tcp_close(pcb);
+        return ERR_OK;
+    }
+    tcp_recved(pcb, p->tot_len);
+    pbuf_free(p);
+    
+    // Qualquer método/URI recebe o mesmo redirecionamento; dados seguintes
+    // são descartados pelo lwIP
+    tcp_recv(pcb, NULL);
+    if (tcp_write(pcb, redirect_response, sizeof(redirect_response) - 1, 0) == ERR_OK) {
+        stats.redirects++;
+        tcp_output(pcb);
+    }
+    if (tcp_close(pcb) != ERR_OK) {
+        tcp_abort(pcb);
+        return ERR_ABRT;
+    }
+    return ERR_OK;
+}
+
+static err_t redirect_accept(void *arg, struct tcp_pcb *newpcb, err_t err) {
+    if (err != ERR_OK || newpcb == NULL) {
+        return ERR_VAL;
+    }
+    tcp_recv(newpcb, redirect_recv);
+    tcp_err(newpcb, NULL);
+    return ERR_OK;
+}
+
+void captive_portal_page_served(const ip_addr_t *client) {
+    uint32_t ip = ntohl(ip4_addr_get_u32(ip_2_ip4(client)));
+    if ((ip & 0xFFFFFF00) != 0xC0A80400) {
+        return;
+    }
+    uint32_t join_ms;
+    if (!dhcp_lease_first_page((uint8_t)(ip & 0xFF), hal_time_ms(), &join_ms)) {
+        return;
+    }
+    
+    stats.joins++;
+    stats.last_join_ms = join_ms;
+    if (stats.joins == 1 || join_ms < stats.min_join_ms) stats.min_join_ms = join_ms;
+    if (join_ms > stats.max_join_ms) stats.max_join_ms = join_ms;
+    LOG_I(LOG_MOD_DNS, "Cliente 192.168.4.%lu: DHCP -> primeira página em %lu ms",
+          (unsigned long)(ip & 0xFF), (unsigned long)join_ms);
+}
+
+const captive_stats_t *captive_portal_get_stats(void) {
+    return &stats;
+}
+
+void captive_portal_init(void) {
+    struct udp_pcb *dns_pcb = udp_new();
+    if (dns_pcb == NULL || udp_bind(dns_pcb, IP_ADDR_ANY, DNS_PORT) != ERR_OK) {
+        printf("ERRO: Falha ao iniciar DNS na porta 53\n");
+        if (dns_pcb != NULL) {
+            udp_remove(dns_pcb);
+        }
+    } else {
+        udp_recv(dns_pcb, dns_recv, NULL);
+        printf("✅ DNS do portal cativo na porta 53\n");
+    }
+    
+    struct tcp_pcb *pcb = tcp_new();
+    if (pcb == NULL) {
+        printf("ERRO: Falha ao criar TCP PCB do redirecionamento\n");
+        return;
+    }
+    if (tcp_bind(pcb, IP_ADDR_ANY, REDIRECT_PORT) != ERR_OK) {
+        printf("ERRO: Falha ao fazer bind na porta 80\n");
+        tcp_close(pcb);
+        return;
+    }
+    pcb = tcp_listen(pcb);
+    if (pcb == NULL) {
+        printf("ERRO: Falha ao colocar a porta 80 em modo listen\n");
+        return;
+    }
+    tcp_accept(pcb, redirect_accept);
+    printf("✅ Porta 80 redirecionando para " CAPTIVE_PORTAL_URL "\n");
+}
@@ -0,0 +1,33 @@
+#ifndef CAPTIVE_PORTAL_H
+#define CAPTIVE_PORTAL_H
+
+#include <stdint.h>
+#include "lwip/ip_addr.h"
+
+// Portal cativo do AP
+// DNS na porta UDP 53 que responde toda consulta A com o IP do AP (o DHCP já
+// anuncia 192.168.4.1 como DNS), e HTTP na porta 80 que redireciona qualquer
+// requisição - inclusive as sondas de conectividade do Android, iOS e
+// Windows - para a interface na porta 8000. O celular abre a interface
+// sozinho em vez de esperar timeouts de DNS. Sem alocação: as respostas
+// saem de buffers estáticos.
+
+#define CAPTIVE_PORTAL_URL "http://192.168.4.1:8000/"
+
+typedef struct {
+    uint32_t dns_queries;
+    uint32_t dns_answers;         // Respostas com registro A
+    uint32_t dns_dropped;         // Malformadas ou não suportadas
+    uint32_t redirects;           // Respostas 302 na porta 80
+    uint32_t joins;               // Clientes que chegaram à interface após o DHCP
+    uint32_t last_join_ms;        // ACK do DHCP -> primeira página
+    uint32_t min_join_ms;
+    uint32_t max_join_ms;
+} captive_stats_t;
+
+// Funções públicas (contexto do lwIP)
+void captive_portal_init(void);
+void captive_portal_page_served(const ip_addr_t *client);   // Página principal servida
+const captive_stats_t *captive_portal_get_stats(void);
+
+#endif // CAPTIVE_PORTAL_H
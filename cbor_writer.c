@@ -0,0 +1,180 @@
+#include "cbor_writer.h"
+#include <string.h>
+#include <math.h>
+
+// Tipos maiores (3 bits altos do byte inicial)
+#define CBOR_UINT   0x00
+#define CBOR_NEGINT 0x20
+#define CBOR_TEXT   0x60
+#define CBOR_ARRAY  0x80
+#define CBOR_MAP    0xA0
+#define CBOR_SIMPLE 0xE0
+
+#define CBOR_INDEF  0x1F
+#define CBOR_FALSE  0xF4
+#define CBOR_TRUE   0xF5
+#define CBOR_NULL   0xF6
+#define CBOR_FLOAT32 0xFA
+#define CBOR_BREAK  0xFF
+
+void cbor_writer_init(cbor_writer_t *w, void *buf, size_t cap) {
+    w->buf = (uint8_t *)buf;
+    w->cap = cap;
+    w->len = 0;
+    w->overflow = false;
+}
+
+static void put(cbor_writer_t *w, const void *s, size_t n) {
+    if (w->overflow || n > w->cap - w->len) {
+        w->overflow = true;
+        return;
+    }
+    memcpy(w->buf + w->len, s, n);
+    w->len += n;
+}
+
+static void put_byte(cbor_writer_t *w, uint8_t b) {
+    if (w->overflow || w->len >= w->cap) {
+        w->overflow = true;
+        return;
+    }
+    w->buf[w->len++] = b;
+}
+
+// Byte inicial + argumento em big-endian no menor tamanho (0, 1, 2 ou 4 bytes)
+static void put_head(cbor_writer_t *w, uint8_t major, uint32_t arg) {
+    uint8_t head[5];
+    size_t n;
+    if (arg < 24) {
+        head[0] = (uint8_t)(major | arg);
+        n = 1;
+    } else if (arg <= 0xFF) {
+        head[0] = major | 24;
+        head[1] = (uint8_t)arg;
+        n = 2;
+    } else if (arg <= 0xFFFF) {
+        head[0] = major | 25;
+        head[1] = (uint8_t)(arg >> 8);
+        head[2] = (uint8_t)arg;
+        n = 3;
+    } else {
+        head[0] = major | 26;
+        head[1] = (uint8_t)(arg >> 24);
+        head[2] = (uint8_t)(arg >> 16);
+        head[3] = (uint8_t)(arg >> 8);
+        head[4] = (uint8_t)arg;
+        n = 5;
+    }
+    put(w, head, n);
+}
+
+void cbor_array(cbor_writer_t *w, uint32_t count) {
+    put_head(w, CBOR_ARRAY, count);
+}
+
+void cbor_map(cbor_writer_t *w, uint32_t pairs) {
+    put_head(w, CBOR_MAP, pairs);
+}
+
+void cbor_array_indef(cbor_writer_t *w) {
+    put_byte(w, CBOR_ARRAY | CBOR_INDEF);
+}
+
+void cbor_map_indef(cbor_writer_t *w) {
+    put_byte(w, CBOR_MAP | CBOR_INDEF);
+}
+
+void cbor_break(cbor_writer_t *w) {
+    put_byte(w, CBOR_BREAK);
+}
+
+void cbor_uint(cbor_writer_t *w, uint32_t value) {
+    put_head(w, CBOR_UINT, value);
+}
+
+// Negativo n sai como -1 - arg: arg = |n| - 1
+void cbor_int(cbor_writer_t *w, int32_t value) {
+    if (value < 0) {
+        put_head(w, CBOR_NEGINT, (uint32_t)(-1 - value));
+    } else {
+        put_head(w, CBOR_UINT, (uint32_t)value);
+    }
+}
+
+void cbor_text_n(cbor_writer_t *w, const char *s, size_t len) {
+    put_head(w, CBOR_TEXT, (uint32_t)len);
+    put(w, s, len);
+}
+
+void cbor_text(cbor_writer_t *w, const char *s) {
+    if (s == NULL) {
+        cbor_null(w);
+        return;
+    }
+    cbor_text_n(w, s, strlen(s));
+}
+
+void cbor_bool(cbor_writer_t *w, bool value) {
+    put_byte(w, value ? CBOR_TRUE : CBOR_FALSE);
+}
+
+void cbor_null(cbor_writer_t *w) {
+    put_byte(w, CBOR_NULL);
+}
+
+void cbor_float(cbor_writer_t *w, float value) {
+    uint32_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    uint8_t b[5] = {
+        CBOR_FLOAT32, (uint8_t)(bits >> 24), (uint8_t)(bits >> 16), (uint8_t)(bits >> 8), (uint8_t)bits,
+    };
+    put(w, b, sizeof(b));
+}
+
+// Mesmo arredondamento do json_float(): o inteiro é o número do JSON sem o ponto
+void cbor_fixed(cbor_writer_t *w, float value, uint8_t decimals) {
+    bool negative;
+    uint32_t magnitude;
+    if (!isfinite(value)) {
+        cbor_null(w);
+    } else if (!json_float_fixed(value, decimals, &negative, &magnitude)) {
+        cbor_float(w, value);
+    } else if (negative) {
+        put_head(w, CBOR_NEGINT, magnitude - 1);
+    } else {
+        put_head(w, CBOR_UINT, magnitude);
+    }
+}
+
+void cbor_write_fields(cbor_writer_t *w, const json_field_t *fields, size_t count, const void *base) {
+    const uint8_t *p = (const uint8_t *)base;
+    for (size_t i = 0; i < count && !w->overflow; i++) {
+        const json_field_t *f = &fields[i];
+        const void *member = p + f->offset;
+        cbor_uint(w, (uint32_t)i);
+        switch (f->type) {
+            case JSON_FIELD_UINT:
+                cbor_uint(w, f->size == 1 ? *(const uint8_t *)member
+                           : f->size == 2 ? *(const uint16_t *)member
+                           : *(const uint32_t *)member);
+                break;
+            case JSON_FIELD_INT:
+                cbor_int(w, f->size == 1 ? *(const int8_t *)member
+                          : f->size == 2 ? *(const int16_t *)member
+                          : *(const int32_t *)member);
+                break;
+            case JSON_FIELD_FLOAT:
+                cbor_fixed(w, *(const float *)member, f->decimals);
+                break;
+            case JSON_FIELD_BOOL:
+                cbor_bool(w, *(const bool *)member);
+                break;
+            case JSON_FIELD_STR:
+                cbor_text(w, *(const char *const *)member);
+                break;
+            default:
+                cbor_null(w);
+                break;
+        }
+    }
+}
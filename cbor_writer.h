@@ -0,0 +1,54 @@
+#ifndef CBOR_WRITER_H
+#define CBOR_WRITER_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "json_writer.h"
+
+// Escrita de CBOR (RFC 8949) sem alocação, direto no buffer de destino
+// Variante compacta das respostas JSON para clientes com pouca banda. Só o
+// subconjunto que a API usa: inteiros, texto, arrays/mapas (tamanho fixo ou
+// indefinido), bool, null e float32. Cada inteiro ocupa o menor cabeçalho que
+// o comporta (0..23 num único byte). Como no json_writer, o que não couber é
+// descartado e cbor_writer_ok() devolve false.
+//
+// Esquema: as mesmas tabelas json_field_t do JSON. cbor_write_fields() usa o
+// índice do campo na tabela como chave do mapa (em vez do nome) e escreve
+// JSON_FIELD_FLOAT em ponto fixo: inteiro = valor * 10^decimals. NaN/infinito
+// viram null; fora da faixa de int32, float32. GET /api/schema publica as
+// tabelas (índice, nome, tipo, escala) para geradores de cliente.
+
+#define CBOR_SCHEMA_VERSION 1   // Muda quando índices ou escalas mudam
+
+typedef struct {
+    uint8_t *buf;
+    size_t cap;
+    size_t len;
+    bool overflow;
+} cbor_writer_t;
+
+// Funções públicas
+void cbor_writer_init(cbor_writer_t *w, void *buf, size_t cap);
+static inline bool cbor_writer_ok(const cbor_writer_t *w) { return !w->overflow; }
+static inline size_t cbor_writer_len(const cbor_writer_t *w) { return w->len; }
+
+void cbor_array(cbor_writer_t *w, uint32_t count);
+void cbor_map(cbor_writer_t *w, uint32_t pairs);
+void cbor_array_indef(cbor_writer_t *w);
+void cbor_map_indef(cbor_writer_t *w);
+void cbor_break(cbor_writer_t *w);                  // Fecha array/mapa indefinido
+
+void cbor_uint(cbor_writer_t *w, uint32_t value);
+void cbor_int(cbor_writer_t *w, int32_t value);
+void cbor_text(cbor_writer_t *w, const char *s);    // NULL = null
+void cbor_text_n(cbor_writer_t *w, const char *s, size_t len);
+void cbor_bool(cbor_writer_t *w, bool value);
+void cbor_null(cbor_writer_t *w);
+void cbor_float(cbor_writer_t *w, float value);     // float32
+void cbor_fixed(cbor_writer_t *w, float value, uint8_t decimals);   // 12.34, 1 -> 123
+
+// Pares índice -> valor de 'count' campos (o chamador abre o mapa)
+void cbor_write_fields(cbor_writer_t *w, const json_field_t *fields, size_t count, const void *base);
+
+#endif // CBOR_WRITER_H
@@ -0,0 +1,63 @@
+#include "config_json.h"
+#include <string.h>
+
+const json_field_t config_json_fields[] = {
+    JSON_FIELD(ibag_config_t, version, "version", JSON_FIELD_UINT, 0),
+    JSON_FIELD(ibag_config_t, heater_target, "heater", JSON_FIELD_FLOAT, 1),
+    JSON_FIELD(ibag_config_t, conservative_target, "freezer", JSON_FIELD_FLOAT, 1),
+    JSON_FIELD(ibag_config_t, heater_offset, "heater_offset", JSON_FIELD_FLOAT, 2),
+    JSON_FIELD(ibag_config_t, conservative_offset, "freezer_offset", JSON_FIELD_FLOAT, 2),
+};
+
+const size_t config_json_field_count = sizeof(config_json_fields) / sizeof(config_json_fields[0]);
+
+// Só os campos float são graváveis pelo corpo
+static int8_t field_lookup(const char *key) {
+    for (size_t i = 0; i < config_json_field_count; i++) {
+        if (config_json_fields[i].type == JSON_FIELD_FLOAT && strcmp(key, config_json_fields[i].key) == 0) {
+            return (int8_t)i;
+        }
+    }
+    return -1;
+}
+
+static json_err_t on_token(void *ctx, const json_token_t *token) {
+    config_json_t *cj = (config_json_t *)ctx;
+    if (token->depth == 0) {
+        // Raiz: só um objeto
+        return (token->type == JSON_TOK_OBJ_BEGIN || token->type == JSON_TOK_OBJ_END) ? JSON_OK : JSON_ERR_TYPE;
+    }
+    if (token->depth > 1) {
+        return JSON_OK;   // Dentro de uma chave ignorada
+    }
+    if (token->type == JSON_TOK_KEY) {
+        cj->field = field_lookup(token->text);
+        return JSON_OK;
+    }
+    if (cj->field < 0 || token->type == JSON_TOK_OBJ_END || token->type == JSON_TOK_ARR_END) {
+        return JSON_OK;
+    }
+    if (token->type != JSON_TOK_NUMBER) {
+        return JSON_ERR_TYPE;
+    }
+    float value;
+    if (!json_number_to_float(token->text, token->len, &value)) {
+        return JSON_ERR_RANGE;
+    }
+    memcpy((uint8_t *)&cj->proposed + config_json_fields[cj->field].offset, &value, sizeof(value));
+    return JSON_OK;
+}
+
+void config_json_begin(config_json_t *cj, const ibag_config_t *current) {
+    json_tok_init(&cj->tok, on_token, cj);
+    cj->proposed = *current;
+    cj->field = -1;
+}
+
+json_err_t config_json_feed(config_json_t *cj, const char *data, size_t len) {
+    return json_tok_feed(&cj->tok, data, len);
+}
+
+json_err_t config_json_end(config_json_t *cj) {
+    return json_tok_finish(&cj->tok);
+}
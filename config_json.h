@@ -0,0 +1,34 @@
+#ifndef CONFIG_JSON_H
+#define CONFIG_JSON_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "config_store.h"
+#include "json_tok.h"
+#include "json_writer.h"
+
+// Corpo do POST /api/config: {"heater":x,"freezer":y,...}
+// Lido em pedaços pelo tokenizador estrito (um por pbuf) sobre uma cópia da
+// configuração atual; campos ausentes mantêm o valor. O documento precisa ser
+// um objeto; as chaves conhecidas exigem número. Chaves desconhecidas (e
+// "version", só de leitura) são ignoradas com o que houver dentro delas.
+// Nada é aplicado aqui: o chamador passa 'proposed' ao config_store_update()
+// só se config_json_end() devolver JSON_OK.
+
+typedef struct {
+    json_tok_t tok;
+    ibag_config_t proposed;
+    int8_t field;      // Campo da última chave no nível 1 (-1 = ignorada)
+} config_json_t;
+
+// Esquema da configuração na resposta (e chaves aceitas no corpo)
+extern const json_field_t config_json_fields[];
+extern const size_t config_json_field_count;
+
+// Funções públicas
+void config_json_begin(config_json_t *cj, const ibag_config_t *current);
+json_err_t config_json_feed(config_json_t *cj, const char *data, size_t len);
+json_err_t config_json_end(config_json_t *cj);
+static inline uint32_t config_json_error_offset(const config_json_t *cj) { return cj->tok.err_offset; }
+
+#endif // CONFIG_JSON_H
@@ -0,0 +1,115 @@
+#include "config_store.h"
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include <stdatomic.h>
+#include "kv_store.h"
+
+static _Atomic uint32_t config_seq;
+static ibag_config_t current_config;
+
+void config_store_init(void) {
+    atomic_store_explicit(&config_seq, 0, memory_order_relaxed);
+    memset(&current_config, 0, sizeof(current_config));
+
+    // Continuar a numeração de versões de antes do reboot; republicar o
+    // valor idêntico não gera nova gravação no kv_store
+    ibag_config_t saved;
+    if (!kv_get(KV_KEY_CONFIG, &saved, sizeof(saved)) || saved.version == 0) {
+        return;
+    }
+    current_config.version = saved.version - 1;
+    if (config_store_update(&saved, NULL) != CONFIG_INVALID) {
+        printf("[CONFIG] Restaurada v%lu: Quente=%.1f°C, Frio=%.1f°C\n",
+               (unsigned long)saved.version, current_config.heater_target,
+               current_config.conservative_target);
+    }
+}
+
+static bool clamp_offset(float *value) {
+    if (*value < -CONFIG_OFFSET_LIMIT || *value > CONFIG_OFFSET_LIMIT) {
+        *value = *value < 0.0f ? -CONFIG_OFFSET_LIMIT : CONFIG_OFFSET_LIMIT;
+        return true;
+    }
+    return false;
+}
+
+// Limitar à faixa; 0.0 continua significando "desabilitada"
+static bool clamp_target(float *value, float min, float max) {
+    if (*value == 0.0f) {
+        return false;
+    }
+    if (*value < min) {
+        *value = min;
+        return true;
+    }
+    if (*value > max) {
+        *value = max;
+        return true;
+    }
+    return false;
+}
+
+config_result_t config_store_update(const ibag_config_t *proposed, ibag_config_t *applied) {
+    ibag_config_t next = *proposed;
+
+    if (!isfinite(next.heater_target) || !isfinite(next.conservative_target) ||
+        !isfinite(next.heater_offset) || !isfinite(next.conservative_offset)) {
+        return CONFIG_INVALID;
+    }
+
+    bool clamped = clamp_target(&next.heater_target, CONFIG_HEATER_MIN, CONFIG_HEATER_MAX);
+    clamped |= clamp_target(&next.conservative_target, CONFIG_CONSERVATIVE_MIN, CONFIG_CONSERVATIVE_MAX);
+    clamped |= clamp_offset(&next.heater_offset);
+    clamped |= clamp_offset(&next.conservative_offset);
+
+    // Com as duas zonas ativas, o quente precisa ficar acima do frio
+    if (next.heater_target != 0.0f && next.conservative_target != 0.0f &&
+        next.heater_target <= next.conservative_target) {
+        return CONFIG_INVALID;
+    }
+
+    // Escrita com seqlock: ímpar durante a escrita, par ao publicar
+    uint32_t seq = atomic_load_explicit(&config_seq, memory_order_relaxed);
+    next.version = current_config.version + 1;
+
+    atomic_store_explicit(&config_seq, seq + 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+    current_config = next;
+    atomic_store_explicit(&config_seq, seq + 2, memory_order_release);
+
+    kv_set(KV_KEY_CONFIG, &next, sizeof(next));
+
+    if (applied) {
+        *applied = next;
+    }
+    return clamped ? CONFIG_CLAMPED : CONFIG_OK;
+}
+
+void config_store_read(ibag_config_t *config) {
+    uint32_t before, after = 0;
+    do {
+        before = atomic_load_explicit(&config_seq, memory_order_acquire);
+        if (before & 1) {
+            continue;  // Escrita em andamento
+        }
+        *config = current_config;
+        atomic_thread_fence(memory_order_acquire);
+        after = atomic_load_explicit(&config_seq, memory_order_relaxed);
+    } while ((before & 1) || before != after);
+}
+
+uint32_t config_store_version(void) {
+    ibag_config_t config;
+    config_store_read(&config);
+    return config.version;
+}
+
+const char *config_result_name(config_result_t result) {
+    switch (result) {
+        case CONFIG_OK: return "ok";
+        case CONFIG_CLAMPED: return "clamped";
+        case CONFIG_INVALID: return "invalid";
+    }
+    return "unknown";
+}
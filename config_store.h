@@ -0,0 +1,42 @@
+#ifndef CONFIG_STORE_H
+#define CONFIG_STORE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// Configuração compartilhada entre rede e controle
+// Publicada com seqlock: o escritor (core 0, handlers HTTP) deixa a sequência
+// ímpar enquanto escreve; leitores em qualquer core ou IRQ copiam a struct e
+// repetem se a sequência mudou ou estava ímpar. Todos os campos de uma
+// atualização aparecem juntos - nunca aquecedor novo com conservador antigo.
+// Cada atualização aceita também é enviada ao kv_store (gravação adiada).
+
+// Faixas aceitas (0.0 = zona desabilitada)
+#define CONFIG_HEATER_MIN 20.0f
+#define CONFIG_HEATER_MAX 70.0f
+#define CONFIG_CONSERVATIVE_MIN 2.0f
+#define CONFIG_CONSERVATIVE_MAX 25.0f
+#define CONFIG_OFFSET_LIMIT 5.0f    // Calibração dos LM35: ±5 °C
+
+typedef struct {
+    uint32_t version;            // Incrementa a cada publicação (0 = padrão de fábrica)
+    float heater_target;         // °C
+    float conservative_target;   // °C
+    float heater_offset;         // Correção somada à leitura do LM35 (°C)
+    float conservative_offset;
+} ibag_config_t;
+
+typedef enum {
+    CONFIG_OK = 0,
+    CONFIG_CLAMPED,    // Aplicado, mas algum valor foi limitado à faixa
+    CONFIG_INVALID,    // Rejeitado (NaN, aquecedor abaixo do conservador...)
+} config_result_t;
+
+// Funções públicas
+void config_store_init(void);   // Restaura a última configuração gravada (kv_store)
+config_result_t config_store_update(const ibag_config_t *proposed, ibag_config_t *applied);  // Escritor único
+void config_store_read(ibag_config_t *config);   // Sem locks, qualquer core
+uint32_t config_store_version(void);
+const char *config_result_name(config_result_t result);
+
+#endif // CONFIG_STORE_H
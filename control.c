@@ -0,0 +1,302 @@
+#include "control.h"
+#include <stdio.h>
+#include "pico/stdlib.h"
+#include "hal.h"
+#include "logger.h"
+#include "telemetry.h"
+
+// Filtro EMA das leituras do LM35 (0-1, maior = responde mais rápido)
+#define CONTROL_FILTER_ALPHA 0.3f
+
+// Coordenador: quantas zonas podem ficar ligadas ao mesmo tempo na fonte
+// compartilhada. Com 1, as zonas revezam a energia por prioridade.
+#define CONTROL_MAX_ACTIVE_ZONES 1
+#define CONTROL_MIN_ON_MS 30000       // Tempo mínimo ligado antes de ceder a energia
+#define CONTROL_MAX_HOLD_MS 300000    // Tempo máximo segurando a energia se outra zona espera
+#define CONTROL_AGING_MS 60000        // Cada minuto de espera vale +1 no score
+
+static control_zone_t zones[CONTROL_ZONE_COUNT] = {
+    [CONTROL_ZONE_HEATER] = {
+        .name = "heater",
+        .adc_channel = ADC_HEATER,
+        .relay_pin = HEATER_RELAY_PIN,
+        .heats = true,
+        .priority = 1,
+    },
+    [CONTROL_ZONE_CONSERVATIVE] = {
+        .name = "freezer",
+        .adc_channel = ADC_CONSERVATIVE,
+        .relay_pin = CONSERVATIVE_RELAY_PIN,
+        .heats = false,
+        .priority = 2,  // Segurança alimentar: conservador tem prioridade
+    },
+};
+
+static uint32_t last_update_time = 0;
+static uint32_t adc_samples = 0;   // Leituras do ADC desde o boot (métricas)
+
+// Função para inicializar os relés (um por zona)
+void init_relay(void) {
+    for (int z = 0; z < CONTROL_ZONE_COUNT; z++) {
+        control_zone_t *zone = &zones[z];
+        hal_gpio_init_out(zone->relay_pin, false);  // Desligado inicialmente
+        zone->relay_on = false;
+        zone->off_until = 0;
+        zone->state = ZONE_DISABLED;
+        printf("Relé Peltier %s inicializado (GPIO %d)\n", zone->name, zone->relay_pin);
+    }
+    printf("  - Estado inicial: DESLIGADOS\n\n");
+}
+
+// Função para inicializar o ADC
+void init_adc_sensors(void) {
+    hal_adc_init();
+    hal_adc_init_pin(26);  // GPIO 26 como entrada analógica (ADC0 - FRIO)
+    hal_adc_init_pin(27);  // GPIO 27 como entrada analógica (ADC1 - QUENTE)
+    printf("Sensores LM35 inicializados:\n");
+    printf("  - GPIO 27 (ADC1): Sensor QUENTE\n");
+    printf("  - GPIO 26 (ADC0): Sensor FRIO\n\n");
+}
+
+// Conversão da leitura do LM35 para Celsius
+// LM35: 10mV/°C, ADC: 12-bit (0-4095), Vref: 3.3V
+// Temp (°C) = (ADC_value * 3.3 / 4095) / 0.01
+float lm35_to_celsius(uint16_t adc_value) {
+    float voltage = (adc_value * 3.3f) / 4095.0f;
+    return voltage / 0.01f;  // LM35: 10mV/°C
+}
+
+// Função para ler temperatura do LM35 (retorna em Celsius)
+float read_lm35_temp(uint8_t adc_channel) {
+    uint16_t adc_value = hal_adc_read(adc_channel);
+    adc_samples++;
+    telemetry_adc(adc_channel, adc_value);
+    return lm35_to_celsius(adc_value);
+}
+
+uint32_t control_adc_samples(void) {
+    return adc_samples;
+}
+
+void control_set_targets(float heater, float conservative) {
+    zones[CONTROL_ZONE_HEATER].target = heater;
+    zones[CONTROL_ZONE_CONSERVATIVE].target = conservative;
+}
+
+void control_set_offsets(float heater, float conservative) {
+    zones[CONTROL_ZONE_HEATER].offset = heater;
+    zones[CONTROL_ZONE_CONSERVATIVE].offset = conservative;
+}
+
+static void zone_set_relay(control_zone_t *zone, bool on, uint32_t now_ms) {
+    if (zone->relay_on == on) {
+        return;
+    }
+    zone->relay_on = on;
+    hal_gpio_put(zone->relay_pin, on);
+    telemetry_relay((uint8_t)(zone - zones), on);
+    if (on) {
+        zone->on_since = now_ms;
+        zone->stats.actuations++;
+    }
+}
+
+// Erro positivo = a zona precisa de energia para se aproximar do alvo
+static float zone_error(const control_zone_t *zone) {
+    return zone->heats ? zone->target - zone->filtered : zone->filtered - zone->target;
+}
+
+static void zone_sample(control_zone_t *zone) {
+    zone->raw = read_lm35_temp(zone->adc_channel) + zone->offset;
+    if (!zone->filter_ready) {
+        zone->filtered = zone->raw;
+        zone->stats.min_temp = zone->raw;
+        zone->stats.max_temp = zone->raw;
+        zone->filter_ready = true;
+    } else {
+        zone->filtered += CONTROL_FILTER_ALPHA * (zone->raw - zone->filtered);
+    }
+    if (zone->filtered < zone->stats.min_temp) zone->stats.min_temp = zone->filtered;
+    if (zone->filtered > zone->stats.max_temp) zone->stats.max_temp = zone->filtered;
+}
+
+// Máquina de estados local da zona: decide se ela tem demanda, sem olhar as outras
+static void zone_evaluate(int index, control_zone_t *zone, uint32_t now_ms) {
+    const controller_params_t *params = autotune_get_params((autotune_zone_t)index);
+    float band = params->hysteresis_c;
+
+    // Autotune assume o relé desta zona
+    if (autotune_is_running() && autotune_get_zone() == (autotune_zone_t)index) {
+        zone->state = ZONE_AUTOTUNE;
+        zone_set_relay(zone, autotune_update(zone->filtered, now_ms), now_ms);
+        return;
+    }
+    if (zone->state == ZONE_AUTOTUNE) {
+        // Ensaio terminou: voltar ao controle normal sem espera
+        zone_set_relay(zone, false, now_ms);
+        zone->off_until = 0;
+        zone->state = ZONE_IDLE;
+    }
+
+    if (zone->target == 0.0f) {
+        if (zone->state != ZONE_DISABLED) {
+            zone_set_relay(zone, false, now_ms);
+            LOG_I(LOG_MOD_CTRL, "Zona %s desabilitada (alvo 0.0°C)", zone->name);
+        }
+        zone->state = ZONE_DISABLED;
+        return;
+    }
+
+    float error = zone_error(zone);
+
+    if (zone->relay_on) {
+        // Ligado até cruzar o alvo; a inércia térmica completa a banda
+        if (error <= 0.0f) {
+            zone_set_relay(zone, false, now_ms);
+            zone->off_until = now_ms + params->min_off_ms;
+            zone->state = ZONE_LOCKOUT;
+            LOG_I(LOG_MOD_CTRL, "Meta atingida (%s): relé desligado por %lu ms, %.1f°C (alvo %.1f°C)",
+                  zone->name, (unsigned long)params->min_off_ms, zone->filtered, zone->target);
+        } else {
+            zone->state = ZONE_ACTIVE;
+        }
+        return;
+    }
+
+    if (zone->state == ZONE_LOCKOUT && (int32_t)(now_ms - zone->off_until) < 0) {
+        return;
+    }
+
+    if (error > band) {
+        if (zone->state != ZONE_WAITING) {
+            zone->waiting_since = now_ms;
+        }
+        zone->state = ZONE_WAITING;
+    } else {
+        zone->state = ZONE_IDLE;
+    }
+}
+
+// Score de arbitragem: prioridade x erro normalizado pela banda + envelhecimento
+static float zone_score(int index, const control_zone_t *zone, uint32_t now_ms) {
+    const controller_params_t *params = autotune_get_params((autotune_zone_t)index);
+    float normalized = zone_error(zone) / params->hysteresis_c;
+    float aging = (zone->state == ZONE_WAITING) ?
+                  (float)(now_ms - zone->waiting_since) / CONTROL_AGING_MS : 0.0f;
+    return zone->priority * normalized + aging;
+}
+
+// Coordenador: distribui o orçamento de energia entre as zonas
+static void control_arbitrate(uint32_t now_ms) {
+    int budget = CONTROL_MAX_ACTIVE_ZONES;
+    bool anyone_waiting = false;
+
+    for (int z = 0; z < CONTROL_ZONE_COUNT; z++) {
+        if (zones[z].state == ZONE_AUTOTUNE && zones[z].relay_on) budget--;
+        if (zones[z].state == ZONE_WAITING) anyone_waiting = true;
+    }
+
+    // Zonas ativas mantêm a energia, exceto se seguraram demais com alguém esperando
+    for (int z = 0; z < CONTROL_ZONE_COUNT; z++) {
+        control_zone_t *zone = &zones[z];
+        if (zone->state != ZONE_ACTIVE) continue;
+
+        uint32_t held = now_ms - zone->on_since;
+        bool preempt = budget <= 0 ||
+                       (anyone_waiting && held >= CONTROL_MAX_HOLD_MS);
+        if (preempt && held >= CONTROL_MIN_ON_MS) {
+            zone_set_relay(zone, false, now_ms);
+            zone->state = ZONE_WAITING;
+            zone->waiting_since = now_ms;
+            zone->stats.preemptions++;
+            LOG_I(LOG_MOD_CTRL, "Zona %s cedeu a energia após %lu s", zone->name, (unsigned long)(held / 1000));
+        } else {
+            budget--;
+        }
+    }
+
+    // Distribuir o que sobrou para as zonas em espera, maior score primeiro
+    while (budget > 0) {
+        int best = -1;
+        float best_score = 0.0f;
+        for (int z = 0; z < CONTROL_ZONE_COUNT; z++) {
+            if (zones[z].state != ZONE_WAITING) continue;
+            float score = zone_score(z, &zones[z], now_ms);
+            if (best < 0 || score > best_score) {
+                best = z;
+                best_score = score;
+            }
+        }
+        if (best < 0) break;
+
+        control_zone_t *zone = &zones[best];
+        zone_set_relay(zone, true, now_ms);
+        zone->state = ZONE_ACTIVE;
+        budget--;
+        LOG_I(LOG_MOD_CTRL, "Relé %s ligado: %.1f°C (alvo %.1f°C, score %.2f)",
+              zone->name, zone->filtered, zone->target, best_score);
+    }
+}
+
+static void control_update_stats(uint32_t dt_ms) {
+    for (int z = 0; z < CONTROL_ZONE_COUNT; z++) {
+        control_zone_t *zone = &zones[z];
+        const controller_params_t *params = autotune_get_params((autotune_zone_t)z);
+
+        if (zone->relay_on) zone->stats.on_time_ms += dt_ms;
+        if (zone->state == ZONE_WAITING) zone->stats.wait_time_ms += dt_ms;
+        if (zone->state != ZONE_DISABLED &&
+            zone->filtered >= zone->target - params->hysteresis_c &&
+            zone->filtered <= zone->target + params->hysteresis_c) {
+            zone->stats.on_target_ms += dt_ms;
+        }
+    }
+}
+
+// Função para controlar os relés baseado nas temperaturas
+void control_update(uint32_t now_ms) {
+    // LOG: Mostrar valores atuais das temperaturas alvo
+    static uint8_t log_counter = 0;
+    if (log_counter++ % 10 == 0) {  // Log a cada 10 chamadas (~20s)
+        LOG_D(LOG_MOD_CTRL, "Alvos: Quente=%.1f°C, Frio=%.1f°C",
+              zones[CONTROL_ZONE_HEATER].target, zones[CONTROL_ZONE_CONSERVATIVE].target);
+    }
+
+    uint32_t dt_ms = last_update_time ? now_ms - last_update_time : 0;
+    last_update_time = now_ms;
+
+    for (int z = 0; z < CONTROL_ZONE_COUNT; z++) {
+        zone_sample(&zones[z]);
+    }
+    control_update_stats(dt_ms);
+    for (int z = 0; z < CONTROL_ZONE_COUNT; z++) {
+        zone_evaluate(z, &zones[z], now_ms);
+    }
+    control_arbitrate(now_ms);
+}
+
+const control_zone_t *control_get_zone(int zone) {
+    if (zone < 0 || zone >= CONTROL_ZONE_COUNT) {
+        return NULL;
+    }
+    return &zones[zone];
+}
+
+bool control_any_relay_on(void) {
+    for (int z = 0; z < CONTROL_ZONE_COUNT; z++) {
+        if (zones[z].relay_on) return true;
+    }
+    return false;
+}
+
+const char *control_zone_state_name(zone_state_t state) {
+    switch (state) {
+        case ZONE_DISABLED: return "disabled";
+        case ZONE_IDLE: return "idle";
+        case ZONE_WAITING: return "waiting";
+        case ZONE_ACTIVE: return "active";
+        case ZONE_LOCKOUT: return "lockout";
+        case ZONE_AUTOTUNE: return "autotune";
+    }
+    return "unknown";
+}
@@ -0,0 +1,84 @@
+#ifndef CONTROL_H
+#define CONTROL_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "autotune.h"
+
+// Controle térmico por zona
+// Cada compartimento tem sensor, filtro, relé (GPIO próprio), estado e
+// estatísticas independentes. Um coordenador decide quais zonas com demanda
+// recebem energia, respeitando o orçamento da fonte compartilhada.
+
+// Configurações dos sensores LM35
+// GPIO 27 = ADC1 (QUENTE), GPIO 26 = ADC0 (FRIO)
+#define ADC_HEATER 0    // ADC1 - GPIO 27 (sensor quente)
+#define ADC_CONSERVATIVE 1   // ADC0 - GPIO 26 (sensor frio)
+
+// Relés (um por zona)
+#define HEATER_RELAY_PIN 15        // GPIO 15 - Peltier do aquecedor
+#define CONSERVATIVE_RELAY_PIN 14  // GPIO 14 - Peltier do conservador
+
+// Índices das zonas (mesmos valores do autotune)
+#define CONTROL_ZONE_HEATER AUTOTUNE_ZONE_HEATER
+#define CONTROL_ZONE_CONSERVATIVE AUTOTUNE_ZONE_CONSERVATIVE
+#define CONTROL_ZONE_COUNT AUTOTUNE_ZONE_COUNT
+
+typedef enum {
+    ZONE_DISABLED = 0,  // Alvo em 0.0 - zona desligada
+    ZONE_IDLE,          // Dentro da banda, sem demanda
+    ZONE_WAITING,       // Com demanda, aguardando energia do coordenador
+    ZONE_ACTIVE,        // Relé ligado
+    ZONE_LOCKOUT,       // Meta atingida, em tempo mínimo desligado
+    ZONE_AUTOTUNE,      // Relé sob controle do autotune
+} zone_state_t;
+
+// Estatísticas acumuladas de uma zona
+typedef struct {
+    uint32_t actuations;       // Quantas vezes o relé ligou
+    uint32_t on_time_ms;       // Tempo total com relé ligado
+    uint32_t wait_time_ms;     // Tempo com demanda sem receber energia
+    uint32_t on_target_ms;     // Tempo dentro da banda
+    uint32_t preemptions;      // Vezes que perdeu a energia para outra zona
+    float min_temp;
+    float max_temp;
+} zone_stats_t;
+
+typedef struct {
+    const char *name;
+    uint8_t adc_channel;
+    uint8_t relay_pin;
+    bool heats;                // true: relé liga = esquenta; false: relé liga = esfria
+    uint8_t priority;          // Peso na arbitragem (maior = mais prioritário)
+    float target;              // Setpoint (°C), 0.0 = desabilitada
+    float offset;              // Calibração do sensor somada à leitura (°C)
+
+    // Filtro (média móvel exponencial)
+    float raw;
+    float filtered;
+    bool filter_ready;
+
+    // Estado
+    zone_state_t state;
+    bool relay_on;
+    uint32_t on_since;         // Quando o relé ligou
+    uint32_t off_until;        // Fim do tempo mínimo desligado
+    uint32_t waiting_since;    // Início da espera por energia
+
+    zone_stats_t stats;
+} control_zone_t;
+
+// Funções públicas
+void init_adc_sensors(void);
+void init_relay(void);
+float read_lm35_temp(uint8_t adc_channel);
+float lm35_to_celsius(uint16_t adc_value);   // Só a conversão (sem ler o ADC)
+uint32_t control_adc_samples(void);
+void control_set_targets(float heater, float conservative);
+void control_set_offsets(float heater, float conservative);
+void control_update(uint32_t now_ms);  // Amostrar, filtrar, arbitrar e acionar
+const control_zone_t *control_get_zone(int zone);
+bool control_any_relay_on(void);
+const char *control_zone_state_name(zone_state_t state);
+
+#endif // CONTROL_H
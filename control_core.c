@@ -0,0 +1,189 @@
+#include "control_core.h"
+#include <string.h>
+#include "pico/stdlib.h"
+#include "pico/multicore.h"
+#include "pico/flash.h"
+#include "mpu6050.h"
+#include "autotune.h"
+#include "control.h"
+#include "scheduler.h"
+#include "ipc.h"
+#include "config_store.h"
+#include "power.h"
+#include "boot.h"
+#include "logger.h"
+#include "prof.h"
+#include "supervisor.h"
+#include "telemetry.h"
+#include "hal.h"
+
+// Períodos das tarefas do core 1
+#define CONTROL_PERIOD_MS 2000
+#define AUTOTUNE_PERIOD_MS 250
+
+static scheduler_t core1_scheduler;
+static int control_task_id = -1;
+static bool shaken = false;
+static uint32_t applied_config_version = 0;
+static bool motion_wake_armed = false;
+
+// Tarefa: finalizar calibração do MPU6050 quando o tempo acabar
+static void task_mpu_calibration(void *ctx) {
+    PROF_SCOPE("mpu_calib");
+    mpu6050_update_calibration();
+}
+
+// Tarefa: verificar shake do MPU6050 (a cada 100ms)
+static void task_shake(void *ctx) {
+    PROF_SCOPE("mpu_shake");
+    shaken = mpu6050_detect_shake();
+}
+
+// Tarefa: controlar os relés a cada 2 segundos (reduzir carga)
+// Durante o autotune, a cada 250ms para medir os picos com precisão
+static void task_control(void *ctx) {
+    PROF_SCOPE("control");
+    // Snapshot consistente dos alvos (seqlock, sem lock)
+    ibag_config_t config;
+    config_store_read(&config);
+    if (config.version != applied_config_version) {
+        LOG_I(LOG_MOD_CTRL, "Configuração v%lu: Quente=%.1f°C, Frio=%.1f°C",
+              (unsigned long)config.version, config.heater_target, config.conservative_target);
+        applied_config_version = config.version;
+    }
+    control_set_targets(config.heater_target, config.conservative_target);
+    control_set_offsets(config.heater_offset, config.conservative_offset);
+
+    uint32_t now_ms = hal_time_ms();
+    control_update(now_ms);
+
+    const control_zone_t *hz = control_get_zone(CONTROL_ZONE_HEATER);
+    const control_zone_t *cz = control_get_zone(CONTROL_ZONE_CONSERVATIVE);
+    ipc_sample_t sample = {
+        .time_ms = now_ms,
+        .heater = hz->filtered,
+        .conservative = cz->filtered,
+        .relays = (hz->relay_on ? 1 : 0) | (cz->relay_on ? 2 : 0),
+        .shaken = shaken,
+    };
+    ipc_push_sample(&sample);  // Fila cheia: amostra descartada e contada
+
+    uint32_t period_ms = autotune_is_running() ? AUTOTUNE_PERIOD_MS : CONTROL_PERIOD_MS;
+    sched_set_period(&core1_scheduler, control_task_id, period_ms * 1000);
+}
+
+// Retorna true se algum comando foi processado
+static bool handle_commands(void) {
+    ipc_cmd_t cmd;
+    bool handled = false;
+    while (ipc_receive_command(&cmd)) {
+        handled = true;
+        switch (cmd.type) {
+            case IPC_CMD_RESET_SHAKE:
+                mpu6050_reset_shake_detection();
+                shaken = false;
+                break;
+            case IPC_CMD_AUTOTUNE_START:
+                autotune_start((autotune_zone_t)cmd.zone, cmd.setpoint,
+                               hal_time_ms());
+                // Amostrar já no período do autotune
+                sched_set_period(&core1_scheduler, control_task_id, AUTOTUNE_PERIOD_MS * 1000);
+                break;
+            case IPC_CMD_AUTOTUNE_CANCEL:
+                autotune_cancel();
+                break;
+            case IPC_CMD_MOTION_WAKE_ARM:
+                motion_wake_armed = mpu6050_set_motion_wake(true);
+                break;
+            case IPC_CMD_MOTION_WAKE_DISARM:
+                mpu6050_set_motion_wake(false);
+                motion_wake_armed = false;
+                break;
+        }
+    }
+    return handled;
+}
+
+// Tempo de cada execução do core 1 na telemetria (uma por execução nova)
+static void report_timing(void) {
+    static uint32_t reported_runs[SCHED_MAX_TASKS];
+    for (int i = 0; i < core1_scheduler.count; i++) {
+        const sched_task_t *task = &core1_scheduler.tasks[i];
+        if (task->runs != reported_runs[i]) {
+            reported_runs[i] = task->runs;
+            telemetry_timing((uint8_t)i, task->last_exec_us, task->last_jitter_us);
+        }
+    }
+}
+
+static void publish_snapshot(void) {
+    static ipc_snapshot_t snapshot;
+
+    snapshot.time_ms = hal_time_ms();
+    snapshot.valid = true;
+    snapshot.shaken = shaken;
+    snapshot.config_version = applied_config_version;
+    for (int z = 0; z < CONTROL_ZONE_COUNT; z++) {
+        snapshot.zones[z] = *control_get_zone(z);
+        snapshot.params[z] = *autotune_get_params((autotune_zone_t)z);
+    }
+    autotune_get_status(&snapshot.autotune);
+    snapshot.task_count = core1_scheduler.count;
+    memcpy(snapshot.tasks, core1_scheduler.tasks, sizeof(snapshot.tasks));
+    snapshot.power = *power_get_stats();
+    snapshot.motion_wake_armed = motion_wake_armed;
+    mpu6050_get_i2c_stats(&snapshot.i2c);
+    snapshot.adc_samples = control_adc_samples();
+    snapshot.vibration_mg = mpu6050_vibration_mg();
+    snapshot.shake_events = mpu6050_shake_count();
+
+    ipc_publish_snapshot(&snapshot);
+}
+
+static void core1_main(void) {
+    prof_core_init();   // DWT próprio deste core
+    // Permitir que o core 0 pause este core durante gravações na flash
+    flash_safe_execute_core_init();
+
+    // O MPU6050 inicializa aqui, em paralelo com o Wi-Fi no core 0. Começa com
+    // o baseline gravado e refina a calibração em segundo plano.
+    bool imu_ok = mpu6050_init();
+    if (imu_ok) {
+        mpu6050_restore_calibration();
+        mpu6050_start_background_calibration();
+    } else {
+        LOG_E(LOG_MOD_CTRL, "Falha ao inicializar MPU6050! Verifique as conexões I2C (SDA=GPIO20, SCL=GPIO21)");
+    }
+    boot_mark("imu");
+
+    sched_init(&core1_scheduler);
+    if (imu_ok) {
+        sched_add(&core1_scheduler, "mpu_calib", task_mpu_calibration, NULL, 100 * 1000, 2000, 0);
+        sched_add(&core1_scheduler, "shake", task_shake, NULL, 100 * 1000, 2000, 50 * 1000);
+    }
+    control_task_id = sched_add(&core1_scheduler, "control", task_control, NULL,
+                                CONTROL_PERIOD_MS * 1000, 5000, 0);
+
+    LOG_I(LOG_MOD_CTRL, "✅ Core 1: sensores e controle ativos");
+
+    while (true) {
+        bool handled = handle_commands();
+
+        int ran = sched_run(&core1_scheduler);
+        if (ran > 0) {
+            report_timing();
+        }
+        if (ran > 0 || handled) {
+            publish_snapshot();
+        }
+        supervisor_poll();   // Vigia também as tarefas do core 0
+
+        // Dormir até o próximo deadline; ipc_send_command acorda com __sev()
+        power_idle_until(sched_next_deadline(&core1_scheduler));
+    }
+}
+
+void control_core_launch(void) {
+    ipc_init();
+    multicore_launch_core1(core1_main);
+}
@@ -0,0 +1,11 @@
+#ifndef CONTROL_CORE_H
+#define CONTROL_CORE_H
+
+// Core 1: amostragem dos LM35, detecção de shake (MPU6050 via I2C),
+// autotune e controle dos relés, com escalonador próprio. O core 0 fica só
+// com cyw43/lwIP e conversa com este core pelas filas de ipc.h.
+
+// Funções públicas
+void control_core_launch(void);  // Chamar no core 0 após inicializar os periféricos
+
+#endif // CONTROL_CORE_H
@@ -0,0 +1,225 @@
+#include "dhcp_leases.h"
+#include <string.h>
+
+#define OWNER_NONE 0xFF
+#define LEASE_MASK (DHCP_LEASE_SLOTS - 1)
+
+_Static_assert((DHCP_LEASE_SLOTS & LEASE_MASK) == 0, "DHCP_LEASE_SLOTS deve ser potência de 2");
+_Static_assert(DHCP_LEASE_SLOTS < OWNER_NONE, "índice da lease precisa caber em uint8_t");
+
+static dhcp_lease_t leases[DHCP_LEASE_SLOTS];
+static uint8_t host_owner[256];           // Lease dona de cada endereço (OWNER_NONE = livre)
+static uint32_t quarantine_until[256];    // Endereços recusados via DECLINE (0 = nenhum)
+static uint8_t next_host = DHCP_POOL_FIRST;
+
+// true se o instante ainda não chegou (tolerante ao estouro do contador em ms)
+static bool time_before(uint32_t now_ms, uint32_t deadline_ms) {
+    return (int32_t)(deadline_ms - now_ms) > 0;
+}
+
+// FNV-1a sobre os 6 bytes do MAC
+static uint32_t mac_hash(const uint8_t mac[6]) {
+    uint32_t h = 2166136261u;
+    for (int i = 0; i < 6; i++) {
+        h = (h ^ mac[i]) * 16777619u;
+    }
+    return h;
+}
+
+void dhcp_leases_init(void) {
+    memset(leases, 0, sizeof(leases));
+    memset(host_owner, OWNER_NONE, sizeof(host_owner));
+    memset(quarantine_until, 0, sizeof(quarantine_until));
+    next_host = DHCP_POOL_FIRST;
+}
+
+bool dhcp_lease_active(const dhcp_lease_t *lease, uint32_t now_ms) {
+    return (lease->state == DHCP_LEASE_OFFERED || lease->state == DHCP_LEASE_BOUND) &&
+           time_before(now_ms, lease->expires_ms);
+}
+
+// Slot do MAC, ou -1. Entradas nunca voltam a UNUSED, então a sondagem
+// pode parar na primeira UNUSED
+static int lease_find(const uint8_t mac[6]) {
+    uint32_t start = mac_hash(mac);
+    for (uint32_t n = 0; n < DHCP_LEASE_SLOTS; n++) {
+        int slot = (int)((start + n) & LEASE_MASK);
+        if (leases[slot].state == DHCP_LEASE_UNUSED) {
+            return -1;
+        }
+        if (memcmp(leases[slot].mac, mac, 6) == 0) {
+            return slot;
+        }
+    }
+    return -1;
+}
+
+static void lease_drop_host(int slot) {
+    uint8_t host = leases[slot].host;
+    if (host != 0 && host_owner[host] == slot) {
+        host_owner[host] = OWNER_NONE;
+    }
+}
+
+static int lease_insert(const uint8_t mac[6], uint32_t now_ms) {
+    uint32_t start = mac_hash(mac);
+    int slot = -1;
+    for (uint32_t n = 0; n < DHCP_LEASE_SLOTS && slot < 0; n++) {
+        int candidate = (int)((start + n) & LEASE_MASK);
+        if (leases[candidate].state == DHCP_LEASE_UNUSED) {
+            slot = candidate;
+        }
+    }
+    if (slot < 0) {
+        // Sem entradas UNUSED (a busca já percorre a tabela toda): reaproveitar
+        // um cliente sem lease ativa
+        for (int candidate = 0; candidate < DHCP_LEASE_SLOTS && slot < 0; candidate++) {
+            if (!dhcp_lease_active(&leases[candidate], now_ms)) {
+                lease_drop_host(candidate);
+                slot = candidate;
+            }
+        }
+        if (slot < 0) {
+            return -1;
+        }
+    }
+    memcpy(leases[slot].mac, mac, 6);
+    leases[slot].host = 0;
+    leases[slot].state = DHCP_LEASE_FREE;
+    leases[slot].expires_ms = now_ms;
+    return slot;
+}
+
+// Endereço pode ser entregue a este slot? Leases vencidas são liberadas aqui
+static bool host_available(uint8_t host, int slot, uint32_t now_ms) {
+    if (host < DHCP_POOL_FIRST || host > DHCP_POOL_LAST) {
+        return false;
+    }
+    if (quarantine_until[host] != 0) {
+        if (time_before(now_ms, quarantine_until[host])) {
+            return false;
+        }
+        quarantine_until[host] = 0;
+    }
+    uint8_t owner = host_owner[host];
+    if (owner == OWNER_NONE || owner == slot) {
+        return true;
+    }
+    if (leases[owner].host != host || !dhcp_lease_active(&leases[owner], now_ms)) {
+        host_owner[host] = OWNER_NONE;
+        return true;
+    }
+    return false;
+}
+
+static void lease_assign(int slot, uint8_t host) {
+    if (leases[slot].host != host) {
+        lease_drop_host(slot);
+    }
+    leases[slot].host = host;
+    host_owner[host] = (uint8_t)slot;
+}
+
+uint8_t dhcp_lease_offer(const uint8_t mac[6], uint8_t requested, uint32_t now_ms) {
+    int slot = lease_find(mac);
+    if (slot < 0) {
+        slot = lease_insert(mac, now_ms);
+        if (slot < 0) {
+            return 0;
+        }
+    }
+    dhcp_lease_t *lease = &leases[slot];
+
+    // Preferência: endereço anterior do cliente, depois a opção 50, depois o pool
+    uint8_t host = 0;
+    if (lease->host != 0 && host_available(lease->host, slot, now_ms)) {
+        host = lease->host;
+    } else if (requested != 0 && host_available(requested, slot, now_ms)) {
+        host = requested;
+    } else {
+        for (int n = 0; n <= DHCP_POOL_LAST - DHCP_POOL_FIRST && host == 0; n++) {
+            uint8_t candidate = next_host;
+            next_host = (next_host >= DHCP_POOL_LAST) ? DHCP_POOL_FIRST : next_host + 1;
+            if (host_available(candidate, slot, now_ms)) {
+                host = candidate;
+            }
+        }
+        if (host == 0) {
+            return 0;
+        }
+    }
+
+    lease_assign(slot, host);
+    lease->state = DHCP_LEASE_OFFERED;
+    lease->expires_ms = now_ms + DHCP_OFFER_TIMEOUT_MS;
+    return host;
+}
+
+bool dhcp_lease_commit(const uint8_t mac[6], uint8_t host, uint32_t now_ms) {
+    int slot = lease_find(mac);
+    if (slot < 0) {
+        // INIT-REBOOT de um cliente que não conhecemos (ex.: após reboot do Pico)
+        slot = lease_insert(mac, now_ms);
+        if (slot < 0) {
+            return false;
+        }
+    }
+    if (!host_available(host, slot, now_ms)) {
+        return false;
+    }
+
+    lease_assign(slot, host);
+    if (leases[slot].state != DHCP_LEASE_BOUND) {
+        // Nova associação (renovações não contam)
+        leases[slot].bound_ms = now_ms;
+        leases[slot].page_served = false;
+    }
+    leases[slot].state = DHCP_LEASE_BOUND;
+    leases[slot].expires_ms = now_ms + DHCP_LEASE_TIME_S * 1000u;
+    return true;
+}
+
+void dhcp_lease_release(const uint8_t mac[6], uint8_t host) {
+    int slot = lease_find(mac);
+    if (slot < 0 || leases[slot].host != host) {
+        return;
+    }
+    // O cliente continua conhecido e recebe o mesmo endereço se voltar
+    lease_drop_host(slot);
+    leases[slot].state = DHCP_LEASE_FREE;
+}
+
+void dhcp_lease_decline(const uint8_t mac[6], uint8_t host, uint32_t now_ms) {
+    if (host < DHCP_POOL_FIRST || host > DHCP_POOL_LAST) {
+        return;
+    }
+    uint32_t until = now_ms + DHCP_DECLINE_QUARANTINE_MS;
+    quarantine_until[host] = until ? until : 1;
+
+    int slot = lease_find(mac);
+    if (slot >= 0 && leases[slot].host == host) {
+        lease_drop_host(slot);
+        leases[slot].host = 0;
+        leases[slot].state = DHCP_LEASE_FREE;
+    }
+}
+
+bool dhcp_lease_first_page(uint8_t host, uint32_t now_ms, uint32_t *join_ms) {
+    if (host < DHCP_POOL_FIRST || host > DHCP_POOL_LAST || host_owner[host] == OWNER_NONE) {
+        return false;
+    }
+    dhcp_lease_t *lease = &leases[host_owner[host]];
+    if (lease->state != DHCP_LEASE_BOUND || lease->host != host || lease->page_served) {
+        return false;
+    }
+    lease->page_served = true;
+    *join_ms = now_ms - lease->bound_ms;
+    return true;
+}
+
+const dhcp_lease_t *dhcp_lease_slot(int index) {
+    if (index < 0 || index >= DHCP_LEASE_SLOTS) {
+        return NULL;
+    }
+    return &leases[index];
+}
@@ -0,0 +1,46 @@
+#ifndef DHCP_LEASES_H
+#define DHCP_LEASES_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// Tabela de leases do servidor DHCP
+// Tamanho fixo, endereçada por hash do MAC (sondagem linear), sem alocação.
+// Toda operação visita no máximo DHCP_LEASE_SLOTS entradas e, para escolher
+// um endereço livre, no máximo o pool inteiro - tempo limitado por pacote.
+// Os endereços são só o último octeto de 192.168.4.x.
+
+#define DHCP_POOL_FIRST 2
+#define DHCP_POOL_LAST 254
+#define DHCP_LEASE_SLOTS 32              // Potência de 2
+#define DHCP_LEASE_TIME_S 3600           // Enviado na opção 51
+#define DHCP_OFFER_TIMEOUT_MS 30000      // OFFER sem REQUEST volta para o pool
+#define DHCP_DECLINE_QUARANTINE_MS (10u * 60u * 1000u)  // Endereço recusado (conflito ARP)
+
+typedef enum {
+    DHCP_LEASE_UNUSED = 0,   // Nunca usada (fim da sondagem)
+    DHCP_LEASE_FREE,         // Cliente conhecido sem endereço válido (expirou/liberou)
+    DHCP_LEASE_OFFERED,
+    DHCP_LEASE_BOUND,
+} dhcp_lease_state_t;
+
+typedef struct {
+    uint8_t mac[6];
+    uint8_t host;            // Último octeto; 0 = nenhum
+    uint8_t state;           // dhcp_lease_state_t
+    bool page_served;        // Já carregou a interface desde o último bind
+    uint32_t expires_ms;
+    uint32_t bound_ms;       // ACK que iniciou a associação atual
+} dhcp_lease_t;
+
+// Funções públicas
+void dhcp_leases_init(void);
+uint8_t dhcp_lease_offer(const uint8_t mac[6], uint8_t requested, uint32_t now_ms);   // 0 = pool esgotado
+bool dhcp_lease_commit(const uint8_t mac[6], uint8_t host, uint32_t now_ms);           // false = NAK
+void dhcp_lease_release(const uint8_t mac[6], uint8_t host);
+void dhcp_lease_decline(const uint8_t mac[6], uint8_t host, uint32_t now_ms);
+bool dhcp_lease_active(const dhcp_lease_t *lease, uint32_t now_ms);
+bool dhcp_lease_first_page(uint8_t host, uint32_t now_ms, uint32_t *join_ms);       // Só a 1ª página após o bind
+const dhcp_lease_t *dhcp_lease_slot(int index);   // Para listar (0..DHCP_LEASE_SLOTS-1)
+
+#endif // DHCP_LEASES_H
@@ -4,13 +4,29 @@
 #include "lwip/udp.h"
 #include "lwip/ip_addr.h"
 #include "lwip/inet.h"
+#include "pico/stdlib.h"
+#include "dhcp_leases.h"
+#include "captive_portal.h"
+#include "logger.h"
+#include "prof.h"
+#include "hal.h"
 
 #define DHCP_SERVER_PORT 67
 #define DHCP_CLIENT_PORT 68
 #define DHCP_MAGIC_COOKIE 0x63825363
 
-// Pool de IPs para distribuir
-static uint8_t next_ip = 2; // Começa em 192.168.4.2
+// Tipos de mensagem DHCP (opção 53)
+#define DHCP_DISCOVER 1
+#define DHCP_OFFER    2
+#define DHCP_REQUEST  3
+#define DHCP_DECLINE  4
+#define DHCP_ACK      5
+#define DHCP_NAK      6
+#define DHCP_RELEASE  7
+#define DHCP_INFORM   8
+
+#define DHCP_SERVER_IP 0xC0A80401  // 192.168.4.1
+#define DHCP_HEADER_LEN 240        // Cabeçalho fixo + magic cookie
 
 struct dhcp_msg {
     uint8_t op;
@@ -31,134 +47,255 @@ struct dhcp_msg {
     uint8_t options[308];
 };
 
-static void dhcp_recv(void *arg, struct udp_pcb *pcb, struct pbuf *p, const ip_addr_t *addr, u16_t port) {
-    printf("\n>>> DHCP REQUEST RECEBIDO! <<<\n");
-    printf("De: %s:%d\n", ipaddr_ntoa(addr), port);
-    printf("Tamanho do pacote: %d bytes (esperado >= 240)\n", p->tot_len);
-    
-    if (p->tot_len < 240) {  // Tamanho mínimo DHCP
-        printf("Pacote DHCP muito pequeno (recebido: %d)\n", p->tot_len);
-        pbuf_free(p);
-        return;
+// Offsets dos campos fixos BOOTP (RFC 2131)
+#define OFF_OP      0
+#define OFF_HTYPE   1
+#define OFF_HLEN    2
+#define OFF_XID     4
+#define OFF_FLAGS   10
+#define OFF_CIADDR  12
+#define OFF_GIADDR  24
+#define OFF_CHADDR  28
+#define OFF_COOKIE  236
+
+// Iterador TLV sobre as opções, sem copiar o pacote
+typedef struct {
+    const struct pbuf *p;
+    u16_t pos;
+} dhcp_opt_iter_t;
+
+// Próxima opção; false no End, no fim do pacote ou numa opção truncada
+static bool opt_next(dhcp_opt_iter_t *it, uint8_t *code, uint8_t *len, u16_t *value_off) {
+    for (;;) {
+        int c = pbuf_try_get_at(it->p, it->pos);
+        if (c < 0 || c == 255) return false;     // Fim do pacote / End
+        if (c == 0) { it->pos++; continue; }     // Pad
+        int l = pbuf_try_get_at(it->p, (u16_t)(it->pos + 1));
+        if (l < 0 || (uint32_t)it->pos + 2 + (uint32_t)l > it->p->tot_len) return false;
+        *code = (uint8_t)c;
+        *len = (uint8_t)l;
+        *value_off = (u16_t)(it->pos + 2);
+        it->pos = (u16_t)(it->pos + 2 + l);
+        return true;
     }
+}
+
+static uint32_t read_ip(const struct pbuf *p, u16_t off) {
+    uint32_t v = 0;
+    pbuf_copy_partial(p, &v, 4, off);
+    return ntohl(v);
+}
+
+// Validar e extrair o pedido; false descarta o pacote
+bool dhcp_server_parse(const struct pbuf *p, dhcp_request_t *req) {
+    if (p->tot_len < DHCP_HEADER_LEN) return false;
+    if (pbuf_get_at(p, OFF_OP) != 1) return false;  // BOOTREQUEST
+    if (read_ip(p, OFF_COOKIE) != DHCP_MAGIC_COOKIE) return false;
     
-    // Copiar dados do pbuf para buffer contínuo
-    static uint8_t dhcp_buffer[512];
-    pbuf_copy_partial(p, dhcp_buffer, p->tot_len, 0);
-    struct dhcp_msg *request = (struct dhcp_msg *)dhcp_buffer;
-    
-    printf("XID: 0x%08x\n", request->xid);
-    printf("MAC: %02x:%02x:%02x:%02x:%02x:%02x\n", 
-           request->chaddr[0], request->chaddr[1], request->chaddr[2],
-           request->chaddr[3], request->chaddr[4], request->chaddr[5]);
-    
-    // Detectar tipo de mensagem DHCP (opção 53)
-    uint8_t msg_type = 0;
-    uint8_t *opt_ptr = request->options;
-    while (*opt_ptr != 255 && (opt_ptr - request->options) < 308) {
-        if (*opt_ptr == 53 && *(opt_ptr+1) == 1) {
-            msg_type = *(opt_ptr+2);
-            break;
+    memset(req, 0, sizeof(*req));
+    req->htype = pbuf_get_at(p, OFF_HTYPE);
+    req->hlen = pbuf_get_at(p, OFF_HLEN);
+    if (req->hlen != 6) return false;               // Só Ethernet/Wi-Fi
+    pbuf_copy_partial(p, &req->xid, 4, OFF_XID);
+    pbuf_copy_partial(p, &req->flags, 2, OFF_FLAGS);
+    pbuf_copy_partial(p, &req->ciaddr, 4, OFF_CIADDR);
+    pbuf_copy_partial(p, &req->giaddr, 4, OFF_GIADDR);
+    pbuf_copy_partial(p, req->chaddr, 16, OFF_CHADDR);
+    
+    dhcp_opt_iter_t it = { .p = p, .pos = DHCP_HEADER_LEN };
+    uint8_t code, len;
+    u16_t value;
+    while (opt_next(&it, &code, &len, &value)) {
+        switch (code) {
+            case 53: if (len == 1) req->msg_type = pbuf_get_at(p, value); break;
+            case 50: if (len == 4) req->requested = read_ip(p, value); break;
+            case 54: if (len == 4) req->server_id = read_ip(p, value); break;
+            default: break;
         }
-        opt_ptr += 2 + *(opt_ptr+1);
     }
-    
-    printf("Tipo de mensagem DHCP: %d ", msg_type);
-    if (msg_type == 1) printf("(DISCOVER)\n");
-    else if (msg_type == 3) printf("(REQUEST)\n");
-    else printf("(OUTRO)\n");
-    
-    // Ignora se não for DISCOVER ou REQUEST
-    if (msg_type != 1 && msg_type != 3) {
-        printf("Mensagem ignorada\n");
-        pbuf_free(p);
-        return;
+    return req->msg_type != 0;
+}
+
+// Último octeto se o endereço é da nossa rede /24
+static uint8_t host_of(uint32_t ip) {
+    return ((ip & 0xFFFFFF00) == (DHCP_SERVER_IP & 0xFFFFFF00)) ? (uint8_t)(ip & 0xFF) : 0;
+}
+
+// Resposta pré-alocada no init com os campos constantes já preenchidos;
+// cada resposta só grava os campos do cliente e as opções
+static struct pbuf *reply_pbuf;
+static void *reply_payload;
+
+static const uint8_t reply_net_options[] = {
+    1, 4, 255, 255, 255, 0,       // Subnet Mask
+    3, 4, 192, 168, 4, 1,         // Router/Gateway
+    6, 4, 192, 168, 4, 1,         // DNS Server
+};
+
+static void reply_template_fill(struct dhcp_msg *msg) {
+    memset(msg, 0, sizeof(struct dhcp_msg));
+    msg->op = 2; // BOOTREPLY
+    msg->siaddr = htonl(DHCP_SERVER_IP);
+    msg->magic_cookie = htonl(DHCP_MAGIC_COOKIE);
+}
+
+// Pbuf pronto para uso: o pré-alocado, se o lwIP já o devolveu
+static struct pbuf *reply_acquire(void) {
+    if (reply_pbuf != NULL && reply_pbuf->ref == 1) {
+        // O envio pode ter deixado os cabeçalhos UDP/IP à frente do payload
+        if (reply_pbuf->payload != reply_payload) {
+            pbuf_remove_header(reply_pbuf, (size_t)((uint8_t *)reply_payload - (uint8_t *)reply_pbuf->payload));
+        }
+        pbuf_ref(reply_pbuf);
+        return reply_pbuf;
     }
-    
-    // Cria resposta DHCP OFFER/ACK
-    struct pbuf *response_buf = pbuf_alloc(PBUF_TRANSPORT, sizeof(struct dhcp_msg), PBUF_RAM);
+    // Ainda preso numa fila do ARP: usar um pbuf avulso
+    struct pbuf *p = pbuf_alloc(PBUF_TRANSPORT, sizeof(struct dhcp_msg), PBUF_RAM);
+    if (p != NULL) {
+        reply_template_fill((struct dhcp_msg *)p->payload);
+    }
+    return p;
+}
+
+static void dhcp_send_reply(struct udp_pcb *pcb, const dhcp_request_t *request, uint8_t reply_type,
+                            uint32_t yiaddr, uint32_t dest) {
+    struct pbuf *response_buf = reply_acquire();
     if (!response_buf) {
-        printf("Erro ao alocar buffer de resposta\n");
-        pbuf_free(p);
+        LOG_E(LOG_MOD_DHCP, "Erro ao alocar buffer de resposta");
         return;
     }
     
     struct dhcp_msg *response = (struct dhcp_msg *)response_buf->payload;
-    memset(response, 0, sizeof(struct dhcp_msg));
     
-    // Preenche campos básicos
-    response->op = 2; // BOOTREPLY
+    // Campos do cliente
     response->htype = request->htype;
     response->hlen = request->hlen;
     response->xid = request->xid;
-    response->magic_cookie = htonl(DHCP_MAGIC_COOKIE);
-    
-    // Copia MAC address do cliente
+    response->flags = request->flags;
+    response->ciaddr = (reply_type == DHCP_ACK && yiaddr == 0) ? request->ciaddr : 0;  // INFORM
+    response->yiaddr = htonl(yiaddr);
+    response->giaddr = request->giaddr;
     memcpy(response->chaddr, request->chaddr, 16);
     
-    // Atribui IP ao cliente (192.168.4.x)
-    static uint32_t assigned_ip = 0; // Lembra o IP atribuído
-    
-    if (msg_type == 1) {
-        // DISCOVER - oferece novo IP
-        assigned_ip = 0xC0A80400 | next_ip; // 192.168.4.x
-        next_ip++;
-        if (next_ip > 254) next_ip = 2;
-        printf("OFFER: Oferecendo IP 192.168.4.%d\n", assigned_ip & 0xFF);
-    } else {
-        // REQUEST - confirma o mesmo IP
-        printf("ACK: Confirmando IP 192.168.4.%d\n", assigned_ip & 0xFF);
-    }
-    
-    response->yiaddr = htonl(assigned_ip);
-    
-    // IP do servidor DHCP
-    response->siaddr = htonl(0xC0A80401); // 192.168.4.1
-    
-    // Opções DHCP básicas
     uint8_t *opt = response->options;
+    memset(opt, 0, sizeof(response->options));
     
-    // Opção 53: DHCP Message Type (OFFER = 2, ACK = 5)
-    *opt++ = 53; *opt++ = 1;
-    *opt++ = (msg_type == 1) ? 2 : 5; // OFFER ou ACK
+    // Opção 53: DHCP Message Type
+    *opt++ = 53; *opt++ = 1; *opt++ = reply_type;
     
     // Opção 54: Server Identifier
     *opt++ = 54; *opt++ = 4;
     *opt++ = 192; *opt++ = 168; *opt++ = 4; *opt++ = 1;
     
-    // Opção 51: Lease Time (1 hora = 3600s)
-    *opt++ = 51; *opt++ = 4;
-    uint32_t lease = htonl(3600);
-    memcpy(opt, &lease, 4); opt += 4;
-    
-    // Opção 1: Subnet Mask
-    *opt++ = 1; *opt++ = 4;
-    *opt++ = 255; *opt++ = 255; *opt++ = 255; *opt++ = 0;
-    
-    // Opção 3: Router/Gateway
-    *opt++ = 3; *opt++ = 4;
-    *opt++ = 192; *opt++ = 168; *opt++ = 4; *opt++ = 1;
-    
-    // Opção 6: DNS Server
-    *opt++ = 6; *opt++ = 4;
-    *opt++ = 192; *opt++ = 168; *opt++ = 4; *opt++ = 1;
+    if (reply_type != DHCP_NAK) {
+        // Opção 51: Lease Time (não vai em resposta a INFORM)
+        if (yiaddr != 0) {
+            *opt++ = 51; *opt++ = 4;
+            uint32_t lease = htonl(DHCP_LEASE_TIME_S);
+            memcpy(opt, &lease, 4); opt += 4;
+        }
+        memcpy(opt, reply_net_options, sizeof(reply_net_options));
+        opt += sizeof(reply_net_options);
+        
+        // Opção 114: Captive Portal URI (RFC 8910) - Android 11+/iOS 14+
+        // abrem a interface direto, sem depender das sondas HTTP
+        *opt++ = 114; *opt++ = sizeof(CAPTIVE_PORTAL_URL) - 1;
+        memcpy(opt, CAPTIVE_PORTAL_URL, sizeof(CAPTIVE_PORTAL_URL) - 1);
+        opt += sizeof(CAPTIVE_PORTAL_URL) - 1;
+    }
     
     // Opção 255: End
     *opt++ = 255;
     
-    // Envia resposta broadcast
     ip_addr_t dest_ip;
-    IP4_ADDR(&dest_ip, 255, 255, 255, 255);
-    
+    ip4_addr_set_u32(ip_2_ip4(&dest_ip), htonl(dest));
     udp_sendto(pcb, response_buf, &dest_ip, DHCP_CLIENT_PORT);
+    pbuf_free(response_buf);
+}
+
+static struct udp_pcb *server_pcb;
+
+// Pedido já validado: lease e resposta
+static void dhcp_handle(struct udp_pcb *pcb, const dhcp_request_t *request, uint32_t now_ms) {
+    const uint8_t *mac = request->chaddr;
+    uint8_t requested = host_of(request->requested);
+    uint32_t server_id = request->server_id;
+    uint8_t msg_type = request->msg_type;
     
-    printf("Resposta DHCP enviada!\n\n");
+    LOG_D(LOG_MOD_DHCP, "Pedido de %02x:%02x:%02x:%02x:%02x:%02x",
+          mac[0], mac[1], mac[2], mac[3], mac[4], mac[5]);
     
-    pbuf_free(response_buf);
+    switch (msg_type) {
+        case DHCP_DISCOVER: {
+            uint8_t host = dhcp_lease_offer(mac, requested, now_ms);
+            if (host == 0) {
+                LOG_W(LOG_MOD_DHCP, "Pool esgotado - DISCOVER sem resposta");
+                return;
+            }
+            LOG_D(LOG_MOD_DHCP, "OFFER: 192.168.4.%d", host);
+            dhcp_send_reply(pcb, request, DHCP_OFFER, (DHCP_SERVER_IP & 0xFFFFFF00) | host, 0xFFFFFFFF);
+            break;
+        }
+        case DHCP_REQUEST: {
+            if (server_id != 0 && server_id != DHCP_SERVER_IP) {
+                return;  // Cliente escolheu outro servidor
+            }
+            // SELECTING/INIT-REBOOT usam a opção 50; RENEWING/REBINDING, o ciaddr
+            uint8_t host = requested ? requested : host_of(ntohl(request->ciaddr));
+            if (host != 0 && dhcp_lease_commit(mac, host, now_ms)) {
+                LOG_I(LOG_MOD_DHCP, "ACK: 192.168.4.%d", host);
+                dhcp_send_reply(pcb, request, DHCP_ACK, (DHCP_SERVER_IP & 0xFFFFFF00) | host, 0xFFFFFFFF);
+            } else {
+                LOG_I(LOG_MOD_DHCP, "NAK: 192.168.4.%d indisponível", host);
+                dhcp_send_reply(pcb, request, DHCP_NAK, 0, 0xFFFFFFFF);
+            }
+            break;
+        }
+        case DHCP_RELEASE:
+            dhcp_lease_release(mac, host_of(ntohl(request->ciaddr)));
+            LOG_I(LOG_MOD_DHCP, "RELEASE: 192.168.4.%d", host_of(ntohl(request->ciaddr)));
+            break;
+        case DHCP_DECLINE:
+            dhcp_lease_decline(mac, requested, now_ms);
+            LOG_W(LOG_MOD_DHCP, "DECLINE: 192.168.4.%d em quarentena", requested);
+            break;
+        case DHCP_INFORM:
+            // Cliente com IP fixo só quer as opções: resposta direta, sem lease
+            if (request->ciaddr != 0) {
+                dhcp_send_reply(pcb, request, DHCP_ACK, 0, ntohl(request->ciaddr));
+            }
+            break;
+        default:
+            break;
+    }
+}
+
+static void dhcp_recv(void *arg, struct udp_pcb *pcb, struct pbuf *p, const ip_addr_t *addr, u16_t port) {
+    PROF_SCOPE("dhcp_recv");
+    // Tudo que é usado do pedido vai para req; o pbuf é liberado logo
+    dhcp_request_t req;
+    bool valid = dhcp_server_parse(p, &req);
     pbuf_free(p);
+    if (valid) {
+        dhcp_handle(pcb, &req, hal_time_ms());
+    }
+}
+
+void dhcp_server_handle(const dhcp_request_t *req, uint32_t now_ms) {
+    if (server_pcb != NULL) {
+        dhcp_handle(server_pcb, req, now_ms);
+    }
 }
 
 void dhcp_server_init(void) {
+    dhcp_leases_init();
+    
+    reply_pbuf = pbuf_alloc(PBUF_TRANSPORT, sizeof(struct dhcp_msg), PBUF_RAM);
+    if (reply_pbuf != NULL) {
+        reply_payload = reply_pbuf->payload;
+        reply_template_fill((struct dhcp_msg *)reply_payload);
+    }
+    
     struct udp_pcb *pcb = udp_new();
     
     if (pcb == NULL) {
@@ -174,6 +311,7 @@ void dhcp_server_init(void) {
     }
     
     udp_recv(pcb, dhcp_recv, NULL);
+    server_pcb = pcb;
     
     printf("✅ Servidor DHCP iniciado na porta 67\n");
     printf("   Distribuindo IPs: 192.168.4.2 - 192.168.4.254\n");
@@ -1,6 +1,26 @@
 #ifndef DHCP_SERVER_H
 #define DHCP_SERVER_H
 
+#include <stdint.h>
+#include <stdbool.h>
+#include "lwip/pbuf.h"
+
+// Campos do pedido que interessam, lidos direto da cadeia de pbufs
+typedef struct {
+    uint8_t htype;
+    uint8_t hlen;
+    uint32_t xid;        // Ordem de rede (só ecoado)
+    uint16_t flags;      // Ordem de rede (só ecoado)
+    uint32_t ciaddr;     // Ordem de rede
+    uint32_t giaddr;     // Ordem de rede
+    uint8_t chaddr[16];
+    uint8_t msg_type;    // Opção 53
+    uint32_t requested;  // Opção 50, ordem do host (0 = ausente)
+    uint32_t server_id;  // Opção 54, ordem do host (0 = ausente)
+} dhcp_request_t;
+
 void dhcp_server_init(void);
+bool dhcp_server_parse(const struct pbuf *p, dhcp_request_t *req);   // Cabeçalho + opções 53/50/54
+void dhcp_server_handle(const dhcp_request_t *req, uint32_t now_ms);  // Lease + resposta, como na recepção (bench)
 
 #endif
@@ -0,0 +1,268 @@
+// Fuzzer do parser DHCP (dhcp_server_parse) sobre cadeias de pbufs
+// O primeiro byte da entrada escolhe como o pacote (o resto) é partido:
+// pedaços de 0 a 64 bytes, cada um numa alocação exata para o ASan pegar
+// leitura além do pbuf. Cada entrada é conferida contra:
+//  - um parser de referência sobre o pacote contíguo (mesmas regras de
+//    cabeçalho, Pad/End e opção truncada): aceitar e os campos extraídos
+//    precisam bater;
+//  - o mesmo pacote num pbuf único.
+// Pedidos aceitos seguem para dhcp_server_handle (tabela de leases e
+// montagem da resposta), com o relógio andando conforme a entrada.
+//
+// Sem libFuzzer (gcc): ./ibag_fuzz_dhcp [iterações] [semente] muta um
+// corpus embutido. Com clang e -DIBAG_FUZZ_LIBFUZZER=ON o mesmo
+// LLVMFuzzerTestOneInput vira um alvo do libFuzzer.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "lwip/init.h"
+#include "lwip/pbuf.h"
+#include "dhcp_server.h"
+
+#define MAX_PACKET 1500
+#define MAX_PIECES (MAX_PACKET + 1)
+
+// --- parser de referência (pacote contíguo) ---
+
+static uint32_t be32(const uint8_t *p) {
+    return ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 8) | p[3];
+}
+
+static bool ref_parse(const uint8_t *d, size_t len, dhcp_request_t *req) {
+    if (len < 240 || d[0] != 1 || be32(&d[236]) != 0x63825363 || d[2] != 6) {
+        return false;
+    }
+    memset(req, 0, sizeof(*req));
+    req->htype = d[1];
+    req->hlen = d[2];
+    memcpy(&req->xid, &d[4], 4);
+    memcpy(&req->flags, &d[10], 2);
+    memcpy(&req->ciaddr, &d[12], 4);
+    memcpy(&req->giaddr, &d[24], 4);
+    memcpy(req->chaddr, &d[28], 16);
+    size_t pos = 240;
+    while (pos < len && d[pos] != 255) {
+        if (d[pos] == 0) {
+            pos++;
+            continue;
+        }
+        if (pos + 1 >= len || pos + 2 + d[pos + 1] > len) {
+            break;
+        }
+        uint8_t code = d[pos], l = d[pos + 1];
+        const uint8_t *v = &d[pos + 2];
+        if (code == 53 && l == 1) req->msg_type = v[0];
+        if (code == 50 && l == 4) req->requested = be32(v);
+        if (code == 54 && l == 4) req->server_id = be32(v);
+        pos += 2 + (size_t)l;
+    }
+    return req->msg_type != 0;
+}
+
+static bool same_request(const dhcp_request_t *a, const dhcp_request_t *b) {
+    return a->htype == b->htype && a->hlen == b->hlen && a->xid == b->xid && a->flags == b->flags &&
+           a->ciaddr == b->ciaddr && a->giaddr == b->giaddr && memcmp(a->chaddr, b->chaddr, 16) == 0 &&
+           a->msg_type == b->msg_type && a->requested == b->requested && a->server_id == b->server_id;
+}
+
+static void fail(const char *what, const uint8_t *data, size_t len) {
+    fprintf(stderr, "FALHA: %s\nentrada (%zu bytes):", what, len);
+    for (size_t i = 0; i < len; i++) {
+        fprintf(stderr, " %02x", data[i]);
+    }
+    fprintf(stderr, "\n");
+    abort();
+}
+
+static uint32_t stats_accepted;
+static uint32_t stats_pieces;
+
+int LLVMFuzzerTestOneInput(const uint8_t *data, size_t len) {
+    static bool ready;
+    static uint32_t now_ms;
+    if (!ready) {
+        lwip_init();
+        dhcp_server_init();
+        ready = true;
+    }
+    if (len < 1 || len - 1 > MAX_PACKET) {
+        return 0;
+    }
+    uint32_t split = data[0] + 1u;   // Semente dos cortes, vinda da entrada
+    const uint8_t *packet = data + 1;
+    size_t packet_len = len - 1;
+
+    // Cadeia com pedaços de 0..64 bytes (pbufs vazios no meio também valem)
+    static struct pbuf chain[MAX_PIECES];
+    static uint8_t *pieces[MAX_PIECES];
+    size_t count = 0, pos = 0;
+    do {
+        split = split * 1103515245u + 12345u;
+        size_t n = (split >> 16) % 65;
+        if (n > packet_len - pos || count == MAX_PIECES - 1) n = packet_len - pos;
+        pieces[count] = malloc(n ? n : 1);
+        memcpy(pieces[count], packet + pos, n);
+        chain[count] = (struct pbuf){ .payload = pieces[count], .len = (u16_t)n, .ref = 1 };
+        count++;
+        pos += n;
+    } while (pos < packet_len);
+    for (size_t i = count; i-- > 0;) {
+        chain[i].next = (i + 1 < count) ? &chain[i + 1] : NULL;
+        chain[i].tot_len = (u16_t)(chain[i].len + (chain[i].next ? chain[i].next->tot_len : 0));
+    }
+    stats_pieces += (uint32_t)count;
+
+    uint8_t *flat = malloc(packet_len ? packet_len : 1);
+    memcpy(flat, packet, packet_len);
+    struct pbuf single = { .payload = flat, .len = (u16_t)packet_len, .tot_len = (u16_t)packet_len, .ref = 1 };
+
+    dhcp_request_t from_chain, from_single, ref;
+    bool ok_chain = dhcp_server_parse(&chain[0], &from_chain);
+    bool ok_single = dhcp_server_parse(&single, &from_single);
+    bool ok_ref = ref_parse(packet, packet_len, &ref);
+    if (ok_chain != ok_ref) {
+        fail(ok_ref ? "recusado pelo parser, aceito pela referência"
+                    : "aceito pelo parser, recusado pela referência", data, len);
+    }
+    if (ok_single != ok_chain) {
+        fail("resultado depende de como o pacote foi partido", data, len);
+    }
+    if (ok_chain) {
+        if (!same_request(&from_chain, &ref)) {
+            fail("campos diferentes da referência", data, len);
+        }
+        if (!same_request(&from_chain, &from_single)) {
+            fail("campos dependem de como o pacote foi partido", data, len);
+        }
+        stats_accepted++;
+        now_ms += data[0] * 1000u;   // Deixa OFFERs e leases vencerem
+        dhcp_server_handle(&from_chain, now_ms);
+    }
+
+    free(flat);
+    for (size_t i = 0; i < count; i++) {
+        free(pieces[i]);
+    }
+    return 0;
+}
+
+#ifndef IBAG_LIBFUZZER
+
+static uint32_t rng_state = 1;
+
+static uint32_t rng(void) {
+    rng_state ^= rng_state << 13;
+    rng_state ^= rng_state >> 17;
+    rng_state ^= rng_state << 5;
+    return rng_state;
+}
+
+// Pedido de um cliente: cabeçalho + opções (sem o byte de corte)
+static size_t corpus_build(uint8_t *d, uint8_t msg_type, const uint8_t *opts, size_t opts_len) {
+    memset(d, 0, 240);
+    d[0] = 1; d[1] = 1; d[2] = 6;
+    d[4] = 0xDE; d[5] = 0xAD; d[6] = 0xBE; d[7] = 0xEF;
+    memcpy(&d[28], "\x02\x11\x22\x33\x44\x55", 6);
+    d[236] = 0x63; d[237] = 0x82; d[238] = 0x53; d[239] = 0x63;
+    size_t n = 240;
+    d[n++] = 53; d[n++] = 1; d[n++] = msg_type;
+    if (opts_len) {
+        memcpy(&d[n], opts, opts_len);
+        n += opts_len;
+    }
+    d[n++] = 255;
+    return n;
+}
+
+static const uint8_t opts_discover[] = { 61, 7, 1, 0x02, 0x11, 0x22, 0x33, 0x44, 0x55, 57, 2, 0x05, 0xDC,
+                                         55, 4, 1, 3, 6, 114 };
+static const uint8_t opts_request[] = { 50, 4, 192, 168, 4, 23, 54, 4, 192, 168, 4, 1, 12, 3, 'p', 'c', '1' };
+static const uint8_t opts_pad[] = { 0, 0, 0, 50, 4, 192, 168, 4, 200, 0 };
+static const uint8_t opts_other_server[] = { 54, 4, 10, 0, 0, 1 };
+
+// Trechos que a mutação insere (mais úteis que bytes aleatórios)
+static const uint8_t dict[][6] = {
+    { 53, 1, 1 }, { 53, 1, 3 }, { 53, 1, 4 }, { 53, 1, 7 }, { 50, 4, 192, 168, 4, 9 },
+    { 54, 4, 192, 168, 4, 1 }, { 0 }, { 255 }, { 53, 2 }, { 50, 0 }, { 99, 0xFF },
+};
+
+static size_t mutate(uint8_t *buf, size_t len, size_t cap) {
+    int rounds = 1 + rng() % 4;
+    for (int m = 0; m < rounds; m++) {
+        size_t pos = len ? rng() % (len + 1) : 0;
+        switch (rng() % 6) {
+            case 0:   // Trocar um byte
+                if (len) buf[rng() % len] = (uint8_t)rng();
+                break;
+            case 1:   // Trocar um byte nas opções
+                if (len > 241) buf[241 + rng() % (len - 241)] = (uint8_t)rng();
+                break;
+            case 2: { // Inserir uma opção do dicionário depois do cabeçalho
+                const uint8_t *t = dict[rng() % (sizeof(dict) / sizeof(dict[0]))];
+                size_t n = (t[0] == 0 || t[0] == 255) ? 1 : (size_t)(t[1] > 4 ? 2 : 2 + t[1]);
+                if (pos < 241) pos = 241;
+                if (pos <= len && len + n <= cap) {
+                    memmove(buf + pos + n, buf + pos, len - pos);
+                    memcpy(buf + pos, t, n);
+                    len += n;
+                }
+                break;
+            }
+            case 3:   // Apagar um trecho
+                if (len) {
+                    pos = rng() % len;
+                    size_t n = 1 + rng() % (len - pos < 8 ? len - pos : 8);
+                    memmove(buf + pos, buf + pos + n, len - pos - n);
+                    len -= n;
+                }
+                break;
+            case 4:   // Completar com Pad, como os clientes fazem
+                while (len < cap && len < 300 + (rng() % 64)) buf[len++] = 0;
+                break;
+            default:  // Cortar o fim
+                len = pos;
+                break;
+        }
+    }
+    return len;
+}
+
+int main(int argc, char **argv) {
+    uint32_t iterations = argc > 1 ? (uint32_t)strtoul(argv[1], NULL, 10) : 200000;
+    rng_state = argc > 2 ? (uint32_t)strtoul(argv[2], NULL, 10) : 1;
+    if (rng_state == 0) rng_state = 1;
+
+    static uint8_t corpus[5][1 + 400];
+    size_t corpus_len[5];
+    corpus_len[0] = 1 + corpus_build(corpus[0] + 1, 1, opts_discover, sizeof(opts_discover));
+    corpus_len[1] = 1 + corpus_build(corpus[1] + 1, 3, opts_request, sizeof(opts_request));
+    corpus_len[2] = 1 + corpus_build(corpus[2] + 1, 4, opts_pad, sizeof(opts_pad));
+    corpus_len[3] = 1 + corpus_build(corpus[3] + 1, 3, opts_other_server, sizeof(opts_other_server));
+    corpus_len[4] = 1 + corpus_build(corpus[4] + 1, 7, NULL, 0);
+    size_t corpus_count = sizeof(corpus_len) / sizeof(corpus_len[0]);
+    for (size_t i = 0; i < corpus_count; i++) {
+        corpus[i][0] = (uint8_t)(i * 37);
+        LLVMFuzzerTestOneInput(corpus[i], corpus_len[i]);
+        if (stats_accepted != i + 1) {
+            fprintf(stderr, "corpus[%zu] recusado\n", i);
+            return 1;
+        }
+    }
+
+    static uint8_t buf[1 + 600];
+    for (uint32_t it = 0; it < iterations; it++) {
+        size_t seed = rng() % corpus_count;
+        size_t len = corpus_len[seed];
+        memcpy(buf, corpus[seed], len);
+        buf[0] = (uint8_t)rng();
+        len = 1 + mutate(buf + 1, len - 1, sizeof(buf) - 1);
+        LLVMFuzzerTestOneInput(buf, len);
+    }
+
+    printf("%lu entradas, %lu aceitas, %.1f pbufs por cadeia\n", (unsigned long)(iterations + corpus_count),
+           (unsigned long)stats_accepted, (double)stats_pieces / (iterations + corpus_count));
+    return 0;
+}
+
+#endif
@@ -0,0 +1,400 @@
+// Fuzzer do tokenizador JSON (json_tok.c) e do corpo do POST /api/config
+// Cada entrada é conferida contra:
+//  - um validador de referência recursivo, com a mesma gramática e os mesmos
+//    limites (profundidade, tamanho de token, \u0000 e surrogates): aceitar
+//    ou recusar precisa bater;
+//  - a mesma entrada partida em pedaços aleatórios (como pbufs): mesma
+//    sequência de tokens, mesmo erro e mesma posição;
+//  - config_json: um corpo aceito, reescrito pelo json_writer e lido de
+//    novo, dá os mesmos valores (dentro das casas decimais da resposta).
+//
+// Sem libFuzzer (gcc): ./ibag_fuzz_json [iterações] [semente] muta um corpus
+// embutido. Com clang e -DIBAG_FUZZ_LIBFUZZER=ON o mesmo
+// LLVMFuzzerTestOneInput vira um alvo do libFuzzer.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "json_tok.h"
+#include "json_writer.h"
+#include "config_json.h"
+
+// --- validador de referência ---
+
+typedef struct {
+    const uint8_t *p;
+    const uint8_t *end;
+} ref_t;
+
+static void ref_ws(ref_t *r) {
+    while (r->p < r->end && (*r->p == ' ' || *r->p == '\t' || *r->p == '\n' || *r->p == '\r')) {
+        r->p++;
+    }
+}
+
+static int ref_hex4(ref_t *r) {
+    int v = 0;
+    for (int i = 0; i < 4; i++) {
+        if (r->p >= r->end) return -1;
+        uint8_t c = *r->p++;
+        int d = (c >= '0' && c <= '9') ? c - '0' : (c >= 'a' && c <= 'f') ? c - 'a' + 10 :
+                (c >= 'A' && c <= 'F') ? c - 'A' + 10 : -1;
+        if (d < 0) return -1;
+        v = v * 16 + d;
+    }
+    return v;
+}
+
+static bool ref_string(ref_t *r) {
+    size_t len = 0;   // Bytes do texto já sem escape (UTF-8)
+    r->p++;           // '"'
+    while (r->p < r->end) {
+        uint8_t c = *r->p++;
+        if (c == '"') {
+            return true;
+        }
+        if (c < 0x20) {
+            return false;
+        }
+        if (c != '\\') {
+            len++;
+        } else {
+            if (r->p >= r->end) return false;
+            c = *r->p++;
+            if (c == 'u') {
+                int code = ref_hex4(r);
+                if (code <= 0 || (code >= 0xDC00 && code <= 0xDFFF)) return false;
+                if (code >= 0xD800 && code <= 0xDBFF) {
+                    if (r->end - r->p < 2 || r->p[0] != '\\' || r->p[1] != 'u') return false;
+                    r->p += 2;
+                    int low = ref_hex4(r);
+                    if (low < 0xDC00 || low > 0xDFFF) return false;
+                    len += 4;
+                } else {
+                    len += code < 0x80 ? 1 : code < 0x800 ? 2 : 3;
+                }
+            } else if (strchr("\"\\/bfnrt", c) != NULL && c != 0) {
+                len++;
+            } else {
+                return false;
+            }
+        }
+        if (len > JSON_TOK_TEXT_MAX) {
+            return false;
+        }
+    }
+    return false;
+}
+
+static bool ref_digits(ref_t *r) {
+    const uint8_t *start = r->p;
+    while (r->p < r->end && *r->p >= '0' && *r->p <= '9') r->p++;
+    return r->p > start;
+}
+
+static bool ref_number(ref_t *r) {
+    const uint8_t *start = r->p;
+    if (*r->p == '-') r->p++;
+    if (r->p < r->end && *r->p == '0') {
+        r->p++;
+    } else if (!ref_digits(r)) {
+        return false;
+    }
+    if (r->p < r->end && *r->p == '.') {
+        r->p++;
+        if (!ref_digits(r)) return false;
+    }
+    if (r->p < r->end && (*r->p == 'e' || *r->p == 'E')) {
+        r->p++;
+        if (r->p < r->end && (*r->p == '+' || *r->p == '-')) r->p++;
+        if (!ref_digits(r)) return false;
+    }
+    return r->p - start <= JSON_TOK_TEXT_MAX;
+}
+
+static bool ref_value(ref_t *r, int depth) {
+    ref_ws(r);
+    if (r->p >= r->end) return false;
+    uint8_t c = *r->p;
+    if (c == '{' || c == '[') {
+        if (depth >= JSON_TOK_DEPTH_MAX) return false;
+        bool obj = c == '{';
+        r->p++;
+        ref_ws(r);
+        if (r->p < r->end && *r->p == (obj ? '}' : ']')) {
+            r->p++;
+            return true;
+        }
+        for (;;) {
+            if (obj) {
+                ref_ws(r);
+                if (r->p >= r->end || *r->p != '"' || !ref_string(r)) return false;
+                ref_ws(r);
+                if (r->p >= r->end || *r->p++ != ':') return false;
+            }
+            if (!ref_value(r, depth + 1)) return false;
+            ref_ws(r);
+            if (r->p >= r->end) return false;
+            c = *r->p++;
+            if (c == (obj ? '}' : ']')) return true;
+            if (c != ',') return false;
+        }
+    }
+    if (c == '"') return ref_string(r);
+    if (c == '-' || (c >= '0' && c <= '9')) return ref_number(r);
+    static const char *const lits[] = { "true", "false", "null" };
+    for (int i = 0; i < 3; i++) {
+        size_t n = strlen(lits[i]);
+        if ((size_t)(r->end - r->p) >= n && memcmp(r->p, lits[i], n) == 0) {
+            r->p += n;
+            return true;
+        }
+    }
+    return false;
+}
+
+static bool ref_document(const uint8_t *data, size_t len) {
+    ref_t r = { data, data + len };
+    if (!ref_value(&r, 0)) return false;
+    ref_ws(&r);
+    return r.p == r.end;
+}
+
+// --- tokenizador: resumo da sequência de tokens ---
+
+typedef struct {
+    uint64_t hash;
+    uint32_t count;
+} trace_t;
+
+static json_err_t trace_token(void *ctx, const json_token_t *token) {
+    trace_t *t = (trace_t *)ctx;
+    uint64_t h = t->hash ^ ((uint64_t)token->type << 8 | token->depth);
+    h *= 0x100000001B3ull;
+    for (uint8_t i = 0; i < token->len; i++) {
+        h = (h ^ (uint8_t)token->text[i]) * 0x100000001B3ull;
+    }
+    if (token->len != strlen(token->text) && token->type != JSON_TOK_NUMBER) {
+        h ^= 0xDEAD;   // \0 no meio do texto: nunca deveria acontecer
+    }
+    t->hash = h;
+    t->count++;
+    return JSON_OK;
+}
+
+typedef struct {
+    json_err_t err;
+    uint32_t offset;
+    trace_t trace;
+} tok_result_t;
+
+static uint32_t rng_state = 1;
+
+static uint32_t rng(void) {
+    rng_state ^= rng_state << 13;
+    rng_state ^= rng_state >> 17;
+    rng_state ^= rng_state << 5;
+    return rng_state;
+}
+
+// split = 0: tudo de uma vez; senão pedaços de 1..split bytes
+static tok_result_t tokenize(const uint8_t *data, size_t len, uint32_t split) {
+    tok_result_t res = { .trace = { 0xCBF29CE484222325ull, 0 } };
+    json_tok_t tok;
+    json_tok_init(&tok, trace_token, &res.trace);
+    size_t pos = 0;
+    while (pos < len) {
+        size_t n = split ? 1 + rng() % split : len;
+        if (n > len - pos) n = len - pos;
+        // Cópia exata do pedaço: o ASan pega leitura além dele
+        uint8_t *chunk = malloc(n);
+        memcpy(chunk, data + pos, n);
+        json_tok_feed(&tok, (const char *)chunk, n);
+        free(chunk);
+        pos += n;
+    }
+    res.err = json_tok_finish(&tok);
+    res.offset = tok.err_offset;
+    return res;
+}
+
+// --- config_json: ida e volta pelo json_writer ---
+
+static bool config_parse(const uint8_t *data, size_t len, const ibag_config_t *current, ibag_config_t *out) {
+    config_json_t cj;
+    config_json_begin(&cj, current);
+    config_json_feed(&cj, (const char *)data, len);
+    if (config_json_end(&cj) != JSON_OK) {
+        return false;
+    }
+    *out = cj.proposed;
+    return true;
+}
+
+static bool close_enough(float a, float b, uint8_t decimals) {
+    float tol = 0.5f;
+    for (uint8_t i = 0; i < decimals; i++) tol /= 10.0f;
+    return fabsf(a - b) <= tol * 1.0001f + fabsf(a) * 1e-5f;
+}
+
+static void fail(const char *what, const uint8_t *data, size_t len) {
+    fprintf(stderr, "FALHA: %s\nentrada (%zu bytes): ", what, len);
+    for (size_t i = 0; i < len; i++) {
+        fprintf(stderr, (data[i] >= 0x20 && data[i] < 0x7F) ? "%c" : "\\x%02x", data[i]);
+    }
+    fprintf(stderr, "\n");
+    abort();
+}
+
+static uint32_t stats_accepted;
+static uint32_t stats_errors[JSON_ERR_RANGE + 1];
+
+int LLVMFuzzerTestOneInput(const uint8_t *data, size_t len) {
+    tok_result_t whole = tokenize(data, len, 0);
+    bool ref = ref_document(data, len);
+    if ((whole.err == JSON_OK) != ref) {
+        fail(ref ? "recusado pelo tokenizador, aceito pela referência"
+                 : "aceito pelo tokenizador, recusado pela referência", data, len);
+    }
+    if (whole.err != JSON_OK && whole.offset > len) {
+        fail("posição do erro além do fim", data, len);
+    }
+    for (uint32_t split = 1; split <= 7; split += 3) {
+        tok_result_t parts = tokenize(data, len, split);
+        if (parts.err != whole.err || parts.offset != whole.offset ||
+            parts.trace.hash != whole.trace.hash || parts.trace.count != whole.trace.count) {
+            fail("resultado depende de como o corpo foi partido", data, len);
+        }
+    }
+    stats_errors[whole.err]++;
+    stats_accepted += whole.err == JSON_OK;
+
+    ibag_config_t current = { .version = 7, .heater_target = 60.0f, .conservative_target = 4.0f };
+    ibag_config_t parsed;
+    if (config_parse(data, len, &current, &parsed)) {
+        char out[512];
+        json_writer_t w;
+        json_writer_init(&w, out, sizeof(out));
+        json_obj_begin(&w);
+        json_write_fields(&w, config_json_fields, config_json_field_count, &parsed);
+        json_obj_end(&w);
+        ibag_config_t again;
+        if (!json_writer_ok(&w) || !config_parse((const uint8_t *)out, json_writer_len(&w), &current, &again)) {
+            fail("saída do json_writer não é lida de volta", data, len);
+        }
+        for (size_t i = 0; i < config_json_field_count; i++) {
+            const json_field_t *f = &config_json_fields[i];
+            if (f->type != JSON_FIELD_FLOAT) continue;
+            float a, b;
+            memcpy(&a, (const uint8_t *)&parsed + f->offset, sizeof(a));
+            memcpy(&b, (const uint8_t *)&again + f->offset, sizeof(b));
+            if (!isfinite(a) || !close_enough(a, b, f->decimals)) {
+                fail("valor mudou na ida e volta", data, len);
+            }
+        }
+    }
+    return 0;
+}
+
+#ifndef IBAG_LIBFUZZER
+
+static const char *const corpus[] = {
+    "{\"heater\":60.5,\"freezer\":4.0,\"heater_offset\":-0.25,\"freezer_offset\":0.10}",
+    "{\"heater\": 58 , \"freezer\" :3.5e0}",
+    "{\"heater\":1E-2,\"x\":[1,2,{\"a\":null}],\"freezer\":-0}",
+    "[true,false,null,\"\\u00e9\\ud83d\\ude00\\n\",-12.5e+3]",
+    "{\"a\":{\"b\":{\"c\":{\"d\":{\"e\":{\"f\":{\"g\":[]}}}}}}}",
+    "\"s\\\\t\\\"r\\/\"",
+    "0",
+    " {} ",
+    "{\"k\":\"0123456789abcdefghijklmnopqrstuvwxyz0123456789a\",\"n\":12345678901234567890.125e-3}",
+};
+
+// Tokens que a mutação insere (mais úteis que bytes aleatórios)
+static const char *const dict[] = {
+    "{", "}", "[", "]", ",", ":", "\"", "\\", "\\u", "d83d", "\\ude00", "0", "1", "9", ".", "-",
+    "+", "e", "E", "true", "false", "null", " ", "\n", "\t", "\"heater\":", "\x01", "\xff", "1e999",
+};
+
+static size_t mutate(uint8_t *buf, size_t len, size_t cap) {
+    int rounds = 1 + rng() % 4;
+    for (int m = 0; m < rounds; m++) {
+        size_t pos = len ? rng() % (len + 1) : 0;
+        switch (rng() % 5) {
+            case 0:   // Trocar um byte
+                if (len) buf[rng() % len] = (uint8_t)rng();
+                break;
+            case 1:   // Apagar um trecho
+                if (len) {
+                    pos = rng() % len;
+                    size_t n = 1 + rng() % (len - pos < 8 ? len - pos : 8);
+                    memmove(buf + pos, buf + pos + n, len - pos - n);
+                    len -= n;
+                }
+                break;
+            case 2: { // Inserir um token do dicionário
+                const char *t = dict[rng() % (sizeof(dict) / sizeof(dict[0]))];
+                size_t n = strlen(t);
+                if (len + n <= cap) {
+                    memmove(buf + pos + n, buf + pos, len - pos);
+                    memcpy(buf + pos, t, n);
+                    len += n;
+                }
+                break;
+            }
+            case 3:   // Duplicar um trecho (aninhamento, tokens longos)
+                if (len) {
+                    size_t src = rng() % len;
+                    size_t n = 1 + rng() % (len - src < 32 ? len - src : 32);
+                    if (len + n <= cap) {
+                        uint8_t piece[32];
+                        memcpy(piece, buf + src, n);
+                        memmove(buf + pos + n, buf + pos, len - pos);
+                        memcpy(buf + pos, piece, n);
+                        len += n;
+                    }
+                }
+                break;
+            default:  // Cortar o fim
+                len = pos;
+                break;
+        }
+    }
+    return len;
+}
+
+int main(int argc, char **argv) {
+    uint32_t iterations = argc > 1 ? (uint32_t)strtoul(argv[1], NULL, 10) : 200000;
+    rng_state = argc > 2 ? (uint32_t)strtoul(argv[2], NULL, 10) : 1;
+    if (rng_state == 0) rng_state = 1;
+
+    size_t corpus_count = sizeof(corpus) / sizeof(corpus[0]);
+    for (size_t i = 0; i < corpus_count; i++) {
+        LLVMFuzzerTestOneInput((const uint8_t *)corpus[i], strlen(corpus[i]));
+        if (stats_accepted != i + 1) {
+            fprintf(stderr, "corpus[%zu] recusado\n", i);
+            return 1;
+        }
+    }
+
+    uint8_t buf[256];
+    for (uint32_t it = 0; it < iterations; it++) {
+        const char *seed = corpus[rng() % corpus_count];
+        size_t len = strlen(seed);
+        memcpy(buf, seed, len);
+        len = mutate(buf, len, sizeof(buf));
+        LLVMFuzzerTestOneInput(buf, len);
+    }
+
+    printf("%lu entradas, %lu aceitas\n", (unsigned long)(iterations + corpus_count),
+           (unsigned long)stats_accepted);
+    for (int e = JSON_ERR_UNEXPECTED; e <= JSON_ERR_RANGE; e++) {
+        if (stats_errors[e]) {
+            printf("  %-14s %lu\n", json_err_name((json_err_t)e), (unsigned long)stats_errors[e]);
+        }
+    }
+    return 0;
+}
+
+#endif
@@ -0,0 +1,111 @@
+#ifndef HAL_H
+#define HAL_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+// Camada fina entre a lógica e o hardware: ADC, GPIO, I2C e relógio
+// No alvo as funções são inline sobre o SDK do Pico - o código gerado é o
+// mesmo de uma chamada direta. Com IBAG_HOST=1 (build para Linux, host/)
+// viram chamadas para host/hal_sim.c, com dispositivos simulados: LM35 com
+// um modelo térmico que responde aos relés e MPU6050 com registradores em
+// memória.
+//
+// Rede: os módulos só usam a API raw do lwIP; quem escolhe a interface é o
+// main - cyw43 em modo AP no alvo (iBagPico2W.c), TAP no host
+// (host/main_host.c).
+
+#ifndef IBAG_HOST
+#define IBAG_HOST 0
+#endif
+
+#if IBAG_HOST
+
+// Relógio (desde o boot)
+uint32_t hal_time_ms(void);
+uint32_t hal_time_us(void);
+uint64_t hal_time_us64(void);
+void hal_sleep_ms(uint32_t ms);
+
+// GPIO (saídas digitais: relés)
+void hal_gpio_init_out(uint32_t pin, bool value);
+void hal_gpio_put(uint32_t pin, bool value);
+
+// ADC de 12 bits
+void hal_adc_init(void);
+void hal_adc_init_pin(uint32_t gpio);
+uint16_t hal_adc_read(uint8_t channel);
+
+// I2C (barramento do MPU6050); retornos < 0 = erro ou timeout
+void hal_i2c_init(uint32_t baudrate, uint32_t sda_pin, uint32_t scl_pin);
+int hal_i2c_write(uint8_t addr, const uint8_t *src, size_t len, bool nostop, uint32_t timeout_us);
+int hal_i2c_read(uint8_t addr, uint8_t *dst, size_t len, bool nostop, uint32_t timeout_us);
+
+#else
+
+#include "pico/stdlib.h"
+#include "hardware/adc.h"
+#include "hardware/gpio.h"
+#include "hardware/i2c.h"
+
+#define HAL_I2C_PORT i2c0
+
+static inline uint32_t hal_time_ms(void) {
+    return to_ms_since_boot(get_absolute_time());
+}
+
+static inline uint32_t hal_time_us(void) {
+    return time_us_32();
+}
+
+static inline uint64_t hal_time_us64(void) {
+    return time_us_64();
+}
+
+static inline void hal_sleep_ms(uint32_t ms) {
+    sleep_ms(ms);
+}
+
+static inline void hal_gpio_init_out(uint32_t pin, bool value) {
+    gpio_init(pin);
+    gpio_set_dir(pin, GPIO_OUT);
+    gpio_put(pin, value);
+}
+
+static inline void hal_gpio_put(uint32_t pin, bool value) {
+    gpio_put(pin, value);
+}
+
+static inline void hal_adc_init(void) {
+    adc_init();
+}
+
+static inline void hal_adc_init_pin(uint32_t gpio) {
+    adc_gpio_init(gpio);
+}
+
+static inline uint16_t hal_adc_read(uint8_t channel) {
+    adc_select_input(channel);
+    return adc_read();
+}
+
+static inline void hal_i2c_init(uint32_t baudrate, uint32_t sda_pin, uint32_t scl_pin) {
+    i2c_init(HAL_I2C_PORT, baudrate);
+    gpio_set_function(sda_pin, GPIO_FUNC_I2C);
+    gpio_set_function(scl_pin, GPIO_FUNC_I2C);
+    gpio_pull_up(sda_pin);
+    gpio_pull_up(scl_pin);
+}
+
+static inline int hal_i2c_write(uint8_t addr, const uint8_t *src, size_t len, bool nostop, uint32_t timeout_us) {
+    return i2c_write_timeout_us(HAL_I2C_PORT, addr, src, len, nostop, timeout_us);
+}
+
+static inline int hal_i2c_read(uint8_t addr, uint8_t *dst, size_t len, bool nostop, uint32_t timeout_us) {
+    return i2c_read_timeout_us(HAL_I2C_PORT, addr, dst, len, nostop, timeout_us);
+}
+
+#endif // IBAG_HOST
+
+#endif // HAL_H
@@ -0,0 +1,680 @@
+#include "history.h"
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include "pico/stdlib.h"
+#include "pico/flash.h"
+#include "hardware/flash.h"
+#include "kv_store.h"
+#include "ipc.h"
+#include "prof.h"
+#include "hal.h"
+
+// Região logo abaixo da do kv_store (ver kv_store.c)
+#define HISTORY_REGION_OFFSET \
+    (PICO_FLASH_SIZE_BYTES - (KV_SECTOR_COUNT + 1 + HISTORY_FLASH_SECTORS) * FLASH_SECTOR_SIZE)
+#define HISTORY_MAGIC 0x54534948       // "HIST"
+#define BLOCKS_PER_SECTOR (FLASH_SECTOR_SIZE / HISTORY_BLOCK_SIZE)
+#define FLASH_SLOTS (HISTORY_FLASH_SECTORS * BLOCKS_PER_SECTOR)
+#define MAX_MERGE 60                   // Itens por ponto de uma consulta (history_pick_tier)
+#define PAYLOAD_BITS (uint32_t)(sizeof(((history_block_t *)0)->payload) * 8)
+
+_Static_assert(sizeof(history_block_t) == HISTORY_BLOCK_SIZE, "bloco do histórico fora do tamanho");
+_Static_assert(FLASH_SECTOR_SIZE % HISTORY_BLOCK_SIZE == 0, "bloco não divide o setor");
+
+// Anel na RAM: o bloco de sequência s fica em ram_blocks[s % HISTORY_RAM_BLOCKS].
+// open_seq é o bloco aberto; [spill_seq, open_seq) estão fechados e ainda
+// não foram para a flash.
+static history_block_t ram_blocks[HISTORY_RAM_BLOCKS];
+static uint32_t open_seq = 0;
+static uint32_t spill_seq = 0;
+
+// Estado do codificador (última linha do bloco aberto)
+static history_row_t enc_prev;
+static int32_t enc_prev_delta;
+
+// Anel na flash: o bloco de sequência s fica na posição (s + slot_base) % FLASH_SLOTS
+static uint32_t slot_base = 0;
+static uint32_t oldest_seq = 0;        // Mais antigo encontrado no boot
+
+static uint16_t boot_id = 0;
+static uint32_t time_base = 0;         // Relógio do histórico no boot
+static history_stats_t stats;
+
+// --- Bits (MSB primeiro) ---
+
+static void put_bits(history_block_t *b, uint32_t value, int n) {
+    uint32_t pos = b->hdr.bits;
+    while (n > 0) {
+        int room = 8 - (int)(pos & 7);
+        int take = n < room ? n : room;
+        uint32_t chunk = (value >> (n - take)) & ((1u << take) - 1);
+        b->payload[pos >> 3] |= (uint8_t)(chunk << (room - take));
+        pos += take;
+        n -= take;
+    }
+    b->hdr.bits = (uint16_t)pos;
+}
+
+static uint32_t get_bits(history_reader_t *r, int n) {
+    uint32_t value = 0;
+    if (r->bitpos + n > PAYLOAD_BITS) {
+        r->bitpos = PAYLOAD_BITS;   // Bloco corrompido: não ler além do payload
+        return 0;
+    }
+    while (n > 0) {
+        int room = 8 - (int)(r->bitpos & 7);
+        int take = n < room ? n : room;
+        uint32_t byte = r->block->payload[r->bitpos >> 3];
+        value = (value << take) | ((byte >> (room - take)) & ((1u << take) - 1));
+        r->bitpos += take;
+        n -= take;
+    }
+    return value;
+}
+
+// Inteiro com sinal em faixas: 0 | 10+4 | 110+8 | 1110+12 | 1111+32 bits
+static void put_signed(history_block_t *b, int32_t v) {
+    if (v == 0) {
+        put_bits(b, 0x0, 1);
+    } else if (v >= -8 && v < 8) {
+        put_bits(b, 0x2, 2);
+        put_bits(b, (uint32_t)v & 0xF, 4);
+    } else if (v >= -128 && v < 128) {
+        put_bits(b, 0x6, 3);
+        put_bits(b, (uint32_t)v & 0xFF, 8);
+    } else if (v >= -2048 && v < 2048) {
+        put_bits(b, 0xE, 4);
+        put_bits(b, (uint32_t)v & 0xFFF, 12);
+    } else {
+        put_bits(b, 0xF, 4);
+        put_bits(b, (uint32_t)v, 32);
+    }
+}
+
+static int32_t sign_extend(uint32_t v, int bits) {
+    uint32_t m = 1u << (bits - 1);
+    return (int32_t)((v ^ m) - m);
+}
+
+static int32_t get_signed(history_reader_t *r) {
+    if (get_bits(r, 1) == 0) return 0;
+    if (get_bits(r, 1) == 0) return sign_extend(get_bits(r, 4), 4);
+    if (get_bits(r, 1) == 0) return sign_extend(get_bits(r, 8), 8);
+    if (get_bits(r, 1) == 0) return sign_extend(get_bits(r, 12), 12);
+    return (int32_t)get_bits(r, 32);
+}
+
+// --- Blocos ---
+
+static history_block_t *ram_block(uint32_t seq) {
+    return &ram_blocks[seq % HISTORY_RAM_BLOCKS];
+}
+
+// CRC com o campo crc lido como zero, sem copiar o bloco (roda também na
+// IRQ do lwIP, via history_block, com pilha curta)
+static uint32_t block_crc(const history_block_t *b) {
+    static const uint32_t zero;
+    size_t at = offsetof(history_block_t, hdr.crc);
+    uint32_t crc = kv_crc32_update(0, b, at);
+    crc = kv_crc32_update(crc, &zero, sizeof(zero));
+    return kv_crc32_update(crc, (const uint8_t *)b + at + sizeof(zero), sizeof(*b) - at - sizeof(zero));
+}
+
+static void seal_block(void) {
+    history_block_t *b = ram_block(open_seq);
+    b->hdr.crc = block_crc(b);
+    stats.blocks_sealed++;
+    open_seq++;
+    // O próximo bloco aberto reaproveita a posição mais antiga do anel
+    if (open_seq - spill_seq >= HISTORY_RAM_BLOCKS) {
+        spill_seq++;
+        stats.blocks_lost++;
+    }
+    memset(ram_block(open_seq), 0, sizeof(history_block_t));
+}
+
+void history_append(const history_row_t *row) {
+    PROF_SCOPE("hist_append");
+    history_block_t *b = ram_block(open_seq);
+    if (b->hdr.count > 0 && b->hdr.bits + HISTORY_ROW_MAX_BITS > (int)PAYLOAD_BITS) {
+        seal_block();
+        b = ram_block(open_seq);
+    }
+
+    history_row_t cur = *row;
+    cur.vibration_mg -= cur.vibration_mg % HISTORY_VIB_STEP_MG;
+
+    if (b->hdr.count == 0) {
+        b->hdr.magic = HISTORY_MAGIC;
+        b->hdr.seq = open_seq;
+        b->hdr.boot = boot_id;
+        b->hdr.first = cur;
+        enc_prev_delta = HISTORY_PERIOD_MS / 1000;
+        stats.stored_bytes += sizeof(history_block_hdr_t);
+    } else {
+        uint32_t bytes_before = (b->hdr.bits + 7u) / 8u;
+        int32_t delta = (int32_t)(cur.time_s - enc_prev.time_s);
+        put_signed(b, delta - enc_prev_delta);
+        put_signed(b, cur.heater - enc_prev.heater);
+        put_signed(b, cur.conservative - enc_prev.conservative);
+        put_signed(b, (cur.vibration_mg - enc_prev.vibration_mg) / HISTORY_VIB_STEP_MG);
+        uint32_t relays = (cur.relays ^ enc_prev.relays) & 0x3;
+        if (relays) {
+            put_bits(b, 0x4 | relays, 3);
+        } else {
+            put_bits(b, 0, 1);
+        }
+        if (cur.shakes) {
+            put_bits(b, 0x100 | cur.shakes, 9);
+        } else {
+            put_bits(b, 0, 1);
+        }
+        enc_prev_delta = delta;
+        stats.stored_bytes += (b->hdr.bits + 7u) / 8u - bytes_before;
+    }
+    enc_prev = cur;
+    stats.rows++;
+    stats.raw_bytes += sizeof(history_row_t);
+
+    // Leitores na IRQ do lwIP (mesmo core) só enxergam a linha completa
+    __compiler_memory_barrier();
+    b->hdr.count++;
+}
+
+void history_reader_init(history_reader_t *reader, const history_block_t *block) {
+    memset(reader, 0, sizeof(*reader));
+    reader->block = block;
+    reader->count = block->hdr.count;
+    __compiler_memory_barrier();
+    reader->bits = block->hdr.bits;
+    reader->prev_delta = HISTORY_PERIOD_MS / 1000;
+}
+
+bool history_reader_next(history_reader_t *r, history_row_t *row) {
+    if (r->index >= r->count) {
+        return false;
+    }
+    if (r->index == 0) {
+        r->prev = r->block->hdr.first;
+    } else {
+        if (r->bitpos >= r->bits) {
+            return false;   // Bloco corrompido
+        }
+        history_row_t cur = r->prev;
+        int32_t delta = r->prev_delta + get_signed(r);
+        cur.time_s += (uint32_t)delta;
+        cur.heater = (int16_t)(cur.heater + get_signed(r));
+        cur.conservative = (int16_t)(cur.conservative + get_signed(r));
+        cur.vibration_mg = (uint16_t)(cur.vibration_mg + get_signed(r) * HISTORY_VIB_STEP_MG);
+        if (get_bits(r, 1)) cur.relays ^= (uint8_t)get_bits(r, 2);
+        cur.shakes = get_bits(r, 1) ? (uint8_t)get_bits(r, 8) : 0;
+        r->prev_delta = delta;
+        r->prev = cur;
+    }
+    *row = r->prev;
+    r->index++;
+    return true;
+}
+
+// --- Flash ---
+
+typedef struct {
+    uint32_t offset;
+    const uint8_t *data;   // NULL = apagar o setor
+} history_flash_op_t;
+
+static uint32_t slot_of(uint32_t seq) {
+    return (seq + slot_base) % FLASH_SLOTS;
+}
+
+static const history_block_t *flash_block(uint32_t slot) {
+    return (const history_block_t *)(uintptr_t)(XIP_BASE + HISTORY_REGION_OFFSET + slot * HISTORY_BLOCK_SIZE);
+}
+
+// Executado com interrupções desabilitadas e o outro core parado (flash_safe_execute)
+static void history_flash_exec(void *param) {
+    const history_flash_op_t *op = (const history_flash_op_t *)param;
+    if (op->data == NULL) {
+        flash_range_erase(op->offset, FLASH_SECTOR_SIZE);
+    } else {
+        flash_range_program(op->offset, op->data, HISTORY_BLOCK_SIZE);
+    }
+}
+
+static bool flash_op(uint32_t offset, const uint8_t *data) {
+    history_flash_op_t op = { offset, data };
+    int rc = flash_safe_execute(history_flash_exec, &op, 100);
+    if (rc != PICO_OK) {
+        stats.flash_failures++;
+        printf("[HIST] ERRO: operação na flash falhou (%d)\n", rc);
+        return false;
+    }
+    return true;
+}
+
+static bool slot_blank(uint32_t slot) {
+    const uint32_t *p = (const uint32_t *)flash_block(slot);
+    for (size_t i = 0; i < HISTORY_BLOCK_SIZE / 4; i++) {
+        if (p[i] != 0xFFFFFFFFu) return false;
+    }
+    return true;
+}
+
+// Um passo por execução: apagar o setor da próxima posição (início de setor
+// ou resto da volta anterior) ou gravar um bloco
+static void spill_step(void) {
+    if (spill_seq == open_seq) {
+        return;
+    }
+    uint32_t slot = slot_of(spill_seq);
+    if (!slot_blank(slot)) {
+        uint32_t sector = slot / BLOCKS_PER_SECTOR;
+        flash_op(HISTORY_REGION_OFFSET + sector * FLASH_SECTOR_SIZE, NULL);
+        return;
+    }
+    if (flash_op(HISTORY_REGION_OFFSET + slot * HISTORY_BLOCK_SIZE, (const uint8_t *)ram_block(spill_seq))) {
+        spill_seq++;
+        stats.blocks_spilled++;
+    }
+}
+
+// Cabeçalho plausível; o CRC completo só é conferido na leitura
+static bool header_sane(const history_block_hdr_t *hdr) {
+    return hdr->magic == HISTORY_MAGIC && hdr->count > 0 && hdr->bits <= PAYLOAD_BITS;
+}
+
+uint32_t history_open_seq(void) {
+    return open_seq;
+}
+
+uint32_t history_oldest_seq(void) {
+    uint32_t floor = open_seq >= FLASH_SLOTS ? open_seq - FLASH_SLOTS + 1 : 0;
+    return (int32_t)(oldest_seq - floor) > 0 ? oldest_seq : floor;
+}
+
+const history_block_t *history_block(uint32_t seq) {
+    // Blocos deste boot ainda no anel da RAM (o aberto inclusive)
+    if (open_seq - seq < HISTORY_RAM_BLOCKS) {
+        const history_block_t *b = ram_block(seq);
+        if (b->hdr.seq == seq && b->hdr.count > 0) {
+            return b;
+        }
+    }
+    if ((int32_t)(seq - open_seq) >= 0) {
+        return NULL;
+    }
+    const history_block_t *b = flash_block(slot_of(seq));
+    if (!header_sane(&b->hdr) || b->hdr.seq != seq || block_crc(b) != b->hdr.crc) {
+        return NULL;
+    }
+    return b;
+}
+
+// Última linha de um bloco (retomada do relógio no boot)
+static uint32_t block_last_time(const history_block_t *b) {
+    history_reader_t reader;
+    history_row_t row = b->hdr.first;
+    history_reader_init(&reader, b);
+    while (history_reader_next(&reader, &row)) {
+    }
+    return row.time_s;
+}
+
+uint32_t history_now_s(void) {
+    return time_base + (uint32_t)((hal_time_us64() + 500000) / 1000000);
+}
+
+// --- Agregados ---
+
+typedef struct {
+    int32_t sum;
+    int16_t min;
+    int16_t max;
+    uint16_t n;
+} acc_range_t;
+
+typedef struct {
+    history_bucket_t *ring;
+    uint32_t cap;
+    uint32_t seconds;
+    uint32_t total;                    // Buckets fechados (índice absoluto do próximo)
+    bool open;                         // Há um intervalo acumulando
+    history_bucket_t acc;              // time_s, count, shakes e relés do intervalo aberto
+    acc_range_t heater, conservative, vibration;
+} tier_t;
+
+static history_bucket_t minute_ring[HISTORY_MINUTE_BUCKETS];
+static history_bucket_t hour_ring[HISTORY_HOUR_BUCKETS];
+static tier_t tiers[HISTORY_TIER_COUNT] = {
+    [HISTORY_TIER_1S] = { NULL, 0, 1 },
+    [HISTORY_TIER_1MIN] = { minute_ring, HISTORY_MINUTE_BUCKETS, 60 },
+    [HISTORY_TIER_1H] = { hour_ring, HISTORY_HOUR_BUCKETS, 3600 },
+};
+
+// Cursor que alimenta os agregados a partir dos blocos
+static uint32_t feed_seq;
+static history_reader_t feed_reader;
+static bool feed_open = false;
+static bool rollups_ready = false;
+
+static void acc_add(acc_range_t *a, int32_t v) {
+    if (v == HISTORY_NO_TEMP) return;
+    if (a->n == 0 || v < a->min) a->min = (int16_t)v;
+    if (a->n == 0 || v > a->max) a->max = (int16_t)v;
+    a->sum += v;
+    a->n++;
+}
+
+static history_range_t acc_range(const acc_range_t *a) {
+    if (a->n == 0) {
+        return (history_range_t){ HISTORY_NO_TEMP, HISTORY_NO_TEMP, HISTORY_NO_TEMP };
+    }
+    int32_t half = a->sum >= 0 ? a->n / 2 : -(a->n / 2);
+    return (history_range_t){ a->min, a->max, (int16_t)((a->sum + half) / a->n) };
+}
+
+static void tier_close(tier_t *t) {
+    history_bucket_t b = t->acc;
+    b.heater = acc_range(&t->heater);
+    b.conservative = acc_range(&t->conservative);
+    b.vibration_mg = acc_range(&t->vibration);
+    // Grava antes de publicar: leitores na IRQ do lwIP conferem total
+    t->ring[t->total % t->cap] = b;
+    __compiler_memory_barrier();
+    t->total++;
+    t->open = false;
+}
+
+static void tier_add(tier_t *t, const history_row_t *row) {
+    uint32_t start = row->time_s - row->time_s % t->seconds;
+    if (t->open && start != t->acc.time_s) {
+        tier_close(t);
+    }
+    if (!t->open) {
+        memset(&t->acc, 0, sizeof(t->acc));
+        t->heater = (acc_range_t){ 0 };
+        t->conservative = (acc_range_t){ 0 };
+        t->vibration = (acc_range_t){ 0 };
+        t->acc.time_s = start;
+        t->open = true;
+    }
+    t->acc.count++;
+    t->acc.shakes += row->shakes;
+    if (row->relays & 1) t->acc.relay_on_s[0]++;
+    if (row->relays & 2) t->acc.relay_on_s[1]++;
+    acc_add(&t->heater, row->heater);
+    acc_add(&t->conservative, row->conservative);
+    acc_add(&t->vibration, row->vibration_mg > INT16_MAX ? INT16_MAX : row->vibration_mg);
+}
+
+// Consumir até max_rows linhas novas dos blocos, em ordem de sequência
+static void feed_step(uint32_t max_rows) {
+    history_row_t row;
+    // Na reconstrução o cursor pode ficar para trás de um setor apagado ou
+    // de um bloco da RAM reaproveitado
+    if (feed_open && feed_reader.block->hdr.seq != feed_seq) {
+        feed_open = false;
+        feed_seq++;
+    }
+    if ((int32_t)(feed_seq - history_oldest_seq()) < 0) {
+        feed_seq = history_oldest_seq();
+        feed_open = false;
+    }
+    while (max_rows > 0) {
+        if (!feed_open) {
+            const history_block_t *b = history_block(feed_seq);
+            if (b == NULL) {
+                if (feed_seq == open_seq) break;   // Bloco aberto ainda vazio
+                feed_seq++;                         // Apagado, perdido ou corrompido
+                continue;
+            }
+            history_reader_init(&feed_reader, b);
+            feed_open = true;
+        }
+        if (history_reader_next(&feed_reader, &row)) {
+            for (int t = HISTORY_TIER_1MIN; t < HISTORY_TIER_COUNT; t++) {
+                tier_add(&tiers[t], &row);
+            }
+            max_rows--;
+            continue;
+        }
+        // Fim do que estava visível: o bloco da RAM pode ter crescido
+        const history_block_t *b = feed_reader.block;
+        if (b->hdr.seq == feed_seq && b->hdr.count > feed_reader.count) {
+            feed_reader.count = b->hdr.count;
+            __compiler_memory_barrier();
+            feed_reader.bits = b->hdr.bits;
+            continue;
+        }
+        if (feed_seq == open_seq) break;
+        feed_seq++;
+        feed_open = false;
+    }
+    rollups_ready = max_rows > 0;
+}
+
+uint32_t history_tier_seconds(history_tier_t tier) {
+    return tiers[tier].seconds;
+}
+
+uint32_t history_bucket_end(history_tier_t tier) {
+    return tiers[tier].total;
+}
+
+// A posição total % cap é a próxima a ser sobrescrita
+uint32_t history_bucket_first(history_tier_t tier) {
+    const tier_t *t = &tiers[tier];
+    return t->total >= t->cap ? t->total - t->cap + 1 : 0;
+}
+
+bool history_bucket_get(history_tier_t tier, uint32_t n, history_bucket_t *out) {
+    const tier_t *t = &tiers[tier];
+    if (tier == HISTORY_TIER_1S || n - history_bucket_first(tier) >= t->total - history_bucket_first(tier)) {
+        return false;
+    }
+    *out = t->ring[n % t->cap];
+    return true;
+}
+
+uint32_t history_bucket_find(history_tier_t tier, uint32_t time_s) {
+    const tier_t *t = &tiers[tier];
+    uint32_t lo = history_bucket_first(tier);
+    uint32_t hi = t->total;
+    while (lo < hi) {
+        uint32_t mid = lo + (hi - lo) / 2;
+        if (t->ring[mid % t->cap].time_s < time_s) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return lo;
+}
+
+void history_bucket_from_row(history_bucket_t *bucket, const history_row_t *row) {
+    bucket->time_s = row->time_s;
+    bucket->count = 1;
+    bucket->shakes = row->shakes;
+    bucket->relay_on_s[0] = row->relays & 1;
+    bucket->relay_on_s[1] = (row->relays >> 1) & 1;
+    bucket->heater = (history_range_t){ row->heater, row->heater, row->heater };
+    bucket->conservative = (history_range_t){ row->conservative, row->conservative, row->conservative };
+    int16_t vib = row->vibration_mg > INT16_MAX ? INT16_MAX : (int16_t)row->vibration_mg;
+    bucket->vibration_mg = (history_range_t){ vib, vib, vib };
+}
+
+static void range_merge(history_range_t *into, uint16_t into_count, const history_range_t *r, uint16_t count) {
+    if (r->mean == HISTORY_NO_TEMP) return;
+    if (into->mean == HISTORY_NO_TEMP) {
+        *into = *r;
+        return;
+    }
+    if (r->min < into->min) into->min = r->min;
+    if (r->max > into->max) into->max = r->max;
+    int32_t total = (int32_t)into_count + count;
+    if (total > 0) {
+        int32_t sum = (int32_t)into->mean * into_count + (int32_t)r->mean * count;
+        into->mean = (int16_t)((sum + (sum >= 0 ? total / 2 : -total / 2)) / total);
+    }
+}
+
+// Juntar intervalos consecutivos (reamostragem para um passo maior)
+void history_bucket_merge(history_bucket_t *into, const history_bucket_t *bucket) {
+    if (into->count == 0) {
+        *into = *bucket;
+        return;
+    }
+    range_merge(&into->heater, into->count, &bucket->heater, bucket->count);
+    range_merge(&into->conservative, into->count, &bucket->conservative, bucket->count);
+    range_merge(&into->vibration_mg, into->count, &bucket->vibration_mg, bucket->count);
+    uint32_t count = (uint32_t)into->count + bucket->count;
+    into->count = count > UINT16_MAX ? UINT16_MAX : (uint16_t)count;
+    uint32_t shakes = (uint32_t)into->shakes + bucket->shakes;
+    into->shakes = shakes > UINT16_MAX ? UINT16_MAX : (uint16_t)shakes;
+    for (int i = 0; i < 2; i++) {
+        uint32_t on = (uint32_t)into->relay_on_s[i] + bucket->relay_on_s[i];
+        into->relay_on_s[i] = on > UINT16_MAX ? UINT16_MAX : (uint16_t)on;
+    }
+}
+
+// Instante mais antigo disponível em cada camada (UINT32_MAX = vazia)
+static uint32_t tier_oldest_s(history_tier_t tier) {
+    if (tier == HISTORY_TIER_1S) {
+        for (uint32_t seq = history_oldest_seq(); seq != open_seq + 1; seq++) {
+            const history_block_t *b = history_block(seq);
+            if (b != NULL) return b->hdr.first.time_s;
+        }
+        return UINT32_MAX;
+    }
+    history_bucket_t b;
+    return history_bucket_get(tier, history_bucket_first(tier), &b) ? b.time_s : UINT32_MAX;
+}
+
+// Camada mais grossa com resolução <= passo desejado (no máximo MAX_MERGE
+// itens por ponto) que cobre 'from' com folga de um passo; sem nenhuma, a
+// mais fina acima do passo que cobre; sem cobertura, a que guarda mais tempo.
+// A camada de 1 s sempre está em dia; as agregadas, só depois da reconstrução
+// (até lá a consulta pode percorrer mais linhas).
+history_tier_t history_pick_tier(uint32_t from_s, uint32_t to_s, uint32_t step_s,
+                                 uint32_t max_points, uint32_t *out_step_s) {
+    uint32_t span = to_s > from_s ? to_s - from_s : 0;
+    uint32_t want = step_s ? step_s : 1;
+    if (max_points > 0 && (span + max_points - 1) / max_points > want) {
+        want = (span + max_points - 1) / max_points;
+    }
+
+    int last = rollups_ready ? HISTORY_TIER_COUNT - 1 : HISTORY_TIER_1S;
+    int chosen = -1;
+    for (int t = last; t >= HISTORY_TIER_1S && chosen < 0; t--) {
+        uint32_t sec = tiers[t].seconds;
+        if (sec <= want && want / sec <= MAX_MERGE && tier_oldest_s((history_tier_t)t) <= from_s + want) {
+            chosen = t;
+        }
+    }
+    for (int t = HISTORY_TIER_1S; t <= last && chosen < 0; t++) {
+        if (tiers[t].seconds > want && tier_oldest_s((history_tier_t)t) <= from_s + want) chosen = t;
+    }
+    if (chosen < 0) {
+        chosen = last;
+    }
+    uint32_t sec = tiers[chosen].seconds;
+    *out_step_s = want < sec ? sec : (want + sec - 1) / sec * sec;
+    return (history_tier_t)chosen;
+}
+
+// --- Inicialização ---
+
+void history_init(void) {
+    memset(&stats, 0, sizeof(stats));
+    memset(ram_blocks, 0, sizeof(ram_blocks));
+
+    // Continuar depois do bloco mais novo (maior seq)
+    bool found = false;
+    uint32_t newest_seq = 0;
+    uint32_t newest_slot = 0;
+    for (uint32_t slot = 0; slot < FLASH_SLOTS; slot++) {
+        const history_block_hdr_t *hdr = &flash_block(slot)->hdr;
+        if (!header_sane(hdr)) continue;
+        stats.flash_blocks++;
+        if (!found || (int32_t)(hdr->seq - newest_seq) > 0) {
+            newest_seq = hdr->seq;
+            newest_slot = slot;
+        }
+        if (!found || (int32_t)(hdr->seq - oldest_seq) < 0) {
+            oldest_seq = hdr->seq;
+        }
+        found = true;
+    }
+
+    if (found) {
+        const history_block_t *newest = flash_block(newest_slot);
+        slot_base = (newest_slot + FLASH_SLOTS - newest_seq % FLASH_SLOTS) % FLASH_SLOTS;
+        open_seq = newest_seq + 1;
+        boot_id = (uint16_t)(newest->hdr.boot + 1);
+        if (block_crc(newest) == newest->hdr.crc) {
+            time_base = block_last_time(newest) + 1;
+        } else {
+            time_base = newest->hdr.first.time_s + 1;
+            printf("[HIST] Bloco %lu incompleto (queda durante a gravação?)\n", (unsigned long)newest_seq);
+        }
+    } else {
+        // Flash vazia; zera também o que uma chamada anterior deixou (testes)
+        slot_base = 0;
+        open_seq = 0;
+        oldest_seq = 0;
+        boot_id = 0;
+        time_base = 0;
+    }
+    spill_seq = open_seq;
+    feed_seq = oldest_seq;
+    feed_open = false;
+    rollups_ready = false;
+    stats.boot = boot_id;
+    printf("[HIST] Boot %u: %lu blocos na flash, próximo bloco %lu, relógio em %lu s\n", boot_id,
+           (unsigned long)stats.flash_blocks, (unsigned long)open_seq, (unsigned long)time_base);
+}
+
+// --- Amostragem ---
+
+static int16_t temp_value(const control_zone_t *zone) {
+    if (!zone->filter_ready || !isfinite(zone->filtered)) {
+        return HISTORY_NO_TEMP;
+    }
+    float v = roundf(zone->filtered * HISTORY_TEMP_SCALE);
+    if (v <= INT16_MIN) return INT16_MIN + 1;
+    if (v > INT16_MAX) return INT16_MAX;
+    return (int16_t)v;
+}
+
+void history_task(void *ctx) {
+    static ipc_snapshot_t snap;
+    static uint32_t last_shake_events;
+    static bool has_shake_events = false;
+
+    ipc_read_snapshot(&snap);
+    if (snap.valid) {
+        const control_zone_t *hz = &snap.zones[CONTROL_ZONE_HEATER];
+        const control_zone_t *cz = &snap.zones[CONTROL_ZONE_CONSERVATIVE];
+        uint32_t shakes = has_shake_events ? snap.shake_events - last_shake_events : 0;
+        last_shake_events = snap.shake_events;
+        has_shake_events = true;
+
+        history_row_t row = {
+            .time_s = history_now_s(),
+            .heater = temp_value(hz),
+            .conservative = temp_value(cz),
+            .vibration_mg = snap.vibration_mg,
+            .relays = (hz->relay_on ? 1 : 0) | (cz->relay_on ? 2 : 0),
+            .shakes = shakes > UINT8_MAX ? UINT8_MAX : (uint8_t)shakes,
+        };
+        history_append(&row);
+    }
+    feed_step(HISTORY_FEED_ROWS);
+    spill_step();
+}
+
+void history_get_stats(history_stats_t *out) {
+    *out = stats;
+    out->rollups_ready = rollups_ready;
+}
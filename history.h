@@ -0,0 +1,146 @@
+#ifndef HISTORY_H
+#define HISTORY_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+// Histórico comprimido (estilo Gorilla) das zonas e do MPU6050
+// Uma linha por segundo: temperatura das duas zonas, relés, índice de
+// vibração e viradas. As linhas vão para blocos de HISTORY_BLOCK_SIZE bytes:
+// a primeira fica crua no cabeçalho, as seguintes como bits -
+//   tempo: delta-do-delta (1 bit quando o período se mantém)
+//   temperaturas e vibração: delta em faixas de tamanho variável
+//   relés: XOR com a linha anterior; viradas: contagem do intervalo
+// Acrescentar uma linha é O(1) (no pior caso HISTORY_ROW_MAX_BITS bits).
+//
+// Os blocos fechados ficam num anel de HISTORY_RAM_BLOCKS na RAM e são
+// copiados, um por execução de history_task() (core 0), para um anel de
+// HISTORY_FLASH_SECTORS setores logo abaixo do kv_store - o mais antigo é
+// apagado quando o anel dá a volta. Cada bloco leva o número do boot e um
+// número de sequência contínuo entre boots; o bloco de sequência s mora
+// sempre na mesma posição do anel da flash.
+//
+// O tempo das linhas é o relógio do histórico: segundos de operação
+// acumulados, retomados no boot a partir da última linha gravada (não há
+// relógio de parede; o tempo desligado não conta).
+//
+// Agregados: a mesma tarefa mantém, linha a linha, mín/máx/média/contagem
+// por minuto e por hora em anéis na RAM (camadas HISTORY_TIER_*; a de 1 s
+// são os próprios blocos). No boot as camadas são reconstruídas a partir da
+// flash, HISTORY_FEED_ROWS linhas por execução. history_pick_tier() escolhe
+// a camada mais grossa que ainda atende o passo pedido, então uma consulta
+// percorre no máximo ~60 itens por ponto devolvido.
+
+#define HISTORY_BLOCK_SIZE 512         // 2 páginas da flash
+#define HISTORY_RAM_BLOCKS 32          // 16 KB (~2,5 h no ritmo típico)
+#define HISTORY_FLASH_SECTORS 64       // 256 KB (> 24 h no ritmo típico)
+#define HISTORY_PERIOD_MS 1000
+#define HISTORY_TEMP_SCALE 10          // Temperaturas em 0,1 °C
+#define HISTORY_VIB_STEP_MG 8          // Resolução guardada do índice de vibração
+#define HISTORY_NO_TEMP INT16_MIN      // Zona sem leitura filtrada
+#define HISTORY_ROW_MAX_BITS 156       // 4 deltas de 36 bits + relés (3) + viradas (9)
+#define HISTORY_MINUTE_BUCKETS 1440    // 24 h de agregados por minuto (45 KB)
+#define HISTORY_HOUR_BUCKETS 168       // 7 dias de agregados por hora (5 KB)
+#define HISTORY_FEED_ROWS 2000         // Linhas agregadas por execução na reconstrução
+
+typedef enum {
+    HISTORY_TIER_1S = 0,
+    HISTORY_TIER_1MIN,
+    HISTORY_TIER_1H,
+    HISTORY_TIER_COUNT
+} history_tier_t;
+
+// Linha descomprimida (12 bytes)
+typedef struct {
+    uint32_t time_s;                   // Relógio do histórico (s)
+    int16_t heater;                    // 0,1 °C
+    int16_t conservative;
+    uint16_t vibration_mg;             // Múltiplo de HISTORY_VIB_STEP_MG
+    uint8_t relays;                    // bit 0 = aquecedor, bit 1 = conservador
+    uint8_t shakes;                    // Viradas desde a linha anterior
+} history_row_t;
+
+typedef struct {
+    uint32_t magic;
+    uint32_t seq;                      // Ordem de gravação (contínua entre boots)
+    uint16_t boot;                     // Boot em que o bloco foi gravado
+    uint16_t count;                    // Linhas no bloco, incluindo a primeira
+    uint16_t bits;                     // Bits usados em payload
+    uint16_t reserved;
+    history_row_t first;
+    uint32_t crc;                      // kv_crc32 do bloco com este campo zerado
+} history_block_hdr_t;
+
+typedef struct {
+    history_block_hdr_t hdr;
+    uint8_t payload[HISTORY_BLOCK_SIZE - sizeof(history_block_hdr_t)];
+} history_block_t;
+
+// Decodificação sequencial de um bloco
+typedef struct {
+    const history_block_t *block;
+    uint16_t index;                    // Próxima linha
+    uint16_t count;                    // Linhas visíveis quando o leitor abriu
+    uint16_t bits;
+    uint32_t bitpos;
+    history_row_t prev;
+    int32_t prev_delta;
+} history_reader_t;
+
+typedef struct {
+    int16_t min;
+    int16_t max;
+    int16_t mean;
+} history_range_t;
+
+// Agregado de um intervalo (32 bytes)
+typedef struct {
+    uint32_t time_s;                   // Início do intervalo
+    uint16_t count;                    // Linhas agregadas
+    uint16_t shakes;
+    uint16_t relay_on_s[2];            // Linhas com cada relé ligado
+    history_range_t heater;            // 0,1 °C; tudo HISTORY_NO_TEMP se não houve leitura
+    history_range_t conservative;
+    history_range_t vibration_mg;
+} history_bucket_t;
+
+typedef struct {
+    uint16_t boot;
+    bool rollups_ready;                // Camadas agregadas em dia com os blocos
+    uint32_t rows;                     // Linhas acrescentadas neste boot
+    uint32_t raw_bytes;                // rows * sizeof(history_row_t)
+    uint32_t stored_bytes;             // Cabeçalhos + bits ocupados
+    uint32_t blocks_sealed;
+    uint32_t blocks_spilled;           // Copiados para a flash
+    uint32_t blocks_lost;              // Sobrescritos na RAM antes da cópia
+    uint32_t flash_blocks;             // Blocos válidos na flash ao iniciar
+    uint32_t flash_failures;
+} history_stats_t;
+
+// Funções públicas
+void history_init(void);                                   // Core 0, depois do kv_store_init
+void history_append(const history_row_t *row);             // O(1); só o core 0
+void history_task(void *ctx);                              // Tarefa do escalonador do core 0 (1 s)
+void history_get_stats(history_stats_t *stats);
+uint32_t history_now_s(void);                              // Relógio do histórico
+void history_reader_init(history_reader_t *reader, const history_block_t *block);
+bool history_reader_next(history_reader_t *reader, history_row_t *row);
+
+// Blocos (camada de 1 s), por número de sequência
+uint32_t history_oldest_seq(void);
+uint32_t history_open_seq(void);                           // Bloco aberto (o mais novo)
+const history_block_t *history_block(uint32_t seq);        // NULL se apagado, perdido ou corrompido
+
+// Agregados: n é um índice absoluto (não volta a zero quando o anel dá a volta)
+uint32_t history_tier_seconds(history_tier_t tier);
+uint32_t history_bucket_first(history_tier_t tier);        // Mais antigo ainda no anel
+uint32_t history_bucket_end(history_tier_t tier);          // Um depois do mais novo fechado
+uint32_t history_bucket_find(history_tier_t tier, uint32_t time_s);   // Primeiro com time_s >= time_s
+bool history_bucket_get(history_tier_t tier, uint32_t n, history_bucket_t *out);
+void history_bucket_from_row(history_bucket_t *bucket, const history_row_t *row);
+void history_bucket_merge(history_bucket_t *into, const history_bucket_t *bucket);
+history_tier_t history_pick_tier(uint32_t from_s, uint32_t to_s, uint32_t step_s,
+                                 uint32_t max_points, uint32_t *out_step_s);
+
+#endif // HISTORY_H
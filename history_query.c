@@ -0,0 +1,409 @@
+#include "history_query.h"
+#include <stdio.h>
+#include <string.h>
+#include "pico/stdlib.h"
+#include "cbor_writer.h"
+
+enum {
+    PHASE_HEADER = 0,
+    PHASE_WINDOWS,
+    PHASE_CURSOR,
+    PHASE_DONE,
+};
+
+const history_column_t history_columns[HISTORY_COLUMNS] = {
+    { "time", 0 }, { "count", 0 },
+    { "heater_min", 1 }, { "heater_max", 1 }, { "heater_mean", 1 },
+    { "freezer_min", 1 }, { "freezer_max", 1 }, { "freezer_mean", 1 },
+    { "vibration_min_mg", 0 }, { "vibration_max_mg", 0 }, { "vibration_mean_mg", 0 },
+    { "heater_on_s", 0 }, { "freezer_on_s", 0 }, { "shakes", 0 },
+};
+
+static const char *const tier_names[HISTORY_TIER_COUNT] = { "1s", "1min", "1h" };
+
+const char *history_tier_name(history_tier_t tier) {
+    return tier < HISTORY_TIER_COUNT ? tier_names[tier] : "?";
+}
+
+const char *history_format_mime(history_format_t format) {
+    switch (format) {
+        case HISTORY_FMT_NDJSON: return "application/x-ndjson";
+        case HISTORY_FMT_BIN: return "application/octet-stream";
+        case HISTORY_FMT_CBOR: return "application/cbor-seq";
+        default: return "text/csv; charset=UTF-8";
+    }
+}
+
+// Último bloco que começa em from_s ou antes (busca binária por sequência;
+// blocos ausentes são pulados)
+static uint32_t seek_block(uint32_t from_s) {
+    uint32_t lo = history_oldest_seq();
+    uint32_t hi = history_open_seq();
+    uint32_t best = lo;
+    while ((int32_t)(hi - lo) >= 0) {
+        uint32_t mid = lo + (hi - lo) / 2;
+        uint32_t probe = mid;
+        const history_block_t *b = NULL;
+        while ((int32_t)(hi - probe) >= 0 && (b = history_block(probe)) == NULL) {
+            probe++;
+        }
+        if (b == NULL) {
+            hi = mid - 1;
+        } else if (b->hdr.first.time_s <= from_s) {
+            best = probe;
+            lo = probe + 1;
+        } else {
+            hi = mid - 1;
+        }
+    }
+    return best;
+}
+
+void history_query_init(history_query_t *q, history_format_t format, uint32_t from_s, uint32_t to_s,
+                        uint32_t step_s, uint32_t max_points) {
+    memset(q, 0, sizeof(*q));
+    if (max_points == 0) max_points = HISTORY_QUERY_DEFAULT_POINTS;
+    if (max_points > HISTORY_QUERY_MAX_POINTS) max_points = HISTORY_QUERY_MAX_POINTS;
+
+    q->format = format;
+    q->max_points = max_points;
+    q->tier = history_pick_tier(from_s, to_s, step_s, max_points, &q->step_s);
+
+    // Janelas alinhadas ao passo; 'to' arredondado para cima, então nenhuma
+    // janela é cortada pelo pedido (só pela falta de dados)
+    q->from_s = from_s - from_s % q->step_s;
+    q->to_s = to_s % q->step_s ? to_s + (q->step_s - to_s % q->step_s) : to_s;
+    if (q->to_s < to_s) q->to_s = UINT32_MAX;   // Estouro: até o fim
+    q->next_s = q->from_s;
+    q->cursor_s = q->from_s;
+
+    if (q->tier == HISTORY_TIER_1S) {
+        q->seq = seek_block(q->from_s);
+    } else {
+        q->bucket_n = history_bucket_find(q->tier, q->from_s);
+    }
+}
+
+// Próximo item da camada em [next_s, to)
+static bool next_item(history_query_t *q, history_bucket_t *item) {
+    if (q->tier == HISTORY_TIER_1S) {
+        history_row_t row;
+        while (true) {
+            // Bloco da RAM reaproveitado ou setor apagado entre duas chamadas:
+            // reabrir pela sequência; next_s descarta o que já foi lido
+            if (q->reader_open && q->reader.block->hdr.seq != q->seq) {
+                q->reader_open = false;
+            }
+            if (!q->reader_open) {
+                if ((int32_t)(q->seq - history_open_seq()) > 0) return false;
+                const history_block_t *b = history_block(q->seq);
+                if (b == NULL) {
+                    if (q->seq == history_open_seq()) return false;
+                    q->seq++;
+                    continue;
+                }
+                history_reader_init(&q->reader, b);
+                q->reader_open = true;
+            }
+            if (!history_reader_next(&q->reader, &row)) {
+                const history_block_t *b = q->reader.block;
+                if (b->hdr.count > q->reader.count) {
+                    // Bloco aberto cresceu (ou foi fechado) desde a abertura
+                    q->reader.count = b->hdr.count;
+                    __compiler_memory_barrier();
+                    q->reader.bits = b->hdr.bits;
+                    continue;
+                }
+                if (q->seq == history_open_seq()) return false;
+                q->seq++;
+                q->reader_open = false;
+                continue;
+            }
+            if (row.time_s < q->next_s) continue;
+            if (row.time_s >= q->to_s) {
+                q->range_closed = true;
+                return false;
+            }
+            history_bucket_from_row(item, &row);
+            q->next_s = row.time_s + 1;
+            return true;
+        }
+    }
+
+    uint32_t seconds = history_tier_seconds(q->tier);
+    while (true) {
+        uint32_t first = history_bucket_first(q->tier);
+        if ((int32_t)(q->bucket_n - first) < 0) q->bucket_n = first;
+        if (!history_bucket_get(q->tier, q->bucket_n, item)) return false;
+        q->bucket_n++;
+        if (item->time_s < q->next_s) continue;
+        if (item->time_s >= q->to_s) {
+            q->range_closed = true;
+            return false;
+        }
+        q->next_s = item->time_s + seconds;
+        return true;
+    }
+}
+
+// 0,1 °C em texto; sem leitura = 'none'
+static int fmt_deci(char *out, size_t len, int16_t v, const char *none) {
+    if (v == HISTORY_NO_TEMP) {
+        return snprintf(out, len, "%s", none);
+    }
+    int32_t a = v < 0 ? -(int32_t)v : v;
+    return snprintf(out, len, "%s%ld.%ld", v < 0 ? "-" : "", (long)(a / 10), (long)(a % 10));
+}
+
+static int fmt_range_csv(char *out, size_t len, const history_range_t *r) {
+    int n = fmt_deci(out, len, r->min, "");
+    n += snprintf(out + n, len - n, ",");
+    n += fmt_deci(out + n, len - n, r->max, "");
+    n += snprintf(out + n, len - n, ",");
+    n += fmt_deci(out + n, len - n, r->mean, "");
+    return n;
+}
+
+static int fmt_range_json(char *out, size_t len, const char *key, const history_range_t *r) {
+    if (r->mean == HISTORY_NO_TEMP) {
+        return snprintf(out, len, ",\"%s\":null", key);
+    }
+    int n = snprintf(out, len, ",\"%s\":[", key);
+    n += fmt_deci(out + n, len - n, r->min, "null");
+    n += snprintf(out + n, len - n, ",");
+    n += fmt_deci(out + n, len - n, r->max, "null");
+    n += snprintf(out + n, len - n, ",");
+    n += fmt_deci(out + n, len - n, r->mean, "null");
+    return n + snprintf(out + n, len - n, "]");
+}
+
+static uint8_t *put_u16(uint8_t *p, uint16_t v) {
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+    return p + 2;
+}
+
+static uint8_t *put_u32(uint8_t *p, uint32_t v) {
+    p = put_u16(p, (uint16_t)v);
+    return put_u16(p, (uint16_t)(v >> 16));
+}
+
+static uint8_t *put_range(uint8_t *p, const history_range_t *r) {
+    p = put_u16(p, (uint16_t)r->min);
+    p = put_u16(p, (uint16_t)r->max);
+    return put_u16(p, (uint16_t)r->mean);
+}
+
+static void cbor_temp(cbor_writer_t *w, int16_t v) {
+    if (v == HISTORY_NO_TEMP) {
+        cbor_null(w);
+    } else {
+        cbor_int(w, v);
+    }
+}
+
+static void cbor_range(cbor_writer_t *w, const history_range_t *r) {
+    cbor_temp(w, r->min);
+    cbor_temp(w, r->max);
+    cbor_temp(w, r->mean);
+}
+
+int history_query_format_window(history_query_t *q, const history_bucket_t *w) {
+    char *out = q->line;
+    size_t len = sizeof(q->line);
+    int n = 0;
+    switch (q->format) {
+        case HISTORY_FMT_CSV:
+            n = snprintf(out, len, "%lu,%u,", (unsigned long)q->window_s, w->count);
+            n += fmt_range_csv(out + n, len - n, &w->heater);
+            n += snprintf(out + n, len - n, ",");
+            n += fmt_range_csv(out + n, len - n, &w->conservative);
+            n += snprintf(out + n, len - n, ",%d,%d,%d,%u,%u,%u\n",
+                          w->vibration_mg.min, w->vibration_mg.max, w->vibration_mg.mean,
+                          w->relay_on_s[0], w->relay_on_s[1], w->shakes);
+            break;
+        case HISTORY_FMT_NDJSON:
+            n = snprintf(out, len, "{\"t\":%lu,\"n\":%u", (unsigned long)q->window_s, w->count);
+            n += fmt_range_json(out + n, len - n, "heater", &w->heater);
+            n += fmt_range_json(out + n, len - n, "freezer", &w->conservative);
+            n += snprintf(out + n, len - n, ",\"vibration_mg\":[%d,%d,%d],\"relay_s\":[%u,%u],\"shakes\":%u}\n",
+                          w->vibration_mg.min, w->vibration_mg.max, w->vibration_mg.mean,
+                          w->relay_on_s[0], w->relay_on_s[1], w->shakes);
+            break;
+        case HISTORY_FMT_BIN: {
+            uint8_t *p = (uint8_t *)out;
+            p = put_u32(p, q->window_s);
+            p = put_u16(p, w->count);
+            p = put_u16(p, w->shakes);
+            p = put_u16(p, w->relay_on_s[0]);
+            p = put_u16(p, w->relay_on_s[1]);
+            p = put_range(p, &w->heater);
+            p = put_range(p, &w->conservative);
+            p = put_range(p, &w->vibration_mg);
+            n = (int)(p - (uint8_t *)out);
+            break;
+        }
+        case HISTORY_FMT_CBOR: {
+            // Índice da janela em vez do tempo: 1 a 3 bytes em vez de 5
+            cbor_writer_t c;
+            cbor_writer_init(&c, out, len);
+            cbor_array(&c, HISTORY_COLUMNS);
+            cbor_uint(&c, (q->window_s - q->from_s) / q->step_s);
+            cbor_uint(&c, w->count);
+            cbor_range(&c, &w->heater);
+            cbor_range(&c, &w->conservative);
+            cbor_int(&c, w->vibration_mg.min);
+            cbor_int(&c, w->vibration_mg.max);
+            cbor_int(&c, w->vibration_mg.mean);
+            cbor_uint(&c, w->relay_on_s[0]);
+            cbor_uint(&c, w->relay_on_s[1]);
+            cbor_uint(&c, w->shakes);
+            n = (int)cbor_writer_len(&c);
+            break;
+        }
+    }
+    return n < (int)len ? n : (int)len - 1;
+}
+
+static int format_header(history_query_t *q) {
+    char *out = q->line;
+    size_t len = sizeof(q->line);
+    switch (q->format) {
+        case HISTORY_FMT_CSV: {
+            int n = 0;
+            for (int i = 0; i < HISTORY_COLUMNS; i++) {
+                n += snprintf(out + n, len - n, "%s%s", i ? "," : "", history_columns[i].name);
+            }
+            return n + snprintf(out + n, len - n, "\n");
+        }
+        case HISTORY_FMT_NDJSON:
+            return snprintf(out, len, "{\"tier\":\"%s\",\"step\":%lu,\"from\":%lu,\"to\":%lu}\n",
+                            history_tier_name(q->tier), (unsigned long)q->step_s,
+                            (unsigned long)q->from_s, (unsigned long)q->to_s);
+        case HISTORY_FMT_BIN: {
+            uint8_t *p = (uint8_t *)out;
+            memcpy(p, "IBH1", 4);
+            p = put_u16(p + 4, HISTORY_BIN_RECORD);
+            p = put_u16(p, (uint16_t)q->tier);
+            p = put_u32(p, q->step_s);
+            return (int)(p - (uint8_t *)out);
+        }
+        case HISTORY_FMT_CBOR: {
+            cbor_writer_t c;
+            cbor_writer_init(&c, out, len);
+            cbor_map(&c, 5);
+            cbor_text(&c, "v");
+            cbor_uint(&c, CBOR_SCHEMA_VERSION);
+            cbor_text(&c, "tier");
+            cbor_text(&c, history_tier_name(q->tier));
+            cbor_text(&c, "step");
+            cbor_uint(&c, q->step_s);
+            cbor_text(&c, "from");
+            cbor_uint(&c, q->from_s);
+            cbor_text(&c, "to");
+            cbor_uint(&c, q->to_s);
+            return (int)cbor_writer_len(&c);
+        }
+    }
+    return 0;
+}
+
+static int format_cursor(history_query_t *q) {
+    switch (q->format) {
+        case HISTORY_FMT_CSV:
+            return snprintf(q->line, sizeof(q->line), "# cursor=%lu\n", (unsigned long)q->cursor_s);
+        case HISTORY_FMT_NDJSON:
+            return snprintf(q->line, sizeof(q->line), "{\"cursor\":%lu,\"points\":%lu}\n",
+                            (unsigned long)q->cursor_s, (unsigned long)q->points);
+        case HISTORY_FMT_BIN: {
+            history_bucket_t end;
+            memset(&end, 0, sizeof(end));
+            uint32_t window_s = q->window_s;
+            q->window_s = q->cursor_s;
+            int n = history_query_format_window(q, &end);
+            q->window_s = window_s;
+            return n;
+        }
+        case HISTORY_FMT_CBOR: {
+            cbor_writer_t c;
+            cbor_writer_init(&c, q->line, sizeof(q->line));
+            cbor_map(&c, 2);
+            cbor_text(&c, "cursor");
+            cbor_uint(&c, q->cursor_s);
+            cbor_text(&c, "points");
+            cbor_uint(&c, q->points);
+            return (int)cbor_writer_len(&c);
+        }
+    }
+    return 0;
+}
+
+// Fecha a janela em montagem como a próxima linha
+static int emit_window(history_query_t *q) {
+    int n = history_query_format_window(q, &q->window);
+    q->cursor_s = q->window_s + q->step_s;
+    q->points++;
+    memset(&q->window, 0, sizeof(q->window));
+    return n;
+}
+
+// Próxima linha em q->line; 0 = acabou
+static int produce_line(history_query_t *q) {
+    while (q->phase == PHASE_WINDOWS) {
+        if (q->points >= q->max_points) {
+            q->phase = PHASE_CURSOR;
+            break;
+        }
+        history_bucket_t item;
+        if (q->has_pending) {
+            item = q->pending;
+            q->has_pending = false;
+        } else if (!next_item(q, &item)) {
+            // Sem mais itens: a janela aberta só sai se estiver completa
+            q->phase = PHASE_CURSOR;
+            if (q->window.count > 0 && (q->range_closed || q->window_s + q->step_s <= q->next_s)) {
+                return emit_window(q);
+            }
+            break;
+        }
+        uint32_t start = item.time_s - item.time_s % q->step_s;
+        if (q->window.count > 0 && start != q->window_s) {
+            q->pending = item;
+            q->has_pending = true;
+            return emit_window(q);
+        }
+        if (q->window.count == 0) {
+            q->window_s = start;
+        }
+        history_bucket_merge(&q->window, &item);
+    }
+
+    switch (q->phase) {
+        case PHASE_HEADER:
+            q->phase = PHASE_WINDOWS;
+            return format_header(q);
+        case PHASE_CURSOR:
+            q->phase = PHASE_DONE;
+            return format_cursor(q);
+        default:
+            return 0;
+    }
+}
+
+size_t history_query_render(history_query_t *q, char *out, size_t out_len) {
+    size_t used = 0;
+    while (true) {
+        if (q->line_len == 0) {
+            int n = produce_line(q);
+            if (n <= 0) break;
+            q->line_len = (uint16_t)n;
+        }
+        if (used + q->line_len > out_len) {
+            break;
+        }
+        memcpy(out + used, q->line, q->line_len);
+        used += q->line_len;
+        q->line_len = 0;
+    }
+    return used;
+}
@@ -0,0 +1,86 @@
+#ifndef HISTORY_QUERY_H
+#define HISTORY_QUERY_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "history.h"
+
+// Consulta ao histórico (GET /api/history), gerada em partes
+// A consulta escolhe a camada (history_pick_tier), percorre os itens de
+// [from, to) e junta os que caem na mesma janela de 'step' segundos. Cada
+// chamada de history_query_render() escreve as linhas inteiras que couberem
+// e guarda a posição na própria consulta - nada além de uma linha fica em
+// buffer. Uma janela só sai quando está completa (o próximo item já passou
+// dela, ou o intervalo pedido terminou); a última linha traz o cursor, o
+// início da primeira janela ainda não enviada. Passar esse valor em 'since'
+// devolve só o que chegou depois.
+//
+// Formatos: CSV, NDJSON e binário little-endian (cabeçalho de 12 bytes:
+// "IBH1", tamanho do registro (u16), camada (u16), passo (u32); registros de
+// HISTORY_BIN_RECORD bytes; o último tem count = 0 e o cursor no tempo).
+//
+// CBOR: sequência de itens (RFC 8742, application/cbor-seq), um por linha do
+// NDJSON: mapa {"v", "tier", "step", "from", "to"}, uma janela por array com
+// as colunas de history_columns[] e o mapa {"cursor", "points"} no fim. A
+// primeira coluna é o índice da janela (tempo = from + índice * step), não o
+// tempo absoluto; temperaturas em 0,1 °C inteiros, null sem leitura.
+
+#define HISTORY_QUERY_DEFAULT_POINTS 720
+#define HISTORY_QUERY_MAX_POINTS 5000
+#define HISTORY_BIN_RECORD 30
+
+typedef enum {
+    HISTORY_FMT_CSV = 0,
+    HISTORY_FMT_NDJSON,
+    HISTORY_FMT_BIN,
+    HISTORY_FMT_CBOR,
+} history_format_t;
+
+// Colunas de uma janela (cabeçalho do CSV, array do CBOR, GET /api/schema)
+typedef struct {
+    const char *name;
+    uint8_t decimals;      // Inteiro / 10^decimals; 0 = como está
+} history_column_t;
+
+#define HISTORY_COLUMNS 14
+extern const history_column_t history_columns[HISTORY_COLUMNS];
+
+typedef struct {
+    history_format_t format;
+    history_tier_t tier;
+    uint8_t phase;                     // Cabeçalho, janelas, cursor, fim
+    uint32_t from_s;                   // Início da primeira janela
+    uint32_t to_s;                     // Exclusivo
+    uint32_t step_s;
+    uint32_t max_points;
+    uint32_t points;
+    uint32_t next_s;                   // Itens antes disso já foram consumidos
+    uint32_t cursor_s;                 // Devolvido ao cliente no fim
+    bool range_closed;                 // Algum item em 'to' ou depois: nada mais vai entrar
+
+    // Posição na camada: blocos (1 s) ou índice absoluto do agregado
+    uint32_t seq;
+    bool reader_open;
+    history_reader_t reader;
+    uint32_t bucket_n;
+
+    // Janela em montagem
+    uint32_t window_s;
+    history_bucket_t window;
+    history_bucket_t pending;          // Item lido que já pertence à próxima janela
+    bool has_pending;
+
+    char line[224];                    // Linha que não coube na última chamada
+    uint16_t line_len;
+} history_query_t;
+
+// Funções públicas (contexto do lwIP)
+void history_query_init(history_query_t *q, history_format_t format, uint32_t from_s, uint32_t to_s,
+                        uint32_t step_s, uint32_t max_points);
+size_t history_query_render(history_query_t *q, char *out, size_t out_len);   // 0 = terminou
+int history_query_format_window(history_query_t *q, const history_bucket_t *w);   // Em q->line (e no bench)
+const char *history_format_mime(history_format_t format);
+const char *history_tier_name(history_tier_t tier);
+
+#endif // HISTORY_QUERY_H
@@ -0,0 +1,149 @@
+// Build para Linux: o que os módulos esperam do SDK do Pico, sobre POSIX
+// Flash num arquivo mapeado (sobrevive entre execuções, como a flash real),
+// relógio monotônico desde o início do processo e o core 1 numa thread.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <pthread.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include "pico/stdlib.h"
+#include "pico/flash.h"
+#include "pico/multicore.h"
+#include "hardware/flash.h"
+#include "hardware/watchdog.h"
+#include "tusb.h"
+
+// Flash: IBAG_FLASH (padrão ibag_flash.bin) com o tamanho da flash do pico2_w.
+// O mapeamento é MAP_SHARED no endereço fixo de host_flash: kv_store, history
+// e autotune leem direto por XIP_BASE, como no alvo.
+uint8_t host_flash[PICO_FLASH_SIZE_BYTES] __attribute__((aligned(4096)));
+
+static void flash_map(void) {
+    const char *path = getenv("IBAG_FLASH");
+    if (path == NULL) {
+        path = "ibag_flash.bin";
+    }
+    int fd = open(path, O_RDWR | O_CREAT, 0644);
+    if (fd < 0) {
+        fprintf(stderr, "[HOST] Falha ao abrir %s: %s (flash só em memória)\n", path, strerror(errno));
+        memset(host_flash, 0xFF, sizeof(host_flash));
+        return;
+    }
+    off_t size = lseek(fd, 0, SEEK_END);
+    if (size < (off_t)sizeof(host_flash)) {
+        // Arquivo novo: flash apagada
+        static const uint8_t erased[FLASH_SECTOR_SIZE] = { [0 ... FLASH_SECTOR_SIZE - 1] = 0xFF };
+        for (off_t off = size & ~(off_t)(FLASH_SECTOR_SIZE - 1); off < (off_t)sizeof(host_flash); off += FLASH_SECTOR_SIZE) {
+            if (pwrite(fd, erased, FLASH_SECTOR_SIZE, off) != FLASH_SECTOR_SIZE) {
+                break;
+            }
+        }
+    }
+    if (mmap(host_flash, sizeof(host_flash), PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, fd, 0) == MAP_FAILED) {
+        fprintf(stderr, "[HOST] mmap de %s falhou: %s (flash só em memória)\n", path, strerror(errno));
+        memset(host_flash, 0xFF, sizeof(host_flash));
+    } else {
+        printf("[HOST] Flash simulada: %s\n", path);
+    }
+    close(fd);
+}
+
+void flash_range_erase(uint32_t flash_offs, size_t count) {
+    memset(&host_flash[flash_offs], 0xFF, count);
+}
+
+void flash_range_program(uint32_t flash_offs, const uint8_t *data, size_t count) {
+    for (size_t i = 0; i < count; i++) {
+        host_flash[flash_offs + i] &= data[i];
+    }
+}
+
+// Sem XIP para proteger; a trava serializa as gravações dos dois "cores"
+static pthread_mutex_t flash_lock = PTHREAD_MUTEX_INITIALIZER;
+
+int flash_safe_execute(void (*func)(void *), void *param, uint32_t enter_exit_timeout_ms) {
+    (void)enter_exit_timeout_ms;
+    pthread_mutex_lock(&flash_lock);
+    func(param);
+    pthread_mutex_unlock(&flash_lock);
+    return PICO_OK;
+}
+
+bool flash_safe_execute_core_init(void) {
+    return true;
+}
+
+// Relógio: zero no início do processo, como o timer do RP2350 no boot
+static struct timespec boot_ts;
+
+uint64_t hal_time_us64(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)(ts.tv_sec - boot_ts.tv_sec) * 1000000u +
+           (uint64_t)((ts.tv_nsec - boot_ts.tv_nsec) / 1000);
+}
+
+uint32_t hal_time_us(void) {
+    return (uint32_t)hal_time_us64();
+}
+
+uint32_t hal_time_ms(void) {
+    return (uint32_t)(hal_time_us64() / 1000u);
+}
+
+void hal_sleep_ms(uint32_t ms) {
+    struct timespec ts = { .tv_sec = ms / 1000u, .tv_nsec = (long)(ms % 1000u) * 1000000L };
+    while (nanosleep(&ts, &ts) != 0 && errno == EINTR) {
+    }
+}
+
+// Core 1
+static _Thread_local uint core_num;
+static pthread_t core1_thread;
+
+uint get_core_num(void) {
+    return core_num;
+}
+
+static void *core1_entry(void *arg) {
+    core_num = 1;
+    ((void (*)(void))arg)();
+    return NULL;
+}
+
+void multicore_launch_core1(void (*entry)(void)) {
+    if (pthread_create(&core1_thread, NULL, core1_entry, (void *)entry) != 0) {
+        fprintf(stderr, "[HOST] Falha ao criar a thread do core 1\n");
+        exit(1);
+    }
+}
+
+// Console: stdin no lugar do USB serial
+bool stdio_init_all(void) {
+    clock_gettime(CLOCK_MONOTONIC, &boot_ts);
+    setvbuf(stdout, NULL, _IOLBF, 0);
+    flash_map();
+    return true;
+}
+
+int getchar_timeout_us(uint32_t timeout_us) {
+    struct pollfd pfd = { .fd = STDIN_FILENO, .events = POLLIN };
+    if (poll(&pfd, 1, (int)(timeout_us / 1000u)) <= 0 || !(pfd.revents & POLLIN)) {
+        return PICO_ERROR_TIMEOUT;
+    }
+    unsigned char c;
+    return read(STDIN_FILENO, &c, 1) == 1 ? c : PICO_ERROR_TIMEOUT;
+}
+
+// Porta de telemetria (tusb.h): fechada, a não ser que um teste instale o destino
+host_cdc_write_fn host_cdc_write;
+
+// Registradores de rascunho do watchdog (o supervisor grava o relatório)
+static watchdog_hw_t watchdog_regs;
+watchdog_hw_t *const watchdog_hw = &watchdog_regs;
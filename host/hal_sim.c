@@ -0,0 +1,158 @@
+// Build para Linux: dispositivos simulados atrás do hal.h
+// LM35: temperatura de primeira ordem por zona - cada relé puxa a sua zona
+// para a temperatura do Peltier (quente ou frio) e, desligado, ela volta ao
+// ambiente. MPU6050: registradores em memória com 1 g em Z, ruído e
+// chacoalhadas periódicas (IBAG_SIM_SHAKE_S).
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <pthread.h>
+#include "hal.h"
+#include "control.h"
+#include "mpu6050.h"
+
+#define AMBIENT_C 25.0f
+#define HOT_PLATE_C 70.0f        // Para onde o Peltier do aquecedor puxa
+#define COLD_PLATE_C 0.0f        // Para onde o Peltier do conservador puxa
+#define TAU_ON_S 300.0f          // Constante de tempo com o relé ligado
+#define TAU_OFF_S 900.0f         // Perda para o ambiente com o relé desligado
+#define ADC_NOISE_COUNTS 2       // ±LSB de ruído por leitura
+
+#define GPIO_COUNT 48
+
+static pthread_mutex_t sim_lock = PTHREAD_MUTEX_INITIALIZER;
+static bool gpio_out[GPIO_COUNT];
+
+// Modelo térmico (um por canal do ADC)
+typedef struct {
+    uint8_t channel;
+    uint32_t relay_pin;
+    float plate_c;
+    float temp_c;
+    uint64_t last_us;
+} sim_zone_t;
+
+static sim_zone_t sim_zones[] = {
+    { ADC_HEATER, HEATER_RELAY_PIN, HOT_PLATE_C, AMBIENT_C, 0 },
+    { ADC_CONSERVATIVE, CONSERVATIVE_RELAY_PIN, COLD_PLATE_C, AMBIENT_C, 0 },
+};
+
+static int noise(int amplitude) {
+    return rand() % (2 * amplitude + 1) - amplitude;
+}
+
+void hal_gpio_init_out(uint32_t pin, bool value) {
+    hal_gpio_put(pin, value);
+}
+
+void hal_gpio_put(uint32_t pin, bool value) {
+    if (pin < GPIO_COUNT) {
+        pthread_mutex_lock(&sim_lock);
+        gpio_out[pin] = value;
+        pthread_mutex_unlock(&sim_lock);
+    }
+}
+
+void hal_adc_init(void) {
+    const char *ambient = getenv("IBAG_SIM_AMBIENT_C");
+    for (size_t i = 0; i < sizeof(sim_zones) / sizeof(sim_zones[0]); i++) {
+        sim_zones[i].temp_c = ambient ? strtof(ambient, NULL) : AMBIENT_C;
+        sim_zones[i].last_us = hal_time_us64();
+    }
+}
+
+void hal_adc_init_pin(uint32_t gpio) {
+    (void)gpio;
+}
+
+// Avança o modelo até agora: relaxação exponencial para o alvo do momento
+static void zone_step(sim_zone_t *z, uint64_t now_us) {
+    float dt = (float)(now_us - z->last_us) / 1e6f;
+    z->last_us = now_us;
+    bool on = gpio_out[z->relay_pin];
+    float target = on ? z->plate_c : AMBIENT_C;
+    float tau = on ? TAU_ON_S : TAU_OFF_S;
+    z->temp_c = target + (z->temp_c - target) * expf(-dt / tau);
+}
+
+uint16_t hal_adc_read(uint8_t channel) {
+    float temp_c = AMBIENT_C;
+    pthread_mutex_lock(&sim_lock);
+    for (size_t i = 0; i < sizeof(sim_zones) / sizeof(sim_zones[0]); i++) {
+        if (sim_zones[i].channel == channel) {
+            zone_step(&sim_zones[i], hal_time_us64());
+            temp_c = sim_zones[i].temp_c;
+        }
+    }
+    pthread_mutex_unlock(&sim_lock);
+
+    // LM35: 10 mV/°C, ADC de 12 bits com referência de 3,3 V
+    int raw = (int)lroundf(temp_c * 0.01f / 3.3f * 4095.0f) + noise(ADC_NOISE_COUNTS);
+    return (uint16_t)(raw < 0 ? 0 : raw > 4095 ? 4095 : raw);
+}
+
+// MPU6050: registrador apontado pela última escrita e 128 registradores
+static uint8_t mpu_regs[128];
+static uint8_t mpu_pointer;
+static uint32_t shake_period_us;
+
+void hal_i2c_init(uint32_t baudrate, uint32_t sda_pin, uint32_t scl_pin) {
+    (void)baudrate; (void)sda_pin; (void)scl_pin;
+    memset(mpu_regs, 0, sizeof(mpu_regs));
+    mpu_regs[MPU6050_WHO_AM_I] = MPU6050_ADDR;
+    mpu_regs[MPU6050_PWR_MGMT_1] = 0x40;   // Sleep após o reset
+    const char *shake = getenv("IBAG_SIM_SHAKE_S");
+    shake_period_us = shake ? (uint32_t)(atoi(shake) * 1000000) : 0;
+}
+
+static void put_be16(uint8_t *p, int value) {
+    int16_t v = (int16_t)(value < -32768 ? -32768 : value > 32767 ? 32767 : value);
+    p[0] = (uint8_t)((uint16_t)v >> 8);
+    p[1] = (uint8_t)v;
+}
+
+// Parado com 1 g em Z; nos primeiros 300 ms de cada período, uma virada
+static void mpu_sample(void) {
+    bool shaking = shake_period_us != 0 && hal_time_us64() % shake_period_us < 300000;
+    int ax = noise(60), ay = noise(60), az = 16384 + noise(60);
+    int gx = noise(30), gy = noise(30), gz = noise(30);
+    if (shaking) {
+        ax += 18000;
+        az -= 9000;
+        gz += 20000;
+    }
+    put_be16(&mpu_regs[MPU6050_ACCEL_XOUT_H + 0], ax);
+    put_be16(&mpu_regs[MPU6050_ACCEL_XOUT_H + 2], ay);
+    put_be16(&mpu_regs[MPU6050_ACCEL_XOUT_H + 4], az);
+    put_be16(&mpu_regs[MPU6050_GYRO_XOUT_H + 0], gx);
+    put_be16(&mpu_regs[MPU6050_GYRO_XOUT_H + 2], gy);
+    put_be16(&mpu_regs[MPU6050_GYRO_XOUT_H + 4], gz);
+}
+
+int hal_i2c_write(uint8_t addr, const uint8_t *src, size_t len, bool nostop, uint32_t timeout_us) {
+    (void)nostop; (void)timeout_us;
+    if (addr != MPU6050_ADDR || len == 0) {
+        return -1;   // Ninguém responde (PICO_ERROR_GENERIC)
+    }
+    mpu_pointer = src[0] & 0x7F;
+    for (size_t i = 1; i < len; i++) {
+        mpu_regs[(mpu_pointer + i - 1) & 0x7F] = src[i];
+    }
+    return (int)len;
+}
+
+int hal_i2c_read(uint8_t addr, uint8_t *dst, size_t len, bool nostop, uint32_t timeout_us) {
+    (void)nostop; (void)timeout_us;
+    if (addr != MPU6050_ADDR) {
+        return -1;
+    }
+    if (mpu_pointer == MPU6050_ACCEL_XOUT_H || mpu_pointer == MPU6050_GYRO_XOUT_H) {
+        mpu_sample();
+    }
+    for (size_t i = 0; i < len; i++) {
+        dst[i] = mpu_regs[(mpu_pointer + i) & 0x7F];
+    }
+    return (int)len;
+}
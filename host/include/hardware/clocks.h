@@ -0,0 +1,11 @@
+#ifndef HOST_HARDWARE_CLOCKS_H
+#define HOST_HARDWARE_CLOCKS_H
+
+#include <stdint.h>
+
+enum clock_index { clk_sys = 0 };
+
+// prof.c só usa para converter ciclos em µs (desligado no host)
+static inline uint32_t clock_get_hz(enum clock_index clk) { (void)clk; return 150000000u; }
+
+#endif // HOST_HARDWARE_CLOCKS_H
@@ -0,0 +1,14 @@
+#ifndef HOST_HARDWARE_SYNC_H
+#define HOST_HARDWARE_SYNC_H
+
+#include <stdint.h>
+
+// Threads não dormem em WFE (power_host.c dorme em fatias curtas)
+static inline void __sev(void) { }
+static inline void __wfe(void) { }
+
+// O lwIP do host roda no laço principal, não numa interrupção: nada a mascarar
+static inline uint32_t save_and_disable_interrupts(void) { return 0; }
+static inline void restore_interrupts(uint32_t status) { (void)status; }
+
+#endif // HOST_HARDWARE_SYNC_H
@@ -0,0 +1,19 @@
+#ifndef HOST_HARDWARE_WATCHDOG_H
+#define HOST_HARDWARE_WATCHDOG_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// Sem reset no host: o supervisor detecta e registra, o processo segue
+typedef struct {
+    uint32_t scratch[8];
+} watchdog_hw_t;
+
+extern watchdog_hw_t *const watchdog_hw;
+
+static inline bool watchdog_enable_caused_reboot(void) { return false; }
+static inline void watchdog_enable(uint32_t delay_ms, bool pause_on_debug) { (void)delay_ms; (void)pause_on_debug; }
+static inline void watchdog_disable(void) { }
+static inline void watchdog_update(void) { }
+
+#endif // HOST_HARDWARE_WATCHDOG_H
@@ -0,0 +1,11 @@
+#ifndef HOST_PICO_FLASH_H
+#define HOST_PICO_FLASH_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// Sem XIP no host: nada a pausar, a função roda direto
+int flash_safe_execute(void (*func)(void *), void *param, uint32_t enter_exit_timeout_ms);
+bool flash_safe_execute_core_init(void);
+
+#endif // HOST_PICO_FLASH_H
@@ -0,0 +1,7 @@
+#ifndef HOST_PICO_MULTICORE_H
+#define HOST_PICO_MULTICORE_H
+
+// O "core 1" é uma thread (get_core_num() devolve 1 nela)
+void multicore_launch_core1(void (*entry)(void));
+
+#endif // HOST_PICO_MULTICORE_H
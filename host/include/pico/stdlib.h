@@ -0,0 +1,38 @@
+#ifndef HOST_PICO_STDLIB_H
+#define HOST_PICO_STDLIB_H
+
+// Build para Linux: o pedaço do SDK do Pico que os módulos usam além do
+// hal.h (tipos, relógio, núcleo atual, console), sobre POSIX (host/compat.c)
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdio.h>
+#include "hal.h"
+
+typedef unsigned int uint;
+typedef uint64_t absolute_time_t;
+
+#define PICO_OK 0
+#define PICO_ERROR_TIMEOUT (-1)
+
+// Flash simulada (host/compat.c): mesma geometria do pico2_w
+#define PICO_FLASH_SIZE_BYTES (4u * 1024u * 1024u)
+extern uint8_t host_flash[];
+#define XIP_BASE ((uintptr_t)host_flash)
+
+static inline uint64_t time_us_64(void) { return hal_time_us64(); }
+static inline uint32_t time_us_32(void) { return hal_time_us(); }
+static inline absolute_time_t get_absolute_time(void) { return hal_time_us64(); }
+static inline uint32_t to_ms_since_boot(absolute_time_t t) { return (uint32_t)(t / 1000u); }
+static inline absolute_time_t from_us_since_boot(uint64_t us) { return us; }
+static inline void sleep_ms(uint32_t ms) { hal_sleep_ms(ms); }
+static inline void tight_loop_contents(void) { }
+
+#define __compiler_memory_barrier() __asm__ volatile("" ::: "memory")
+
+uint get_core_num(void);                   // 0 = thread principal, 1 = thread do "core 1"
+bool stdio_init_all(void);
+int getchar_timeout_us(uint32_t timeout_us);   // stdin sem bloquear
+
+#endif // HOST_PICO_STDLIB_H
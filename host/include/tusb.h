@@ -0,0 +1,24 @@
+#ifndef HOST_TUSB_H
+#define HOST_TUSB_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// Sem USB no host: a porta de telemetria só abre se houver um destino para
+// os bytes em host_cdc_write (test/telemetry_frames.c grava os quadros num
+// arquivo); no ibag_host fica NULL e telemetry.c não grava nada
+typedef uint32_t (*host_cdc_write_fn)(const void *buf, uint32_t len);
+extern host_cdc_write_fn host_cdc_write;
+
+static inline bool tud_inited(void) { return true; }
+static inline bool tusb_init(void) { return true; }
+static inline void tud_task(void) { }
+static inline bool tud_cdc_n_connected(uint8_t itf) { (void)itf; return host_cdc_write != NULL; }
+static inline uint32_t tud_cdc_n_write_available(uint8_t itf) { (void)itf; return host_cdc_write ? 4096 : 0; }
+static inline uint32_t tud_cdc_n_write(uint8_t itf, const void *buf, uint32_t len) {
+    (void)itf;
+    return host_cdc_write ? host_cdc_write(buf, len) : 0;
+}
+static inline uint32_t tud_cdc_n_write_flush(uint8_t itf) { (void)itf; return 0; }
+
+#endif // HOST_TUSB_H
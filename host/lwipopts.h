@@ -0,0 +1,21 @@
+#ifndef HOST_LWIPOPTS_H
+#define HOST_LWIPOPTS_H
+
+// Build para Linux: as mesmas opções do firmware (../lwipopts.h), com o
+// que muda na porta unix do lwIP. Este diretório vem antes da raiz nos
+// includes do host, então os módulos recebem este arquivo.
+
+#include "../lwipopts.h"
+
+// A pilha roda só no loop principal (tapif_poll): nada a proteger
+#define SYS_LIGHTWEIGHT_PROT        0
+
+// Pools do alvo por padrão (teste de carga esgota o que esgotaria no Pico);
+// com os sanitizers cada pbuf/pcb vem do malloc para o ASan enxergar
+#if IBAG_HOST_LWIP_MALLOC
+#undef MEM_LIBC_MALLOC
+#define MEM_LIBC_MALLOC             1
+#define MEMP_MEM_MALLOC             1
+#endif
+
+#endif // HOST_LWIPOPTS_H
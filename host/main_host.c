@@ -0,0 +1,149 @@
+// Build para Linux: o main do iBagPico2W.c com a rede numa interface TAP
+// Mesma ordem de inicialização e os mesmos módulos; o que muda é o que fica
+// abaixo do hal.h (host/hal_sim.c) e a interface de rede: no lugar do AP do
+// cyw43, o lwIP (porta unix, NO_SYS) fala com o kernel por um tap. A pilha
+// roda no loop principal, então não há IRQ nem travas do cyw43 aqui.
+//
+// O lado do kernel fica com 192.168.4.2 (o "gateway" da netif, que o tapif
+// configura sozinho quando roda como root) ou, com PRECONFIGURED_TAPIF=tap0,
+// com o endereço que o usuário deu ao tap (ver README).
+
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <time.h>
+#include <signal.h>
+#include "pico/stdlib.h"
+#include "lwip/init.h"
+#include "lwip/netif.h"
+#include "lwip/ip4_addr.h"
+#include "lwip/timeouts.h"
+#include "netif/etharp.h"
+#include "netif/tapif.h"
+#include "simple_http_server.h"
+#include "dhcp_server.h"
+#include "captive_portal.h"
+#include "mdns_responder.h"
+#include "autotune.h"
+#include "control.h"
+#include "scheduler.h"
+#include "ipc.h"
+#include "config_store.h"
+#include "kv_store.h"
+#include "history.h"
+#include "boot.h"
+#include "control_core.h"
+#include "power.h"
+#include "logger.h"
+#include "prof.h"
+#include "supervisor.h"
+#include "telemetry.h"
+#include "web_content.h"  // Conteúdo HTML da interface web
+
+// Escalonador do loop principal - core 0 (lido por /api/tasks e /api/metrics)
+scheduler_t main_scheduler;
+
+static struct netif tap_netif;
+static volatile sig_atomic_t running = 1;
+
+// Amostras do core 1: só drenar (a interface lê o snapshot)
+static void task_samples(void *ctx) {
+    ipc_sample_t sample;
+    while (ipc_pop_sample(&sample)) {
+    }
+}
+
+// 'p' = imprimir o perfil, 'r' = zerar, como no console USB
+static void task_console(void *ctx) {
+    int c = getchar_timeout_us(0);
+    if (c == 'p') {
+        prof_dump();
+    } else if (c == 'r') {
+        prof_reset();
+        printf("Perfil zerado\n");
+    }
+}
+
+static void on_signal(int sig) {
+    (void)sig;
+    running = 0;
+}
+
+int main(void) {
+    stdio_init_all();   // Também mapeia a flash simulada
+    boot_mark("stdio");
+    supervisor_init();
+    srand((unsigned)time(NULL));
+    signal(SIGINT, on_signal);
+    signal(SIGTERM, on_signal);
+
+    printf("\n=================================\n");
+    printf("iBag - build para Linux (host)\n");
+    printf("=================================\n\n");
+
+    kv_store_init();
+    history_init();
+    config_store_init();
+    autotune_init();
+    boot_mark("storage");
+
+    init_adc_sensors();
+    init_relay();
+    telemetry_init();
+    control_core_launch();
+    boot_mark("core1");
+
+    // Rede: lwIP sobre o tap, com o mesmo endereço do AP
+    lwip_init();
+    ip4_addr_t ipaddr, netmask, gw;
+    IP4_ADDR(&ipaddr, 192, 168, 4, 1);
+    IP4_ADDR(&netmask, 255, 255, 255, 0);
+    IP4_ADDR(&gw, 192, 168, 4, 2);
+    if (netif_add(&tap_netif, &ipaddr, &netmask, &gw, NULL, tapif_init, ethernet_input) == NULL) {
+        printf("Falha ao abrir a interface TAP\n");
+        return 1;
+    }
+    netif_set_default(&tap_netif);
+    netif_set_up(&tap_netif);
+    netif_set_link_up(&tap_netif);
+    boot_mark("tap");
+
+    dhcp_server_init();
+    captive_portal_init();
+    mdns_responder_init(&tap_netif);
+    simple_http_server_init();
+    boot_mark("http");
+
+    printf("🌐 HTTP Server: http://%s:8000 (via %c%c%d)\n",
+           ip4addr_ntoa(netif_ip4_addr(&tap_netif)), tap_netif.name[0], tap_netif.name[1], tap_netif.num);
+
+    sched_init(&main_scheduler);
+    int failed = 0;   // Tarefas que não couberam (SCHED_MAX_TASKS)
+    failed += sched_add(&main_scheduler, "samples", task_samples, NULL, 500 * 1000, 1000, 0) < 0;
+    failed += sched_add(&main_scheduler, "kv", kv_store_task, NULL, 250 * 1000, 60000, 0) < 0;
+    failed += sched_add(&main_scheduler, "log", log_drain_task, NULL, 50 * 1000, 40000, 25 * 1000) < 0;
+    failed += sched_add(&main_scheduler, "console", task_console, NULL, 100 * 1000, 20000, 0) < 0;
+    failed += sched_add(&main_scheduler, "history", history_task, NULL, HISTORY_PERIOD_MS * 1000, 60000, 0) < 0;
+    if (failed > 0) {
+        printf("%d tarefa(s) do core 0 sem espaço no escalonador\n", failed);
+        return 1;
+    }
+
+    supervisor_start();
+
+    while (running) {
+        sched_run(&main_scheduler);
+        supervisor_poll();
+        telemetry_poll();
+
+        // Rede: quadros recebidos no tap e timers do lwIP (ARP, TCP, mDNS)
+        tapif_poll(&tap_netif);
+        sys_check_timeouts();
+
+        power_idle_until(sched_next_deadline(&main_scheduler));
+    }
+
+    // A flash simulada é MAP_SHARED: o que foi gravado já está no arquivo
+    printf("\nEncerrando\n");
+    return 0;
+}
@@ -0,0 +1,50 @@
+// Build para Linux: power.h sem WFE nem dormant
+// O core dorme com nanosleep até o deadline, em fatias de no máximo 1 ms
+// para que a rede (tapif_poll no loop principal) continue sendo atendida.
+
+#include "power.h"
+#include <stdio.h>
+#include <time.h>
+#include "pico/stdlib.h"
+
+#define IDLE_SLICE_US 1000
+
+static power_stats_t stats[2];
+
+void power_idle_until(uint64_t deadline_us) {
+    power_stats_t *s = &stats[get_core_num()];
+    uint64_t start = time_us_64();
+    if (s->since_us == 0) {
+        s->since_us = start;
+    }
+    if (deadline_us <= start) {
+        return;
+    }
+
+    uint64_t wait_us = deadline_us - start;
+    if (wait_us > IDLE_SLICE_US) {
+        wait_us = IDLE_SLICE_US;
+    }
+    struct timespec ts = { .tv_sec = 0, .tv_nsec = (long)wait_us * 1000L };
+    nanosleep(&ts, NULL);
+
+    s->sleep_us += time_us_64() - start;
+    s->sleeps++;
+}
+
+// Sem pino de interrupção para acordar: nunca entra
+bool power_dormant_until_pin(unsigned gpio) {
+    (void)gpio;
+    return false;
+}
+
+const power_stats_t *power_get_stats(void) {
+    return &stats[get_core_num()];
+}
+
+uint32_t power_sleep_permille(const power_stats_t *s, uint64_t now_us) {
+    if (s->since_us == 0 || now_us <= s->since_us) {
+        return 0;
+    }
+    return (uint32_t)((s->sleep_us * 1000) / (now_us - s->since_us));
+}
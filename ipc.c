@@ -0,0 +1,83 @@
+#include "ipc.h"
+#include <string.h>
+#include <stdatomic.h>
+#include "pico/stdlib.h"
+#include "hardware/sync.h"
+#include "spsc_ring.h"
+
+#define IPC_CMD_QUEUE_LEN 8
+#define IPC_SAMPLE_QUEUE_LEN 64  // ~2 min de amostras com controle a cada 2 s
+
+SPSC_RING_STORAGE(cmd_ring, ipc_cmd_t, IPC_CMD_QUEUE_LEN);
+SPSC_RING_STORAGE(sample_ring, ipc_sample_t, IPC_SAMPLE_QUEUE_LEN);
+
+static spsc_ring_t cmd_ring;
+static spsc_ring_t sample_ring;
+
+// Buffer duplo: o escritor preenche o buffer que não está publicado e
+// incrementa seq; o leitor copia buf[seq & 1] e confere se seq não mudou.
+static struct {
+    _Atomic uint32_t seq;
+    ipc_snapshot_t buf[2];
+} snapshot_block;
+
+static void dbuf_write(_Atomic uint32_t *seq, void *bufs, size_t size, const void *src) {
+    uint32_t s = atomic_load_explicit(seq, memory_order_relaxed);
+    memcpy((uint8_t *)bufs + ((s + 1) & 1) * size, src, size);
+    atomic_store_explicit(seq, s + 1, memory_order_release);
+}
+
+static void dbuf_read(_Atomic uint32_t *seq, const void *bufs, size_t size, void *dst) {
+    uint32_t before, after;
+    do {
+        before = atomic_load_explicit(seq, memory_order_acquire);
+        memcpy(dst, (const uint8_t *)bufs + (before & 1) * size, size);
+        atomic_thread_fence(memory_order_acquire);
+        after = atomic_load_explicit(seq, memory_order_relaxed);
+    } while (before != after);
+}
+
+void ipc_init(void) {
+    spsc_ring_init(&cmd_ring, cmd_ring_storage, sizeof(ipc_cmd_t), IPC_CMD_QUEUE_LEN);
+    spsc_ring_init(&sample_ring, sample_ring_storage, sizeof(ipc_sample_t), IPC_SAMPLE_QUEUE_LEN);
+    memset(&snapshot_block, 0, sizeof(snapshot_block));
+}
+
+// Dois produtores no core 0: tarefas do escalonador e os handlers HTTP na
+// IRQ do cyw43/lwIP. O push do SPSC não é reentrante (lê head, copia, grava
+// head + 1), então roda com as interrupções do core 0 mascaradas - a IRQ não
+// entra no meio de um push da tarefa
+bool ipc_send_command(const ipc_cmd_t *cmd) {
+    uint32_t irq_state = save_and_disable_interrupts();
+    bool pushed = spsc_ring_push(&cmd_ring, cmd);
+    restore_interrupts(irq_state);
+    if (!pushed) {
+        return false;
+    }
+    __sev();  // Acordar o core 1 se estiver em WFE
+    return true;
+}
+
+bool ipc_receive_command(ipc_cmd_t *cmd) {
+    return spsc_ring_pop(&cmd_ring, cmd);
+}
+
+bool ipc_push_sample(const ipc_sample_t *sample) {
+    return spsc_ring_push(&sample_ring, sample);
+}
+
+bool ipc_pop_sample(ipc_sample_t *sample) {
+    return spsc_ring_pop(&sample_ring, sample);
+}
+
+uint32_t ipc_samples_dropped(void) {
+    return spsc_ring_dropped(&sample_ring);
+}
+
+void ipc_publish_snapshot(const ipc_snapshot_t *snapshot) {
+    dbuf_write(&snapshot_block.seq, snapshot_block.buf, sizeof(ipc_snapshot_t), snapshot);
+}
+
+void ipc_read_snapshot(ipc_snapshot_t *snapshot) {
+    dbuf_read(&snapshot_block.seq, snapshot_block.buf, sizeof(ipc_snapshot_t), snapshot);
+}
@@ -0,0 +1,78 @@
+#ifndef IPC_H
+#define IPC_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "control.h"
+#include "autotune.h"
+#include "scheduler.h"
+#include "power.h"
+#include "mpu6050.h"
+
+// Comunicação entre os cores
+// Core 0: cyw43/lwIP e HTTP. Core 1: amostragem, filtro, detecção e relés.
+//   core 0 -> core 1: fila de comandos (SPSC); os alvos vêm do config_store.
+//     ipc_send_command() pode ser chamada das tarefas do core 0 e da IRQ do
+//     lwIP (o push roda com as interrupções mascaradas)
+//   core 1 -> core 0: fila de amostras (SPSC) + snapshot de estado (buffer duplo)
+// Nenhum lado usa mutex; quem lê o buffer duplo repete a cópia se o
+// escritor publicou no meio dela.
+
+typedef enum {
+    IPC_CMD_RESET_SHAKE = 0,   // Resetar shake e recalibrar o MPU6050
+    IPC_CMD_AUTOTUNE_START,
+    IPC_CMD_AUTOTUNE_CANCEL,
+    IPC_CMD_MOTION_WAKE_ARM,     // Preparar o MPU6050 para acordar do dormant
+    IPC_CMD_MOTION_WAKE_DISARM,
+} ipc_cmd_type_t;
+
+typedef struct {
+    uint8_t type;      // ipc_cmd_type_t
+    uint8_t zone;      // autotune_zone_t
+    float setpoint;
+} ipc_cmd_t;
+
+// Uma amostra por ciclo de controle
+typedef struct {
+    uint32_t time_ms;
+    float heater;
+    float conservative;
+    uint8_t relays;    // bit 0 = aquecedor, bit 1 = conservador
+    bool shaken;
+} ipc_sample_t;
+
+// Estado completo publicado pelo core 1
+typedef struct {
+    uint32_t time_ms;
+    bool valid;
+    bool shaken;
+    uint32_t config_version;   // Versão do config_store aplicada pelo controle
+    control_zone_t zones[CONTROL_ZONE_COUNT];
+    autotune_status_t autotune;
+    controller_params_t params[CONTROL_ZONE_COUNT];
+    uint8_t task_count;
+    sched_task_t tasks[SCHED_MAX_TASKS];  // Estatísticas do escalonador do core 1
+    power_stats_t power;                  // Tempo em WFE do core 1
+    bool motion_wake_armed;
+    mpu6050_i2c_stats_t i2c;              // Barramento do MPU6050
+    uint32_t adc_samples;                 // Leituras do ADC desde o boot
+    uint16_t vibration_mg;                // Índice de vibração do último 1 s
+    uint32_t shake_events;                // Viradas detectadas desde o boot
+} ipc_snapshot_t;
+
+// Funções públicas
+void ipc_init(void);
+
+// Core 0
+bool ipc_send_command(const ipc_cmd_t *cmd);
+bool ipc_pop_sample(ipc_sample_t *sample);
+void ipc_read_snapshot(ipc_snapshot_t *snapshot);
+
+// Core 1
+bool ipc_receive_command(ipc_cmd_t *cmd);
+bool ipc_push_sample(const ipc_sample_t *sample);
+void ipc_publish_snapshot(const ipc_snapshot_t *snapshot);
+
+uint32_t ipc_samples_dropped(void);
+
+#endif // IPC_H
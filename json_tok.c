@@ -0,0 +1,501 @@
+#include "json_tok.h"
+#include <string.h>
+#include <math.h>
+
+// Entre tokens
+enum {
+    S_VALUE = 0,       // Raiz, após ':' ou após ',' num array
+    S_VALUE_OR_END,    // Após '['
+    S_KEY_OR_END,      // Após '{'
+    S_KEY,             // Após ',' num objeto
+    S_COLON,
+    S_COMMA_OR_END,    // Após um item
+    S_DONE,            // Documento completo: só espaços
+};
+
+// Dentro de um token
+enum {
+    L_NONE = 0,
+    L_STRING,
+    L_ESCAPE,
+    L_HEX,             // sub = dígitos restantes do \uXXXX
+    L_LOW_BS,          // Par surrogate: esperando '\'
+    L_LOW_U,           // Par surrogate: esperando 'u'
+    L_NUMBER,          // sub = N_*
+    L_LITERAL,         // code = literal, sub = posição
+};
+
+// Número: -?(0|[1-9][0-9]*)(\.[0-9]+)?([eE][+-]?[0-9]+)?
+enum {
+    N_MINUS = 0,
+    N_ZERO,
+    N_INT,
+    N_DOT,
+    N_FRAC,
+    N_E,
+    N_ESIGN,
+    N_EXP,
+};
+
+// Resultado de um byte dentro de um token
+enum {
+    LEX_MORE = 0,      // Consumido
+    LEX_AGAIN,         // Token terminou antes deste byte: tratar como estrutura
+    LEX_ERR,
+};
+
+static const char *const literals[] = { "true", "false", "null" };
+static const uint8_t literal_types[] = { JSON_TOK_TRUE, JSON_TOK_FALSE, JSON_TOK_NULL };
+
+void json_tok_init(json_tok_t *tok, json_tok_cb cb, void *ctx) {
+    memset(tok, 0, sizeof(*tok));
+    tok->cb = cb;
+    tok->ctx = ctx;
+    tok->state = S_VALUE;
+}
+
+static json_err_t fail(json_tok_t *tok, json_err_t err) {
+    tok->err = err;
+    tok->err_offset = tok->offset;
+    return err;
+}
+
+static json_err_t emit(json_tok_t *tok, json_tok_type_t type, uint8_t depth) {
+    tok->text[tok->text_len] = '\0';
+    json_token_t token = {
+        .type = type,
+        .depth = depth,
+        .len = tok->text_len,
+        .text = tok->text,
+    };
+    json_err_t err = tok->cb ? tok->cb(tok->ctx, &token) : JSON_OK;
+    return err == JSON_OK ? JSON_OK : fail(tok, err);
+}
+
+static void value_done(json_tok_t *tok) {
+    tok->state = tok->depth == 0 ? S_DONE : S_COMMA_OR_END;
+}
+
+static bool in_object(const json_tok_t *tok) {
+    return tok->depth > 0 && (tok->objects & (1u << (tok->depth - 1)));
+}
+
+static bool text_push(json_tok_t *tok, char c) {
+    if (tok->text_len >= JSON_TOK_TEXT_MAX) {
+        fail(tok, JSON_ERR_TOO_LONG);
+        return false;
+    }
+    tok->text[tok->text_len++] = c;
+    return true;
+}
+
+static bool text_push_utf8(json_tok_t *tok, uint32_t cp) {
+    if (cp < 0x80) {
+        return text_push(tok, (char)cp);
+    }
+    if (cp < 0x800) {
+        return text_push(tok, (char)(0xC0 | (cp >> 6))) &&
+               text_push(tok, (char)(0x80 | (cp & 0x3F)));
+    }
+    if (cp < 0x10000) {
+        return text_push(tok, (char)(0xE0 | (cp >> 12))) &&
+               text_push(tok, (char)(0x80 | ((cp >> 6) & 0x3F))) &&
+               text_push(tok, (char)(0x80 | (cp & 0x3F)));
+    }
+    return text_push(tok, (char)(0xF0 | (cp >> 18))) &&
+           text_push(tok, (char)(0x80 | ((cp >> 12) & 0x3F))) &&
+           text_push(tok, (char)(0x80 | ((cp >> 6) & 0x3F))) &&
+           text_push(tok, (char)(0x80 | (cp & 0x3F)));
+}
+
+static int hex_value(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+// \uXXXX completo; \u0000 é recusado porque o texto chega como string C
+static int unicode_done(json_tok_t *tok) {
+    uint32_t code = tok->code;
+    if (tok->high != 0) {
+        if (code < 0xDC00 || code > 0xDFFF) {
+            fail(tok, JSON_ERR_STRING);
+            return LEX_ERR;
+        }
+        code = 0x10000 + (((uint32_t)tok->high - 0xD800) << 10) + (code - 0xDC00);
+        tok->high = 0;
+    } else if (code >= 0xD800 && code <= 0xDBFF) {
+        tok->high = (uint16_t)code;
+        tok->lex = L_LOW_BS;
+        return LEX_MORE;
+    } else if ((code >= 0xDC00 && code <= 0xDFFF) || code == 0) {
+        fail(tok, JSON_ERR_STRING);
+        return LEX_ERR;
+    }
+    tok->lex = L_STRING;
+    return text_push_utf8(tok, code) ? LEX_MORE : LEX_ERR;
+}
+
+static int lex_string(json_tok_t *tok, char c) {
+    switch (tok->lex) {
+        case L_STRING:
+            if (c == '"') {
+                tok->lex = L_NONE;
+                if (tok->is_key) {
+                    tok->state = S_COLON;
+                    return emit(tok, JSON_TOK_KEY, tok->depth) == JSON_OK ? LEX_MORE : LEX_ERR;
+                }
+                value_done(tok);
+                return emit(tok, JSON_TOK_STRING, tok->depth) == JSON_OK ? LEX_MORE : LEX_ERR;
+            }
+            if (c == '\\') {
+                tok->lex = L_ESCAPE;
+                return LEX_MORE;
+            }
+            if ((unsigned char)c < 0x20) {
+                fail(tok, JSON_ERR_STRING);
+                return LEX_ERR;
+            }
+            return text_push(tok, c) ? LEX_MORE : LEX_ERR;
+
+        case L_ESCAPE: {
+            char out;
+            switch (c) {
+                case '"':  out = '"'; break;
+                case '\\': out = '\\'; break;
+                case '/':  out = '/'; break;
+                case 'b':  out = '\b'; break;
+                case 'f':  out = '\f'; break;
+                case 'n':  out = '\n'; break;
+                case 'r':  out = '\r'; break;
+                case 't':  out = '\t'; break;
+                case 'u':
+                    tok->lex = L_HEX;
+                    tok->sub = 4;
+                    tok->code = 0;
+                    return LEX_MORE;
+                default:
+                    fail(tok, JSON_ERR_STRING);
+                    return LEX_ERR;
+            }
+            tok->lex = L_STRING;
+            return text_push(tok, out) ? LEX_MORE : LEX_ERR;
+        }
+
+        case L_HEX: {
+            int v = hex_value(c);
+            if (v < 0) {
+                fail(tok, JSON_ERR_STRING);
+                return LEX_ERR;
+            }
+            tok->code = (uint16_t)((tok->code << 4) | v);
+            if (--tok->sub > 0) {
+                return LEX_MORE;
+            }
+            return unicode_done(tok);
+        }
+
+        case L_LOW_BS:
+            if (c != '\\') {
+                fail(tok, JSON_ERR_STRING);
+                return LEX_ERR;
+            }
+            tok->lex = L_LOW_U;
+            return LEX_MORE;
+
+        default:   // L_LOW_U
+            if (c != 'u') {
+                fail(tok, JSON_ERR_STRING);
+                return LEX_ERR;
+            }
+            tok->lex = L_HEX;
+            tok->sub = 4;
+            tok->code = 0;
+            return LEX_MORE;
+    }
+}
+
+static bool number_complete(const json_tok_t *tok) {
+    return tok->sub == N_ZERO || tok->sub == N_INT || tok->sub == N_FRAC || tok->sub == N_EXP;
+}
+
+static json_err_t number_end(json_tok_t *tok) {
+    tok->lex = L_NONE;
+    value_done(tok);
+    return emit(tok, JSON_TOK_NUMBER, tok->depth);
+}
+
+static int lex_number(json_tok_t *tok, char c) {
+    bool digit = c >= '0' && c <= '9';
+    uint8_t next;
+    switch (tok->sub) {
+        case N_MINUS:
+            next = c == '0' ? N_ZERO : digit ? N_INT : 0xFF;
+            break;
+        case N_ZERO:
+            next = c == '.' ? N_DOT : (c == 'e' || c == 'E') ? N_E : digit ? 0xFF : 0xFE;
+            break;
+        case N_INT:
+            next = digit ? N_INT : c == '.' ? N_DOT : (c == 'e' || c == 'E') ? N_E : 0xFE;
+            break;
+        case N_DOT:
+            next = digit ? N_FRAC : 0xFF;
+            break;
+        case N_FRAC:
+            next = digit ? N_FRAC : (c == 'e' || c == 'E') ? N_E : 0xFE;
+            break;
+        case N_E:
+            next = (c == '+' || c == '-') ? N_ESIGN : digit ? N_EXP : 0xFF;
+            break;
+        case N_ESIGN:
+            next = digit ? N_EXP : 0xFF;
+            break;
+        default:   // N_EXP
+            next = digit ? N_EXP : 0xFE;
+            break;
+    }
+    if (next == 0xFF) {
+        fail(tok, JSON_ERR_NUMBER);
+        return LEX_ERR;
+    }
+    if (next == 0xFE) {
+        // Byte seguinte ao número: vale como estrutura (',', '}', espaço...)
+        return number_end(tok) == JSON_OK ? LEX_AGAIN : LEX_ERR;
+    }
+    tok->sub = next;
+    return text_push(tok, c) ? LEX_MORE : LEX_ERR;
+}
+
+static int lex_literal(json_tok_t *tok, char c) {
+    const char *lit = literals[tok->code];
+    if (c != lit[tok->sub]) {
+        fail(tok, JSON_ERR_UNEXPECTED);
+        return LEX_ERR;
+    }
+    if (lit[++tok->sub] == '\0') {
+        tok->lex = L_NONE;
+        value_done(tok);
+        return emit(tok, literal_types[tok->code], tok->depth) == JSON_OK ? LEX_MORE : LEX_ERR;
+    }
+    return LEX_MORE;
+}
+
+static json_err_t structural(json_tok_t *tok, char c) {
+    if (c == ' ' || c == '\t' || c == '\n' || c == '\r') {
+        return JSON_OK;
+    }
+    if (tok->state == S_DONE) {
+        return fail(tok, JSON_ERR_TRAILING);
+    }
+    bool want_value = tok->state == S_VALUE || tok->state == S_VALUE_OR_END;
+    switch (c) {
+        case '{':
+        case '[': {
+            if (!want_value) {
+                return fail(tok, JSON_ERR_UNEXPECTED);
+            }
+            if (tok->depth >= JSON_TOK_DEPTH_MAX) {
+                return fail(tok, JSON_ERR_DEPTH);
+            }
+            bool obj = c == '{';
+            if (emit(tok, obj ? JSON_TOK_OBJ_BEGIN : JSON_TOK_ARR_BEGIN, tok->depth) != JSON_OK) {
+                return tok->err;
+            }
+            if (obj) {
+                tok->objects |= 1u << tok->depth;
+            } else {
+                tok->objects &= ~(1u << tok->depth);
+            }
+            tok->depth++;
+            tok->state = obj ? S_KEY_OR_END : S_VALUE_OR_END;
+            return JSON_OK;
+        }
+        case '}':
+        case ']': {
+            bool obj = c == '}';
+            bool open = obj ? (tok->state == S_KEY_OR_END || tok->state == S_COMMA_OR_END)
+                            : (tok->state == S_VALUE_OR_END || tok->state == S_COMMA_OR_END);
+            if (tok->depth == 0 || in_object(tok) != obj || !open) {
+                return fail(tok, JSON_ERR_UNEXPECTED);
+            }
+            tok->depth--;
+            value_done(tok);
+            return emit(tok, obj ? JSON_TOK_OBJ_END : JSON_TOK_ARR_END, tok->depth);
+        }
+        case ',':
+            if (tok->state != S_COMMA_OR_END) {
+                return fail(tok, JSON_ERR_UNEXPECTED);
+            }
+            tok->state = in_object(tok) ? S_KEY : S_VALUE;
+            return JSON_OK;
+        case ':':
+            if (tok->state != S_COLON) {
+                return fail(tok, JSON_ERR_UNEXPECTED);
+            }
+            tok->state = S_VALUE;
+            return JSON_OK;
+        case '"':
+            if (tok->state == S_KEY_OR_END || tok->state == S_KEY) {
+                tok->is_key = true;
+            } else if (want_value) {
+                tok->is_key = false;
+            } else {
+                return fail(tok, JSON_ERR_UNEXPECTED);
+            }
+            tok->lex = L_STRING;
+            tok->text_len = 0;
+            tok->high = 0;
+            return JSON_OK;
+        default:
+            break;
+    }
+    if (!want_value) {
+        return fail(tok, JSON_ERR_UNEXPECTED);
+    }
+    if (c == '-' || (c >= '0' && c <= '9')) {
+        tok->lex = L_NUMBER;
+        tok->sub = c == '-' ? N_MINUS : c == '0' ? N_ZERO : N_INT;
+        tok->text_len = 0;
+        text_push(tok, c);
+        return JSON_OK;
+    }
+    for (uint8_t i = 0; i < sizeof(literal_types); i++) {
+        if (c == literals[i][0]) {
+            tok->lex = L_LITERAL;
+            tok->code = i;
+            tok->sub = 1;
+            tok->text_len = 0;
+            return JSON_OK;
+        }
+    }
+    return fail(tok, JSON_ERR_UNEXPECTED);
+}
+
+json_err_t json_tok_feed(json_tok_t *tok, const char *data, size_t len) {
+    if (tok->err != JSON_OK) {
+        return (json_err_t)tok->err;
+    }
+    for (size_t i = 0; i < len; i++, tok->offset++) {
+        char c = data[i];
+        int r = LEX_AGAIN;
+        switch (tok->lex) {
+            case L_NONE:    break;
+            case L_NUMBER:  r = lex_number(tok, c); break;
+            case L_LITERAL: r = lex_literal(tok, c); break;
+            default:        r = lex_string(tok, c); break;
+        }
+        if (r == LEX_ERR) {
+            return (json_err_t)tok->err;
+        }
+        if (r == LEX_AGAIN && structural(tok, c) != JSON_OK) {
+            return (json_err_t)tok->err;
+        }
+    }
+    return JSON_OK;
+}
+
+json_err_t json_tok_finish(json_tok_t *tok) {
+    if (tok->err != JSON_OK) {
+        return (json_err_t)tok->err;
+    }
+    // Número na raiz só termina com o corpo
+    if (tok->lex == L_NUMBER && number_complete(tok) && number_end(tok) != JSON_OK) {
+        return (json_err_t)tok->err;
+    }
+    if (tok->lex != L_NONE || tok->state != S_DONE) {
+        return fail(tok, JSON_ERR_TRUNCATED);
+    }
+    return JSON_OK;
+}
+
+const char *json_err_name(json_err_t err) {
+    switch (err) {
+        case JSON_OK:             return "ok";
+        case JSON_ERR_UNEXPECTED: return "unexpected";
+        case JSON_ERR_NUMBER:     return "bad_number";
+        case JSON_ERR_STRING:     return "bad_string";
+        case JSON_ERR_TOO_LONG:   return "too_long";
+        case JSON_ERR_DEPTH:      return "too_deep";
+        case JSON_ERR_TRAILING:   return "trailing_data";
+        case JSON_ERR_TRUNCATED:  return "truncated";
+        case JSON_ERR_TYPE:       return "wrong_type";
+        case JSON_ERR_RANGE:      return "out_of_range";
+    }
+    return "?";
+}
+
+static const float pow10_f[] = { 1e0f, 1e1f, 1e2f, 1e3f, 1e4f, 1e5f, 1e6f, 1e7f, 1e8f, 1e9f, 1e10f };
+
+bool json_number_to_float(const char *text, size_t len, float *out) {
+    const char *p = text;
+    const char *end = text + len;
+    bool negative = p < end && *p == '-';
+    if (negative) {
+        p++;
+    }
+    uint32_t mantissa = 0;
+    int digits = 0;     // Dígitos significativos na mantissa
+    int scale = 0;      // Expoente decimal acumulado
+    bool any = false;
+    for (; p < end && *p >= '0' && *p <= '9'; p++) {
+        any = true;
+        if (digits < 9) {
+            mantissa = mantissa * 10 + (uint32_t)(*p - '0');
+            digits += mantissa != 0;
+        } else {
+            scale++;
+        }
+    }
+    if (p < end && *p == '.') {
+        for (p++; p < end && *p >= '0' && *p <= '9'; p++) {
+            any = true;
+            if (digits < 9) {
+                mantissa = mantissa * 10 + (uint32_t)(*p - '0');
+                digits += mantissa != 0;
+                scale--;
+            }
+        }
+    }
+    if (!any) {
+        return false;
+    }
+    if (p < end && (*p == 'e' || *p == 'E')) {
+        p++;
+        bool exp_negative = p < end && *p == '-';
+        if (p < end && (*p == '-' || *p == '+')) {
+            p++;
+        }
+        int exp = 0;
+        for (; p < end && *p >= '0' && *p <= '9'; p++) {
+            if (exp < 1000) {
+                exp = exp * 10 + (*p - '0');
+            }
+        }
+        scale += exp_negative ? -exp : exp;
+    }
+    if (p != end) {
+        return false;
+    }
+
+    float value = (float)mantissa;
+    if (mantissa != 0) {
+        // Passos de no máximo 10^10; dividir (em vez de multiplicar por 0.1)
+        // mantém 45.5 e 0.1 exatos até o arredondamento do float
+        while (scale > 0 && isfinite(value)) {
+            int step = scale > 10 ? 10 : scale;
+            value *= pow10_f[step];
+            scale -= step;
+        }
+        while (scale < 0 && value != 0.0f) {
+            int step = -scale > 10 ? 10 : -scale;
+            value /= pow10_f[step];
+            scale += step;
+        }
+        if (!isfinite(value) || value == 0.0f) {
+            return false;   // Fora da faixa do float: nunca vira 0 ou inf calado
+        }
+    }
+    *out = negative ? -value : value;
+    return true;
+}
@@ -0,0 +1,87 @@
+#ifndef JSON_TOK_H
+#define JSON_TOK_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+// Tokenizador JSON incremental e estrito (RFC 8259)
+// O corpo entra em pedaços de qualquer tamanho (um por pbuf); cada token
+// completo vai para o callback, mesmo que tenha começado no pedaço anterior.
+// Não há alocação: strings e números são montados num buffer interno de
+// JSON_TOK_TEXT_MAX bytes (strings já sem escape, em UTF-8).
+//
+// Qualquer desvio da gramática para o tokenizador no primeiro byte errado e
+// guarda o erro e a posição (bytes desde o início do corpo): zero à esquerda,
+// vírgula sobrando, aspas simples, caractere de controle em string, literal
+// incompleto, lixo após o documento... json_tok_finish() acusa documento
+// truncado. O callback também pode recusar um token (tipo errado, fora da
+// faixa) devolvendo o erro.
+
+#define JSON_TOK_TEXT_MAX 48
+#define JSON_TOK_DEPTH_MAX 8
+
+typedef enum {
+    JSON_TOK_OBJ_BEGIN = 0,
+    JSON_TOK_OBJ_END,
+    JSON_TOK_ARR_BEGIN,
+    JSON_TOK_ARR_END,
+    JSON_TOK_KEY,
+    JSON_TOK_STRING,
+    JSON_TOK_NUMBER,
+    JSON_TOK_TRUE,
+    JSON_TOK_FALSE,
+    JSON_TOK_NULL,
+} json_tok_type_t;
+
+typedef enum {
+    JSON_OK = 0,
+    JSON_ERR_UNEXPECTED,   // Caractere fora da gramática nesta posição
+    JSON_ERR_NUMBER,       // Número malformado
+    JSON_ERR_STRING,       // Escape inválido ou caractere de controle
+    JSON_ERR_TOO_LONG,     // Token maior que JSON_TOK_TEXT_MAX
+    JSON_ERR_DEPTH,        // Aninhamento além de JSON_TOK_DEPTH_MAX
+    JSON_ERR_TRAILING,     // Dados após o fim do documento
+    JSON_ERR_TRUNCATED,    // Corpo terminou no meio do documento
+    JSON_ERR_TYPE,         // Recusado pelo callback: tipo errado
+    JSON_ERR_RANGE,        // Recusado pelo callback: valor fora da faixa
+} json_err_t;
+
+typedef struct {
+    uint8_t type;      // json_tok_type_t
+    uint8_t depth;     // Nível onde o token aparece (0 = raiz)
+    uint8_t len;
+    const char *text;  // KEY, STRING e NUMBER (terminado em '\0')
+} json_token_t;
+
+typedef json_err_t (*json_tok_cb)(void *ctx, const json_token_t *token);
+
+typedef struct {
+    json_tok_cb cb;
+    void *ctx;
+    uint32_t offset;       // Bytes consumidos
+    uint32_t err_offset;   // Posição do byte que causou o erro
+    uint8_t err;           // json_err_t
+    uint8_t state;         // O que pode vir entre tokens
+    uint8_t lex;           // Token em andamento
+    uint8_t sub;           // Estado dentro do token
+    uint8_t depth;
+    uint8_t objects;       // Bit por nível: 1 = objeto, 0 = array
+    uint8_t text_len;
+    bool is_key;
+    uint16_t code;         // \uXXXX em andamento
+    uint16_t high;         // Primeira metade de um par surrogate
+    char text[JSON_TOK_TEXT_MAX + 1];
+} json_tok_t;
+
+// Funções públicas
+void json_tok_init(json_tok_t *tok, json_tok_cb cb, void *ctx);
+json_err_t json_tok_feed(json_tok_t *tok, const char *data, size_t len);
+json_err_t json_tok_finish(json_tok_t *tok);   // Fim do corpo
+const char *json_err_name(json_err_t err);
+
+// Texto de um token NUMBER -> float sem strtof (mantissa de até 9 dígitos
+// e escala por potência de 10); false se não couber num float
+bool json_number_to_float(const char *text, size_t len, float *out);
+
+#endif // JSON_TOK_H
@@ -0,0 +1,255 @@
+#include "json_writer.h"
+#include <string.h>
+#include <math.h>
+
+#define JSON_MAX_DECIMALS 6
+
+static const uint32_t pow10_u32[JSON_MAX_DECIMALS + 1] = {
+    1, 10, 100, 1000, 10000, 100000, 1000000,
+};
+
+void json_writer_init(json_writer_t *w, char *buf, size_t cap) {
+    w->buf = buf;
+    w->cap = cap;
+    w->len = 0;
+    w->overflow = false;
+    w->comma = false;
+}
+
+static void put(json_writer_t *w, const char *s, size_t n) {
+    if (w->overflow || n > w->cap - w->len) {
+        w->overflow = true;
+        return;
+    }
+    memcpy(w->buf + w->len, s, n);
+    w->len += n;
+}
+
+static void put_char(json_writer_t *w, char c) {
+    if (w->overflow || w->len >= w->cap) {
+        w->overflow = true;
+        return;
+    }
+    w->buf[w->len++] = c;
+}
+
+// Vírgula antes de um item que não é o primeiro do objeto/array
+static void item_begin(json_writer_t *w) {
+    if (w->comma) {
+        put_char(w, ',');
+    }
+    w->comma = true;
+}
+
+// Dígitos de trás para frente num buffer local; min_digits completa com zeros
+static void put_digits(json_writer_t *w, uint32_t value, int min_digits) {
+    char tmp[10];
+    int n = 0;
+    do {
+        tmp[sizeof(tmp) - 1 - n++] = (char)('0' + value % 10);
+        value /= 10;
+    } while (value != 0 || n < min_digits);
+    put(w, tmp + sizeof(tmp) - n, n);
+}
+
+// Módulo do valor escalado com o ponto antes das 'decimals' últimas casas
+static void put_scaled(json_writer_t *w, bool negative, uint32_t magnitude, uint8_t decimals) {
+    if (negative) {
+        put_char(w, '-');
+    }
+    if (decimals == 0) {
+        put_digits(w, magnitude, 1);
+        return;
+    }
+    uint32_t scale = pow10_u32[decimals];
+    put_digits(w, magnitude / scale, 1);
+    put_char(w, '.');
+    put_digits(w, magnitude % scale, decimals);
+}
+
+void json_obj_begin(json_writer_t *w) {
+    item_begin(w);
+    put_char(w, '{');
+    w->comma = false;
+}
+
+void json_obj_end(json_writer_t *w) {
+    put_char(w, '}');
+    w->comma = true;
+}
+
+void json_arr_begin(json_writer_t *w) {
+    item_begin(w);
+    put_char(w, '[');
+    w->comma = false;
+}
+
+void json_arr_end(json_writer_t *w) {
+    put_char(w, ']');
+    w->comma = true;
+}
+
+void json_key(json_writer_t *w, const char *key) {
+    item_begin(w);
+    put_char(w, '"');
+    put(w, key, strlen(key));
+    put(w, "\":", 2);
+    w->comma = false;   // O valor vem colado na chave
+}
+
+void json_str(json_writer_t *w, const char *s) {
+    if (s == NULL) {
+        json_null(w);
+        return;
+    }
+    item_begin(w);
+    put_char(w, '"');
+    // Trechos sem escape saem de uma vez
+    const char *run = s;
+    for (; *s; s++) {
+        unsigned char c = (unsigned char)*s;
+        if (c >= 0x20 && c != '"' && c != '\\') {
+            continue;
+        }
+        put(w, run, s - run);
+        run = s + 1;
+        char esc[6] = { '\\', 0 };
+        switch (c) {
+            case '"':  esc[1] = '"'; break;
+            case '\\': esc[1] = '\\'; break;
+            case '\n': esc[1] = 'n'; break;
+            case '\r': esc[1] = 'r'; break;
+            case '\t': esc[1] = 't'; break;
+            default:
+                memcpy(esc, "\\u00", 4);
+                esc[4] = "0123456789abcdef"[c >> 4];
+                esc[5] = "0123456789abcdef"[c & 0xF];
+                put(w, esc, 6);
+                continue;
+        }
+        put(w, esc, 2);
+    }
+    put(w, run, s - run);
+    put_char(w, '"');
+}
+
+void json_bool(json_writer_t *w, bool value) {
+    item_begin(w);
+    if (value) {
+        put(w, "true", 4);
+    } else {
+        put(w, "false", 5);
+    }
+}
+
+void json_null(json_writer_t *w) {
+    item_begin(w);
+    put(w, "null", 4);
+}
+
+void json_uint(json_writer_t *w, uint32_t value) {
+    item_begin(w);
+    put_digits(w, value, 1);
+}
+
+void json_int(json_writer_t *w, int32_t value) {
+    item_begin(w);
+    put_scaled(w, value < 0, value < 0 ? 0u - (uint32_t)value : (uint32_t)value, 0);
+}
+
+void json_fixed(json_writer_t *w, int32_t scaled, uint8_t decimals) {
+    if (decimals > JSON_MAX_DECIMALS) {
+        decimals = JSON_MAX_DECIMALS;
+    }
+    item_begin(w);
+    put_scaled(w, scaled < 0, scaled < 0 ? 0u - (uint32_t)scaled : (uint32_t)scaled, decimals);
+}
+
+// Parte inteira e fração escaladas separadamente: a fração (< 1) tem a
+// mantissa inteira do float para as casas. Empate vai para o par, como no
+// "%.Nf"; difere do snprintf só quando o produto em float arredonda para o
+// meio exato (~1 em 10^6 valores, última casa)
+bool json_float_fixed(float value, uint8_t decimals, bool *negative, uint32_t *magnitude) {
+    if (decimals > JSON_MAX_DECIMALS) {
+        decimals = JSON_MAX_DECIMALS;
+    }
+    uint32_t scale = pow10_u32[decimals];
+    float a = fabsf(value);
+    if (!isfinite(value) || a >= 4.2e9f / (float)scale) {
+        return false;
+    }
+    uint32_t ip = (uint32_t)a;
+    float frac = (a - (float)ip) * (float)scale;
+    uint32_t f = (uint32_t)frac;
+    float rest = frac - (float)f;
+    uint32_t m = ip * scale + f;
+    if (rest > 0.5f || (rest == 0.5f && (m & 1))) {
+        m++;
+    }
+    *negative = value < 0 && m != 0;
+    *magnitude = m;
+    return true;
+}
+
+void json_float(json_writer_t *w, float value, uint8_t decimals) {
+    if (!isfinite(value)) {
+        json_null(w);
+        return;
+    }
+    if (decimals > JSON_MAX_DECIMALS) {
+        decimals = JSON_MAX_DECIMALS;
+    }
+    item_begin(w);
+    bool negative;
+    uint32_t magnitude;
+    if (json_float_fixed(value, decimals, &negative, &magnitude)) {
+        put_scaled(w, negative, magnitude, decimals);
+        return;
+    }
+    // Grande demais para ponto fixo em 32 bits: sem casas, com expoente se
+    // nem a parte inteira couber
+    float a = fabsf(value);
+    uint32_t exp = 0;
+    while (a >= 4294967296.0f) {
+        a /= 10.0f;
+        exp++;
+    }
+    put_scaled(w, value < 0, (uint32_t)a, 0);
+    if (exp > 0) {
+        put_char(w, 'e');
+        put_digits(w, exp, 1);
+    }
+}
+
+void json_write_fields(json_writer_t *w, const json_field_t *fields, size_t count, const void *base) {
+    const uint8_t *p = (const uint8_t *)base;
+    for (size_t i = 0; i < count && !w->overflow; i++) {
+        const json_field_t *f = &fields[i];
+        const void *member = p + f->offset;
+        json_key(w, f->key);
+        switch (f->type) {
+            case JSON_FIELD_UINT:
+                json_uint(w, f->size == 1 ? *(const uint8_t *)member
+                           : f->size == 2 ? *(const uint16_t *)member
+                           : *(const uint32_t *)member);
+                break;
+            case JSON_FIELD_INT:
+                json_int(w, f->size == 1 ? *(const int8_t *)member
+                          : f->size == 2 ? *(const int16_t *)member
+                          : *(const int32_t *)member);
+                break;
+            case JSON_FIELD_FLOAT:
+                json_float(w, *(const float *)member, f->decimals);
+                break;
+            case JSON_FIELD_BOOL:
+                json_bool(w, *(const bool *)member);
+                break;
+            case JSON_FIELD_STR:
+                json_str(w, *(const char *const *)member);
+                break;
+            default:
+                json_null(w);
+                break;
+        }
+    }
+}
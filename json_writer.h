@@ -0,0 +1,69 @@
+#ifndef JSON_WRITER_H
+#define JSON_WRITER_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+// Escrita de JSON sem alocação, direto no buffer de destino
+// Números saem em ponto fixo (inteiro escalado por 10^decimais), sem printf
+// nem float na formatação; NaN/infinito viram null. A vírgula entre itens é
+// controlada pelo próprio writer. Se o buffer acabar, o resto é descartado
+// e json_writer_ok() devolve false - nunca escreve além de cap.
+//
+// Esquema: uma tabela de json_field_t descreve chave, tipo e posição de cada
+// campo numa struct; json_write_fields() serializa a struct pela tabela.
+
+typedef struct {
+    char *buf;
+    size_t cap;
+    size_t len;
+    bool overflow;
+    bool comma;      // Próximo item precisa de vírgula antes
+} json_writer_t;
+
+typedef enum {
+    JSON_FIELD_UINT = 0,   // uint8/16/32, pelo tamanho do membro
+    JSON_FIELD_INT,        // int8/16/32
+    JSON_FIELD_FLOAT,      // float com 'decimals' casas
+    JSON_FIELD_BOOL,
+    JSON_FIELD_STR,        // const char * (NULL = null)
+} json_field_type_t;
+
+typedef struct {
+    const char *key;
+    uint16_t offset;
+    uint8_t type;       // json_field_type_t
+    uint8_t size;       // sizeof do membro
+    uint8_t decimals;   // JSON_FIELD_FLOAT
+} json_field_t;
+
+// Entrada da tabela a partir do membro da struct
+#define JSON_FIELD(st, member, key_, type_, decimals_) \
+    { .key = (key_), .offset = (uint16_t)offsetof(st, member), .type = (type_), \
+      .size = (uint8_t)sizeof(((st *)0)->member), .decimals = (decimals_) }
+
+// Funções públicas
+void json_writer_init(json_writer_t *w, char *buf, size_t cap);
+static inline bool json_writer_ok(const json_writer_t *w) { return !w->overflow; }
+static inline size_t json_writer_len(const json_writer_t *w) { return w->len; }
+
+void json_obj_begin(json_writer_t *w);
+void json_obj_end(json_writer_t *w);
+void json_arr_begin(json_writer_t *w);
+void json_arr_end(json_writer_t *w);
+void json_key(json_writer_t *w, const char *key);   // Chave literal, sem escape
+
+void json_str(json_writer_t *w, const char *s);
+void json_bool(json_writer_t *w, bool value);
+void json_null(json_writer_t *w);
+void json_uint(json_writer_t *w, uint32_t value);
+void json_int(json_writer_t *w, int32_t value);
+void json_fixed(json_writer_t *w, int32_t scaled, uint8_t decimals);   // 1234, 2 -> 12.34
+void json_float(json_writer_t *w, float value, uint8_t decimals);
+// Valor de json_float() como inteiro escalado; false se não finito ou fora de 32 bits
+bool json_float_fixed(float value, uint8_t decimals, bool *negative, uint32_t *magnitude);
+
+void json_write_fields(json_writer_t *w, const json_field_t *fields, size_t count, const void *base);
+
+#endif // JSON_WRITER_H
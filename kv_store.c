@@ -0,0 +1,351 @@
+#include "kv_store.h"
+#include <stdio.h>
+#include <string.h>
+#include "pico/stdlib.h"
+#include "pico/flash.h"
+#include "pico/sync.h"
+#include "hardware/flash.h"
+#include "hal.h"
+
+// Região logo abaixo do último setor (que guardava o registro antigo do autotune)
+#define KV_REGION_OFFSET (PICO_FLASH_SIZE_BYTES - (KV_SECTOR_COUNT + 1) * FLASH_SECTOR_SIZE)
+#define KV_SECTOR_MAGIC 0x474C564B  // "KVLG"
+#define KV_KEY_ERASED 0xFFFF
+
+typedef struct {
+    uint32_t magic;
+    uint32_t generation;
+    uint32_t reserved;
+    uint32_t crc;
+} kv_sector_hdr_t;
+
+typedef struct {
+    uint16_t key;
+    uint16_t len;
+    uint32_t crc;        // CRC-32 de key, len e dados
+} kv_record_hdr_t;
+
+// Cópia em RAM de cada chave
+typedef struct {
+    uint8_t data[KV_MAX_VALUE];
+    uint16_t len;            // 0 = ausente
+    uint32_t version;        // Incrementa a cada kv_set
+    uint32_t written;        // Versão que já está na flash
+    uint32_t changed_ms;
+} kv_entry_t;
+
+// Passos da gravação (um por execução da tarefa)
+typedef enum {
+    KV_STEP_IDLE = 0,
+    KV_STEP_ERASE,       // Apagar o setor de destino da compactação
+    KV_STEP_COPY,        // Copiar uma chave por vez
+    KV_STEP_HEADER,      // Gravar o cabeçalho: o setor passa a valer
+} kv_step_t;
+
+static kv_entry_t entries[KV_KEY_COUNT];
+static critical_section_t entries_lock;
+
+static int active_sector = -1;
+static uint32_t generation = 0;
+static uint32_t write_offset = 0;   // Próximo byte livre no setor ativo
+static bool needs_compaction = false;
+
+static kv_step_t step = KV_STEP_IDLE;
+static int target_sector = 0;
+static uint32_t target_offset = 0;
+static int copy_key = 0;
+
+static kv_stats_t stats;
+
+// Parâmetros de uma operação executada por flash_safe_execute
+typedef struct {
+    uint32_t offset;
+    const uint8_t *data;   // NULL = apagar o setor
+    size_t len;
+} kv_flash_op_t;
+
+static uint8_t page_buf[2 * FLASH_PAGE_SIZE];
+
+// Encadeável: kv_crc32_update(kv_crc32(a), b) == kv_crc32(a seguido de b)
+uint32_t kv_crc32_update(uint32_t crc, const void *data, size_t len) {
+    const uint8_t *p = (const uint8_t *)data;
+    crc = ~crc;
+    for (size_t i = 0; i < len; i++) {
+        crc ^= p[i];
+        for (int b = 0; b < 8; b++) {
+            crc = (crc >> 1) ^ (0xEDB88320u & (0u - (crc & 1u)));
+        }
+    }
+    return ~crc;
+}
+
+uint32_t kv_crc32(const void *data, size_t len) {
+    return kv_crc32_update(0, data, len);
+}
+
+static uint32_t record_crc(const kv_record_hdr_t *hdr, const uint8_t *data) {
+    uint8_t buf[4 + KV_MAX_VALUE];
+    memcpy(buf, hdr, 4);   // key + len
+    memcpy(buf + 4, data, hdr->len);
+    return kv_crc32(buf, 4 + hdr->len);
+}
+
+static uint32_t record_size(uint16_t len) {
+    return (sizeof(kv_record_hdr_t) + len + 3u) & ~3u;
+}
+
+static const uint8_t *sector_ptr(int sector) {
+    return (const uint8_t *)(uintptr_t)(XIP_BASE + KV_REGION_OFFSET + (uint32_t)sector * FLASH_SECTOR_SIZE);
+}
+
+static bool sector_header_valid(int sector, uint32_t *gen) {
+    const kv_sector_hdr_t *hdr = (const kv_sector_hdr_t *)sector_ptr(sector);
+    if (hdr->magic != KV_SECTOR_MAGIC ||
+        hdr->crc != kv_crc32(hdr, offsetof(kv_sector_hdr_t, crc))) {
+        return false;
+    }
+    *gen = hdr->generation;
+    return true;
+}
+
+// Ler os registros do setor ativo para a RAM; a última versão de cada chave vence
+static void scan_sector(int sector) {
+    const uint8_t *base = sector_ptr(sector);
+    uint32_t off = sizeof(kv_sector_hdr_t);
+
+    while (off + sizeof(kv_record_hdr_t) <= FLASH_SECTOR_SIZE) {
+        kv_record_hdr_t hdr;
+        memcpy(&hdr, base + off, sizeof(hdr));
+        if (hdr.key == KV_KEY_ERASED) {
+            break;
+        }
+        if (hdr.key >= KV_KEY_COUNT || hdr.len == 0 || hdr.len > KV_MAX_VALUE ||
+            off + record_size(hdr.len) > FLASH_SECTOR_SIZE ||
+            hdr.crc != record_crc(&hdr, base + off + sizeof(hdr))) {
+            // Registro interrompido por queda de energia: o resto do setor é descartado
+            printf("[KV] Registro inválido em +%lu - compactação agendada\n", (unsigned long)off);
+            needs_compaction = true;
+            break;
+        }
+        memcpy(entries[hdr.key].data, base + off + sizeof(hdr), hdr.len);
+        entries[hdr.key].len = hdr.len;
+        off += record_size(hdr.len);
+    }
+    write_offset = off;
+
+    // Bytes programados depois do último registro válido não podem ser reaproveitados
+    for (uint32_t i = off; i < FLASH_SECTOR_SIZE && !needs_compaction; i++) {
+        if (base[i] != 0xFF) {
+            needs_compaction = true;
+        }
+    }
+}
+
+void kv_store_init(void) {
+    critical_section_init(&entries_lock);
+    memset(entries, 0, sizeof(entries));
+
+    for (int s = 0; s < KV_SECTOR_COUNT; s++) {
+        uint32_t gen;
+        if (sector_header_valid(s, &gen) && (active_sector < 0 || gen > generation)) {
+            active_sector = s;
+            generation = gen;
+        }
+    }
+
+    if (active_sector < 0) {
+        printf("[KV] Região vazia - será formatada na primeira gravação\n");
+        return;
+    }
+
+    scan_sector(active_sector);
+    printf("[KV] Setor %d ativo (geração %lu, %lu/%u bytes)\n", active_sector,
+           (unsigned long)generation, (unsigned long)write_offset, FLASH_SECTOR_SIZE);
+}
+
+bool kv_get(kv_key_t key, void *out, size_t len) {
+    if (key >= KV_KEY_COUNT) {
+        return false;
+    }
+    critical_section_enter_blocking(&entries_lock);
+    bool found = entries[key].len == len;   // Tamanho diferente = formato antigo
+    if (found) {
+        memcpy(out, entries[key].data, len);
+    }
+    critical_section_exit(&entries_lock);
+    return found;
+}
+
+void kv_set(kv_key_t key, const void *data, size_t len) {
+    if (key >= KV_KEY_COUNT || len == 0 || len > KV_MAX_VALUE) {
+        return;
+    }
+    critical_section_enter_blocking(&entries_lock);
+    kv_entry_t *e = &entries[key];
+    if (e->len != len || memcmp(e->data, data, len) != 0) {
+        memcpy(e->data, data, len);
+        e->len = (uint16_t)len;
+        e->version++;
+        e->changed_ms = hal_time_ms();
+    }
+    critical_section_exit(&entries_lock);
+}
+
+// Executado com interrupções desabilitadas e o outro core parado (flash_safe_execute)
+static void kv_flash_exec(void *param) {
+    const kv_flash_op_t *op = (const kv_flash_op_t *)param;
+    if (op->data == NULL) {
+        flash_range_erase(op->offset, FLASH_SECTOR_SIZE);
+    } else {
+        flash_range_program(op->offset, op->data, op->len);
+    }
+}
+
+static bool flash_op(uint32_t offset, const uint8_t *data, size_t len) {
+    kv_flash_op_t op = { offset, data, len };
+    uint64_t start = hal_time_us64();
+    int rc = flash_safe_execute(kv_flash_exec, &op, 100);
+    stats.last_op_us = (uint32_t)(hal_time_us64() - start);
+    if (stats.last_op_us > stats.max_op_us) {
+        stats.max_op_us = stats.last_op_us;
+    }
+    if (rc != PICO_OK) {
+        stats.failures++;
+        printf("[KV] ERRO: operação na flash falhou (%d)\n", rc);
+        return false;
+    }
+    return true;
+}
+
+// Programar bytes em qualquer posição: as páginas são completadas com 0xFF,
+// que não altera o que já está gravado
+static bool program_bytes(int sector, uint32_t offset, const void *data, size_t len) {
+    uint32_t abs_offset = KV_REGION_OFFSET + (uint32_t)sector * FLASH_SECTOR_SIZE + offset;
+    uint32_t page_start = abs_offset & ~(FLASH_PAGE_SIZE - 1);
+    uint32_t span = ((abs_offset + len + FLASH_PAGE_SIZE - 1) & ~(FLASH_PAGE_SIZE - 1)) - page_start;
+    if (span > sizeof(page_buf)) {
+        return false;
+    }
+    memset(page_buf, 0xFF, span);
+    memcpy(page_buf + (abs_offset - page_start), data, len);
+    return flash_op(page_start, page_buf, span);
+}
+
+// Gravar o valor atual de uma chave em sector/offset; retorna o tamanho gravado (0 = falha)
+static uint32_t write_record(int key, int sector, uint32_t offset) {
+    uint8_t image[sizeof(kv_record_hdr_t) + KV_MAX_VALUE];
+    kv_record_hdr_t hdr;
+
+    critical_section_enter_blocking(&entries_lock);
+    uint32_t version = entries[key].version;
+    hdr.key = (uint16_t)key;
+    hdr.len = entries[key].len;
+    memcpy(image + sizeof(hdr), entries[key].data, hdr.len);
+    critical_section_exit(&entries_lock);
+
+    hdr.crc = record_crc(&hdr, image + sizeof(hdr));
+    memcpy(image, &hdr, sizeof(hdr));
+
+    uint32_t size = record_size(hdr.len);
+    if (!program_bytes(sector, offset, image, sizeof(hdr) + hdr.len)) {
+        return 0;
+    }
+    entries[key].written = version;
+    return size;
+}
+
+static bool entry_dirty(int key) {
+    return entries[key].len > 0 && entries[key].version != entries[key].written;
+}
+
+static void start_compaction(void) {
+    target_sector = (active_sector + 1) % KV_SECTOR_COUNT;
+    step = KV_STEP_ERASE;
+}
+
+void kv_store_task(void *ctx) {
+    uint32_t now_ms = hal_time_ms();
+
+    switch (step) {
+        case KV_STEP_IDLE: {
+            // Chave alterada e estável há KV_COMMIT_DELAY_MS
+            int key = -1;
+            for (int k = 0; k < KV_KEY_COUNT; k++) {
+                if (entry_dirty(k) && now_ms - entries[k].changed_ms >= KV_COMMIT_DELAY_MS) {
+                    key = k;
+                    break;
+                }
+            }
+            if (key < 0) {
+                return;
+            }
+            if (active_sector < 0 || needs_compaction ||
+                write_offset + record_size(entries[key].len) > FLASH_SECTOR_SIZE) {
+                start_compaction();
+                return;
+            }
+            uint32_t size = write_record(key, active_sector, write_offset);
+            if (size > 0) {
+                write_offset += size;
+                stats.appends++;
+            } else {
+                needs_compaction = true;   // Página possivelmente parcial: não reaproveitar
+            }
+            break;
+        }
+        case KV_STEP_ERASE:
+            if (flash_op(KV_REGION_OFFSET + (uint32_t)target_sector * FLASH_SECTOR_SIZE, NULL, 0)) {
+                stats.erases++;
+                target_offset = sizeof(kv_sector_hdr_t);
+                copy_key = 0;
+                step = KV_STEP_COPY;
+            }
+            break;
+        case KV_STEP_COPY:
+            while (copy_key < KV_KEY_COUNT && entries[copy_key].len == 0) {
+                copy_key++;
+            }
+            if (copy_key >= KV_KEY_COUNT) {
+                step = KV_STEP_HEADER;
+                break;
+            }
+            {
+                uint32_t size = write_record(copy_key, target_sector, target_offset);
+                if (size == 0) {
+                    step = KV_STEP_ERASE;   // Recomeçar no mesmo setor
+                    break;
+                }
+                target_offset += size;
+                copy_key++;
+            }
+            break;
+        case KV_STEP_HEADER: {
+            kv_sector_hdr_t hdr = { KV_SECTOR_MAGIC, generation + 1, 0, 0 };
+            hdr.crc = kv_crc32(&hdr, offsetof(kv_sector_hdr_t, crc));
+            if (!program_bytes(target_sector, 0, &hdr, sizeof(hdr))) {
+                step = KV_STEP_ERASE;
+                break;
+            }
+            active_sector = target_sector;
+            generation = hdr.generation;
+            write_offset = target_offset;
+            needs_compaction = false;
+            stats.compactions++;
+            step = KV_STEP_IDLE;
+            printf("[KV] Compactado no setor %d (geração %lu, %lu bytes)\n", active_sector,
+                   (unsigned long)generation, (unsigned long)write_offset);
+            break;
+        }
+    }
+}
+
+void kv_get_stats(kv_stats_t *out) {
+    *out = stats;
+    out->active_sector = (int8_t)active_sector;
+    out->generation = generation;
+    out->used_bytes = (uint16_t)write_offset;
+    out->pending = step != KV_STEP_IDLE;
+    for (int k = 0; k < KV_KEY_COUNT; k++) {
+        out->pending |= entry_dirty(k);
+    }
+}
@@ -0,0 +1,54 @@
+#ifndef KV_STORE_H
+#define KV_STORE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+// Armazenamento chave/valor em log na flash
+// Uma região de KV_SECTOR_COUNT setores; só um está ativo por vez. Cada
+// gravação acrescenta um registro {chave, tamanho, CRC, dados} ao final do
+// setor ativo - o valor mais recente de cada chave vence. Quando o setor
+// enche, os valores atuais são copiados para o próximo setor (rodízio =
+// nivelamento de desgaste) e só então o cabeçalho dele é gravado, com uma
+// geração maior. Uma queda de energia no meio deixa, no pior caso, um
+// registro com CRC inválido ou um setor sem cabeçalho - ambos ignorados.
+//
+// kv_set() só atualiza a cópia em RAM; a gravação acontece em kv_store_task()
+// (core 0), um passo limitado por vez: um registro (até 2 páginas) ou um
+// apagamento de setor.
+
+#define KV_SECTOR_COUNT 4
+#define KV_MAX_VALUE 96          // Bytes por valor
+#define KV_COMMIT_DELAY_MS 2000  // Agrupa alterações em sequência (sliders, etc.)
+
+typedef enum {
+    KV_KEY_CONFIG = 0,        // Alvos e calibração dos sensores (config_store)
+    KV_KEY_CONTROLLER,        // Parâmetros do controlador das zonas (autotune)
+    KV_KEY_IMU_BASELINE,      // Baseline/bias do MPU6050
+    KV_KEY_COUNT
+} kv_key_t;
+
+typedef struct {
+    int8_t active_sector;     // -1 = região ainda não formatada
+    uint32_t generation;      // Número de compactações da região
+    uint16_t used_bytes;      // Ocupação do setor ativo
+    uint32_t appends;
+    uint32_t compactions;
+    uint32_t erases;
+    uint32_t failures;
+    uint32_t last_op_us;      // Duração da última operação na flash
+    uint32_t max_op_us;
+    bool pending;             // Há valores ainda não gravados
+} kv_stats_t;
+
+// Funções públicas
+void kv_store_init(void);                                  // Carregar o setor ativo (boot, core 0)
+bool kv_get(kv_key_t key, void *out, size_t len);          // O(1), a partir da RAM
+void kv_set(kv_key_t key, const void *data, size_t len);   // Qualquer core
+void kv_store_task(void *ctx);                             // Tarefa do escalonador do core 0
+void kv_get_stats(kv_stats_t *stats);
+uint32_t kv_crc32(const void *data, size_t len);
+uint32_t kv_crc32_update(uint32_t crc, const void *data, size_t len);   // Continua um CRC
+
+#endif // KV_STORE_H
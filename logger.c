@@ -0,0 +1,218 @@
+#include "logger.h"
+#include <stdio.h>
+#include <string.h>
+#include <stdatomic.h>
+#include "pico/stdlib.h"
+#include "prof.h"
+#include "hal.h"
+
+#define LOG_RING_MASK (LOG_RING_SIZE - 1)
+#define LOG_DRAIN_MAX 16       // Registros por execução da tarefa
+
+_Static_assert((LOG_RING_SIZE & LOG_RING_MASK) == 0, "LOG_RING_SIZE deve ser potência de 2");
+_Static_assert(LOG_MAX_ARGS * 2 <= 16, "tipos dos argumentos precisam caber em 16 bits");
+
+static log_record_t ring[LOG_RING_SIZE];
+static _Atomic uint32_t next_seq = 1;     // 0 marca registro em escrita
+static uint32_t drain_seq = 1;            // Só a tarefa de drenagem usa
+static uint32_t drained;
+static uint32_t lost;
+
+static const char level_letters[] = { '-', 'E', 'W', 'I', 'D' };
+static const char *const module_names[LOG_MOD_COUNT] = { "main", "http", "dhcp", "dns", "ctrl", "store" };
+
+void log_write(const log_site_t *site, const log_arg_t *args, size_t nargs) {
+    // Reserva do registro sem lock: produtores no core 0, na IRQ do lwIP e no core 1
+    uint32_t seq = atomic_fetch_add_explicit(&next_seq, 1, memory_order_relaxed);
+    log_record_t *rec = &ring[seq & LOG_RING_MASK];
+    
+    atomic_store_explicit((_Atomic uint32_t *)&rec->seq, 0, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+    
+    rec->t_us = hal_time_us();
+    rec->site = site;
+    rec->core = (uint8_t)get_core_num();
+    rec->types = 0;
+    
+    size_t word = 0;
+    size_t n = 0;
+    for (; n < nargs && n < LOG_MAX_ARGS && word < LOG_ARG_WORDS; n++) {
+        rec->types |= (uint16_t)(args[n].type << (n * 2));
+        if (args[n].type == LOG_ARG_STR) {
+            // String copiada com '\0', truncada ao espaço que resta
+            char *dst = (char *)&rec->data[word];
+            size_t room = (LOG_ARG_WORDS - word) * 4;
+            const char *src = args[n].s ? args[n].s : "(null)";
+            size_t len = strnlen(src, room - 1);
+            memcpy(dst, src, len);
+            dst[len] = '\0';
+            word += (len + 4) / 4;
+        } else {
+            rec->data[word++] = args[n].u;
+        }
+    }
+    rec->nargs = (uint8_t)n;
+    
+    atomic_store_explicit((_Atomic uint32_t *)&rec->seq, seq, memory_order_release);
+}
+
+bool log_read(uint32_t seq, log_record_t *out) {
+    const log_record_t *rec = &ring[seq & LOG_RING_MASK];
+    if (atomic_load_explicit((_Atomic uint32_t *)&rec->seq, memory_order_acquire) != seq) {
+        return false;
+    }
+    memcpy(out, rec, sizeof(*out));
+    atomic_thread_fence(memory_order_acquire);
+    // Sobrescrito durante a cópia?
+    return atomic_load_explicit((_Atomic uint32_t *)&rec->seq, memory_order_relaxed) == seq;
+}
+
+uint32_t log_oldest_seq(void) {
+    uint32_t head = atomic_load_explicit(&next_seq, memory_order_relaxed);
+    return head > LOG_RING_SIZE ? head - LOG_RING_SIZE : 1;
+}
+
+const char *log_module_name(uint8_t module) {
+    return module < LOG_MOD_COUNT ? module_names[module] : "?";
+}
+
+size_t log_record_args(const log_record_t *rec, log_arg_t *out) {
+    size_t word = 0;
+    size_t n = 0;
+    for (; n < rec->nargs && n < LOG_MAX_ARGS && word < LOG_ARG_WORDS; n++) {
+        out[n].type = (rec->types >> (n * 2)) & 3;
+        if (out[n].type == LOG_ARG_STR) {
+            out[n].s = (const char *)&rec->data[word];
+            word += (strlen(out[n].s) + 4) / 4;
+        } else {
+            out[n].u = rec->data[word++];
+        }
+    }
+    return n;
+}
+
+// Reaplica o formato conversão por conversão, com os argumentos do registro
+int log_format(const log_record_t *rec, char *out, size_t out_len) {
+    const log_site_t *site = rec->site;
+    size_t len = (size_t)snprintf(out, out_len, "[%lu.%03lu] %c %s: ",
+            (unsigned long)(rec->t_us / 1000000), (unsigned long)(rec->t_us / 1000 % 1000),
+            level_letters[site->level <= LOG_LEVEL_DEBUG ? site->level : 0],
+            site->module < LOG_MOD_COUNT ? module_names[site->module] : "?");
+    
+    const char *f = site->fmt;
+    size_t word = 0;
+    int arg = 0;
+    while (*f && len + 1 < out_len) {
+        if (*f != '%') {
+            out[len++] = *f++;
+            continue;
+        }
+        if (f[1] == '%') {
+            out[len++] = '%';
+            f += 2;
+            continue;
+        }
+        
+        // Copiar a especificação sem modificadores de tamanho (l, ll, h, z)
+        char spec[16];
+        size_t s = 0;
+        spec[s++] = *f++;
+        while (*f && strchr("-+ #0123456789.*lhzjt", *f) && s < sizeof(spec) - 3) {
+            if (!strchr("lhzjt", *f)) {
+                spec[s++] = *f;
+            }
+            f++;
+        }
+        char conv = *f ? *f++ : 's';
+        
+        size_t room = out_len - len;
+        int n = 0;
+        if (arg >= rec->nargs || word >= LOG_ARG_WORDS) {
+            n = snprintf(out + len, room, "?");
+        } else {
+            uint8_t type = (rec->types >> (arg * 2)) & 3;
+            const uint32_t *w = &rec->data[word];
+            if (type == LOG_ARG_STR) {
+                const char *str = (const char *)w;
+                word += (strlen(str) + 4) / 4;
+                spec[s++] = 's';
+                spec[s] = '\0';
+                n = snprintf(out + len, room, spec, str);
+            } else {
+                word++;
+                if (strchr("fFeEgG", conv)) {
+                    float fv;
+                    memcpy(&fv, w, sizeof(fv));
+                    double v = (type == LOG_ARG_FLOAT) ? fv : (type == LOG_ARG_INT) ? (double)(int32_t)*w : (double)*w;
+                    spec[s++] = conv;
+                    spec[s] = '\0';
+                    n = snprintf(out + len, room, spec, v);
+                } else if (strchr("di", conv)) {
+                    spec[s++] = 'l';
+                    spec[s++] = conv;
+                    spec[s] = '\0';
+                    n = snprintf(out + len, room, spec, (long)(int32_t)*w);
+                } else if (conv == 'c') {
+                    spec[s++] = 'c';
+                    spec[s] = '\0';
+                    n = snprintf(out + len, room, spec, (int)*w);
+                } else {
+                    // u, x, X, o, p e qualquer outra conversão inteira
+                    spec[s++] = 'l';
+                    spec[s++] = strchr("uxXo", conv) ? conv : 'x';
+                    spec[s] = '\0';
+                    n = snprintf(out + len, room, spec, (unsigned long)*w);
+                }
+            }
+            arg++;
+        }
+        if (n < 0) {
+            break;
+        }
+        len += ((size_t)n < room) ? (size_t)n : room - 1;
+    }
+    // Formatos com '\n' no fim (herdados de printf) não duplicam a quebra
+    while (len > 0 && out[len - 1] == '\n') {
+        len--;
+    }
+    out[len] = '\0';
+    return (int)len;
+}
+
+void log_drain_task(void *ctx) {
+    PROF_SCOPE("log_drain");
+    static log_record_t rec;
+    static char line[192];
+    uint32_t head = atomic_load_explicit(&next_seq, memory_order_acquire);
+    
+    if (head - drain_seq > LOG_RING_SIZE) {
+        lost += head - LOG_RING_SIZE - drain_seq;
+        drain_seq = head - LOG_RING_SIZE;
+    }
+    for (int n = 0; n < LOG_DRAIN_MAX && drain_seq != head; n++) {
+        if (!log_read(drain_seq, &rec)) {
+            // drain_seq < head: o registro já foi reservado. Com 0 ou ainda o
+            // antecessor na posição (volta anterior do anel), o produtor fez
+            // o fetch_add mas não terminou; só um número mais novo é perda
+            const log_record_t *slot = &ring[drain_seq & LOG_RING_MASK];
+            uint32_t seq = atomic_load_explicit((_Atomic uint32_t *)&slot->seq, memory_order_relaxed);
+            if (seq == 0 || seq == drain_seq - LOG_RING_SIZE) {
+                break;   // Ainda sendo escrito; tenta na próxima execução
+            }
+            lost++;      // Sobrescrito
+            drain_seq++;
+            continue;
+        }
+        log_format(&rec, line, sizeof(line));
+        puts(line);
+        drain_seq++;
+        drained++;
+    }
+}
+
+void log_get_stats(log_stats_t *stats) {
+    stats->next_seq = atomic_load_explicit(&next_seq, memory_order_relaxed);
+    stats->written = stats->next_seq - 1;
+    stats->drained = drained;
+    stats->lost = lost;
+}
@@ -0,0 +1,136 @@
+#ifndef LOGGER_H
+#define LOGGER_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+// Log binário adiado
+// LOG_x() grava só {tempo, id do formato, argumentos} num anel em RAM - sem
+// formatar e sem tocar em stdio. A tarefa "log" do core 0 formata e envia
+// para UART/USB fora do caminho quente, e GET /api/logs lê o mesmo anel.
+// O id do formato é o endereço de uma estrutura constante (na flash) com a
+// string, o nível e o módulo. Níveis e módulos desligados em tempo de
+// compilação somem do binário.
+//
+// Argumentos: inteiros (até 32 bits), float/double e strings (copiadas,
+// truncadas no espaço livre do registro). Até LOG_MAX_ARGS por chamada.
+
+#define LOG_LEVEL_NONE  0
+#define LOG_LEVEL_ERROR 1
+#define LOG_LEVEL_WARN  2
+#define LOG_LEVEL_INFO  3
+#define LOG_LEVEL_DEBUG 4
+
+#ifndef IBAG_LOG_LEVEL
+#define IBAG_LOG_LEVEL LOG_LEVEL_INFO
+#endif
+
+typedef enum {
+    LOG_MOD_MAIN = 0,
+    LOG_MOD_HTTP,
+    LOG_MOD_DHCP,
+    LOG_MOD_DNS,       // Portal cativo e mDNS
+    LOG_MOD_CTRL,      // Controle, autotune, IMU (core 1)
+    LOG_MOD_STORE,     // kv_store/config_store
+    LOG_MOD_COUNT
+} log_module_t;
+
+#ifndef IBAG_LOG_MODULES
+#define IBAG_LOG_MODULES 0xFFFFFFFFu   // Bit por log_module_t
+#endif
+
+#define LOG_RING_SIZE 256              // Registros (potência de 2)
+#define LOG_ARG_WORDS 6                // Palavras de 32 bits por registro
+#define LOG_MAX_ARGS 6
+
+typedef enum {
+    LOG_ARG_INT = 0,
+    LOG_ARG_UINT,
+    LOG_ARG_FLOAT,
+    LOG_ARG_STR,
+} log_arg_type_t;
+
+typedef struct {
+    const char *fmt;
+    uint8_t level;
+    uint8_t module;
+} log_site_t;
+
+typedef struct {
+    uint8_t type;          // log_arg_type_t
+    union {
+        uint32_t u;
+        float f;
+        const char *s;
+    };
+} log_arg_t;
+
+typedef struct {
+    uint32_t seq;          // Número do registro; 0 = sendo escrito
+    uint32_t t_us;
+    const log_site_t *site;
+    uint16_t types;        // 2 bits por argumento
+    uint8_t nargs;
+    uint8_t core;
+    uint32_t data[LOG_ARG_WORDS];
+} log_record_t;
+
+typedef struct {
+    uint32_t written;
+    uint32_t drained;
+    uint32_t lost;         // Sobrescritos antes de chegar à UART/USB
+    uint32_t next_seq;     // Próximo número de registro
+} log_stats_t;
+
+static inline log_arg_t log_arg_i(long v) { log_arg_t a = { .type = LOG_ARG_INT }; a.u = (uint32_t)v; return a; }
+static inline log_arg_t log_arg_u(unsigned long v) { log_arg_t a = { .type = LOG_ARG_UINT }; a.u = (uint32_t)v; return a; }
+static inline log_arg_t log_arg_f(double v) { log_arg_t a = { .type = LOG_ARG_FLOAT }; a.f = (float)v; return a; }
+static inline log_arg_t log_arg_s(const char *v) { log_arg_t a = { .type = LOG_ARG_STR }; a.s = v; return a; }
+
+#define LOG_ARG(x) _Generic((x), \
+    float: log_arg_f, double: log_arg_f, \
+    char *: log_arg_s, const char *: log_arg_s, \
+    unsigned int: log_arg_u, unsigned long: log_arg_u, unsigned long long: log_arg_u, \
+    unsigned char: log_arg_u, unsigned short: log_arg_u, \
+    default: log_arg_i)(x)
+
+#define LOG_MAP0()
+#define LOG_MAP1(a) LOG_ARG(a)
+#define LOG_MAP2(a, ...) LOG_ARG(a), LOG_MAP1(__VA_ARGS__)
+#define LOG_MAP3(a, ...) LOG_ARG(a), LOG_MAP2(__VA_ARGS__)
+#define LOG_MAP4(a, ...) LOG_ARG(a), LOG_MAP3(__VA_ARGS__)
+#define LOG_MAP5(a, ...) LOG_ARG(a), LOG_MAP4(__VA_ARGS__)
+#define LOG_MAP6(a, ...) LOG_ARG(a), LOG_MAP5(__VA_ARGS__)
+#define LOG_NARGS(...) LOG_NARGS_(0, ##__VA_ARGS__, 6, 5, 4, 3, 2, 1, 0)
+#define LOG_NARGS_(_0, _1, _2, _3, _4, _5, _6, n, ...) n
+#define LOG_CAT(a, b) LOG_CAT_(a, b)
+#define LOG_CAT_(a, b) a##b
+
+#define LOG_ENABLED(level, module) \
+    ((level) <= IBAG_LOG_LEVEL && (IBAG_LOG_MODULES & (1u << (module))) != 0)
+
+#define LOG_AT(level, module, fmt, ...) do { \
+    if (LOG_ENABLED(level, module)) { \
+        static const log_site_t log_site_ = { fmt, level, module }; \
+        const log_arg_t log_args_[] = { LOG_CAT(LOG_MAP, LOG_NARGS(__VA_ARGS__))(__VA_ARGS__) }; \
+        log_write(&log_site_, log_args_, sizeof(log_args_) / sizeof(log_args_[0])); \
+    } \
+} while (0)
+
+#define LOG_E(module, fmt, ...) LOG_AT(LOG_LEVEL_ERROR, module, fmt, ##__VA_ARGS__)
+#define LOG_W(module, fmt, ...) LOG_AT(LOG_LEVEL_WARN, module, fmt, ##__VA_ARGS__)
+#define LOG_I(module, fmt, ...) LOG_AT(LOG_LEVEL_INFO, module, fmt, ##__VA_ARGS__)
+#define LOG_D(module, fmt, ...) LOG_AT(LOG_LEVEL_DEBUG, module, fmt, ##__VA_ARGS__)
+
+// Funções públicas
+void log_write(const log_site_t *site, const log_arg_t *args, size_t nargs);   // Qualquer core/IRQ
+bool log_read(uint32_t seq, log_record_t *out);           // false se ainda não escrito ou já sobrescrito
+int log_format(const log_record_t *rec, char *out, size_t out_len);   // Linha sem '\n'
+const char *log_module_name(uint8_t module);
+size_t log_record_args(const log_record_t *rec, log_arg_t *out);      // Até LOG_MAX_ARGS; strings apontam para rec
+uint32_t log_oldest_seq(void);
+void log_drain_task(void *ctx);                           // Tarefa do escalonador do core 0
+void log_get_stats(log_stats_t *stats);
+
+#endif // LOGGER_H
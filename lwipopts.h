@@ -38,10 +38,12 @@
 #define LWIP_NETIF_LINK_CALLBACK    1
 #define LWIP_NETIF_HOSTNAME         1
 #define LWIP_NETCONN                0
-#define MEM_STATS                   0
+// Contadores lidos por /api/metrics (não dependem de LWIP_DEBUG)
+#define LWIP_STATS                  1
+#define MEM_STATS                   1
 #define SYS_STATS                   0
-#define MEMP_STATS                  0
-#define LINK_STATS                  0
+#define MEMP_STATS                  1
+#define LINK_STATS                  1
 
 // if_stats=1 is incompatible with NO_SYS=1
 #define IF_STATS                    0
@@ -51,14 +53,16 @@
 #define IP_STATS                    0
 #define IPFRAG_STATS                0
 #define MIB2_STATS                  0
-#define TCP_STATS                   0
-#define UDP_STATS                   0
+#define TCP_STATS                   1
+#define UDP_STATS                   1
 #define LWIP_CHKSUM_ALGORITHM       3
 #define LWIP_DHCP                   1
 #define LWIP_IPV4                   1
 #define LWIP_TCP                    1
 #define LWIP_UDP                    1
 #define LWIP_DNS                    1
+#define LWIP_IGMP                   1   // Grupo 224.0.0.251 do mDNS
+#define MEMP_NUM_SYS_TIMEOUT        (LWIP_NUM_SYS_TIMEOUT_INTERNAL + 1)   // Anúncios do mDNS
 #define LWIP_TCP_KEEPALIVE          1
 #define LWIP_NETIF_TX_SINGLE_PBUF   1
 #define DHCP_DOES_ARP_CHECK         0
@@ -67,24 +71,8 @@
 // DHCP Server settings (para o Access Point)
 #define LWIP_DHCP                   1
 
-// HTTP Server settings
-#define LWIP_HTTPD                  1
-#define LWIP_HTTPD_DYNAMIC_HEADERS  1
-#define LWIP_HTTPD_CGI              1
-#define LWIP_HTTPD_SSI              1
-#define LWIP_HTTPD_SSI_INCLUDE_TAG  0
-#define HTTPD_USE_CUSTOM_FSDATA     0
-#define LWIP_HTTPD_CUSTOM_FILES     1
-#define LWIP_HTTPD_DYNAMIC_FILE_READ 1
-#define LWIP_HTTPD_FILE_EXTENSION   1
-#define HTTPD_SERVER_AGENT          "iBag-Pico2W"
-#define LWIP_HTTPD_MAX_REQUEST_URI_LEN 128
-#define LWIP_HTTPD_SUPPORT_POST     1
-#define HTTPD_SERVER_PORT           8000
-
 #ifndef NDEBUG
 #define LWIP_DEBUG                  1
-#define LWIP_STATS                  1
 #define LWIP_STATS_DISPLAY          1
 #endif
 
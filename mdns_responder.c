@@ -0,0 +1,369 @@
+#include "mdns_responder.h"
+#include <string.h>
+#include <strings.h>
+#include <stdio.h>
+#include "lwip/udp.h"
+#include "lwip/igmp.h"
+#include "lwip/timeouts.h"
+#include "lwip/inet.h"
+#include "pico/stdlib.h"
+#include "prof.h"
+#include "hal.h"
+
+#define MDNS_PORT 5353
+#define MDNS_HEADER_LEN 12
+#define MDNS_MAX_NAME 256
+#define MDNS_MAX_JUMPS 8                // Ponteiros de compressão seguidos por nome
+#define MDNS_MIN_INTERVAL_MS 1000       // Entre multicasts do mesmo registro
+#define MDNS_ANNOUNCE_COUNT 2
+#define MDNS_ANNOUNCE_DELAY_MS 1000
+
+// TTLs recomendados pela RFC 6762 §10
+#define TTL_HOST 120
+#define TTL_OTHER 4500
+#define TTL_LEGACY 10                   // Consultas unicast "legadas" (porta != 5353)
+
+#define TYPE_A   1
+#define TYPE_PTR 12
+#define TYPE_TXT 16
+#define TYPE_SRV 33
+#define TYPE_ANY 255
+#define CLASS_IN 1
+#define CLASS_FLUSH 0x8000              // Registro único (cache-flush)
+#define CLASS_QU 0x8000                 // Pergunta pede resposta unicast
+
+#define FLAG_QR 0x8000
+#define FLAG_AA 0x0400
+
+// Registros publicados (bits)
+enum {
+    REC_A = 0,
+    REC_PTR,          // _http._tcp.local -> iBag._http._tcp.local
+    REC_SRV,
+    REC_TXT,
+    REC_ENUM,         // _services._dns-sd._udp.local -> _http._tcp.local
+    REC_COUNT
+};
+
+#define NAME_HOST     MDNS_HOSTNAME ".local"
+#define NAME_SERVICE  "_http._tcp.local"
+#define NAME_INSTANCE MDNS_INSTANCE "._http._tcp.local"
+#define NAME_ENUM     "_services._dns-sd._udp.local"
+
+// TXT: cada string é precedida do seu tamanho
+static const char txt_entries[][32] = {
+    "txtvers=1",
+    "fw=" IBAG_FW_VERSION,
+    "path=/",
+    "api=/api/status",
+    "sensors=lm35x2,mpu6050",
+    "zones=heater,conservative",
+};
+
+static struct udp_pcb *mdns_pcb;
+static struct netif *mdns_netif;
+static ip_addr_t mdns_group;
+static uint32_t last_multicast_ms[REC_COUNT];
+static uint8_t announcements_left;
+static mdns_stats_t stats;
+static uint8_t out_buf[768];    // Todos os registros + pergunta ecoada (até metade do buffer)
+
+static uint8_t *put_u16(uint8_t *out, uint16_t v) {
+    *out++ = (uint8_t)(v >> 8);
+    *out++ = (uint8_t)v;
+    return out;
+}
+
+static uint8_t *put_u32(uint8_t *out, uint32_t v) {
+    out = put_u16(out, (uint16_t)(v >> 16));
+    return put_u16(out, (uint16_t)v);
+}
+
+// Nome com pontos -> rótulos DNS (sem compressão; os nomes são curtos)
+static uint8_t *put_name(uint8_t *out, const char *name) {
+    while (*name) {
+        const char *dot = strchr(name, '.');
+        size_t len = dot ? (size_t)(dot - name) : strlen(name);
+        *out++ = (uint8_t)len;
+        memcpy(out, name, len);
+        out += len;
+        name += len + (dot ? 1 : 0);
+    }
+    *out++ = 0;
+    return out;
+}
+
+static uint8_t *put_record(uint8_t *out, int rec, bool legacy) {
+    uint16_t cls = CLASS_IN;
+    uint32_t ttl;
+    uint8_t *rdlen;
+    const char *owner;
+    uint16_t type;
+    
+    switch (rec) {
+        case REC_A:    owner = NAME_HOST;     type = TYPE_A;   ttl = TTL_HOST;  cls |= CLASS_FLUSH; break;
+        case REC_PTR:  owner = NAME_SERVICE;  type = TYPE_PTR; ttl = TTL_OTHER; break;
+        case REC_SRV:  owner = NAME_INSTANCE; type = TYPE_SRV; ttl = TTL_HOST;  cls |= CLASS_FLUSH; break;
+        case REC_TXT:  owner = NAME_INSTANCE; type = TYPE_TXT; ttl = TTL_OTHER; cls |= CLASS_FLUSH; break;
+        default:       owner = NAME_ENUM;     type = TYPE_PTR; ttl = TTL_OTHER; break;
+    }
+    if (legacy) {
+        // Resolvedores DNS comuns não entendem o bit de cache-flush
+        cls = CLASS_IN;
+        ttl = TTL_LEGACY;
+    }
+    
+    out = put_name(out, owner);
+    out = put_u16(out, type);
+    out = put_u16(out, cls);
+    out = put_u32(out, ttl);
+    rdlen = out;
+    out += 2;
+    
+    switch (rec) {
+        case REC_A: {
+            uint32_t ip = ntohl(ip4_addr_get_u32(netif_ip4_addr(mdns_netif)));
+            out = put_u32(out, ip);
+            break;
+        }
+        case REC_PTR:
+            out = put_name(out, NAME_INSTANCE);
+            break;
+        case REC_SRV:
+            out = put_u16(out, 0);      // Prioridade
+            out = put_u16(out, 0);      // Peso
+            out = put_u16(out, 8000);   // Porta do servidor HTTP
+            out = put_name(out, NAME_HOST);
+            break;
+        case REC_TXT:
+            for (size_t i = 0; i < sizeof(txt_entries) / sizeof(txt_entries[0]); i++) {
+                size_t len = strlen(txt_entries[i]);
+                *out++ = (uint8_t)len;
+                memcpy(out, txt_entries[i], len);
+                out += len;
+            }
+            break;
+        default:
+            out = put_name(out, NAME_SERVICE);
+            break;
+    }
+    put_u16(rdlen, (uint16_t)(out - rdlen - 2));
+    return out;
+}
+
+// Registros que respondem a uma pergunta (bits REC_*)
+static uint32_t match_question(const char *name, uint16_t type) {
+    bool any = (type == TYPE_ANY);
+    if (strcasecmp(name, NAME_HOST) == 0 && (any || type == TYPE_A)) {
+        return 1u << REC_A;
+    }
+    if (strcasecmp(name, NAME_SERVICE) == 0 && (any || type == TYPE_PTR)) {
+        return 1u << REC_PTR;
+    }
+    if (strcasecmp(name, NAME_INSTANCE) == 0) {
+        uint32_t recs = 0;
+        if (any || type == TYPE_SRV) recs |= 1u << REC_SRV;
+        if (any || type == TYPE_TXT) recs |= 1u << REC_TXT;
+        return recs;
+    }
+    if (strcasecmp(name, NAME_ENUM) == 0 && (any || type == TYPE_PTR)) {
+        return 1u << REC_ENUM;
+    }
+    return 0;
+}
+
+// Ler um nome (com ponteiros de compressão) em texto com pontos.
+// Retorna o offset logo após o nome no pacote, ou 0 se malformado.
+static u16_t read_name(const struct pbuf *p, u16_t pos, char *name) {
+    u16_t end = 0;
+    int len = 0;
+    int jumps = 0;
+    for (;;) {
+        int label = pbuf_try_get_at(p, pos);
+        if (label < 0) return 0;
+        if ((label & 0xC0) == 0xC0) {
+            int low = pbuf_try_get_at(p, (u16_t)(pos + 1));
+            if (low < 0 || ++jumps > MDNS_MAX_JUMPS) return 0;
+            if (end == 0) end = (u16_t)(pos + 2);
+            pos = (u16_t)(((label & 0x3F) << 8) | low);
+            continue;
+        }
+        if (label & 0xC0) return 0;
+        if (label == 0) {
+            name[len] = '\0';
+            return end ? end : (u16_t)(pos + 1);
+        }
+        if (len + label + 2 > MDNS_MAX_NAME) return 0;
+        if (len > 0) name[len++] = '.';
+        if (pbuf_copy_partial(p, name + len, (u16_t)label, (u16_t)(pos + 1)) != label) return 0;
+        len += label;
+        pos = (u16_t)(pos + 1 + label);
+    }
+}
+
+static void mdns_send(uint32_t answers, uint32_t additional, const ip_addr_t *dest, u16_t port,
+                      const struct pbuf *query, u16_t question_end) {
+    bool legacy = (port != MDNS_PORT);
+    uint8_t *out = out_buf;
+    int an = 0, ar = 0;
+    
+    // Cabeçalho: ID só é ecoado em respostas legadas (RFC 6762 §18.1)
+    if (legacy) {
+        pbuf_copy_partial(query, out, 2, 0);
+        out += 2;
+    } else {
+        out = put_u16(out, 0);
+    }
+    out = put_u16(out, FLAG_QR | FLAG_AA);
+    uint8_t *counts = out;
+    out += 8;
+    
+    // Respostas legadas repetem a pergunta
+    u16_t qd = 0;
+    if (legacy && question_end > MDNS_HEADER_LEN &&
+        question_end - MDNS_HEADER_LEN <= (int)sizeof(out_buf) / 2) {
+        u16_t qlen = (u16_t)(question_end - MDNS_HEADER_LEN);
+        pbuf_copy_partial(query, out, qlen, MDNS_HEADER_LEN);
+        out += qlen;
+        qd = (uint16_t)(pbuf_get_at(query, 4) << 8 | pbuf_get_at(query, 5));
+    }
+    
+    for (int rec = 0; rec < REC_COUNT; rec++) {
+        if (answers & (1u << rec)) { out = put_record(out, rec, legacy); an++; }
+    }
+    for (int rec = 0; rec < REC_COUNT; rec++) {
+        if ((additional & ~answers) & (1u << rec)) { out = put_record(out, rec, legacy); ar++; }
+    }
+    put_u16(counts, qd);
+    put_u16(counts + 2, (uint16_t)an);
+    put_u16(counts + 4, 0);
+    put_u16(counts + 6, (uint16_t)ar);
+    
+    struct pbuf *p = pbuf_alloc(PBUF_TRANSPORT, (u16_t)(out - out_buf), PBUF_REF);
+    if (p == NULL) {
+        return;
+    }
+    p->payload = out_buf;
+    udp_sendto_if(mdns_pcb, p, dest, port, mdns_netif);
+    pbuf_free(p);
+    stats.responses++;
+}
+
+// Tirar do multicast os registros enviados há menos de 1 s
+static uint32_t rate_limit(uint32_t recs, uint32_t now_ms) {
+    for (int rec = 0; rec < REC_COUNT; rec++) {
+        if (!(recs & (1u << rec))) continue;
+        if (last_multicast_ms[rec] != 0 && now_ms - last_multicast_ms[rec] < MDNS_MIN_INTERVAL_MS) {
+            recs &= ~(1u << rec);
+            stats.suppressed++;
+        } else {
+            last_multicast_ms[rec] = now_ms ? now_ms : 1;
+        }
+    }
+    return recs;
+}
+
+static void mdns_recv(void *arg, struct udp_pcb *pcb, struct pbuf *p, const ip_addr_t *addr, u16_t port) {
+    PROF_SCOPE("mdns_recv");
+    static char name[MDNS_MAX_NAME];
+    uint32_t multicast = 0, unicast = 0;
+    u16_t pos = MDNS_HEADER_LEN;
+    
+    if (p->tot_len < MDNS_HEADER_LEN) {
+        pbuf_free(p);
+        return;
+    }
+    uint16_t flags = (uint16_t)(pbuf_get_at(p, 2) << 8 | pbuf_get_at(p, 3));
+    uint16_t qdcount = (uint16_t)(pbuf_get_at(p, 4) << 8 | pbuf_get_at(p, 5));
+    if (flags & FLAG_QR) {
+        pbuf_free(p);   // Resposta de outro dispositivo
+        return;
+    }
+    stats.queries++;
+    
+    for (uint16_t q = 0; q < qdcount; q++) {
+        pos = read_name(p, pos, name);
+        if (pos == 0 || (uint32_t)pos + 4 > p->tot_len) {
+            pos = 0;
+            break;
+        }
+        uint16_t qtype = (uint16_t)(pbuf_get_at(p, pos) << 8 | pbuf_get_at(p, (u16_t)(pos + 1)));
+        uint16_t qclass = (uint16_t)(pbuf_get_at(p, (u16_t)(pos + 2)) << 8 | pbuf_get_at(p, (u16_t)(pos + 3)));
+        pos = (u16_t)(pos + 4);
+        if ((qclass & ~CLASS_QU) != CLASS_IN && (qclass & ~CLASS_QU) != TYPE_ANY) {
+            continue;
+        }
+        uint32_t recs = match_question(name, qtype);
+        if ((qclass & CLASS_QU) || port != MDNS_PORT) {
+            unicast |= recs;
+        } else {
+            multicast |= recs;
+        }
+    }
+    
+    // Adicionais do DNS-SD: quem pergunta pelo serviço recebe SRV/TXT/A juntos
+    uint32_t all = multicast | unicast;
+    uint32_t additional = 0;
+    if (all & ((1u << REC_PTR) | (1u << REC_ENUM))) {
+        additional |= (1u << REC_SRV) | (1u << REC_TXT) | (1u << REC_A);
+    }
+    if (all & (1u << REC_SRV)) {
+        additional |= 1u << REC_A;
+    }
+    
+    if (unicast) {
+        mdns_send(unicast, additional, addr, port, p, pos);
+    }
+    if (multicast) {
+        multicast = rate_limit(multicast, hal_time_ms());
+        if (multicast) {
+            mdns_send(multicast, additional, &mdns_group, MDNS_PORT, p, 0);
+        }
+    }
+    pbuf_free(p);
+}
+
+static void mdns_announce(void *arg) {
+    uint32_t all = (1u << REC_COUNT) - 1;
+    mdns_send(all, 0, &mdns_group, MDNS_PORT, NULL, 0);
+    stats.announcements++;
+    uint32_t now_ms = hal_time_ms();
+    for (int rec = 0; rec < REC_COUNT; rec++) {
+        last_multicast_ms[rec] = now_ms ? now_ms : 1;
+    }
+    if (--announcements_left > 0) {
+        sys_timeout(MDNS_ANNOUNCE_DELAY_MS, mdns_announce, NULL);
+    }
+}
+
+const mdns_stats_t *mdns_responder_get_stats(void) {
+    return &stats;
+}
+
+void mdns_responder_init(struct netif *netif) {
+    mdns_netif = netif;
+    IP_ADDR4(&mdns_group, 224, 0, 0, 251);
+    
+    if (igmp_joingroup_netif(netif, ip_2_ip4(&mdns_group)) != ERR_OK) {
+        printf("ERRO: Falha ao entrar no grupo mDNS\n");
+        return;
+    }
+    
+    mdns_pcb = udp_new();
+    if (mdns_pcb == NULL || udp_bind(mdns_pcb, IP_ADDR_ANY, MDNS_PORT) != ERR_OK) {
+        printf("ERRO: Falha ao fazer bind mDNS na porta 5353\n");
+        if (mdns_pcb != NULL) {
+            udp_remove(mdns_pcb);
+            mdns_pcb = NULL;
+        }
+        return;
+    }
+    mdns_pcb->ttl = 255;   // RFC 6762 §11
+    udp_set_multicast_ttl(mdns_pcb, 255);
+    udp_recv(mdns_pcb, mdns_recv, NULL);
+    
+    announcements_left = MDNS_ANNOUNCE_COUNT;
+    sys_timeout(MDNS_ANNOUNCE_DELAY_MS, mdns_announce, NULL);
+    
+    printf("✅ mDNS: http://" NAME_HOST ":8000 (serviço " NAME_INSTANCE ")\n");
+}
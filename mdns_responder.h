@@ -0,0 +1,31 @@
+#ifndef MDNS_RESPONDER_H
+#define MDNS_RESPONDER_H
+
+#include <stdint.h>
+#include "lwip/netif.h"
+
+// Responder mDNS/DNS-SD (UDP 5353, grupo 224.0.0.251)
+// Publica o host ibag.local (A) e o serviço "iBag._http._tcp.local" (PTR,
+// SRV na porta 8000 e TXT com versão do firmware e sensores). Anuncia duas
+// vezes no boot e depois só responde a consultas; o mesmo registro não é
+// repetido em multicast com menos de 1 s de intervalo (RFC 6762 §6).
+
+#define MDNS_HOSTNAME "ibag"
+#define MDNS_INSTANCE "iBag"
+
+#ifndef IBAG_FW_VERSION
+#define IBAG_FW_VERSION "0.1"
+#endif
+
+typedef struct {
+    uint32_t queries;          // Consultas recebidas
+    uint32_t responses;        // Pacotes de resposta enviados
+    uint32_t suppressed;       // Registros omitidos pelo limite de 1 s
+    uint32_t announcements;
+} mdns_stats_t;
+
+// Funções públicas (contexto do lwIP)
+void mdns_responder_init(struct netif *netif);
+const mdns_stats_t *mdns_responder_get_stats(void);
+
+#endif // MDNS_RESPONDER_H
@@ -0,0 +1,346 @@
+#include "metrics.h"
+#include <stdio.h>
+#include <string.h>
+#include <malloc.h>
+#include "pico/stdlib.h"
+#include "lwip/stats.h"
+#include "lwip/memp.h"
+#include "scheduler.h"
+#include "ipc.h"
+#include "logger.h"
+#include "history.h"
+#include "telemetry.h"
+#include "hal.h"
+
+extern scheduler_t main_scheduler;
+
+// Limites do heap definidos pelo linker script do SDK (no host o heap da
+// glibc não tem tamanho fixo: reporta 0). Na glibc mallinfo() é obsoleto
+// (campos int estouram acima de 2 GB); o newlib só tem mallinfo()
+#if IBAG_HOST
+#define HEAP_SIZE 0ul
+typedef struct mallinfo2 heap_info_t;
+#define heap_info() mallinfo2()
+#else
+extern char __end__;
+extern char __HeapLimit;
+#define HEAP_SIZE ((unsigned long)(&__HeapLimit - &__end__))
+typedef struct mallinfo heap_info_t;
+#define heap_info() mallinfo()
+#endif
+
+// Rotas com contador próprio; o resto cai em "other" (cardinalidade fixa)
+static const char *const routes[] = {
+    "/", "/api/status", "/api/config", "/api/reset", "/api/zones", "/api/tasks",
+    "/api/power", "/api/storage", "/api/boot", "/api/captive", "/api/logs",
+    "/api/autotune", "/api/autotune/cancel", "/api/metrics", "/api/prof", "/api/watchdog",
+    "/api/history", "/api/schema",
+};
+#define ROUTE_COUNT (int)(sizeof(routes) / sizeof(routes[0]))
+
+// Limites do histograma de tempo de resposta (µs)
+static const uint32_t bucket_us[] = { 100, 250, 500, 1000, 2500, 5000, 10000, 25000, 50000, 100000 };
+#define BUCKET_COUNT (int)(sizeof(bucket_us) / sizeof(bucket_us[0]))
+
+static uint32_t route_requests[ROUTE_COUNT + 1];   // Último = other
+static uint32_t duration_buckets[BUCKET_COUNT + 1]; // Último = +Inf (não cumulativo aqui)
+static uint64_t duration_sum_us;
+static uint32_t duration_count;
+
+// Fotografias das renderizações em andamento, uma por conexão; o byte alto
+// do cursor é o índice (tirada em metrics_render_begin)
+#define METRICS_RENDERS 2
+
+typedef struct {
+    ipc_snapshot_t snap;
+    heap_info_t heap;
+    log_stats_t log_stats;
+    history_stats_t hist;
+    telemetry_stats_t telem;
+} metrics_view_t;
+
+static metrics_view_t views[METRICS_RENDERS];
+static uint8_t views_used;
+static const metrics_view_t *view;   // Fotografia da chamada atual de metrics_render
+
+int metrics_route_id(const char *path) {
+    for (int i = 0; i < ROUTE_COUNT; i++) {
+        if (strcmp(path, routes[i]) == 0) {
+            return i;
+        }
+    }
+    return METRICS_ROUTE_OTHER;
+}
+
+void metrics_http_request(int route, uint32_t elapsed_us) {
+    route_requests[route >= 0 && route < ROUTE_COUNT ? route : ROUTE_COUNT]++;
+    int b = 0;
+    while (b < BUCKET_COUNT && elapsed_us > bucket_us[b]) {
+        b++;
+    }
+    duration_buckets[b]++;
+    duration_sum_us += elapsed_us;
+    duration_count++;
+}
+
+// --- Famílias ---
+// count() = número de amostras; sample(i) escreve o sufixo da amostra i
+// (labels e valor) logo após o nome da família.
+
+typedef struct {
+    const char *name;
+    const char *type;
+    const char *help;
+    int (*count)(void);
+    int (*sample)(int i, char *out, size_t len);
+} metric_family_t;
+
+static int one(void) { return 1; }
+static int two(void) { return 2; }
+static int three(void) { return 3; }
+static int four(void) { return 4; }
+static int six(void) { return 6; }
+static int route_count(void) { return ROUTE_COUNT + 1; }
+static int bucket_count(void) { return BUCKET_COUNT + 3; }   // buckets, +Inf, _sum, _count
+static int pool_count(void) { return MEMP_MAX; }
+static int zone_count(void) { return CONTROL_ZONE_COUNT; }
+static int task_count(void) { return main_scheduler.count + view->snap.task_count; }
+
+static const sched_task_t *task_at(int i, int *core) {
+    if (i < main_scheduler.count) {
+        *core = 0;
+        return sched_get_task(&main_scheduler, i);
+    }
+    *core = 1;
+    return &view->snap.tasks[i - main_scheduler.count];
+}
+
+static const char *pool_name(int i) {
+    const struct stats_mem *m = lwip_stats.memp[i];
+    return (m && m->name) ? m->name : "?";
+}
+
+static int s_uptime(int i, char *out, size_t len) {
+    return snprintf(out, len, " %.3f\n", hal_time_us64() / 1e6);
+}
+
+static int s_requests(int i, char *out, size_t len) {
+    return snprintf(out, len, "{route=\"%s\"} %lu\n", i < ROUTE_COUNT ? routes[i] : "other",
+                    (unsigned long)route_requests[i]);
+}
+
+static int s_duration(int i, char *out, size_t len) {
+    if (i <= BUCKET_COUNT) {
+        uint32_t cumulative = 0;
+        for (int b = 0; b <= i; b++) cumulative += duration_buckets[b];
+        if (i == BUCKET_COUNT) {
+            return snprintf(out, len, "_bucket{le=\"+Inf\"} %lu\n", (unsigned long)cumulative);
+        }
+        return snprintf(out, len, "_bucket{le=\"%g\"} %lu\n", bucket_us[i] / 1e6, (unsigned long)cumulative);
+    }
+    if (i == BUCKET_COUNT + 1) {
+        return snprintf(out, len, "_sum %.6f\n", duration_sum_us / 1e6);
+    }
+    return snprintf(out, len, "_count %lu\n", (unsigned long)duration_count);
+}
+
+static int s_mem(int i, char *out, size_t len) {
+    static const char *const states[] = { "used", "max", "avail" };
+    const u32_t values[] = { lwip_stats.mem.used, lwip_stats.mem.max, lwip_stats.mem.avail };
+    return snprintf(out, len, "{state=\"%s\"} %lu\n", states[i], (unsigned long)values[i]);
+}
+
+static int s_memp_used(int i, char *out, size_t len) {
+    const struct stats_mem *m = lwip_stats.memp[i];
+    return snprintf(out, len, "{pool=\"%s\"} %lu\n", pool_name(i), m ? (unsigned long)m->used : 0ul);
+}
+
+static int s_memp_max(int i, char *out, size_t len) {
+    const struct stats_mem *m = lwip_stats.memp[i];
+    return snprintf(out, len, "{pool=\"%s\"} %lu\n", pool_name(i), m ? (unsigned long)m->max : 0ul);
+}
+
+static int s_memp_avail(int i, char *out, size_t len) {
+    const struct stats_mem *m = lwip_stats.memp[i];
+    return snprintf(out, len, "{pool=\"%s\"} %lu\n", pool_name(i), m ? (unsigned long)m->avail : 0ul);
+}
+
+static int s_memp_err(int i, char *out, size_t len) {
+    const struct stats_mem *m = lwip_stats.memp[i];
+    return snprintf(out, len, "{pool=\"%s\"} %lu\n", pool_name(i), m ? (unsigned long)m->err : 0ul);
+}
+
+static int s_packets(int i, char *out, size_t len) {
+    static const char *const dirs[] = { "xmit", "recv", "drop" };
+    const struct stats_proto *proto = (i < 3) ? &lwip_stats.tcp : &lwip_stats.udp;
+    const unsigned values[] = { proto->xmit, proto->recv, proto->drop };
+    return snprintf(out, len, "{proto=\"%s\",dir=\"%s\"} %u\n", i < 3 ? "tcp" : "udp", dirs[i % 3], values[i % 3]);
+}
+
+static int s_heap(int i, char *out, size_t len) {
+    static const char *const states[] = { "size", "high_water", "used", "free" };
+    unsigned long size = HEAP_SIZE;
+    const unsigned long values[] = { size, (unsigned long)view->heap.arena, (unsigned long)view->heap.uordblks,
+                                     size > (unsigned long)view->heap.uordblks ? size - (unsigned long)view->heap.uordblks : 0 };
+    return snprintf(out, len, "{state=\"%s\"} %lu\n", states[i], values[i]);
+}
+
+static int s_i2c(int i, char *out, size_t len) {
+    static const char *const results[] = { "transfer", "error", "retry", "failure" };
+    const uint32_t values[] = { view->snap.i2c.transfers, view->snap.i2c.errors, view->snap.i2c.retries, view->snap.i2c.failures };
+    return snprintf(out, len, "{result=\"%s\"} %lu\n", results[i], (unsigned long)values[i]);
+}
+
+static int s_adc(int i, char *out, size_t len) {
+    return snprintf(out, len, " %lu\n", (unsigned long)view->snap.adc_samples);
+}
+
+static int s_actuations(int i, char *out, size_t len) {
+    return snprintf(out, len, "{zone=\"%s\"} %lu\n", view->snap.zones[i].name,
+                    (unsigned long)view->snap.zones[i].stats.actuations);
+}
+
+static int s_relay_on(int i, char *out, size_t len) {
+    return snprintf(out, len, "{zone=\"%s\"} %.3f\n", view->snap.zones[i].name,
+                    view->snap.zones[i].stats.on_time_ms / 1e3);
+}
+
+static int s_task_runs(int i, char *out, size_t len) {
+    int core;
+    const sched_task_t *t = task_at(i, &core);
+    return snprintf(out, len, "{core=\"%d\",task=\"%s\"} %lu\n", core, t->name, (unsigned long)t->runs);
+}
+
+static int s_task_overruns(int i, char *out, size_t len) {
+    int core;
+    const sched_task_t *t = task_at(i, &core);
+    return snprintf(out, len, "{core=\"%d\",task=\"%s\"} %lu\n", core, t->name, (unsigned long)t->overruns);
+}
+
+static int s_task_missed(int i, char *out, size_t len) {
+    int core;
+    const sched_task_t *t = task_at(i, &core);
+    return snprintf(out, len, "{core=\"%d\",task=\"%s\"} %lu\n", core, t->name, (unsigned long)t->missed);
+}
+
+static int s_task_exec_max(int i, char *out, size_t len) {
+    int core;
+    const sched_task_t *t = task_at(i, &core);
+    return snprintf(out, len, "{core=\"%d\",task=\"%s\"} %.6f\n", core, t->name, t->max_exec_us / 1e6);
+}
+
+static int s_samples_dropped(int i, char *out, size_t len) {
+    return snprintf(out, len, " %lu\n", (unsigned long)ipc_samples_dropped());
+}
+
+static int s_log_lost(int i, char *out, size_t len) {
+    return snprintf(out, len, " %lu\n", (unsigned long)view->log_stats.lost);
+}
+
+static int s_history_rows(int i, char *out, size_t len) {
+    return snprintf(out, len, " %lu\n", (unsigned long)view->hist.rows);
+}
+
+static int s_history_bytes(int i, char *out, size_t len) {
+    static const char *const kinds[] = { "raw", "stored" };
+    const uint32_t values[] = { view->hist.raw_bytes, view->hist.stored_bytes };
+    return snprintf(out, len, "{kind=\"%s\"} %lu\n", kinds[i], (unsigned long)values[i]);
+}
+
+static int s_history_blocks(int i, char *out, size_t len) {
+    static const char *const states[] = { "sealed", "spilled", "lost", "flash_failure" };
+    const uint32_t values[] = { view->hist.blocks_sealed, view->hist.blocks_spilled, view->hist.blocks_lost, view->hist.flash_failures };
+    return snprintf(out, len, "{state=\"%s\"} %lu\n", states[i], (unsigned long)values[i]);
+}
+
+static int s_telemetry_records(int i, char *out, size_t len) {
+    static const char *const states[] = { "sent", "dropped" };
+    const uint32_t values[] = { view->telem.records_sent, view->telem.records_dropped };
+    return snprintf(out, len, "{state=\"%s\"} %lu\n", states[i], (unsigned long)values[i]);
+}
+
+static const metric_family_t families[] = {
+    { "ibag_uptime_seconds", "gauge", "Tempo desde o boot", one, s_uptime },
+    { "ibag_http_requests_total", "counter", "Requisições HTTP por rota", route_count, s_requests },
+    { "ibag_http_request_duration_seconds", "histogram", "Tempo para tratar uma requisição HTTP", bucket_count, s_duration },
+    { "ibag_lwip_mem_bytes", "gauge", "Heap interno do lwIP", three, s_mem },
+    { "ibag_lwip_memp_used", "gauge", "Elementos em uso por pool do lwIP (PCBs, pbufs, segmentos)", pool_count, s_memp_used },
+    { "ibag_lwip_memp_max", "gauge", "Máximo de elementos em uso por pool do lwIP", pool_count, s_memp_max },
+    { "ibag_lwip_memp_avail", "gauge", "Tamanho de cada pool do lwIP", pool_count, s_memp_avail },
+    { "ibag_lwip_memp_errors_total", "counter", "Alocações que falharam por pool do lwIP", pool_count, s_memp_err },
+    { "ibag_lwip_packets_total", "counter", "Pacotes TCP/UDP", six, s_packets },
+    { "ibag_heap_bytes", "gauge", "Heap do newlib (high_water = maior tamanho já alocado do sistema)", four, s_heap },
+    { "ibag_i2c_events_total", "counter", "Transferências I2C do MPU6050", four, s_i2c },
+    { "ibag_adc_samples_total", "counter", "Leituras do ADC (LM35)", one, s_adc },
+    { "ibag_relay_actuations_total", "counter", "Acionamentos de relé por zona", zone_count, s_actuations },
+    { "ibag_relay_on_seconds_total", "counter", "Tempo com relé ligado por zona", zone_count, s_relay_on },
+    { "ibag_task_runs_total", "counter", "Execuções por tarefa do escalonador", task_count, s_task_runs },
+    { "ibag_task_overruns_total", "counter", "Execuções acima do orçamento", task_count, s_task_overruns },
+    { "ibag_task_missed_total", "counter", "Períodos perdidos", task_count, s_task_missed },
+    { "ibag_task_exec_max_seconds", "gauge", "Maior tempo de execução por tarefa", task_count, s_task_exec_max },
+    { "ibag_ipc_samples_dropped_total", "counter", "Amostras do core 1 descartadas com a fila cheia", one, s_samples_dropped },
+    { "ibag_log_lost_total", "counter", "Registros de log sobrescritos antes da drenagem", one, s_log_lost },
+    { "ibag_history_rows_total", "counter", "Linhas acrescentadas ao histórico neste boot", one, s_history_rows },
+    { "ibag_history_bytes_total", "counter", "Tamanho das linhas do histórico sem e com compressão", two, s_history_bytes },
+    { "ibag_history_blocks_total", "counter", "Blocos do histórico por destino", four, s_history_blocks },
+    { "ibag_telemetry_records_total", "counter", "Registros da telemetria USB enviados e descartados (fila cheia)", two, s_telemetry_records },
+};
+#define FAMILY_COUNT (int)(sizeof(families) / sizeof(families[0]))
+
+bool metrics_render_begin(uint32_t *cursor) {
+    for (int i = 0; i < METRICS_RENDERS; i++) {
+        if (!(views_used & (1u << i))) {
+            metrics_view_t *v = &views[i];
+            views_used |= 1u << i;
+            ipc_read_snapshot(&v->snap);
+            v->heap = heap_info();
+            log_get_stats(&v->log_stats);
+            history_get_stats(&v->hist);
+            telemetry_get_stats(&v->telem);
+            *cursor = (uint32_t)i << 24;
+            return true;
+        }
+    }
+    return false;
+}
+
+void metrics_render_end(uint32_t cursor) {
+    views_used &= ~(1u << (cursor >> 24));
+}
+
+size_t metrics_render(uint32_t *cursor, char *out, size_t out_len) {
+    uint32_t slot = *cursor >> 24;
+    int family = (int)((*cursor >> 16) & 0xFF);
+    int line = (int)(*cursor & 0xFFFF);
+    size_t used = 0;
+    static char buf[512];   // Pilha da IRQ do lwIP (http_sent -> http_body_fill)
+    
+    view = &views[slot];
+    
+    while (family < FAMILY_COUNT) {
+        const metric_family_t *f = &families[family];
+        int n;
+        if (line == 0) {
+            n = snprintf(buf, sizeof(buf), "# HELP %s %s\n# TYPE %s %s\n", f->name, f->help, f->name, f->type);
+        } else if (line - 1 < f->count()) {
+            n = snprintf(buf, sizeof(buf), "%s", f->name);
+            n += f->sample(line - 1, buf + n, sizeof(buf) - n);
+        } else {
+            family++;
+            line = 0;
+            continue;
+        }
+        if (n >= (int)sizeof(buf)) {
+            n = sizeof(buf) - 1;
+        }
+        if (used + n > out_len) {
+            break;
+        }
+        memcpy(out + used, buf, n);
+        used += n;
+        line++;
+    }
+    
+    *cursor = (slot << 24) | ((uint32_t)family << 16) | (uint32_t)line;
+    return used;
+}
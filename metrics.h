@@ -0,0 +1,26 @@
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+// Métricas no formato de texto do Prometheus (GET /api/metrics)
+// A renderização é incremental: cada chamada de metrics_render() escreve
+// as linhas que couberem no buffer e guarda a posição em *cursor, então a
+// resposta sai em pedaços do tamanho da janela TCP, sem buffer grande.
+// Contadores do HTTP são atualizados no contexto do lwIP; os demais vêm
+// das estatísticas do lwIP, do heap, dos escalonadores e do snapshot do core 1,
+// fotografados por metrics_render_begin() numa das poucas vagas (uma por
+// conexão, indicada no cursor) e liberados com metrics_render_end().
+
+#define METRICS_ROUTE_OTHER (-1)
+
+// Funções públicas (contexto do lwIP)
+int metrics_route_id(const char *path);                       // Rota conhecida ou METRICS_ROUTE_OTHER
+void metrics_http_request(int route, uint32_t elapsed_us);
+bool metrics_render_begin(uint32_t *cursor);                  // false = sem vaga (503)
+size_t metrics_render(uint32_t *cursor, char *out, size_t out_len);   // 0 = terminou
+void metrics_render_end(uint32_t cursor);
+
+#endif // METRICS_H
@@ -1,21 +1,36 @@
 #include "mpu6050.h"
-#include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <math.h>
 #include "pico/stdlib.h"
-#include "hardware/i2c.h"
+#include "hal.h"
+#include "kv_store.h"
+#include "telemetry.h"
+#include "logger.h"
 
 // Configuração I2C
-#define I2C_PORT i2c0
 #define I2C_SDA_PIN 20
 #define I2C_SCL_PIN 21
 #define I2C_FREQ 400000  // 400 kHz
+#define I2C_RETRIES 2    // Tentativas extras por transferência
+#define I2C_TIMEOUT_US 2000  // Por transferência: um escravo preso não trava o core 1
 
 // Thresholds para detecção de virada brusca
 #define ACCEL_THRESHOLD 20000   // Threshold para aceleração (valores brutos)
 #define GYRO_Z_RATE_THRESHOLD 8000  // Taxa de variação do Gyro Z para detectar giro brusco
 #define GYRO_Z_ABSOLUTE_THRESHOLD 12000  // Valor absoluto alto do Gyro Z
-#define CALIBRATION_TIME_MS 10000  // 10 segundos para calibração
+
+// Refinamento do baseline em segundo plano (média com o dispositivo parado)
+#define REFINE_SAMPLES 100            // 10 s de leituras (uma a cada 100 ms)
+#define REFINE_MOTION_LIMIT 1500      // Desvio da 1ª amostra (soma |Δaccel|) que reinicia a janela
+
+// Interrupção de movimento (acordar do modo dormant)
+#define MOTION_WAKE_THRESHOLD 20   // 2 mg por LSB: ~40 mg
+#define MOTION_WAKE_DURATION 1     // 1 ms acima do threshold
+
+// Índice de vibração: maior soma |Δaccel| entre leituras seguidas na janela
+#define VIBRATION_WINDOW 10           // Leituras por janela (1 s a cada 100 ms)
+#define ACCEL_LSB_PER_G 16384         // Faixa padrão de ±2 g
 
 // Variável estática para rastrear se houve shake
 static bool shake_detected = false;
@@ -27,57 +42,92 @@ static bool is_calibrated = false;
 static mpu6050_accel_t baseline_accel = {0, 0, 0};
 static mpu6050_gyro_t baseline_gyro = {0, 0, 0};
 
+// Baseline persistido no kv_store
+typedef struct {
+    mpu6050_accel_t accel;
+    mpu6050_gyro_t gyro;
+} mpu6050_baseline_t;
+
+// Janela do refinamento
+static bool is_refining = false;
+static int32_t refine_sum[6];
+static uint16_t refine_count = 0;
+static mpu6050_accel_t refine_ref;
+
 // Variáveis para monitorar taxa de variação do Gyro Z
 static int16_t last_gyro_z = 0;
 static bool has_last_gyro_z = false;
 
-// Leitura de registrador do MPU6050
+// Contadores do barramento (só o core 1 escreve)
+static mpu6050_i2c_stats_t i2c_stats;
+
+// Vibração e viradas (só o core 1 escreve)
+static mpu6050_accel_t last_accel;
+static bool has_last_accel = false;
+static uint32_t vibration_peak = 0;
+static uint8_t vibration_reads = 0;
+static uint16_t vibration_mg = 0;
+static uint32_t shake_count = 0;
+
+// Leitura de registrador do MPU6050 (repete após NAK/ruído)
 static bool mpu6050_read_reg(uint8_t reg, uint8_t *data, size_t len) {
-    int ret = i2c_write_blocking(I2C_PORT, MPU6050_ADDR, &reg, 1, true);
-    if (ret < 0) return false;
-    
-    ret = i2c_read_blocking(I2C_PORT, MPU6050_ADDR, data, len, false);
-    return ret >= 0;
+    for (int attempt = 0; attempt <= I2C_RETRIES; attempt++) {
+        if (attempt > 0) i2c_stats.retries++;
+        i2c_stats.transfers++;
+        int ret = hal_i2c_write(MPU6050_ADDR, &reg, 1, true, I2C_TIMEOUT_US);
+        if (ret >= 0) {
+            ret = hal_i2c_read(MPU6050_ADDR, data, len, false, I2C_TIMEOUT_US);
+        }
+        if (ret >= 0) return true;
+        i2c_stats.errors++;
+    }
+    i2c_stats.failures++;
+    return false;
 }
 
 // Escrita em registrador do MPU6050
 static bool mpu6050_write_reg(uint8_t reg, uint8_t data) {
     uint8_t buf[2] = {reg, data};
-    int ret = i2c_write_blocking(I2C_PORT, MPU6050_ADDR, buf, 2, false);
-    return ret >= 0;
+    for (int attempt = 0; attempt <= I2C_RETRIES; attempt++) {
+        if (attempt > 0) i2c_stats.retries++;
+        i2c_stats.transfers++;
+        if (hal_i2c_write(MPU6050_ADDR, buf, 2, false, I2C_TIMEOUT_US) >= 0) return true;
+        i2c_stats.errors++;
+    }
+    i2c_stats.failures++;
+    return false;
+}
+
+void mpu6050_get_i2c_stats(mpu6050_i2c_stats_t *stats) {
+    *stats = i2c_stats;
 }
 
 // Inicializar o MPU6050
 bool mpu6050_init(void) {
     // Inicializar I2C
-    i2c_init(I2C_PORT, I2C_FREQ);
-    gpio_set_function(I2C_SDA_PIN, GPIO_FUNC_I2C);
-    gpio_set_function(I2C_SCL_PIN, GPIO_FUNC_I2C);
-    gpio_pull_up(I2C_SDA_PIN);
-    gpio_pull_up(I2C_SCL_PIN);
+    hal_i2c_init(I2C_FREQ, I2C_SDA_PIN, I2C_SCL_PIN);
     
-    sleep_ms(100);  // Dar tempo para o MPU6050 inicializar
+    hal_sleep_ms(100);  // Dar tempo para o MPU6050 inicializar
     
     // Verificar WHO_AM_I
     uint8_t who_am_i;
     if (!mpu6050_read_reg(MPU6050_WHO_AM_I, &who_am_i, 1)) {
-        printf("MPU6050: Falha ao ler WHO_AM_I\n");
+        LOG_E(LOG_MOD_CTRL, "MPU6050: Falha ao ler WHO_AM_I");
         return false;
     }
     
-    printf("MPU6050: WHO_AM_I = 0x%02X\n", who_am_i);
+    LOG_I(LOG_MOD_CTRL, "MPU6050: WHO_AM_I = 0x%02X", who_am_i);
     
     // Acordar o MPU6050 (desabilitar sleep mode)
     if (!mpu6050_write_reg(MPU6050_PWR_MGMT_1, 0x00)) {
-        printf("MPU6050: Falha ao acordar dispositivo\n");
+        LOG_E(LOG_MOD_CTRL, "MPU6050: Falha ao acordar dispositivo");
         return false;
     }
     
-    sleep_ms(100);
+    hal_sleep_ms(100);
     
-    printf("MPU6050 inicializado com sucesso!\n");
-    printf("  - I2C0: SDA=GPIO%d, SCL=GPIO%d\n", I2C_SDA_PIN, I2C_SCL_PIN);
-    printf("  - Detecção de virada brusca: ATIVA\n\n");
+    LOG_I(LOG_MOD_CTRL, "MPU6050 inicializado (I2C0: SDA=GPIO%d, SCL=GPIO%d), detecção de virada ativa",
+          I2C_SDA_PIN, I2C_SCL_PIN);
     
     return true;
 }
@@ -112,6 +162,81 @@ bool mpu6050_read_gyro(mpu6050_gyro_t *gyro) {
     return true;
 }
 
+// Acumular uma leitura; a janela recomeça se o dispositivo se mexer
+static void refine_sample(const mpu6050_accel_t *accel, const mpu6050_gyro_t *gyro) {
+    if (refine_count == 0) {
+        refine_ref = *accel;
+        memset(refine_sum, 0, sizeof(refine_sum));
+    }
+    int32_t motion = abs(accel->x - refine_ref.x) + abs(accel->y - refine_ref.y) +
+                     abs(accel->z - refine_ref.z);
+    if (motion > REFINE_MOTION_LIMIT) {
+        refine_count = 0;
+        return;
+    }
+    
+    refine_sum[0] += accel->x; refine_sum[1] += accel->y; refine_sum[2] += accel->z;
+    refine_sum[3] += gyro->x;  refine_sum[4] += gyro->y;  refine_sum[5] += gyro->z;
+    if (++refine_count < REFINE_SAMPLES) {
+        return;
+    }
+    
+    baseline_accel.x = (int16_t)(refine_sum[0] / refine_count);
+    baseline_accel.y = (int16_t)(refine_sum[1] / refine_count);
+    baseline_accel.z = (int16_t)(refine_sum[2] / refine_count);
+    baseline_gyro.x = (int16_t)(refine_sum[3] / refine_count);
+    baseline_gyro.y = (int16_t)(refine_sum[4] / refine_count);
+    baseline_gyro.z = (int16_t)(refine_sum[5] / refine_count);
+    is_calibrated = true;
+    is_refining = false;
+    
+    mpu6050_baseline_t saved = { baseline_accel, baseline_gyro };
+    kv_set(KV_KEY_IMU_BASELINE, &saved, sizeof(saved));
+    LOG_I(LOG_MOD_CTRL, "MPU6050: Baseline refinado em segundo plano (média de %d leituras)", REFINE_SAMPLES);
+}
+
+// Vibração independe do baseline: compara leituras consecutivas
+static void update_vibration(const mpu6050_accel_t *accel) {
+    if (has_last_accel) {
+        uint32_t delta = abs(accel->x - last_accel.x) + abs(accel->y - last_accel.y) +
+                         abs(accel->z - last_accel.z);
+        if (delta > vibration_peak) vibration_peak = delta;
+    }
+    last_accel = *accel;
+    has_last_accel = true;
+    if (++vibration_reads >= VIBRATION_WINDOW) {
+        uint32_t mg = vibration_peak * 1000u / ACCEL_LSB_PER_G;
+        vibration_mg = mg > UINT16_MAX ? UINT16_MAX : (uint16_t)mg;
+        vibration_peak = 0;
+        vibration_reads = 0;
+    }
+}
+
+// Aritmética da detecção de virada brusca, sem estado nem I2C:
+// 1. Se a TAXA DE VARIAÇÃO do Gyro Z for muito alta (mudança rápida)
+// 2. OU se o valor absoluto do Gyro Z for extremamente alto
+// 3. OU se a aceleração for muito alta
+bool mpu6050_shake_eval(const mpu6050_accel_t *accel, const mpu6050_gyro_t *gyro,
+                        const mpu6050_accel_t *base_accel, const mpu6050_gyro_t *base_gyro,
+                        const int16_t *last_gyro_z, mpu6050_shake_metrics_t *m) {
+    // Diferença em relação à linha base (posição de referência)
+    m->accel_diff = abs(accel->x - base_accel->x) +
+                    abs(accel->y - base_accel->y) +
+                    abs(accel->z - base_accel->z);
+    
+    // Taxa de variação do Gyro Z (diferença entre leitura atual e anterior)
+    m->gyro_z_rate = last_gyro_z ? abs(gyro->z - *last_gyro_z) : 0;
+    
+    // Valor absoluto do Gyro Z em relação à baseline
+    m->gyro_z_absolute = abs(gyro->z - base_gyro->z);
+    
+    m->reasons = 0;
+    if (m->gyro_z_rate > GYRO_Z_RATE_THRESHOLD) m->reasons |= MPU6050_SHAKE_RAPID_ROTATION;
+    if (m->gyro_z_absolute > GYRO_Z_ABSOLUTE_THRESHOLD) m->reasons |= MPU6050_SHAKE_EXTREME_ROTATION;
+    if (m->accel_diff > ACCEL_THRESHOLD) m->reasons |= MPU6050_SHAKE_HIGH_ACCEL;
+    return m->reasons != 0;
+}
+
 // Detectar virada brusca
 bool mpu6050_detect_shake(void) {
     mpu6050_accel_t accel;
@@ -119,78 +244,66 @@ bool mpu6050_detect_shake(void) {
     
     // Ler dados do sensor
     if (!mpu6050_read_accel(&accel) || !mpu6050_read_gyro(&gyro)) {
-        printf("[MPU6050] ERRO: Falha ao ler dados do sensor!\n");
+        LOG_E(LOG_MOD_CTRL, "MPU6050: Falha ao ler dados do sensor");
         return false;
     }
+    const int16_t raw_accel[3] = { accel.x, accel.y, accel.z };
+    const int16_t raw_gyro[3] = { gyro.x, gyro.y, gyro.z };
+    telemetry_imu(raw_accel, raw_gyro);
+    
+    if (is_refining && !is_calibrating) {
+        refine_sample(&accel, &gyro);
+    }
+    update_vibration(&accel);
     
     // Se está calibrando, mostrar status
     if (is_calibrating) {
-        printf("[MPU6050] CALIBRANDO... Accel: X=%6d Y=%6d Z=%6d | Gyro: X=%6d Y=%6d Z=%6d\n",
-               accel.x, accel.y, accel.z, gyro.x, gyro.y, gyro.z);
+        LOG_D(LOG_MOD_CTRL, "MPU6050: CALIBRANDO... Accel: X=%6d Y=%6d Z=%6d | Gyro: X=%6d Y=%6d Z=%6d",
+              accel.x, accel.y, accel.z, gyro.x, gyro.y, gyro.z);
         has_last_gyro_z = false;  // Reset durante calibração
         return false;
     }
     
     // Se não está calibrado, mostrar status
     if (!is_calibrated) {
-        printf("[MPU6050] NAO CALIBRADO! Accel: X=%6d Y=%6d Z=%6d | Gyro: X=%6d Y=%6d Z=%6d\n",
-               accel.x, accel.y, accel.z, gyro.x, gyro.y, gyro.z);
+        LOG_D(LOG_MOD_CTRL, "MPU6050: NAO CALIBRADO! Accel: X=%6d Y=%6d Z=%6d | Gyro: X=%6d Y=%6d Z=%6d",
+              accel.x, accel.y, accel.z, gyro.x, gyro.y, gyro.z);
         has_last_gyro_z = false;  // Reset se não calibrado
         return false;
     }
     
     // Se já detectou shake, retornar true (mas ainda mostrar dados)
     if (shake_detected) {
-        // printf("[MPU6050] SHAKE JA DETECTADO! Accel: X=%6d Y=%6d Z=%6d | Gyro: X=%6d Y=%6d Z=%6d\n",
-        //        accel.x, accel.y, accel.z, gyro.x, gyro.y, gyro.z);
         return true;
     }
     
-    // Calcular diferença em relação à linha base (posição de referência)
-    int32_t accel_diff = abs(accel.x - baseline_accel.x) + 
-                         abs(accel.y - baseline_accel.y) + 
-                         abs(accel.z - baseline_accel.z);
-    
-    // Calcular taxa de variação do Gyro Z (diferença entre leitura atual e anterior)
-    int32_t gyro_z_rate = 0;
-    if (has_last_gyro_z) {
-        gyro_z_rate = abs(gyro.z - last_gyro_z);
-    }
-    
-    // Valor absoluto do Gyro Z em relação à baseline
-    int32_t gyro_z_absolute = abs(gyro.z - baseline_gyro.z);
+    // Comparar com a linha base e com a leitura anterior do Gyro Z
+    mpu6050_shake_metrics_t m;
+    bool shaken = mpu6050_shake_eval(&accel, &gyro, &baseline_accel, &baseline_gyro,
+                                     has_last_gyro_z ? &last_gyro_z : NULL, &m);
     
     // Atualizar histórico
     last_gyro_z = gyro.z;
     has_last_gyro_z = true;
     
-    // Log detalhado dos valores do MPU6050
-    // printf("[MPU6050] Gyro.Z: %6d | Z_rate: %6ld | Z_abs: %6ld | Accel_diff: %6ld\n",
-    //        gyro.z, gyro_z_rate, gyro_z_absolute, accel_diff);
-    
-    // Detectar virada brusca:
-    // 1. Se a TAXA DE VARIAÇÃO do Gyro Z for muito alta (mudança rápida)
-    // 2. OU se o valor absoluto do Gyro Z for extremamente alto
-    // 3. OU se a aceleração for muito alta
-    bool rapid_rotation = (gyro_z_rate > GYRO_Z_RATE_THRESHOLD);
-    bool extreme_rotation = (gyro_z_absolute > GYRO_Z_ABSOLUTE_THRESHOLD);
-    bool high_accel = (accel_diff > ACCEL_THRESHOLD);
-    
-    if (rapid_rotation || extreme_rotation || high_accel) {
+    if (shaken) {
         shake_detected = true;
-        printf("\n⚠️  VIRADA BRUSCA DETECTADA!\n");
-        printf("   Razão: ");
-        if (rapid_rotation) printf("ROTAÇÃO RÁPIDA (Z_rate=%ld > %d) ", gyro_z_rate, GYRO_Z_RATE_THRESHOLD);
-        if (extreme_rotation) printf("ROTAÇÃO EXTREMA (Z_abs=%ld > %d) ", gyro_z_absolute, GYRO_Z_ABSOLUTE_THRESHOLD);
-        if (high_accel) printf("ACELERAÇÃO ALTA (A=%ld > %d)", accel_diff, ACCEL_THRESHOLD);
-        printf("\n");
-        printf("   Valores Atuais:\n");
-        printf("     Accel: X=%d, Y=%d, Z=%d\n", accel.x, accel.y, accel.z);
-        printf("     Gyro:  X=%d, Y=%d, Z=%d\n", gyro.x, gyro.y, gyro.z);
-        printf("     Gyro Z anterior: %d\n", last_gyro_z);
-        printf("   Baseline (referência):\n");
-        printf("     Accel: X=%d, Y=%d, Z=%d\n", baseline_accel.x, baseline_accel.y, baseline_accel.z);
-        printf("     Gyro:  X=%d, Y=%d, Z=%d\n\n", baseline_gyro.x, baseline_gyro.y, baseline_gyro.z);
+        shake_count++;
+        LOG_W(LOG_MOD_CTRL, "⚠️  VIRADA BRUSCA DETECTADA!");
+        if (m.reasons & MPU6050_SHAKE_RAPID_ROTATION) {
+            LOG_W(LOG_MOD_CTRL, "   Razão: ROTAÇÃO RÁPIDA (Z_rate=%ld > %d)", (long)m.gyro_z_rate, GYRO_Z_RATE_THRESHOLD);
+        }
+        if (m.reasons & MPU6050_SHAKE_EXTREME_ROTATION) {
+            LOG_W(LOG_MOD_CTRL, "   Razão: ROTAÇÃO EXTREMA (Z_abs=%ld > %d)", (long)m.gyro_z_absolute, GYRO_Z_ABSOLUTE_THRESHOLD);
+        }
+        if (m.reasons & MPU6050_SHAKE_HIGH_ACCEL) {
+            LOG_W(LOG_MOD_CTRL, "   Razão: ACELERAÇÃO ALTA (A=%ld > %d)", (long)m.accel_diff, ACCEL_THRESHOLD);
+        }
+        LOG_I(LOG_MOD_CTRL, "   Atual: Accel X=%d, Y=%d, Z=%d | Gyro X=%d, Y=%d, Z=%d",
+              accel.x, accel.y, accel.z, gyro.x, gyro.y, gyro.z);
+        LOG_I(LOG_MOD_CTRL, "   Baseline: Accel X=%d, Y=%d, Z=%d | Gyro X=%d, Y=%d, Z=%d",
+              baseline_accel.x, baseline_accel.y, baseline_accel.z,
+              baseline_gyro.x, baseline_gyro.y, baseline_gyro.z);
         return true;
     }
     
@@ -204,10 +317,9 @@ void mpu6050_reset_shake_detection(void) {
     is_calibrated = false;
     has_last_gyro_z = false;  // Reset do histórico
     last_gyro_z = 0;
-    calibration_start_time = to_ms_since_boot(get_absolute_time());
-    printf("MPU6050: Estado de virada resetado\n");
-    printf("MPU6050: Iniciando calibração de 10 segundos...\n");
-    printf("         N\u00c3O MOVA O DISPOSITIVO!\n");
+    calibration_start_time = hal_time_ms();
+    LOG_I(LOG_MOD_CTRL, "MPU6050: Estado de virada resetado, calibração de %lu s - NÃO MOVA O DISPOSITIVO!",
+          (unsigned long)(MPU6050_CALIBRATION_MS / 1000));
 }
 
 // Atualizar processo de calibração
@@ -216,10 +328,10 @@ void mpu6050_update_calibration(void) {
         return;
     }
     
-    uint32_t current_time = to_ms_since_boot(get_absolute_time());
+    uint32_t current_time = hal_time_ms();
     uint32_t elapsed = current_time - calibration_start_time;
     
-    if (elapsed >= CALIBRATION_TIME_MS) {
+    if (elapsed >= MPU6050_CALIBRATION_MS) {
         // Finalizar calibração - ler valores base
         mpu6050_accel_t accel;
         mpu6050_gyro_t gyro;
@@ -230,11 +342,63 @@ void mpu6050_update_calibration(void) {
             is_calibrated = true;
             is_calibrating = false;
             
-            printf("\n✅ MPU6050: Calibração completa!\n");
-            printf("   Baseline Accel: X=%d, Y=%d, Z=%d\n", 
-                   baseline_accel.x, baseline_accel.y, baseline_accel.z);
-            printf("   Baseline Gyro:  X=%d, Y=%d, Z=%d\n\n", 
-                   baseline_gyro.x, baseline_gyro.y, baseline_gyro.z);
+            LOG_I(LOG_MOD_CTRL, "✅ MPU6050: Calibração completa! Baseline Accel X=%d, Y=%d, Z=%d | Gyro X=%d, Y=%d, Z=%d",
+                  baseline_accel.x, baseline_accel.y, baseline_accel.z,
+                  baseline_gyro.x, baseline_gyro.y, baseline_gyro.z);
+            
+            mpu6050_baseline_t saved = { baseline_accel, baseline_gyro };
+            kv_set(KV_KEY_IMU_BASELINE, &saved, sizeof(saved));
         }
     }
 }
+
+// Usar o último baseline gravado (evita depender da calibração para detectar)
+bool mpu6050_restore_calibration(void) {
+    mpu6050_baseline_t saved;
+    if (!kv_get(KV_KEY_IMU_BASELINE, &saved, sizeof(saved))) {
+        return false;
+    }
+    baseline_accel = saved.accel;
+    baseline_gyro = saved.gyro;
+    is_calibrated = true;
+    LOG_I(LOG_MOD_CTRL, "MPU6050: Baseline restaurado da flash (Accel Z=%d, Gyro Z=%d)",
+          baseline_accel.z, baseline_gyro.z);
+    return true;
+}
+
+// Refinar o baseline sem bloquear: a detecção continua com o baseline atual
+// (restaurado da flash) e só começa após a primeira janela se não houver um
+void mpu6050_start_background_calibration(void) {
+    is_refining = true;
+    refine_count = 0;
+}
+
+// Habilitar/desabilitar a interrupção de movimento no pino INT
+// Com LATCH_INT_EN o pino fica alto até a leitura de INT_STATUS, então a borda
+// não se perde mesmo com o chip em dormant.
+bool mpu6050_set_motion_wake(bool enable) {
+    uint8_t status;
+    if (!enable) {
+        bool ok = mpu6050_write_reg(MPU6050_INT_ENABLE, 0x00);
+        return mpu6050_read_reg(MPU6050_INT_STATUS, &status, 1) && ok;  // Limpar o latch
+    }
+    
+    if (!mpu6050_write_reg(MPU6050_MOT_THR, MOTION_WAKE_THRESHOLD) ||
+        !mpu6050_write_reg(MPU6050_MOT_DUR, MOTION_WAKE_DURATION) ||
+        !mpu6050_write_reg(MPU6050_INT_PIN_CFG, 0x30) ||   // Ativo alto, latch, limpa na leitura
+        !mpu6050_read_reg(MPU6050_INT_STATUS, &status, 1) ||
+        !mpu6050_write_reg(MPU6050_INT_ENABLE, 0x40)) {    // MOT_EN
+        LOG_E(LOG_MOD_CTRL, "MPU6050: Falha ao configurar interrupção de movimento");
+        return false;
+    }
+    LOG_I(LOG_MOD_CTRL, "MPU6050: Interrupção de movimento armada");
+    return true;
+}
+
+uint16_t mpu6050_vibration_mg(void) {
+    return vibration_mg;
+}
+
+uint32_t mpu6050_shake_count(void) {
+    return shake_count;
+}
@@ -12,6 +12,13 @@
 #define MPU6050_ACCEL_XOUT_H 0x3B
 #define MPU6050_GYRO_XOUT_H  0x43
 #define MPU6050_WHO_AM_I     0x75
+#define MPU6050_MOT_THR      0x1F
+#define MPU6050_MOT_DUR      0x20
+#define MPU6050_INT_PIN_CFG  0x37
+#define MPU6050_INT_ENABLE   0x38
+#define MPU6050_INT_STATUS   0x3A
+
+#define MPU6050_CALIBRATION_MS 10000   // Recalibração pedida por POST /api/reset
 
 // Estrutura para dados do acelerômetro
 typedef struct {
@@ -27,6 +34,27 @@ typedef struct {
     int16_t z;
 } mpu6050_gyro_t;
 
+// Contadores do barramento I2C
+typedef struct {
+    uint32_t transfers;   // Tentativas (inclui repetições)
+    uint32_t errors;      // Tentativas que falharam
+    uint32_t retries;
+    uint32_t failures;    // Transferências que falharam em todas as tentativas
+} mpu6050_i2c_stats_t;
+
+// Critérios da virada brusca (bits de mpu6050_shake_metrics_t.reasons)
+#define MPU6050_SHAKE_RAPID_ROTATION   (1u << 0)
+#define MPU6050_SHAKE_EXTREME_ROTATION (1u << 1)
+#define MPU6050_SHAKE_HIGH_ACCEL       (1u << 2)
+
+// Métricas de uma leitura na detecção de virada brusca
+typedef struct {
+    int32_t accel_diff;        // Soma |accel - baseline|
+    int32_t gyro_z_rate;       // |Gyro Z - leitura anterior|
+    int32_t gyro_z_absolute;   // |Gyro Z - baseline|
+    uint8_t reasons;           // MPU6050_SHAKE_*
+} mpu6050_shake_metrics_t;
+
 // Funções públicas
 bool mpu6050_init(void);
 bool mpu6050_read_accel(mpu6050_accel_t *accel);
@@ -34,5 +62,14 @@ bool mpu6050_read_gyro(mpu6050_gyro_t *gyro);
 bool mpu6050_detect_shake(void);
 void mpu6050_reset_shake_detection(void);
 void mpu6050_update_calibration(void);  // Atualizar processo de calibração
+bool mpu6050_restore_calibration(void);     // Baseline gravado no kv_store
+void mpu6050_start_background_calibration(void);
+bool mpu6050_set_motion_wake(bool enable);  // Pino INT sobe ao detectar movimento
+void mpu6050_get_i2c_stats(mpu6050_i2c_stats_t *stats);
+uint16_t mpu6050_vibration_mg(void);        // Maior variação da aceleração no último 1 s (mg)
+uint32_t mpu6050_shake_count(void);         // Viradas detectadas desde o boot
+bool mpu6050_shake_eval(const mpu6050_accel_t *accel, const mpu6050_gyro_t *gyro,
+                        const mpu6050_accel_t *base_accel, const mpu6050_gyro_t *base_gyro,
+                        const int16_t *last_gyro_z, mpu6050_shake_metrics_t *m);   // last_gyro_z NULL = sem anterior
 
 #endif // MPU6050_H
@@ -0,0 +1,77 @@
+#include "power.h"
+#include <stdio.h>
+#include "pico/stdlib.h"
+#include "pico/runtime_init.h"
+#include "hardware/clocks.h"
+#include "hardware/pll.h"
+#include "hardware/xosc.h"
+#include "hardware/gpio.h"
+#include "hardware/sync.h"
+
+// Uma entrada por core; cada core só escreve na sua
+static power_stats_t stats[2];
+
+void power_idle_until(uint64_t deadline_us) {
+    power_stats_t *s = &stats[get_core_num()];
+    uint64_t start = time_us_64();
+    if (s->since_us == 0) {
+        s->since_us = start;
+    }
+    if (deadline_us <= start) {
+        return;
+    }
+
+    best_effort_wfe_or_timeout(from_us_since_boot(deadline_us));
+
+    s->sleep_us += time_us_64() - start;
+    s->sleeps++;
+}
+
+// Rodar do XOSC com PLLs desligados (o XOSC é o único clock que entra em dormant)
+static void run_from_xosc(void) {
+    clock_configure(clk_ref, CLOCKS_CLK_REF_CTRL_SRC_VALUE_XOSC_CLKSRC, 0, XOSC_HZ, XOSC_HZ);
+    clock_configure(clk_sys, CLOCKS_CLK_SYS_CTRL_SRC_VALUE_CLK_REF, 0, XOSC_HZ, XOSC_HZ);
+    clock_stop(clk_adc);
+    clock_stop(clk_usb);
+    clock_configure(clk_peri, 0, CLOCKS_CLK_PERI_CTRL_AUXSRC_VALUE_XOSC_CLKSRC, XOSC_HZ, XOSC_HZ);
+    pll_deinit(pll_sys);
+    pll_deinit(pll_usb);
+}
+
+bool power_dormant_until_pin(unsigned gpio) {
+    if (get_core_num() != 0) {
+        return false;
+    }
+
+    printf("[POWER] Entrando em dormant (acorda pelo GPIO %u)\n", gpio);
+    stdio_flush();
+
+    gpio_init(gpio);
+    gpio_set_dir(gpio, GPIO_IN);
+    gpio_pull_down(gpio);
+
+    uint32_t irq_state = save_and_disable_interrupts();
+    run_from_xosc();
+    gpio_set_dormant_irq_enabled(gpio, GPIO_IRQ_LEVEL_HIGH, true);
+    xosc_dormant();   // Para aqui até o pino ficar alto
+
+    gpio_set_dormant_irq_enabled(gpio, GPIO_IRQ_LEVEL_HIGH, false);
+    runtime_init_clocks();   // PLLs e clocks de volta à configuração de boot
+    restore_interrupts(irq_state);
+
+    stats[0].dormant_entries++;
+    printf("[POWER] Acordado por movimento\n");
+    return true;
+}
+
+const power_stats_t *power_get_stats(void) {
+    return &stats[get_core_num()];
+}
+
+// Fração do tempo dormindo, em por mil
+uint32_t power_sleep_permille(const power_stats_t *s, uint64_t now_us) {
+    if (s->since_us == 0 || now_us <= s->since_us) {
+        return 0;
+    }
+    return (uint32_t)((s->sleep_us * 1000) / (now_us - s->since_us));
+}
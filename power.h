@@ -0,0 +1,30 @@
+#ifndef POWER_H
+#define POWER_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// Gerenciamento de energia
+// Entre deadlines cada core dorme em WFE: acorda no deadline (alarme do SDK),
+// em qualquer interrupção (Wi-Fi, GPIO) ou no __sev() do outro core.
+// O modo dormant para todos os clocks do chip; só um pino GPIO (INT do
+// MPU6050) acorda o sistema. O timer também para, então o tempo em dormant
+// não é medido - apenas o número de entradas.
+
+// Pino INT do MPU6050 (interrupção de movimento)
+#define MPU6050_INT_PIN 22
+
+typedef struct {
+    uint64_t sleep_us;          // Tempo total dormindo em WFE
+    uint64_t since_us;          // Início da contagem (time_us_64)
+    uint32_t sleeps;            // Vezes que o core entrou em WFE
+    uint32_t dormant_entries;   // Vezes que o chip entrou em dormant
+} power_stats_t;
+
+// Funções públicas
+void power_idle_until(uint64_t deadline_us);   // Dormir até o deadline ou um evento
+bool power_dormant_until_pin(unsigned gpio);   // Core 0; o chamador prepara o Wi-Fi e o core 1
+const power_stats_t *power_get_stats(void);    // Estatísticas do core que chama
+uint32_t power_sleep_permille(const power_stats_t *stats, uint64_t now_us);
+
+#endif // POWER_H
@@ -0,0 +1,208 @@
+#include "prof.h"
+#include <stdio.h>
+#include <string.h>
+#include "pico/stdlib.h"
+#include "hardware/clocks.h"
+#include "json_writer.h"
+
+// Debug do Cortex-M33 (PPB, cada core enxerga o seu)
+#define DEMCR (*(volatile uint32_t *)0xE000EDFCu)
+#define DEMCR_TRCENA (1u << 24)
+#define DWT_CTRL (*(volatile uint32_t *)0xE0001000u)
+#define DWT_CTRL_CYCCNTENA (1u << 0)
+
+const char *volatile prof_last_probe[2];
+
+static prof_probe_t *probes[PROF_MAX_PROBES];
+static _Atomic uint32_t next_slot;
+static _Atomic uint32_t ready_mask;   // Bit por probe já registrada
+static _Atomic uint32_t dropped;      // Probes além de PROF_MAX_PROBES
+
+void prof_core_init(void) {
+#if IBAG_PROF_ENABLED
+    DEMCR |= DEMCR_TRCENA;
+    DWT_CTRL |= DWT_CTRL_CYCCNTENA;
+#endif
+}
+
+// Primeira execução da probe: reservar uma posição na tabela
+static void prof_register(prof_probe_t *probe) {
+    if (atomic_exchange_explicit(&probe->registered, 1, memory_order_relaxed)) {
+        return;
+    }
+    probe->core = (uint8_t)get_core_num();
+    uint32_t slot = atomic_fetch_add_explicit(&next_slot, 1, memory_order_relaxed);
+    if (slot >= PROF_MAX_PROBES) {
+        atomic_fetch_add_explicit(&dropped, 1, memory_order_relaxed);
+        return;
+    }
+    probes[slot] = probe;
+    atomic_fetch_or_explicit(&ready_mask, 1u << slot, memory_order_release);
+}
+
+static void probe_clear(prof_probe_t *probe) {
+    probe->count = 0;
+    probe->min_cycles = UINT32_MAX;
+    probe->max_cycles = 0;
+    probe->total_cycles = 0;
+    memset(probe->hist, 0, sizeof(probe->hist));
+}
+
+void prof_record(prof_probe_t *probe, uint32_t cycles) {
+    if (!atomic_load_explicit(&probe->registered, memory_order_relaxed)) {
+        prof_register(probe);
+    }
+    if (probe->reset_pending) {
+        probe->reset_pending = false;
+        probe_clear(probe);
+    }
+
+    int bucket = cycles ? 31 - __builtin_clz(cycles) : 0;
+    if (bucket >= PROF_HIST_BUCKETS) {
+        bucket = PROF_HIST_BUCKETS - 1;
+    }
+    probe->hist[bucket]++;
+    probe->count++;
+    probe->total_cycles += cycles;
+    if (cycles < probe->min_cycles) probe->min_cycles = cycles;
+    if (cycles > probe->max_cycles) probe->max_cycles = cycles;
+}
+
+int prof_probe_count(void) {
+    uint32_t count = atomic_load_explicit(&next_slot, memory_order_relaxed);
+    return count < PROF_MAX_PROBES ? (int)count : PROF_MAX_PROBES;
+}
+
+const prof_probe_t *prof_get_probe(int index) {
+    if (index < 0 || index >= PROF_MAX_PROBES) {
+        return NULL;
+    }
+    uint32_t mask = atomic_load_explicit(&ready_mask, memory_order_acquire);
+    return (mask & (1u << index)) ? probes[index] : NULL;
+}
+
+// Zerar é aplicado pelo dono na próxima execução, sem disputar os contadores
+void prof_reset(void) {
+    for (int i = 0; i < prof_probe_count(); i++) {
+        if (prof_get_probe(i) != NULL) {
+            probes[i]->reset_pending = true;
+        }
+    }
+}
+
+// Uma probe em JSON; durante o dormant o clk_sys muda, então a conversão
+// para µs usa a frequência do momento da leitura
+static void probe_json(json_writer_t *w, const prof_probe_t *probe, uint32_t cycles_per_us) {
+    uint32_t count = probe->count;
+    uint32_t avg = count ? (uint32_t)(probe->total_cycles / count) : 0;
+    uint32_t min = count ? probe->min_cycles : 0;
+    json_obj_begin(w);
+    json_key(w, "name");
+    json_str(w, probe->name);
+    json_key(w, "core");
+    json_uint(w, probe->core);
+    json_key(w, "count");
+    json_uint(w, count);
+    json_key(w, "min_cycles");
+    json_uint(w, min);
+    json_key(w, "avg_cycles");
+    json_uint(w, avg);
+    json_key(w, "max_cycles");
+    json_uint(w, probe->max_cycles);
+    json_key(w, "min_us");
+    json_uint(w, min / cycles_per_us);
+    json_key(w, "avg_us");
+    json_uint(w, avg / cycles_per_us);
+    json_key(w, "max_us");
+    json_uint(w, probe->max_cycles / cycles_per_us);
+    // Só faixas não vazias, chave = limite inferior em ciclos (2^k)
+    json_key(w, "hist");
+    json_obj_begin(w);
+    for (int b = 0; b < PROF_HIST_BUCKETS; b++) {
+        if (probe->hist[b] == 0) continue;
+        char key[11];
+        int n = sizeof(key) - 1;
+        key[n] = '\0';
+        uint32_t v = 1ul << b;
+        do {
+            key[--n] = (char)('0' + v % 10);
+            v /= 10;
+        } while (v != 0);
+        json_key(w, key + n);
+        json_uint(w, probe->hist[b]);
+    }
+    json_obj_end(w);
+    json_obj_end(w);
+}
+
+static uint32_t cycles_per_us(void) {
+    uint32_t mhz = clock_get_hz(clk_sys) / 1000000u;
+    return mhz ? mhz : 1;
+}
+
+size_t prof_render(uint32_t *cursor, char *out, size_t out_len) {
+    // Cursor: 0 = abertura, 1..N = probes, N+1 = fechamento
+    // Cada item vai direto para 'out'; o que não coube fica para a próxima parte
+    int count = prof_probe_count();
+    uint32_t cpu = cycles_per_us();
+    size_t used = 0;
+
+    while ((int)*cursor <= count + 1) {
+        int item = (int)*cursor;
+        json_writer_t w;
+        json_writer_init(&w, out + used, out_len - used);
+        if (item == 0) {
+            json_obj_begin(&w);
+            json_key(&w, "clk_sys_hz");
+            json_uint(&w, clock_get_hz(clk_sys));
+            json_key(&w, "enabled");
+            json_bool(&w, IBAG_PROF_ENABLED);
+            json_key(&w, "dropped");
+            json_uint(&w, atomic_load_explicit(&dropped, memory_order_relaxed));
+            json_key(&w, "probes");
+            json_arr_begin(&w);
+        } else if (item <= count) {
+            const prof_probe_t *probe = prof_get_probe(item - 1);
+            if (probe != NULL) {
+                // Vírgula se alguma probe anterior já saiu (pode haver lacuna
+                // de uma probe ainda se registrando)
+                uint32_t before = atomic_load_explicit(&ready_mask, memory_order_relaxed) &
+                                  ((1u << (item - 1)) - 1);
+                w.comma = before != 0;
+                probe_json(&w, probe, cpu);
+            }
+        } else {
+            json_arr_end(&w);
+            json_obj_end(&w);
+        }
+        if (!json_writer_ok(&w)) {
+            break;
+        }
+        used += json_writer_len(&w);
+        (*cursor)++;
+    }
+    return used;
+}
+
+void prof_dump(void) {
+    uint32_t cpu = cycles_per_us();
+    printf("\n=== Perfil (CYCCNT, clk_sys %lu MHz) ===\n", (unsigned long)cpu);
+    printf("%-16s %4s %9s %9s %9s %9s\n", "probe", "core", "n", "min us", "med us", "max us");
+    for (int i = 0; i < prof_probe_count(); i++) {
+        const prof_probe_t *probe = prof_get_probe(i);
+        if (probe == NULL || probe->count == 0) {
+            continue;
+        }
+        uint32_t avg = (uint32_t)(probe->total_cycles / probe->count);
+        printf("%-16s %4u %9lu %9lu %9lu %9lu\n", probe->name, probe->core,
+               (unsigned long)probe->count, (unsigned long)(probe->min_cycles / cpu),
+               (unsigned long)(avg / cpu), (unsigned long)(probe->max_cycles / cpu));
+        printf("  hist (ciclos >= 2^k):");
+        for (int b = 0; b < PROF_HIST_BUCKETS; b++) {
+            if (probe->hist[b] != 0) {
+                printf(" %d:%lu", b, (unsigned long)probe->hist[b]);
+            }
+        }
+        printf("\n");
+    }
+}
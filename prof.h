@@ -0,0 +1,91 @@
+#ifndef PROF_H
+#define PROF_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdatomic.h>
+
+// Perfilador por escopo com o contador de ciclos do DWT (CYCCNT)
+// PROF_SCOPE("nome") no início de um bloco mede do ponto da macro até o fim
+// do bloco (inclusive nos returns antecipados, via __attribute__((cleanup))).
+// Cada probe acumula contagem, mín/méd/máx e um histograma log2 em ciclos.
+// Custo ligado: duas leituras do CYCCNT e algumas somas. Com
+// -DIBAG_PROF_ENABLED=0 as macros somem e nada é linkado nos chamadores.
+//
+// Cada core tem seu próprio DWT: prof_core_init() precisa rodar nos dois.
+// Uma probe é atualizada só pelo core que a executa - não usar em código
+// que roda nos dois cores (ex.: scheduler.c). Leitores (HTTP, USB) podem ver
+// um registro pela metade, aceitável para estatística.
+// Resultados: GET /api/prof (JSON), POST /api/prof zera, 'p' no USB serial.
+
+#ifndef IBAG_PROF_ENABLED
+#define IBAG_PROF_ENABLED 1
+#endif
+
+#define PROF_MAX_PROBES 32
+#define PROF_HIST_BUCKETS 24           // Faixa k: [2^k, 2^(k+1)) ciclos; a última acumula o resto
+
+typedef struct {
+    const char *name;
+    uint8_t core;
+    _Atomic uint8_t registered;
+    bool reset_pending;                // Pedido pelo leitor, aplicado pelo dono da probe
+    uint32_t count;
+    uint32_t min_cycles;
+    uint32_t max_cycles;
+    uint64_t total_cycles;
+    uint32_t hist[PROF_HIST_BUCKETS];
+} prof_probe_t;
+
+typedef struct {
+    prof_probe_t *probe;
+    uint32_t start;
+} prof_scope_t;
+
+// Registradores do DWT (Cortex-M33, um por core) e CPUID do SIO
+#define PROF_DWT_CYCCNT (*(volatile uint32_t *)0xE0001004u)
+#define PROF_SIO_CPUID (*(volatile uint32_t *)0xD0000000u)
+
+// Última probe iniciada em cada core (diagnóstico do watchdog, supervisor.h)
+extern const char *volatile prof_last_probe[2];
+
+static inline uint32_t prof_cycles(void) {
+    return PROF_DWT_CYCCNT;
+}
+
+static inline prof_scope_t prof_scope_begin(prof_probe_t *probe) {
+    prof_last_probe[PROF_SIO_CPUID & 1] = probe->name;
+    return (prof_scope_t){ probe, prof_cycles() };
+}
+
+#if IBAG_PROF_ENABLED
+
+#define PROF_CAT(a, b) PROF_CAT_(a, b)
+#define PROF_CAT_(a, b) a##b
+
+#define PROF_SCOPE(probe_name) \
+    static prof_probe_t PROF_CAT(prof_probe_, __LINE__) = { .name = probe_name, .min_cycles = UINT32_MAX }; \
+    prof_scope_t PROF_CAT(prof_scope_, __LINE__) __attribute__((cleanup(prof_scope_end), unused)) = \
+        prof_scope_begin(&PROF_CAT(prof_probe_, __LINE__))
+
+#else
+
+#define PROF_SCOPE(probe_name) do { } while (0)
+
+#endif
+
+// Funções públicas
+void prof_core_init(void);                                      // Ligar o CYCCNT (em cada core)
+void prof_record(prof_probe_t *probe, uint32_t cycles);         // Core que executa a probe
+void prof_reset(void);                                          // Qualquer core
+int prof_probe_count(void);
+const prof_probe_t *prof_get_probe(int index);                  // NULL se ainda não registrada
+size_t prof_render(uint32_t *cursor, char *out, size_t out_len); // JSON em partes, 0 = terminou
+void prof_dump(void);                                           // Tabela no stdio (USB/UART)
+
+static inline void prof_scope_end(prof_scope_t *scope) {
+    prof_record(scope->probe, prof_cycles() - scope->start);
+}
+
+#endif // PROF_H
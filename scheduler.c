@@ -0,0 +1,138 @@
+#include "scheduler.h"
+#include <string.h>
+#include "pico/stdlib.h"
+#include "supervisor.h"
+#include "hal.h"
+#include "logger.h"
+
+void sched_init(scheduler_t *sched) {
+    memset(sched, 0, sizeof(*sched));
+}
+
+// Prazo de check-in no watchdog: um período perdido ainda é tolerado
+static uint32_t watch_deadline_ms(uint32_t period_us) {
+    return 2 * (period_us / 1000) + SUPERVISOR_GRACE_MS;
+}
+
+// Registrar tarefa. phase_us desloca o primeiro deadline para espalhar
+// tarefas de mesmo período. Retorna o id da tarefa ou -1.
+int sched_add(scheduler_t *sched, const char *name, sched_fn_t fn, void *ctx,
+              uint32_t period_us, uint32_t budget_us, uint32_t phase_us) {
+    if (sched->count >= SCHED_MAX_TASKS || period_us == 0) {
+        LOG_E(LOG_MOD_MAIN, "Falha ao registrar tarefa %s", name);
+        return -1;
+    }
+
+    int id = sched->count++;
+    sched_task_t *task = &sched->tasks[id];
+    memset(task, 0, sizeof(*task));
+    task->name = name;
+    task->fn = fn;
+    task->ctx = ctx;
+    task->period_us = period_us;
+    task->budget_us = budget_us;
+    task->next_deadline_us = hal_time_us64() + phase_us;
+    task->watch_id = supervisor_register(name, watch_deadline_ms(period_us));
+    return id;
+}
+
+// Alterar período; o novo vale a partir do próximo deadline
+void sched_set_period(scheduler_t *sched, int task_id, uint32_t period_us) {
+    if (task_id < 0 || task_id >= sched->count || period_us == 0) {
+        return;
+    }
+    sched_task_t *task = &sched->tasks[task_id];
+    if (task->period_us == period_us) {
+        return;
+    }
+    // Encurtar o período não deve esperar o deadline antigo (mais distante)
+    uint64_t now = hal_time_us64();
+    if (task->next_deadline_us > now + period_us) {
+        task->next_deadline_us = now + period_us;
+    }
+    task->period_us = period_us;
+    supervisor_set_deadline(task->watch_id, watch_deadline_ms(period_us));
+}
+
+static void sched_run_task(sched_task_t *task, uint64_t now) {
+    uint32_t jitter = (uint32_t)(now - task->next_deadline_us);
+
+    supervisor_begin(task->watch_id);
+    task->fn(task->ctx);
+    supervisor_checkin(task->watch_id);
+
+    uint64_t end = hal_time_us64();
+    uint32_t exec = (uint32_t)(end - now);
+
+    task->runs++;
+    task->last_jitter_us = jitter;
+    task->sum_jitter_us += jitter;
+    if (jitter > task->max_jitter_us) task->max_jitter_us = jitter;
+    task->last_exec_us = exec;
+    if (exec > task->max_exec_us) task->max_exec_us = exec;
+    if (task->budget_us && exec > task->budget_us) task->overruns++;
+
+    // Próximo deadline absoluto: sem deriva. Se ficou mais de um período
+    // para trás, pula os deadlines perdidos em vez de executar em rajada.
+    task->next_deadline_us += task->period_us;
+    while (task->next_deadline_us <= end) {
+        task->next_deadline_us += task->period_us;
+        task->missed++;
+    }
+}
+
+// Executar cada tarefa vencida uma vez, do deadline mais antigo ao mais novo.
+// Retorna quantas tarefas rodaram.
+int sched_run(scheduler_t *sched) {
+    bool ran[SCHED_MAX_TASKS] = {false};
+    int count = 0;
+
+    while (true) {
+        uint64_t now = hal_time_us64();
+        int earliest = -1;
+        for (int i = 0; i < sched->count; i++) {
+            const sched_task_t *task = &sched->tasks[i];
+            if (ran[i] || task->next_deadline_us > now) continue;
+            if (earliest < 0 || task->next_deadline_us < sched->tasks[earliest].next_deadline_us) {
+                earliest = i;
+            }
+        }
+        if (earliest < 0) {
+            return count;
+        }
+        ran[earliest] = true;
+        count++;
+        sched_run_task(&sched->tasks[earliest], now);
+    }
+}
+
+uint64_t sched_next_deadline(const scheduler_t *sched) {
+    uint64_t next = UINT64_MAX;
+    for (int i = 0; i < sched->count; i++) {
+        if (sched->tasks[i].next_deadline_us < next) {
+            next = sched->tasks[i].next_deadline_us;
+        }
+    }
+    return next;
+}
+
+const sched_task_t *sched_get_task(const scheduler_t *sched, int task_id) {
+    if (task_id < 0 || task_id >= sched->count) {
+        return NULL;
+    }
+    return &sched->tasks[task_id];
+}
+
+void sched_reset_stats(scheduler_t *sched) {
+    for (int i = 0; i < sched->count; i++) {
+        sched_task_t *task = &sched->tasks[i];
+        task->runs = 0;
+        task->overruns = 0;
+        task->missed = 0;
+        task->last_jitter_us = 0;
+        task->max_jitter_us = 0;
+        task->sum_jitter_us = 0;
+        task->last_exec_us = 0;
+        task->max_exec_us = 0;
+    }
+}
@@ -0,0 +1,55 @@
+#ifndef SCHEDULER_H
+#define SCHEDULER_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// Escalonador cooperativo por deadlines absolutos
+// Cada tarefa tem período e orçamento (budget). O próximo deadline é sempre
+// o anterior + período, então o tempo gasto em printf ou chamadas bloqueantes
+// atrasa uma execução mas não acumula deriva. As tarefas rodam no contexto de
+// quem chama sched_run(); no core 0 a pilha lwIP roda na IRQ do cyw43, então
+// tarefas que usam lwIP precisam de cyw43_arch_lwip_begin()/end().
+// Toda tarefa é vigiada pelo watchdog (supervisor.h): cada execução faz
+// check-in, com prazo de dois períodos mais SUPERVISOR_GRACE_MS.
+
+#define SCHED_MAX_TASKS 12   // Por core; o core 0 já usa 8
+
+typedef void (*sched_fn_t)(void *ctx);
+
+typedef struct {
+    const char *name;
+    sched_fn_t fn;
+    void *ctx;
+    uint32_t period_us;
+    uint32_t budget_us;        // Tempo máximo de execução esperado
+    uint64_t next_deadline_us; // Deadline absoluto (time_us_64)
+    int watch_id;              // Registro no supervisor (watchdog)
+
+    // Estatísticas
+    uint32_t runs;
+    uint32_t overruns;         // Execuções que passaram do budget
+    uint32_t missed;           // Períodos inteiros perdidos (deadline pulado)
+    uint32_t last_jitter_us;   // Atraso do início em relação ao deadline
+    uint32_t max_jitter_us;
+    uint64_t sum_jitter_us;
+    uint32_t last_exec_us;
+    uint32_t max_exec_us;
+} sched_task_t;
+
+typedef struct {
+    sched_task_t tasks[SCHED_MAX_TASKS];
+    uint8_t count;
+} scheduler_t;
+
+// Funções públicas
+void sched_init(scheduler_t *sched);
+int sched_add(scheduler_t *sched, const char *name, sched_fn_t fn, void *ctx,
+              uint32_t period_us, uint32_t budget_us, uint32_t phase_us);
+void sched_set_period(scheduler_t *sched, int task_id, uint32_t period_us);
+int sched_run(scheduler_t *sched);                   // Executar tarefas vencidas (EDF)
+uint64_t sched_next_deadline(const scheduler_t *sched);
+const sched_task_t *sched_get_task(const scheduler_t *sched, int task_id);
+void sched_reset_stats(scheduler_t *sched);
+
+#endif // SCHEDULER_H
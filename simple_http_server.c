@@ -2,113 +2,637 @@
 #include <string.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <errno.h>
 #include "pico/stdlib.h"
 #include "lwip/tcp.h"
+#include "hardware/flash.h"
+#include "autotune.h"
+#include "control.h"
+#include "scheduler.h"
+#include "ipc.h"
+#include "mpu6050.h"
+#include "config_store.h"
+#include "power.h"
+#include "kv_store.h"
+#include "boot.h"
+#include "captive_portal.h"
+#include "mdns_responder.h"
+#include "logger.h"
+#include "metrics.h"
+#include "prof.h"
+#include "supervisor.h"
+#include "history.h"
+#include "history_query.h"
+#include "hal.h"
+#include "json_writer.h"
+#include "json_tok.h"
+#include "config_json.h"
+#include "api_json.h"
+#include "cbor_writer.h"
+#include "api_cbor.h"
 
 extern const char html_content[];
-extern float target_heater_temp;
-extern float target_conservative_temp;
-extern bool is_shaken;
+extern scheduler_t main_scheduler;
 
-// Definições dos ADC channels
-#define ADC_HEATER 1    // ADC1 - GPIO 27 (aquecedor)
-#define ADC_CONSERVATIVE 0   // ADC0 - GPIO 26 (conservador)
+// Sensores e relés rodam no core 1: leituras vêm do snapshot e ações
+// viram comandos na fila (ipc.h)
 
-// Funções auxiliares (declaradas em iBagPico2W.c e mpu6050.c)
-extern float read_lm35_temp(uint8_t adc_channel);
-extern bool mpu6050_detect_shake(void);
-extern void mpu6050_reset_shake_detection(void);
-extern void mpu6050_update_calibration(void);
+// Extrair valor de um parâmetro da query string (?chave=valor&...)
+static bool query_get(const char *query, const char *key, char *out, size_t out_len) {
+    size_t key_len = strlen(key);
+    const char *p = query;
+    while (p && *p) {
+        if (strncmp(p, key, key_len) == 0 && p[key_len] == '=') {
+            p += key_len + 1;
+            size_t n = 0;
+            while (p[n] && p[n] != '&' && n < out_len - 1) {
+                out[n] = p[n];
+                n++;
+            }
+            out[n] = '\0';
+            return true;
+        }
+        p = strchr(p, '&');
+        if (p) p++;
+    }
+    return false;
+}
+
+// Inteiro decimal da query em [min, max]; false se ausente
+// Vazio, com sobra depois dos dígitos, truncado por query_get ou fora da
+// faixa marca *invalid
+static bool query_get_long(const char *query, const char *key, long min, long max, long *out, bool *invalid) {
+    char value[16];
+    if (!query || !query_get(query, key, value, sizeof(value))) {
+        return false;
+    }
+    char *end;
+    errno = 0;
+    long v = strtol(value, &end, 10);
+    if (end == value || *end != '\0' || strlen(value) == sizeof(value) - 1 ||
+        errno == ERANGE || v < min || v > max) {
+        *invalid = true;
+        return false;
+    }
+    *out = v;
+    return true;
+}
+
+// Número decimal da query (mesma sintaxe de um número JSON); false se
+// ausente. Vazio, com sobra, truncado ou fora da faixa do float marca *invalid
+static bool query_get_float(const char *query, const char *key, float *out, bool *invalid) {
+    char value[16];
+    if (!query || !query_get(query, key, value, sizeof(value))) {
+        return false;
+    }
+    size_t n = strlen(value);
+    if (n == sizeof(value) - 1 || !json_number_to_float(value, n, out)) {
+        *invalid = true;
+        return false;
+    }
+    return true;
+}
+
+// Estatísticas de uma tarefa do escalonador; jitter_avg (calculado) sai
+// entre as duas tabelas para manter a ordem das chaves
+static const json_field_t task_fields[] = {
+    JSON_FIELD(sched_task_t, period_us, "period", JSON_FIELD_UINT, 0),
+    JSON_FIELD(sched_task_t, budget_us, "budget", JSON_FIELD_UINT, 0),
+    JSON_FIELD(sched_task_t, runs, "runs", JSON_FIELD_UINT, 0),
+    JSON_FIELD(sched_task_t, overruns, "overruns", JSON_FIELD_UINT, 0),
+    JSON_FIELD(sched_task_t, missed, "missed", JSON_FIELD_UINT, 0),
+};
+
+static const json_field_t task_exec_fields[] = {
+    JSON_FIELD(sched_task_t, max_jitter_us, "jitter_max", JSON_FIELD_UINT, 0),
+    JSON_FIELD(sched_task_t, last_exec_us, "exec_last", JSON_FIELD_UINT, 0),
+    JSON_FIELD(sched_task_t, max_exec_us, "exec_max", JSON_FIELD_UINT, 0),
+};
+
+#define COUNT(a) (sizeof(a) / sizeof((a)[0]))
+
+static void task_json(json_writer_t *w, const sched_task_t *task, int core) {
+    json_obj_begin(w);
+    json_key(w, "core");
+    json_uint(w, (uint32_t)core);
+    json_key(w, "name");
+    json_str(w, task->name);
+    json_write_fields(w, task_fields, COUNT(task_fields), task);
+    json_key(w, "jitter_avg");
+    json_uint(w, task->runs ? (uint32_t)(task->sum_jitter_us / task->runs) : 0);
+    json_write_fields(w, task_exec_fields, COUNT(task_exec_fields), task);
+    json_obj_end(w);
+}
+
+// Tarefa vigiada pelo supervisor (GET /api/watchdog)
+static const json_field_t watchdog_task_fields[] = {
+    JSON_FIELD(supervisor_task_t, name, "name", JSON_FIELD_STR, 0),
+    JSON_FIELD(supervisor_task_t, core, "core", JSON_FIELD_UINT, 0),
+    JSON_FIELD(supervisor_task_t, deadline_ms, "deadline_ms", JSON_FIELD_UINT, 0),
+    JSON_FIELD(supervisor_task_t, max_gap_ms, "max_gap_ms", JSON_FIELD_UINT, 0),
+    JSON_FIELD(supervisor_task_t, max_run_ms, "max_run_ms", JSON_FIELD_UINT, 0),
+};
+
+// Portal cativo e mDNS (GET /api/captive)
+static const json_field_t captive_fields[] = {
+    JSON_FIELD(captive_stats_t, dns_queries, "dns_queries", JSON_FIELD_UINT, 0),
+    JSON_FIELD(captive_stats_t, dns_answers, "dns_answers", JSON_FIELD_UINT, 0),
+    JSON_FIELD(captive_stats_t, dns_dropped, "dns_dropped", JSON_FIELD_UINT, 0),
+    JSON_FIELD(captive_stats_t, redirects, "redirects", JSON_FIELD_UINT, 0),
+    JSON_FIELD(captive_stats_t, joins, "joins", JSON_FIELD_UINT, 0),
+};
+
+static const json_field_t captive_join_fields[] = {
+    JSON_FIELD(captive_stats_t, last_join_ms, "last", JSON_FIELD_UINT, 0),
+    JSON_FIELD(captive_stats_t, min_join_ms, "min", JSON_FIELD_UINT, 0),
+    JSON_FIELD(captive_stats_t, max_join_ms, "max", JSON_FIELD_UINT, 0),
+};
+
+static const json_field_t mdns_fields[] = {
+    JSON_FIELD(mdns_stats_t, queries, "queries", JSON_FIELD_UINT, 0),
+    JSON_FIELD(mdns_stats_t, responses, "responses", JSON_FIELD_UINT, 0),
+    JSON_FIELD(mdns_stats_t, suppressed, "suppressed", JSON_FIELD_UINT, 0),
+    JSON_FIELD(mdns_stats_t, announcements, "announcements", JSON_FIELD_UINT, 0),
+};
+
+// Log na flash (GET /api/storage); size (constante) sai entre as duas tabelas
+static const json_field_t storage_fields[] = {
+    JSON_FIELD(kv_stats_t, active_sector, "sector", JSON_FIELD_INT, 0),
+    JSON_FIELD(kv_stats_t, generation, "generation", JSON_FIELD_UINT, 0),
+    JSON_FIELD(kv_stats_t, used_bytes, "used", JSON_FIELD_UINT, 0),
+};
+
+static const json_field_t storage_op_fields[] = {
+    JSON_FIELD(kv_stats_t, appends, "appends", JSON_FIELD_UINT, 0),
+    JSON_FIELD(kv_stats_t, compactions, "compactions", JSON_FIELD_UINT, 0),
+    JSON_FIELD(kv_stats_t, erases, "erases", JSON_FIELD_UINT, 0),
+    JSON_FIELD(kv_stats_t, failures, "failures", JSON_FIELD_UINT, 0),
+    JSON_FIELD(kv_stats_t, last_op_us, "op_last_us", JSON_FIELD_UINT, 0),
+    JSON_FIELD(kv_stats_t, max_op_us, "op_max_us", JSON_FIELD_UINT, 0),
+    JSON_FIELD(kv_stats_t, pending, "pending", JSON_FIELD_BOOL, 0),
+};
+
+// Gerador de corpo em partes: escreve até out_len bytes, 0 = terminou
+typedef size_t (*http_stream_fn)(uint32_t *cursor, char *out, size_t out_len);
+
+// Respostas curtas são montadas num buffer único e copiadas pelo tcp_write
+// (os callbacks do lwIP não se sobrepõem). Corpos longos não passam por ele:
+// a página sai direto da flash, sem cópia, e os geradores usam um bloco do
+// pool por conexão. A RAM de envio fica limitada ao número de conexões.
+#define HTTP_RESPONSE_MAX 4096
+#define HTTP_TX_BLOCK_SIZE 1024
+#define HTTP_TX_BLOCKS 4
+
+static char tx_blocks[HTTP_TX_BLOCKS][HTTP_TX_BLOCK_SIZE];
+static uint8_t tx_blocks_used;   // Bit por bloco
+
+static char *tx_block_acquire(void) {
+    for (int i = 0; i < HTTP_TX_BLOCKS; i++) {
+        if (!(tx_blocks_used & (1u << i))) {
+            tx_blocks_used |= 1u << i;
+            return tx_blocks[i];
+        }
+    }
+    return NULL;
+}
+
+static void tx_block_release(char *block) {
+    if (block != NULL) {
+        tx_blocks_used &= ~(1u << ((block - tx_blocks[0]) / HTTP_TX_BLOCK_SIZE));
+    }
+}
+
+static char response[HTTP_RESPONSE_MAX];
+
+// Respostas JSON/CBOR: o corpo é escrito direto no buffer de resposta, depois
+// do espaço reservado ao cabeçalho; o cabeçalho (que depende do tamanho) é
+// montado por último e encostado no corpo, sem cópia do corpo
+#define HTTP_HEADER_ROOM 160
+
+static int body_end(size_t body_len, bool ok, const char *status, const char *mime,
+                    const char *extra, const char **out) {
+    if (!ok) {
+        LOG_E(LOG_MOD_HTTP, "Resposta maior que o buffer");
+        status = "500 Internal Server Error";
+        body_len = 0;
+    }
+    static char header[HTTP_HEADER_ROOM];
+    int header_len = snprintf(header, sizeof(header),
+        "HTTP/1.1 %s\r\n"
+        "Content-Type: %s\r\n"
+        "Content-Length: %u\r\n"
+        "%s"
+        "Connection: close\r\n"
+        "\r\n", status, mime, (unsigned)body_len, extra);
+    char *start = response + HTTP_HEADER_ROOM - header_len;
+    memcpy(start, header, header_len);
+    *out = start;
+    return header_len + (int)body_len;
+}
+
+static void json_body_begin(json_writer_t *w) {
+    json_writer_init(w, response + HTTP_HEADER_ROOM, sizeof(response) - HTTP_HEADER_ROOM);
+}
+
+static int json_body_end(const json_writer_t *w, const char *status, const char **out) {
+    return body_end(json_writer_len(w), json_writer_ok(w), status, "application/json", "", out);
+}
+
+// {"status":...} das ações, com "message" opcional
+static int status_body(const char *http_status, const char *status, const char *message, const char **out) {
+    json_writer_t w;
+    json_body_begin(&w);
+    json_obj_begin(&w);
+    json_key(&w, "status");
+    json_str(&w, status);
+    if (message != NULL) {
+        json_key(&w, "message");
+        json_str(&w, message);
+    }
+    json_obj_end(&w);
+    return json_body_end(&w, http_status, out);
+}
+
+static void cbor_body_begin(cbor_writer_t *w) {
+    cbor_writer_init(w, response + HTTP_HEADER_ROOM, sizeof(response) - HTTP_HEADER_ROOM);
+}
+
+#define CBOR_STR_(x) #x
+#define CBOR_STR(x) CBOR_STR_(x)
+#define CBOR_HEADERS "Vary: Accept\r\nX-Schema-Version: " CBOR_STR(CBOR_SCHEMA_VERSION) "\r\n"
+
+static int cbor_body_end(const cbor_writer_t *w, const char *status, const char **out) {
+    return body_end(cbor_writer_len(w), cbor_writer_ok(w), status, "application/cbor", CBOR_HEADERS, out);
+}
+
+// Variante CBOR pedida por ?format=cbor ou pelo Accept (application/cbor e
+// application/cbor-seq; sem pesos - aparecer na lista basta)
+static bool http_wants_cbor(const char *request, const char *query) {
+    char value[8];
+    if (query && query_get(query, "format", value, sizeof(value))) {
+        return strcmp(value, "cbor") == 0;
+    }
+    const char *headers_end = strstr(request, "\r\n\r\n");
+    static const char *const names[] = { "\r\nAccept:", "\r\naccept:" };
+    for (int i = 0; i < 2; i++) {
+        const char *h = strstr(request, names[i]);
+        if (h == NULL || (headers_end && h > headers_end)) continue;
+        const char *line_end = strstr(h + 2, "\r\n");
+        const char *cbor = strstr(h, "application/cbor");
+        return cbor != NULL && (line_end == NULL || cbor < line_end);
+    }
+    return false;
+}
+
+// POST /api/config: o corpo pode vir em vários segmentos (Content-Length);
+// cada pbuf vai direto para o tokenizador e a resposta sai no último
+#define CONFIG_BODY_MAX 1024
+#define CONFIG_BODY_TIMEOUT_POLLS 10   // ~5 s sem o resto do corpo
+
+struct config_upload {
+    config_json_t parser;
+    uint32_t remaining;    // Bytes do corpo ainda por vir
+    uint8_t idle_polls;
+};
+
+// Content-Length do cabeçalho (até header_end); false se ausente
+static bool http_content_length(const struct pbuf *p, u16_t header_end, uint32_t *out) {
+    static const char *const names[] = { "\r\nContent-Length:", "\r\ncontent-length:" };
+    for (int i = 0; i < 2; i++) {
+        u16_t name_len = (u16_t)strlen(names[i]);
+        u16_t pos = pbuf_memfind(p, names[i], name_len, 0);
+        if (pos == 0xFFFF || pos >= header_end) {
+            continue;
+        }
+        pos += name_len;
+        while (pos < header_end && pbuf_get_at(p, pos) == ' ') {
+            pos++;
+        }
+        uint32_t value = 0;
+        bool any = false;
+        for (; pos < header_end; pos++) {
+            u8_t c = pbuf_get_at(p, pos);
+            if (c < '0' || c > '9' || value > CONFIG_BODY_MAX) {
+                break;
+            }
+            value = value * 10 + (c - '0');
+            any = true;
+        }
+        if (any) {
+            *out = value;
+            return true;
+        }
+    }
+    return false;
+}
+
+// Passar ao tokenizador o que houver do corpo a partir de 'offset'
+static void config_upload_feed(struct config_upload *up, const struct pbuf *p, u16_t offset) {
+    for (const struct pbuf *q = p; q != NULL && up->remaining > 0; q = q->next) {
+        if (offset >= q->len) {
+            offset -= q->len;
+            continue;
+        }
+        uint32_t n = q->len - offset;
+        if (n > up->remaining) {
+            n = up->remaining;
+        }
+        up->remaining -= n;
+        if (config_json_feed(&up->parser, (const char *)q->payload + offset, n) != JSON_OK) {
+            return;   // Erro já decidido: não precisa do resto
+        }
+        offset = 0;
+    }
+}
+
+static bool config_upload_done(const struct config_upload *up) {
+    return up->remaining == 0 || up->parser.tok.err != JSON_OK;
+}
+
+// Aplicar o corpo (NULL = sem corpo: só devolve a configuração atual)
+// Corpo malformado não muda nada: 400 com o erro e a posição do byte
+static int config_respond(config_json_t *parser, const char **out) {
+    ibag_config_t applied;
+    config_result_t result = CONFIG_OK;
+    json_err_t err = parser != NULL ? config_json_end(parser) : JSON_OK;
+    if (parser == NULL) {
+        config_store_read(&applied);
+    } else if (err != JSON_OK) {
+        result = CONFIG_INVALID;
+        config_store_read(&applied);
+        LOG_W(LOG_MOD_HTTP, "Configuração recusada: %s no byte %lu", json_err_name(err),
+              (unsigned long)config_json_error_offset(parser));
+    } else {
+        result = config_store_update(&parser->proposed, &applied);
+        if (result == CONFIG_INVALID) {
+            config_store_read(&applied);
+        }
+        LOG_I(LOG_MOD_HTTP, "Configuração %s (v%lu): Quente=%.1f°C, Frio=%.1f°C",
+              config_result_name(result), (unsigned long)applied.version,
+              applied.heater_target, applied.conservative_target);
+    }
+
+    json_writer_t w;
+    json_body_begin(&w);
+    json_obj_begin(&w);
+    json_key(&w, "status");
+    json_str(&w, result == CONFIG_INVALID ? "error" : "ok");
+    json_key(&w, "result");
+    json_str(&w, config_result_name(result));
+    if (err != JSON_OK) {
+        json_key(&w, "error");
+        json_str(&w, json_err_name(err));
+        json_key(&w, "offset");
+        json_uint(&w, config_json_error_offset(parser));
+    }
+    json_write_fields(&w, config_json_fields, config_json_field_count, &applied);
+    json_obj_end(&w);
+    return json_body_end(&w, result == CONFIG_INVALID ? "400 Bad Request" : "200 OK", out);
+}
+
+// Consultas ao histórico em andamento; o cursor do gerador é o índice
+#define HTTP_HISTORY_QUERIES 2
+
+static history_query_t history_queries[HTTP_HISTORY_QUERIES];
+static uint8_t history_queries_used;
+
+static int history_query_acquire(void) {
+    for (int i = 0; i < HTTP_HISTORY_QUERIES; i++) {
+        if (!(history_queries_used & (1u << i))) {
+            history_queries_used |= 1u << i;
+            return i;
+        }
+    }
+    return -1;
+}
+
+static size_t history_stream(uint32_t *cursor, char *out, size_t out_len) {
+    return history_query_render(&history_queries[*cursor], out, out_len);
+}
 
 // Estrutura para rastrear estado da conexão
 struct http_state {
     int total_sent;
     int total_length;
+    // Corpo constante na flash, enfileirado sem cópia (NULL = nenhum)
+    const char *body;
+    int body_len;
+    int body_queued;
+    // Corpo gerado sob demanda (NULL = resposta inteira já enfileirada)
+    http_stream_fn stream;
+    uint32_t cursor;
+    bool stream_done;
+    bool chunked;        // Transfer-Encoding: chunked (cada parte vira um chunk)
+    char *tx;            // Bloco do pool; guarda a parte que o lwIP ainda não aceitou
+    uint16_t tx_len;
+    // Corpo do POST ainda chegando (NULL = requisição completa)
+    struct config_upload *upload;
 };
 
+static void http_state_free(struct http_state *hs) {
+    if (hs != NULL) {
+        tx_block_release(hs->tx);
+        free(hs->upload);
+        if (hs->stream == history_stream) {
+            history_queries_used &= ~(1u << hs->cursor);
+        }
+        if (hs->stream == metrics_render) {
+            metrics_render_end(hs->cursor);
+        }
+        free(hs);
+    }
+}
+
+static bool http_body_done(const struct http_state *hs) {
+    return hs->body_queued >= hs->body_len && (hs->stream == NULL || (hs->stream_done && hs->tx_len == 0));
+}
+
+// Enfileirar o corpo enquanto couber no buffer de envio do TCP; o resto sai
+// nos próximos ACKs (http_sent) ou no poll, se o heap do lwIP estiver cheio
+static void http_body_fill(struct tcp_pcb *pcb, struct http_state *hs) {
+    if (hs->body_queued < hs->body_len) {
+        int n = hs->body_len - hs->body_queued;
+        if (n > tcp_sndbuf(pcb)) {
+            n = tcp_sndbuf(pcb);
+        }
+        if (n > 0 && tcp_write(pcb, hs->body + hs->body_queued, n, 0) == ERR_OK) {
+            hs->body_queued += n;
+        }
+    }
+    while (hs->stream != NULL && hs->body_queued >= hs->body_len) {
+        if (hs->tx_len == 0) {
+            if (hs->stream_done) {
+                break;
+            }
+            if (hs->chunked) {
+                // "xxx\r\n" + parte + "\r\n"; o chunk vazio encerra o corpo
+                size_t n = hs->stream(&hs->cursor, hs->tx + 5, HTTP_TX_BLOCK_SIZE - 7);
+                char size[8];
+                snprintf(size, sizeof(size), "%03x\r\n", (unsigned)n);
+                if (n == 0) {
+                    memcpy(hs->tx, "0\r\n\r\n", 5);
+                    hs->tx_len = 5;
+                    hs->stream_done = true;
+                } else {
+                    memcpy(hs->tx, size, 5);
+                    memcpy(hs->tx + 5 + n, "\r\n", 2);
+                    hs->tx_len = n + 7;
+                }
+            } else {
+                size_t n = hs->stream(&hs->cursor, hs->tx, HTTP_TX_BLOCK_SIZE);
+                if (n == 0) {
+                    hs->stream_done = true;
+                    break;
+                }
+                hs->tx_len = n;
+            }
+        }
+        if (tcp_sndbuf(pcb) < hs->tx_len) {
+            break;
+        }
+        err_t write_err = tcp_write(pcb, hs->tx, hs->tx_len, TCP_WRITE_FLAG_COPY);
+        if (write_err == ERR_MEM) {
+            break;   // A parte continua no bloco
+        }
+        if (write_err != ERR_OK) {
+            LOG_E(LOG_MOD_HTTP, "Erro ao enviar parte gerada: %d", write_err);
+            hs->stream_done = true;
+            hs->tx_len = 0;
+            break;
+        }
+        hs->total_length += hs->tx_len;
+        hs->tx_len = 0;
+    }
+    tcp_output(pcb);
+}
+
+static void http_finish(struct tcp_pcb *pcb, struct http_state *hs) {
+    tcp_arg(pcb, NULL);
+    tcp_poll(pcb, NULL, 0);
+    http_state_free(hs);
+    tcp_close(pcb);
+}
+
 static err_t http_sent(void *arg, struct tcp_pcb *pcb, u16_t len) {
+    PROF_SCOPE("http_sent");
     struct http_state *hs = (struct http_state *)arg;
     
     if (hs != NULL) {
         // Somar ACKs recebidos ao total
         hs->total_sent += len;
         
-        printf("HTTP: ACK recebido - %d bytes confirmados (total: %d/%d)\n", 
-               len, hs->total_sent, hs->total_length);
+        LOG_D(LOG_MOD_HTTP, "ACK %d bytes (total: %d/%d)", len, hs->total_sent, hs->total_length);
         
-        // Fechar apenas quando tudo foi enviado E confirmado
-        if (hs->total_sent >= hs->total_length) {
-            printf("HTTP: Transferência completa! Fechando conexão.\n");
-            tcp_arg(pcb, NULL);
-            free(hs);
-            tcp_close(pcb);
+        if (!http_body_done(hs)) {
+            http_body_fill(pcb, hs);
+        }
+        
+        // Fechar apenas quando tudo foi gerado, enviado E confirmado
+        if (http_body_done(hs) && hs->total_sent >= hs->total_length) {
+            LOG_D(LOG_MOD_HTTP, "Transferência completa, fechando conexão");
+            http_finish(pcb, hs);
         }
     } else {
-        printf("HTTP: Dados enviados (%d bytes), fechando.\n", len);
+        LOG_D(LOG_MOD_HTTP, "Dados enviados (%d bytes), fechando", len);
         tcp_close(pcb);
     }
     
     return ERR_OK;
 }
 
+// Sem ACK pendente, só o poll retoma um envio que parou por falta de heap
+static err_t http_poll(void *arg, struct tcp_pcb *pcb) {
+    struct http_state *hs = (struct http_state *)arg;
+    if (hs != NULL && hs->upload != NULL) {
+        if (++hs->upload->idle_polls >= CONFIG_BODY_TIMEOUT_POLLS) {
+            LOG_W(LOG_MOD_HTTP, "Corpo do POST incompleto, faltam %lu bytes", (unsigned long)hs->upload->remaining);
+            http_finish(pcb, hs);
+        }
+        return ERR_OK;
+    }
+    if (hs != NULL && !http_body_done(hs)) {
+        http_body_fill(pcb, hs);
+    }
+    return ERR_OK;
+}
+
+// Conexão abortada (RST, falta de memória): o pcb já foi liberado pelo lwIP
+static void http_err(void *arg, err_t err) {
+    LOG_D(LOG_MOD_HTTP, "Conexão abortada: %d", err);
+    http_state_free((struct http_state *)arg);
+}
+
+// Tempo para tratar uma requisição (parse + montagem da resposta + tcp_write)
+static uint32_t http_last_us;
+static uint32_t http_max_us;
+
+// Resto do corpo do POST /api/config chegando em outro segmento
+static void http_upload_recv(struct tcp_pcb *pcb, struct http_state *hs, struct pbuf *p) {
+    hs->upload->idle_polls = 0;
+    config_upload_feed(hs->upload, p, 0);
+    if (!config_upload_done(hs->upload)) {
+        return;
+    }
+    const char *out;
+    int len = config_respond(&hs->upload->parser, &out);
+    free(hs->upload);
+    hs->upload = NULL;
+    hs->total_length = len;
+    err_t write_err = tcp_write(pcb, out, len, TCP_WRITE_FLAG_COPY);
+    if (write_err == ERR_OK) {
+        tcp_output(pcb);
+    } else {
+        LOG_E(LOG_MOD_HTTP, "Erro ao enviar resposta: %d", write_err);
+        http_finish(pcb, hs);
+    }
+}
+
 static err_t http_recv(void *arg, struct tcp_pcb *pcb, struct pbuf *p, err_t err) {
+    PROF_SCOPE("http_recv");
     if (p == NULL) {
-        tcp_close(pcb);
+        // Cliente fechou: o que já foi enfileirado ainda sai
+        if (arg != NULL) {
+            http_finish(pcb, (struct http_state *)arg);
+        } else {
+            tcp_close(pcb);
+        }
         return ERR_OK;
     }
+    uint32_t start_us = hal_time_us();
+    int route = METRICS_ROUTE_OTHER;
+    http_stream_fn stream = NULL;   // Corpo gerado em partes após o cabeçalho
+    int history_slot = -1;          // Consulta ao histórico usada pelo gerador
+    uint32_t metrics_cursor = 0;    // Fotografia das métricas usada pelo gerador
+    const char *body = NULL;        // Corpo na flash, enviado após o cabeçalho
+    int body_len = 0;
     
-    printf("\n>>> REQUISIÇÃO HTTP RECEBIDA! <<<\n");
-    printf("Tamanho: %d bytes\n", p->tot_len);
-    
-    // Copiar requisição completa
-    char request[512] = {0};
+    // Copiar requisição completa. Os buffers grandes daqui para baixo são
+    // estáticos: os callbacks do lwIP rodam um por vez, na IRQ do cyw43, com
+    // a pilha de 2 KB do core 0 (tools/mem_report.py --stack mostra o pior caso)
+    static char request[512];
     int copy_len = (p->tot_len < 511) ? p->tot_len : 511;
     pbuf_copy_partial(p, request, copy_len, 0);
     request[copy_len] = '\0';
     
-    printf("Request:\n%s\n", request);
+    // Corpo do POST que não veio no primeiro segmento
+    if (arg != NULL && ((struct http_state *)arg)->upload != NULL) {
+        tcp_recved(pcb, p->tot_len);
+        http_upload_recv(pcb, (struct http_state *)arg, p);
+        pbuf_free(p);
+        return ERR_OK;
+    }
     
-    // DETECTAR SE É APENAS JSON (segundo pacote do POST)
-    if (request[0] == '{' && strstr(request, "\"heater\"") != NULL) {
-        printf("🔧 POST JSON recebido: %s\n", request);
-        
-        // Parse do JSON
-        char *heater_str = strstr(request, "\"heater\":");
-        char *conservative_str = strstr(request, "\"freezer\":");
-        
-        float old_heater = target_heater_temp;
-        float old_conservative = target_conservative_temp;
-        
-        if (heater_str) {
-            heater_str += 9;
-            target_heater_temp = atof(heater_str);
-        }
-        
-        if (conservative_str) {
-            conservative_str += 10;
-            target_conservative_temp = atof(conservative_str);
-        }
-        
-        printf("📊 Temperaturas atualizadas:\n");
-        printf("   Quente: %.1f°C → %.1f°C\n", old_heater, target_heater_temp);
-        printf("   Frio: %.1f°C → %.1f°C\n", old_conservative, target_conservative_temp);
-        
-        // Verificar se relé deve ser habilitado
-        if (target_heater_temp == 25.0f && target_conservative_temp == 24.0f) {
-            printf("🚫 Relé DESABILITADO (valores padrão)\n");
-        } else {
-            printf("✅ Relé HABILITADO (valores customizados)\n");
-        }
-        
-        // Liberar pbuf e não responder (resposta já foi enviada no primeiro pacote)
+    // Resposta já em andamento (Connection: close): ignorar o resto do pedido
+    if (arg != NULL) {
         tcp_recved(pcb, p->tot_len);
         pbuf_free(p);
         return ERR_OK;
     }
     
-    // Preparar resposta HTTP
-    static char response[50000];
+    // Preparar resposta HTTP (respostas JSON começam mais adiante no buffer)
+    const char *out = response;
     int len = 0;
+    struct config_upload *upload = NULL;   // Corpo do POST incompleto
     
     // Detectar método e rota
     bool is_post = (strncmp(request, "POST", 4) == 0);
@@ -121,119 +645,492 @@ static err_t http_recv(void *arg, struct tcp_pcb *pcb, struct pbuf *p, err_t err
         char *uri_end = strchr(uri_start, ' ');
         if (uri_end) {
             int uri_len = uri_end - uri_start;
-            char uri[128] = {0};
+            static char uri[128];
             if (uri_len < 127) {
                 memcpy(uri, uri_start, uri_len);
                 uri[uri_len] = '\0';
-                printf("URI detectada: %s\n", uri);
+                LOG_I(LOG_MOD_HTTP, "%s %s (%d bytes)", is_post ? "POST" : is_get ? "GET" : "?", uri, p->tot_len);
+                
+                // Separar query string (?a=b) do caminho
+                char *query = strchr(uri, '?');
+                if (query) {
+                    *query++ = '\0';
+                }
+                route = metrics_route_id(strcmp(uri, "/index.html") == 0 ? "/" : uri);
                 
                 // Roteamento
                 if (is_get && (strcmp(uri, "/") == 0 || strcmp(uri, "/index.html") == 0)) {
                     // Página principal
-                    int html_len = strlen(html_content);
+                    body = html_content;
+                    body_len = strlen(html_content);
                     len = snprintf(response, sizeof(response),
                         "HTTP/1.1 200 OK\r\n"
                         "Content-Type: text/html; charset=UTF-8\r\n"
                         "Content-Length: %d\r\n"
                         "Connection: close\r\n"
-                        "\r\n"
-                        "%s", html_len, html_content);
-                    printf("Servindo página principal (%d bytes HTML, %d bytes total)\n", html_len, len);
+                        "\r\n", body_len);
+                    boot_mark_first_http();
+                    captive_portal_page_served(&pcb->remote_ip);
                 }
                 else if (is_get && strcmp(uri, "/api/status") == 0) {
-                    // API de status - ler sensores LM35 reais
-                    float current_heater = read_lm35_temp(ADC_HEATER);
-                    float current_conservative = read_lm35_temp(ADC_CONSERVATIVE);
+                    // API de status - temperaturas filtradas de cada zona (snapshot do core 1)
+                    static ipc_snapshot_t snap;
+                    ipc_read_snapshot(&snap);
                     
-                    if (!is_shaken) {
-                        is_shaken = mpu6050_detect_shake();
+                    if (http_wants_cbor(request, query)) {
+                        cbor_writer_t w;
+                        cbor_body_begin(&w);
+                        api_cbor_status(&w, &snap);
+                        len = cbor_body_end(&w, "200 OK", &out);
+                    } else {
+                        json_writer_t w;
+                        json_body_begin(&w);
+                        api_json_status(&w, &snap);
+                        len = json_body_end(&w, "200 OK", &out);
                     }
-                    
-                    char json[256];
-                    int json_len = snprintf(json, sizeof(json),
-                            "{\"heater\":%.1f,\"freezer\":%.1f,\"shaken\":%s}",
-                            current_heater, current_conservative, is_shaken ? "true" : "false");
-                    
-                    len = snprintf(response, sizeof(response),
-                        "HTTP/1.1 200 OK\r\n"
-                        "Content-Type: application/json\r\n"
-                        "Content-Length: %d\r\n"
-                        "Connection: close\r\n"
-                        "\r\n"
-                        "%s", json_len, json);
-                    printf("API Status: %s\n", json);
+                }
+                else if (is_get && strcmp(uri, "/api/schema") == 0) {
+                    // Layout das variantes CBOR (índices, tipos e escalas) para geradores de cliente
+                    json_writer_t w;
+                    json_body_begin(&w);
+                    api_cbor_schema(&w);
+                    len = json_body_end(&w, "200 OK", &out);
                 }
                 else if (is_post && strcmp(uri, "/api/config") == 0) {
-                    // Extrair corpo do POST (JSON está após \r\n\r\n)
-                    char *body = strstr(request, "\r\n\r\n");
-                    if (body) {
-                        body += 4; // pular \r\n\r\n
-                        printf("POST body: %s\n", body);
-                        
-                        // Parse simples do JSON
-                        char *heater_str = strstr(body, "\"heater\":");
-                        char *conservative_str = strstr(body, "\"freezer\":");
-                        
-                        if (heater_str) {
-                            heater_str += 9;
-                            target_heater_temp = atof(heater_str);
-                            printf("Nova temperatura aquecedor: %.1f C\n", target_heater_temp);
+                    // Corpo JSON após \r\n\r\n, possivelmente continuando nos
+                    // próximos segmentos. Sem corpo, apenas devolve a configuração atual
+                    u16_t header_end = pbuf_memfind(p, "\r\n\r\n", 4, 0);
+                    uint32_t body_size = 0;
+                    if (header_end != 0xFFFF) {
+                        header_end += 4;
+                        if (!http_content_length(p, header_end, &body_size)) {
+                            body_size = p->tot_len - header_end;   // Só o que veio junto
                         }
-                        
-                        if (conservative_str) {
-                            conservative_str += 10;
-                            target_conservative_temp = atof(conservative_str);
-                            printf("Nova temperatura conservador: %.1f C\n", target_conservative_temp);
+                    }
+                    
+                    if (body_size > CONFIG_BODY_MAX) {
+                        json_writer_t w;
+                        json_body_begin(&w);
+                        json_obj_begin(&w);
+                        json_key(&w, "status");
+                        json_str(&w, "error");
+                        json_key(&w, "error");
+                        json_str(&w, json_err_name(JSON_ERR_TOO_LONG));
+                        json_obj_end(&w);
+                        len = json_body_end(&w, "413 Payload Too Large", &out);
+                    } else if (body_size == 0) {
+                        len = config_respond(NULL, &out);
+                    } else if ((upload = calloc(1, sizeof(*upload))) != NULL) {
+                        ibag_config_t current;
+                        config_store_read(&current);
+                        config_json_begin(&upload->parser, &current);
+                        upload->remaining = body_size;
+                        config_upload_feed(upload, p, header_end);
+                        if (config_upload_done(upload)) {
+                            len = config_respond(&upload->parser, &out);
+                            free(upload);
+                            upload = NULL;
                         }
                     }
+                }
+                else if (is_post && strcmp(uri, "/api/reset") == 0) {
+                    LOG_I(LOG_MOD_HTTP, "Resetando estado e recalibrando o MPU6050");
+                    
+                    // A calibração roda no core 1; responder já com a duração
+                    // (a interface espera por conta própria, sem travar a IRQ)
+                    ipc_cmd_t cmd = { .type = IPC_CMD_RESET_SHAKE };
+                    bool queued = ipc_send_command(&cmd);
+                    
+                    json_writer_t w;
+                    json_body_begin(&w);
+                    json_obj_begin(&w);
+                    json_key(&w, "status");
+                    json_str(&w, queued ? "ok" : "busy");
+                    json_key(&w, "calibration_ms");
+                    json_uint(&w, queued ? MPU6050_CALIBRATION_MS : 0);
+                    json_obj_end(&w);
+                    len = json_body_end(&w, queued ? "200 OK" : "503 Service Unavailable", &out);
+                }
+                else if (is_get && strcmp(uri, "/api/zones") == 0) {
+                    // Estado e estatísticas de cada zona de controle
+                    static ipc_snapshot_t snap;
+                    ipc_read_snapshot(&snap);
                     
-                    char json[128];
-                    int json_len = snprintf(json, sizeof(json),
-                            "{\"status\":\"ok\",\"heater\":%.1f,\"freezer\":%.1f}",
-                            target_heater_temp, target_conservative_temp);
+                    json_writer_t w;
+                    json_body_begin(&w);
+                    api_json_zones(&w, &snap);
+                    len = json_body_end(&w, "200 OK", &out);
+                }
+                else if (is_get && strcmp(uri, "/api/tasks") == 0) {
+                    // Estatísticas dos escalonadores dos dois cores (jitter, execução, overruns)
+                    static ipc_snapshot_t snap;
+                    ipc_read_snapshot(&snap);
+                    
+                    json_writer_t w;
+                    json_body_begin(&w);
+                    json_arr_begin(&w);
+                    for (int t = 0; t < main_scheduler.count; t++) {
+                        task_json(&w, sched_get_task(&main_scheduler, t), 0);
+                    }
+                    for (int t = 0; t < snap.task_count; t++) {
+                        task_json(&w, &snap.tasks[t], 1);
+                    }
+                    json_arr_end(&w);
+                    len = json_body_end(&w, "200 OK", &out);
+                }
+                else if (is_get && strcmp(uri, "/api/power") == 0) {
+                    // Tempo dormindo de cada core (WFE) e entradas em dormant
+                    static ipc_snapshot_t snap;
+                    ipc_read_snapshot(&snap);
+                    uint64_t now_us = hal_time_us64();
+                    const power_stats_t *core_stats[2] = { power_get_stats(), &snap.power };
                     
+                    json_writer_t w;
+                    json_body_begin(&w);
+                    json_obj_begin(&w);
+                    json_key(&w, "uptime");
+                    json_uint(&w, (uint32_t)(now_us / 1000));
+                    json_key(&w, "cores");
+                    json_arr_begin(&w);
+                    for (int c = 0; c < 2; c++) {
+                        json_obj_begin(&w);
+                        json_key(&w, "core");
+                        json_uint(&w, (uint32_t)c);
+                        json_key(&w, "sleep_permille");
+                        json_uint(&w, power_sleep_permille(core_stats[c], now_us));
+                        json_key(&w, "sleep_ms");
+                        json_uint(&w, (uint32_t)(core_stats[c]->sleep_us / 1000));
+                        json_key(&w, "sleeps");
+                        json_uint(&w, core_stats[c]->sleeps);
+                        json_obj_end(&w);
+                    }
+                    json_arr_end(&w);
+                    json_key(&w, "dormant_entries");
+                    json_uint(&w, core_stats[0]->dormant_entries);
+                    json_key(&w, "motion_wake_armed");
+                    json_bool(&w, snap.motion_wake_armed);
+                    json_obj_end(&w);
+                    len = json_body_end(&w, "200 OK", &out);
+                }
+                else if (is_get && strcmp(uri, "/api/captive") == 0) {
+                    // DNS/redirecionamento do portal cativo, tempo até a primeira página e mDNS
+                    const captive_stats_t *cp = captive_portal_get_stats();
+                    const mdns_stats_t *md = mdns_responder_get_stats();
+                    json_writer_t w;
+                    json_body_begin(&w);
+                    json_obj_begin(&w);
+                    json_write_fields(&w, captive_fields, COUNT(captive_fields), cp);
+                    json_key(&w, "join_to_page_ms");
+                    json_obj_begin(&w);
+                    json_write_fields(&w, captive_join_fields, COUNT(captive_join_fields), cp);
+                    json_obj_end(&w);
+                    json_key(&w, "mdns");
+                    json_obj_begin(&w);
+                    json_write_fields(&w, mdns_fields, COUNT(mdns_fields), md);
+                    json_obj_end(&w);
+                    json_obj_end(&w);
+                    len = json_body_end(&w, "200 OK", &out);
+                }
+                else if (is_get && strcmp(uri, "/api/boot") == 0) {
+                    // Fim de cada etapa do boot (ms desde o reset)
+                    json_writer_t w;
+                    json_body_begin(&w);
+                    json_arr_begin(&w);
+                    for (int i = 0; i < boot_stage_count(); i++) {
+                        const boot_stage_t *stage = boot_get_stage(i);
+                        if (stage == NULL) {
+                            continue;
+                        }
+                        json_obj_begin(&w);
+                        json_key(&w, "stage");
+                        json_str(&w, stage->name);
+                        json_key(&w, "core");
+                        json_uint(&w, stage->core);
+                        json_key(&w, "ms");
+                        json_fixed(&w, stage->us > INT32_MAX ? INT32_MAX : (int32_t)stage->us, 3);
+                        json_obj_end(&w);
+                    }
+                    json_arr_end(&w);
+                    len = json_body_end(&w, "200 OK", &out);
+                }
+                else if (is_get && strcmp(uri, "/api/storage") == 0) {
+                    // Estado do log na flash (kv_store)
+                    kv_stats_t kv;
+                    kv_get_stats(&kv);
+                    json_writer_t w;
+                    json_body_begin(&w);
+                    json_obj_begin(&w);
+                    json_write_fields(&w, storage_fields, COUNT(storage_fields), &kv);
+                    json_key(&w, "size");
+                    json_uint(&w, FLASH_SECTOR_SIZE);
+                    json_write_fields(&w, storage_op_fields, COUNT(storage_op_fields), &kv);
+                    json_obj_end(&w);
+                    len = json_body_end(&w, "200 OK", &out);
+                }
+                else if (is_get && strcmp(uri, "/api/metrics") == 0) {
+                    // Formato de texto do Prometheus; o corpo é gerado em partes
+                    // conforme a janela TCP libera espaço, sobre uma fotografia
+                    // própria desta conexão
+                    if (!metrics_render_begin(&metrics_cursor)) {
+                        len = snprintf(response, sizeof(response),
+                            "HTTP/1.1 503 Service Unavailable\r\n"
+                            "Content-Type: text/plain\r\n"
+                            "Retry-After: 1\r\n"
+                            "Connection: close\r\n"
+                            "\r\n"
+                            "busy");
+                    } else {
+                        len = snprintf(response, sizeof(response),
+                            "HTTP/1.1 200 OK\r\n"
+                            "Content-Type: text/plain; version=0.0.4; charset=UTF-8\r\n"
+                            "Connection: close\r\n"
+                            "\r\n");
+                        stream = metrics_render;
+                    }
+                }
+                else if (is_get && strcmp(uri, "/api/watchdog") == 0) {
+                    // Causa do último reset e prazos/piores casos de cada tarefa vigiada
+                    const supervisor_report_t *rep = supervisor_last_reset();
+                    json_writer_t w;
+                    json_body_begin(&w);
+                    json_obj_begin(&w);
+                    json_key(&w, "armed");
+                    json_bool(&w, supervisor_armed());
+                    json_key(&w, "timeout_ms");
+                    json_uint(&w, SUPERVISOR_WDT_MS);
+                    json_key(&w, "stall_ms");
+                    json_uint(&w, SUPERVISOR_STALL_MS);
+                    json_key(&w, "last_reset");
+                    json_obj_begin(&w);
+                    json_key(&w, "watchdog");
+                    json_bool(&w, rep->watchdog);
+                    json_key(&w, "recorded");
+                    json_bool(&w, rep->has_record);
+                    if (rep->has_record) {
+                        json_key(&w, "task");
+                        json_str(&w, rep->task ? rep->task : "?");
+                        json_key(&w, "task_id");
+                        json_uint(&w, rep->task_id);
+                        json_key(&w, "core");
+                        json_uint(&w, rep->core);
+                        json_key(&w, "running");
+                        json_bool(&w, rep->running);
+                        json_key(&w, "probe");
+                        json_str(&w, rep->probe ? rep->probe : "?");
+                        json_key(&w, "uptime_ms");
+                        json_uint(&w, rep->uptime_ms);
+                    }
+                    json_obj_end(&w);
+                    json_key(&w, "tasks");
+                    json_arr_begin(&w);
+                    supervisor_task_t task;
+                    for (int i = 0; i < supervisor_task_count(); i++) {
+                        if (!supervisor_get_task(i, &task)) continue;
+                        json_obj_begin(&w);
+                        json_write_fields(&w, watchdog_task_fields, COUNT(watchdog_task_fields), &task);
+                        json_obj_end(&w);
+                    }
+                    json_arr_end(&w);
+                    json_obj_end(&w);
+                    len = json_body_end(&w, "200 OK", &out);
+                }
+                else if (is_get && strcmp(uri, "/api/prof") == 0) {
+                    // Perfil por probe (CYCCNT), gerado em partes
                     len = snprintf(response, sizeof(response),
                         "HTTP/1.1 200 OK\r\n"
                         "Content-Type: application/json\r\n"
-                        "Content-Length: %d\r\n"
                         "Connection: close\r\n"
-                        "\r\n"
-                        "%s", json_len, json);
-                    printf("Config atualizada: %s\n", json);
+                        "\r\n");
+                    stream = prof_render;
                 }
-                else if (is_post && strcmp(uri, "/api/reset") == 0) {
-                    printf("\n🔄 RESETANDO ESTADO E RECALIBRANDO...\n");
-                    
-                    // Reset do estado
-                    is_shaken = false;
+                else if (is_post && strcmp(uri, "/api/prof") == 0) {
+                    prof_reset();
+                    len = status_body("200 OK", "ok", NULL, &out);
+                }
+                else if (is_get && strcmp(uri, "/api/history") == 0) {
+                    // Histórico em janelas: ?from=&to= (s do relógio do histórico;
+                    // negativos contam a partir de agora), step=, points=, since=<cursor>,
+                    // format=csv|ndjson|bin|cbor (ou Accept: application/cbor-seq).
+                    // Corpo gerado em partes (chunked)
+                    char value[16];
+                    uint32_t now = history_now_s();
+                    long from = -3600;
+                    long to = 0;
+                    long step = 0;
+                    long points = 0;
+                    long since = 0;
+                    bool invalid = false;
+                    history_format_t format = http_wants_cbor(request, query) ? HISTORY_FMT_CBOR : HISTORY_FMT_CSV;
+                    query_get_long(query, "from", -INT32_MAX, INT32_MAX, &from, &invalid);
+                    query_get_long(query, "to", -INT32_MAX, INT32_MAX, &to, &invalid);
+                    query_get_long(query, "step", 0, INT32_MAX, &step, &invalid);
+                    query_get_long(query, "points", 0, INT32_MAX, &points, &invalid);
+                    bool has_since = query_get_long(query, "since", 0, INT32_MAX, &since, &invalid);
+                    if (query && query_get(query, "format", value, sizeof(value))) {
+                        if (strcmp(value, "ndjson") == 0) format = HISTORY_FMT_NDJSON;
+                        else if (strcmp(value, "bin") == 0) format = HISTORY_FMT_BIN;
+                    }
+                    // Relativos a agora; to = 0 inclui o segundo atual
+                    uint32_t from_s = from < 0 ? (now > (uint32_t)-from ? now + from : 0) : (uint32_t)from;
+                    uint32_t to_s = to <= 0 ? (now >= (uint32_t)-to ? now + to + 1 : 0) : (uint32_t)to;
+                    if (from_s > to_s) {
+                        invalid = true;
+                    }
+                    if (has_since && (uint32_t)since > from_s) from_s = (uint32_t)since;
                     
-                    printf("Estado balançado resetado\n");
-                    printf("⏱️  Iniciando calibração do MPU6050...\n");
-                    printf("    NÃO MOVA O DISPOSITIVO por 10 segundos!\n\n");
+                    int slot = invalid ? -1 : history_query_acquire();
+                    if (invalid) {
+                        len = snprintf(response, sizeof(response),
+                            "HTTP/1.1 400 Bad Request\r\n"
+                            "Content-Type: text/plain\r\n"
+                            "Connection: close\r\n"
+                            "\r\n"
+                            "from/to/step/points/since invalidos");
+                    } else if (slot < 0) {
+                        len = snprintf(response, sizeof(response),
+                            "HTTP/1.1 503 Service Unavailable\r\n"
+                            "Content-Type: text/plain\r\n"
+                            "Retry-After: 1\r\n"
+                            "Connection: close\r\n"
+                            "\r\n"
+                            "busy");
+                    } else {
+                        history_query_t *hq = &history_queries[slot];
+                        history_query_init(hq, format, from_s, to_s, step, points);
+                        len = snprintf(response, sizeof(response),
+                            "HTTP/1.1 200 OK\r\n"
+                            "Content-Type: %s\r\n"
+                            "Transfer-Encoding: chunked\r\n"
+                            "X-History-Now: %lu\r\n"
+                            "X-History-Tier: %s\r\n"
+                            "X-History-Step: %lu\r\n"
+                            "Vary: Accept\r\n"
+                            "Connection: close\r\n"
+                            "\r\n", history_format_mime(format), (unsigned long)now,
+                            history_tier_name(hq->tier), (unsigned long)hq->step_s);
+                        stream = history_stream;
+                        history_slot = slot;
+                    }
+                }
+                else if (is_get && strcmp(uri, "/api/logs") == 0) {
+                    // Registros do log em texto, a partir de ?since=<seq> (ou do mais antigo);
+                    // em CBOR (api_cbor.h) com os argumentos sem formatar
+                    // Lido antes de next_seq para não passar dele; since além do
+                    // próximo registro também para nele (o laço abaixo não dá a volta)
+                    uint32_t seq = log_oldest_seq();
+                    log_stats_t ls;
+                    log_get_stats(&ls);
+                    long since;
+                    bool invalid = false;
+                    if (query_get_long(query, "since", 0, INT32_MAX, &since, &invalid) && (uint32_t)since > seq) {
+                        seq = (uint32_t)since < ls.next_seq ? (uint32_t)since : ls.next_seq;
+                    }
+                    if (invalid) {
+                        len = status_body("400 Bad Request", "error", "since invalido", &out);
+                    } else {
+                        bool cbor = http_wants_cbor(request, query);
                     
-                    // IMPORTANTE: Resetar e calibrar ANTES de responder HTTP
-                    mpu6050_reset_shake_detection();
+                        // Corpo montado após o espaço reservado ao cabeçalho
+                        static char header[256];
+                        char *body = response + sizeof(header);
+                        int body_room = sizeof(response) - sizeof(header);
+                        int body_len = 0;
+                        static log_record_t rec;
+                        static api_cbor_log_ctx_t log_ctx;
+                        static char line[192];
+                        if (cbor) {
+                            api_cbor_log_begin(&log_ctx);
+                            body[body_len++] = (char)0x9F;   // Array indefinido; 0xFF no fim
+                            body_room--;
+                        }
+                        for (; seq != ls.next_seq; seq++) {
+                            if (!log_read(seq, &rec)) continue;   // Sobrescrito ou em escrita
+                            if (cbor) {
+                                cbor_writer_t ev;
+                                cbor_writer_init(&ev, line, sizeof(line));
+                                api_cbor_log_event(&ev, &log_ctx, &rec);
+                                if (!cbor_writer_ok(&ev)) continue;   // Formato longo demais
+                                if (body_len + (int)cbor_writer_len(&ev) > body_room) break;
+                                memcpy(body + body_len, line, cbor_writer_len(&ev));
+                                body_len += cbor_writer_len(&ev);
+                                continue;
+                            }
+                            int line_len = log_format(&rec, line, sizeof(line));
+                            if (body_len + line_len + 12 > body_room) break;   // + "<seq> " e '\n'
+                            body_len += snprintf(body + body_len, body_room - body_len, "%lu %s\n",
+                                    (unsigned long)seq, line);
+                        }
+                        if (cbor) {
+                            body[body_len++] = (char)0xFF;
+                        }
                     
-                    // Aguardar calibração completar (10 segundos) ANTES de responder
-                    for (int i = 10; i > 0; i--) {
-                        printf("    Calibrando... %d segundos restantes\n", i);
-                        sleep_ms(1000);
-                        mpu6050_update_calibration();
+                        int header_len = snprintf(header, sizeof(header),
+                            "HTTP/1.1 200 OK\r\n"
+                            "Content-Type: %s\r\n"
+                            "Content-Length: %d\r\n"
+                            "X-Log-Next: %lu\r\n"
+                            "X-Log-Lost: %lu\r\n"
+                            "X-Http-Last-Us: %lu\r\n"
+                            "X-Http-Max-Us: %lu\r\n"
+                            "%s"
+                            "Connection: close\r\n"
+                            "\r\n", cbor ? "application/cbor" : "text/plain; charset=UTF-8",
+                            body_len, (unsigned long)seq, (unsigned long)ls.lost,
+                            (unsigned long)http_last_us, (unsigned long)http_max_us, cbor ? CBOR_HEADERS : "");
+                        memmove(response + header_len, body, body_len);
+                        memcpy(response, header, header_len);
+                        len = header_len + body_len;
+                    }
+                }
+                else if (is_get && strcmp(uri, "/api/autotune") == 0) {
+                    // Progresso do autotune (consultado periodicamente pela interface)
+                    static ipc_snapshot_t snap;
+                    ipc_read_snapshot(&snap);
+                    json_writer_t w;
+                    json_body_begin(&w);
+                    api_json_autotune(&w, &snap);
+                    len = json_body_end(&w, "200 OK", &out);
+                }
+                else if (is_post && strcmp(uri, "/api/autotune") == 0) {
+                    // Iniciar autotune: /api/autotune?zone=heater|freezer&setpoint=45.0
+                    // Sem setpoint, usa o alvo atual da zona
+                    char zone_str[16] = "heater";
+                    bool invalid = false;
+                    if (query) {
+                        query_get(query, "zone", zone_str, sizeof(zone_str));
                     }
                     
-                    printf("\n✅ Calibração completa! Sistema pronto para detectar movimento.\n\n");
+                    autotune_zone_t zone = AUTOTUNE_ZONE_HEATER;
+                    if (strcmp(zone_str, "freezer") == 0) {
+                        zone = AUTOTUNE_ZONE_CONSERVATIVE;
+                    } else if (strcmp(zone_str, "heater") != 0) {
+                        invalid = true;
+                    }
+                    ibag_config_t config;
+                    config_store_read(&config);
+                    float setpoint = (zone == AUTOTUNE_ZONE_HEATER) ? config.heater_target : config.conservative_target;
+                    query_get_float(query, "setpoint", &setpoint, &invalid);
                     
-                    // Agora sim, responder HTTP
-                    const char *json = "{\"status\":\"ok\"}";
-                    int json_len = strlen(json);
+                    static ipc_snapshot_t snap;
+                    ipc_read_snapshot(&snap);
+                    bool running = snap.autotune.state == AUTOTUNE_APPROACH ||
+                                   snap.autotune.state == AUTOTUNE_RELAY;
                     
-                    len = snprintf(response, sizeof(response),
-                        "HTTP/1.1 200 OK\r\n"
-                        "Content-Type: application/json\r\n"
-                        "Content-Length: %d\r\n"
-                        "Connection: close\r\n"
-                        "\r\n"
-                        "%s", json_len, json);
+                    ipc_cmd_t cmd = { .type = IPC_CMD_AUTOTUNE_START, .zone = zone, .setpoint = setpoint };
+                    if (running) {
+                        len = status_body("409 Conflict", "busy", NULL, &out);
+                    } else if (invalid || !autotune_setpoint_valid(setpoint)) {
+                        len = status_body("400 Bad Request", "error", "parametro invalido", &out);
+                    } else if (!ipc_send_command(&cmd)) {
+                        len = status_body("503 Service Unavailable", "busy", NULL, &out);
+                    } else {
+                        len = status_body("200 OK", "ok", NULL, &out);
+                    }
+                }
+                else if (is_post && strcmp(uri, "/api/autotune/cancel") == 0) {
+                    ipc_cmd_t cmd = { .type = IPC_CMD_AUTOTUNE_CANCEL };
+                    ipc_send_command(&cmd);
+                    len = status_body("200 OK", "ok", NULL, &out);
                 }
                 else {
                     // 404 Not Found
@@ -243,74 +1140,77 @@ static err_t http_recv(void *arg, struct tcp_pcb *pcb, struct pbuf *p, err_t err
                         "Connection: close\r\n"
                         "\r\n"
                         "404 - Not Found");
-                    printf("404: %s\n", uri);
+                    LOG_W(LOG_MOD_HTTP, "404: %s", uri);
                 }
             }
         }
     }
     
+    // snprintf devolve o tamanho que teria sem truncar
+    if (out == response && len >= (int)sizeof(response)) {
+        len = sizeof(response) - 1;
+    }
+    
     // Enviar resposta
-    if (len > 0) {
-        // Criar estrutura de estado para rastrear envio
-        struct http_state *hs = (struct http_state *)malloc(sizeof(struct http_state));
+    if (upload != NULL) {
+        // Resposta só quando o corpo terminar (http_upload_recv)
+        struct http_state *hs = (struct http_state *)calloc(1, sizeof(struct http_state));
         if (hs == NULL) {
-            printf("ERRO: Falha ao alocar memória para http_state\n");
-            tcp_close(pcb);
+            LOG_E(LOG_MOD_HTTP, "Sem memória para o corpo do POST");
+            free(upload);
+            tcp_abort(pcb);
             pbuf_free(p);
-            return ERR_MEM;
+            return ERR_ABRT;
+        }
+        hs->upload = upload;
+        tcp_arg(pcb, hs);
+        tcp_err(pcb, http_err);
+        tcp_poll(pcb, http_poll, 2);
+        tcp_recved(pcb, p->tot_len);
+    } else if (len > 0) {
+        // Criar estrutura de estado para rastrear envio
+        struct http_state *hs = (struct http_state *)calloc(1, sizeof(struct http_state));
+        char *tx = (stream != NULL) ? tx_block_acquire() : NULL;
+        if (hs == NULL || (stream != NULL && tx == NULL)) {
+            LOG_E(LOG_MOD_HTTP, "Sem memória para a resposta (estado %d, bloco %d)", hs != NULL, tx != NULL);
+            tx_block_release(tx);
+            free(hs);
+            if (history_slot >= 0) {
+                history_queries_used &= ~(1u << history_slot);
+            }
+            if (stream == metrics_render) {
+                metrics_render_end(metrics_cursor);
+            }
+            tcp_abort(pcb);
+            pbuf_free(p);
+            return ERR_ABRT;
         }
         
-        hs->total_length = len;
-        hs->total_sent = 0;
+        hs->total_length = len + body_len;
+        hs->body = body;
+        hs->body_len = body_len;
+        hs->stream = stream;
+        hs->tx = tx;
+        if (history_slot >= 0) {
+            hs->cursor = (uint32_t)history_slot;
+            hs->chunked = true;
+        }
+        if (stream == metrics_render) {
+            hs->cursor = metrics_cursor;
+        }
         
         // Associar estado à conexão
         tcp_arg(pcb, hs);
+        tcp_err(pcb, http_err);
+        tcp_poll(pcb, http_poll, 2);
         
-        // Para respostas pequenas (<2KB), enviar tudo de uma vez
-        if (len < 2048) {
-            err_t write_err = tcp_write(pcb, response, len, TCP_WRITE_FLAG_COPY);
-            if (write_err == ERR_OK) {
-                tcp_output(pcb);
-                printf("Resposta pequena enviada: %d bytes\n", len);
-            } else {
-                printf("ERRO ao enviar resposta pequena: %d\n", write_err);
-                tcp_arg(pcb, NULL);
-                free(hs);
-                tcp_close(pcb);
-            }
+        // Cabeçalho (e respostas curtas inteiras) cabem no buffer de envio vazio
+        err_t write_err = tcp_write(pcb, out, len, TCP_WRITE_FLAG_COPY);
+        if (write_err == ERR_OK) {
+            http_body_fill(pcb, hs);
         } else {
-            // Para respostas grandes, enviar em chunks
-            int sent = 0;
-            int chunk_size = 1460; // Tamanho do MSS
-            
-            while (sent < len) {
-                int to_send = (len - sent) < chunk_size ? (len - sent) : chunk_size;
-                
-                // Verificar espaço disponível no buffer TCP
-                int available = tcp_sndbuf(pcb);
-                if (available < to_send) {
-                    to_send = available;
-                }
-                
-                if (to_send > 0) {
-                    err_t write_err = tcp_write(pcb, response + sent, to_send, TCP_WRITE_FLAG_COPY);
-                    if (write_err == ERR_OK) {
-                        sent += to_send;
-                    } else {
-                        printf("ERRO ao enviar chunk: %d\n", write_err);
-                        break;
-                    }
-                } else {
-                    // Buffer cheio, forçar envio e aguardar
-                    tcp_output(pcb);
-                    sleep_ms(10);
-                }
-            }
-            
-            // Forçar envio de todos os dados pendentes
-            tcp_output(pcb);
-            
-            printf("Total enfileirado: %d de %d bytes\n", sent, len);
+            LOG_E(LOG_MOD_HTTP, "Erro ao enviar resposta: %d", write_err);
+            http_finish(pcb, hs);
         }
     } else {
         tcp_close(pcb);
@@ -319,14 +1219,16 @@ static err_t http_recv(void *arg, struct tcp_pcb *pcb, struct pbuf *p, err_t err
     // Liberar buffer recebido
     pbuf_free(p);
     
+    http_last_us = hal_time_us() - start_us;
+    if (http_last_us > http_max_us) {
+        http_max_us = http_last_us;
+    }
+    metrics_http_request(route, http_last_us);
     return ERR_OK;
 }
 
 static err_t http_accept(void *arg, struct tcp_pcb *newpcb, err_t err) {
-    printf("\n╔════════════════════════════════════╗\n");
-    printf("║  CLIENTE CONECTADO!               ║\n");
-    printf("║  Nova conexão TCP na porta 8000    ║\n");
-    printf("╚════════════════════════════════════╝\n\n");
+    LOG_D(LOG_MOD_HTTP, "Nova conexão TCP na porta 8000");
     
     tcp_recv(newpcb, http_recv);
     tcp_sent(newpcb, http_sent);
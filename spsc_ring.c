@@ -0,0 +1,47 @@
+#include "spsc_ring.h"
+#include <string.h>
+
+void spsc_ring_init(spsc_ring_t *ring, void *storage, uint16_t elem_size, uint16_t capacity) {
+    ring->buf = (uint8_t *)storage;
+    ring->elem_size = elem_size;
+    ring->capacity = capacity;
+    atomic_store_explicit(&ring->head, 0, memory_order_relaxed);
+    atomic_store_explicit(&ring->tail, 0, memory_order_relaxed);
+    atomic_store_explicit(&ring->dropped, 0, memory_order_relaxed);
+}
+
+bool spsc_ring_push(spsc_ring_t *ring, const void *elem) {
+    uint32_t head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+    uint32_t tail = atomic_load_explicit(&ring->tail, memory_order_acquire);
+
+    if (head - tail >= ring->capacity) {
+        atomic_fetch_add_explicit(&ring->dropped, 1, memory_order_relaxed);
+        return false;
+    }
+
+    memcpy(ring->buf + (head & (ring->capacity - 1)) * ring->elem_size, elem, ring->elem_size);
+    atomic_store_explicit(&ring->head, head + 1, memory_order_release);
+    return true;
+}
+
+bool spsc_ring_pop(spsc_ring_t *ring, void *elem) {
+    uint32_t tail = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+    uint32_t head = atomic_load_explicit(&ring->head, memory_order_acquire);
+
+    if (head == tail) {
+        return false;
+    }
+
+    memcpy(elem, ring->buf + (tail & (ring->capacity - 1)) * ring->elem_size, ring->elem_size);
+    atomic_store_explicit(&ring->tail, tail + 1, memory_order_release);
+    return true;
+}
+
+uint32_t spsc_ring_count(spsc_ring_t *ring) {
+    return atomic_load_explicit(&ring->head, memory_order_acquire) -
+           atomic_load_explicit(&ring->tail, memory_order_acquire);
+}
+
+uint32_t spsc_ring_dropped(spsc_ring_t *ring) {
+    return atomic_load_explicit(&ring->dropped, memory_order_relaxed);
+}
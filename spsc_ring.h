@@ -0,0 +1,33 @@
+#ifndef SPSC_RING_H
+#define SPSC_RING_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdatomic.h>
+
+// Fila circular lock-free de um produtor e um consumidor (SPSC)
+// O produtor só escreve head e o consumidor só escreve tail; cada lado lê o
+// índice do outro com acquire e publica o seu com release. Seguro entre os
+// dois cores do RP2350 (e entre IRQ e loop principal) sem mutex.
+// A capacidade precisa ser potência de 2.
+
+typedef struct {
+    uint8_t *buf;
+    uint16_t elem_size;
+    uint16_t capacity;
+    _Atomic uint32_t head;   // Próxima posição de escrita (produtor)
+    _Atomic uint32_t tail;   // Próxima posição de leitura (consumidor)
+    _Atomic uint32_t dropped;  // push com a fila cheia
+} spsc_ring_t;
+
+// Declara o armazenamento estático de uma fila
+#define SPSC_RING_STORAGE(name, type, cap) \
+    static uint8_t name##_storage[(cap) * sizeof(type)] __attribute__((aligned(4)))
+
+void spsc_ring_init(spsc_ring_t *ring, void *storage, uint16_t elem_size, uint16_t capacity);
+bool spsc_ring_push(spsc_ring_t *ring, const void *elem);  // Produtor
+bool spsc_ring_pop(spsc_ring_t *ring, void *elem);         // Consumidor
+uint32_t spsc_ring_count(spsc_ring_t *ring);
+uint32_t spsc_ring_dropped(spsc_ring_t *ring);
+
+#endif // SPSC_RING_H
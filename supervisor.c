@@ -0,0 +1,222 @@
+#include "supervisor.h"
+#include <stdio.h>
+#include <string.h>
+#include <stdatomic.h>
+#include "pico/stdlib.h"
+#include "hardware/watchdog.h"
+#include "prof.h"
+#include "logger.h"
+
+// Registro nos scratch 0..3 (4..7 são do SDK/bootrom)
+//   scratch[0] = magic << 16 | em execução << 9 | core << 8 | id da tarefa
+//   scratch[1] = nome da tarefa, scratch[2] = última probe (ponteiros na flash)
+//   scratch[3] = ms desde o boot na detecção
+#define RECORD_MAGIC 0x5744u
+#define NAME_MAX_LEN 32
+
+typedef struct {
+    const char *name;
+    uint8_t core;
+    _Atomic uint32_t last_us;          // Último check-in
+    _Atomic uint32_t running_since;    // Início da execução atual (0 = parada)
+    _Atomic uint32_t deadline_us;
+    uint32_t max_gap_us;               // Só o core dono escreve
+    uint32_t max_run_us;
+} watch_t;
+
+static watch_t watches[SUPERVISOR_MAX_TASKS];
+static _Atomic uint32_t next_slot;
+static _Atomic uint32_t ready_mask;    // Bit por tarefa já registrada
+static _Atomic bool armed;
+static _Atomic bool tripped;
+static supervisor_report_t report;
+
+// Ponteiro gravado antes do reset: só vale se apontar para uma string na
+// flash deste firmware
+static const char *flash_string(uint32_t addr) {
+    if (addr < XIP_BASE || addr >= XIP_BASE + PICO_FLASH_SIZE_BYTES - NAME_MAX_LEN) {
+        return NULL;
+    }
+    const char *s = (const char *)(uintptr_t)addr;
+    for (int i = 0; i < NAME_MAX_LEN; i++) {
+        if (s[i] == '\0') {
+            return i > 0 ? s : NULL;
+        }
+        if (s[i] < 0x20 || s[i] > 0x7E) {
+            return NULL;
+        }
+    }
+    return NULL;
+}
+
+void supervisor_init(void) {
+    memset(&report, 0, sizeof(report));
+    report.watchdog = watchdog_enable_caused_reboot();
+
+    uint32_t header = watchdog_hw->scratch[0];
+    if ((header >> 16) == RECORD_MAGIC) {
+        report.has_record = true;
+        report.task_id = header & 0xFF;
+        report.core = (header >> 8) & 1;
+        report.running = (header >> 9) & 1;
+        report.task = flash_string(watchdog_hw->scratch[1]);
+        report.probe = flash_string(watchdog_hw->scratch[2]);
+        report.uptime_ms = watchdog_hw->scratch[3];
+    }
+    for (int i = 0; i < 4; i++) {
+        watchdog_hw->scratch[i] = 0;
+    }
+
+    if (report.has_record) {
+        printf("⚠️  Reset pelo watchdog: tarefa %s (id %u, core %u) %s, última probe %s, aos %lu ms\n",
+               report.task ? report.task : "?", report.task_id, report.core,
+               report.running ? "travada em execução" : "sem check-in",
+               report.probe ? report.probe : "?", (unsigned long)report.uptime_ms);
+    } else if (report.watchdog) {
+        printf("⚠️  Reset pelo watchdog sem diagnóstico (os dois cores parados?)\n");
+    }
+}
+
+int supervisor_register(const char *name, uint32_t deadline_ms) {
+    uint32_t slot = atomic_fetch_add_explicit(&next_slot, 1, memory_order_relaxed);
+    if (slot >= SUPERVISOR_MAX_TASKS) {
+        LOG_E(LOG_MOD_MAIN, "Watchdog sem espaço para a tarefa %s", name);
+        return -1;
+    }
+    watch_t *w = &watches[slot];
+    w->name = name;
+    w->core = (uint8_t)get_core_num();
+    w->max_gap_us = 0;
+    w->max_run_us = 0;
+    atomic_store_explicit(&w->deadline_us, deadline_ms * 1000u, memory_order_relaxed);
+    atomic_store_explicit(&w->running_since, 0, memory_order_relaxed);
+    atomic_store_explicit(&w->last_us, time_us_32(), memory_order_relaxed);
+    atomic_fetch_or_explicit(&ready_mask, 1u << slot, memory_order_release);
+    return (int)slot;
+}
+
+void supervisor_set_deadline(int id, uint32_t deadline_ms) {
+    if (id >= 0 && id < SUPERVISOR_MAX_TASKS) {
+        atomic_store_explicit(&watches[id].deadline_us, deadline_ms * 1000u, memory_order_relaxed);
+    }
+}
+
+void supervisor_begin(int id) {
+    if (id < 0 || id >= SUPERVISOR_MAX_TASKS) {
+        return;
+    }
+    uint32_t now = time_us_32();
+    atomic_store_explicit(&watches[id].running_since, now ? now : 1u, memory_order_release);
+}
+
+void supervisor_checkin(int id) {
+    if (id < 0 || id >= SUPERVISOR_MAX_TASKS) {
+        return;
+    }
+    watch_t *w = &watches[id];
+    uint32_t now = time_us_32();
+    uint32_t since = atomic_load_explicit(&w->running_since, memory_order_relaxed);
+    uint32_t gap = now - atomic_load_explicit(&w->last_us, memory_order_relaxed);
+    if (since != 0 && now - since > w->max_run_us) w->max_run_us = now - since;
+    if (gap > w->max_gap_us) w->max_gap_us = gap;
+    // Ordem: último check-in antes de sair de "em execução" (ver supervisor_poll)
+    atomic_store_explicit(&w->last_us, now, memory_order_release);
+    atomic_store_explicit(&w->running_since, 0, memory_order_release);
+}
+
+// Gravar o diagnóstico e parar de alimentar o watchdog
+static void supervisor_trip(int id, bool running) {
+    if (atomic_exchange_explicit(&tripped, true, memory_order_acq_rel)) {
+        return;
+    }
+    const watch_t *w = &watches[id];
+    watchdog_hw->scratch[1] = (uint32_t)(uintptr_t)w->name;
+    watchdog_hw->scratch[2] = (uint32_t)(uintptr_t)prof_last_probe[w->core];
+    watchdog_hw->scratch[3] = to_ms_since_boot(get_absolute_time());
+    watchdog_hw->scratch[0] = (RECORD_MAGIC << 16) | ((uint32_t)running << 9) |
+                              ((uint32_t)w->core << 8) | (uint32_t)id;
+    LOG_E(LOG_MOD_MAIN, "Watchdog: tarefa %s (core %u) %s; reset em até %d ms",
+          w->name, w->core, running ? "travada" : "sem check-in", SUPERVISOR_WDT_MS);
+}
+
+void supervisor_poll(void) {
+    if (!atomic_load_explicit(&armed, memory_order_relaxed) ||
+        atomic_load_explicit(&tripped, memory_order_relaxed)) {
+        return;
+    }
+    uint32_t mask = atomic_load_explicit(&ready_mask, memory_order_acquire);
+    uint32_t now = time_us_32();
+    for (int i = 0; i < SUPERVISOR_MAX_TASKS; i++) {
+        if (!(mask & (1u << i))) continue;
+        watch_t *w = &watches[i];
+        uint32_t since = atomic_load_explicit(&w->running_since, memory_order_acquire);
+        if (since != 0) {
+            if ((int32_t)(now - since) > SUPERVISOR_STALL_MS * 1000) {
+                supervisor_trip(i, true);
+                return;
+            }
+            continue;
+        }
+        uint32_t last = atomic_load_explicit(&w->last_us, memory_order_acquire);
+        if ((int32_t)(now - last) > (int32_t)atomic_load_explicit(&w->deadline_us, memory_order_relaxed)) {
+            supervisor_trip(i, false);
+            return;
+        }
+    }
+    // Só o core 0 alimenta; se ele parar, o core 1 registra a causa
+    if (get_core_num() == 0) {
+        watchdog_update();
+    }
+}
+
+// Prazos contam a partir do momento em que o watchdog é armado
+static void restart_deadlines(void) {
+    uint32_t mask = atomic_load_explicit(&ready_mask, memory_order_acquire);
+    uint32_t now = time_us_32();
+    for (int i = 0; i < SUPERVISOR_MAX_TASKS; i++) {
+        if (mask & (1u << i)) {
+            atomic_store_explicit(&watches[i].last_us, now, memory_order_relaxed);
+        }
+    }
+}
+
+void supervisor_start(void) {
+    restart_deadlines();
+    watchdog_enable(SUPERVISOR_WDT_MS, true);   // Pausa com o depurador conectado
+    atomic_store_explicit(&armed, true, memory_order_release);
+}
+
+void supervisor_pause(void) {
+    atomic_store_explicit(&armed, false, memory_order_release);
+    watchdog_disable();
+}
+
+bool supervisor_armed(void) {
+    return atomic_load_explicit(&armed, memory_order_relaxed);
+}
+
+int supervisor_task_count(void) {
+    uint32_t count = atomic_load_explicit(&next_slot, memory_order_relaxed);
+    return count < SUPERVISOR_MAX_TASKS ? (int)count : SUPERVISOR_MAX_TASKS;
+}
+
+bool supervisor_get_task(int id, supervisor_task_t *out) {
+    if (id < 0 || id >= SUPERVISOR_MAX_TASKS) {
+        return false;
+    }
+    uint32_t mask = atomic_load_explicit(&ready_mask, memory_order_acquire);
+    if (!(mask & (1u << id))) {
+        return false;
+    }
+    const watch_t *w = &watches[id];
+    out->name = w->name;
+    out->core = w->core;
+    out->deadline_ms = atomic_load_explicit(&w->deadline_us, memory_order_relaxed) / 1000u;
+    out->max_gap_ms = w->max_gap_us / 1000u;
+    out->max_run_ms = w->max_run_us / 1000u;
+    return true;
+}
+
+const supervisor_report_t *supervisor_last_reset(void) {
+    return &report;
+}
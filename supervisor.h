@@ -0,0 +1,56 @@
+#ifndef SUPERVISOR_H
+#define SUPERVISOR_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// Watchdog com verificação de vida por tarefa
+// Cada tarefa registrada faz check-in ao terminar uma execução (as tarefas
+// do escalonador fazem isso sozinhas). O watchdog do RP2350 só é alimentado
+// enquanto todas fizeram check-in dentro do prazo e nenhuma está rodando há
+// mais de SUPERVISOR_STALL_MS. Os dois cores chamam supervisor_poll() e
+// vigiam um ao outro: quem detectar a falha grava nos registradores scratch
+// do watchdog a tarefa, o core, a última probe do perfilador (prof.h) e o
+// instante, e ninguém mais alimenta - o reset vem em até SUPERVISOR_WDT_MS.
+// No boot seguinte o registro é impresso e fica em GET /api/watchdog.
+
+#define SUPERVISOR_MAX_TASKS 16
+#define SUPERVISOR_WDT_MS 5000         // Timeout do watchdog de hardware
+#define SUPERVISOR_STALL_MS 1000       // Execução mais longa tolerada
+#define SUPERVISOR_GRACE_MS 1000       // Folga sobre o prazo de check-in
+
+typedef struct {
+    const char *name;
+    uint8_t core;
+    uint32_t deadline_ms;              // Intervalo máximo entre check-ins
+    uint32_t max_gap_ms;               // Maior intervalo medido
+    uint32_t max_run_ms;               // Execução mais longa medida
+} supervisor_task_t;
+
+// Diagnóstico do último reset
+typedef struct {
+    bool watchdog;                     // O último reset veio do watchdog
+    bool has_record;                   // Alguém registrou a causa antes do reset
+    uint8_t task_id;
+    uint8_t core;
+    bool running;                      // Travou dentro da tarefa (senão, faltou check-in)
+    const char *task;                  // NULL se o registro não confere com este firmware
+    const char *probe;
+    uint32_t uptime_ms;                // Instante da detecção
+} supervisor_report_t;
+
+// Funções públicas
+void supervisor_init(void);                                // Core 0, no boot: lê e limpa o registro
+void supervisor_start(void);                               // Armar o watchdog (também após supervisor_pause)
+void supervisor_pause(void);                               // Desarmar (ex.: antes do dormant)
+int supervisor_register(const char *name, uint32_t deadline_ms);   // No core que executa; id ou -1
+void supervisor_set_deadline(int id, uint32_t deadline_ms);
+void supervisor_begin(int id);                             // Início de uma execução
+void supervisor_checkin(int id);                           // Fim de uma execução
+void supervisor_poll(void);                                // Loop de cada core
+bool supervisor_armed(void);
+int supervisor_task_count(void);
+bool supervisor_get_task(int id, supervisor_task_t *out);
+const supervisor_report_t *supervisor_last_reset(void);
+
+#endif // SUPERVISOR_H
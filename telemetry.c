@@ -0,0 +1,200 @@
+#include "telemetry.h"
+#include <string.h>
+#include <stdatomic.h>
+#include "pico/stdlib.h"
+#include "tusb.h"
+#include "spsc_ring.h"
+#include "kv_store.h"
+#include "prof.h"
+#include "hal.h"
+
+#define RECORD_SIZE sizeof(telemetry_record_t)
+#define FRAME_MAX (RECORD_SIZE + 4 + 1 + 1)   // + CRC, + 1 byte do COBS, + 0x00
+
+_Static_assert(RECORD_SIZE == 20, "registro da telemetria mudou de tamanho");
+
+static spsc_ring_t ring;
+SPSC_RING_STORAGE(ring, telemetry_record_t, TELEMETRY_RING_RECORDS);
+static _Atomic bool enabled;           // Escrito pelo core 0, lido pelo core 1
+static uint16_t next_seq;              // Só o core 1
+
+// Core 0: quadro que o USB ainda não aceitou
+static uint8_t frame[FRAME_MAX];
+static uint8_t frame_len;
+static telemetry_stats_t stats;
+static uint32_t last_stats_ms;
+
+void telemetry_init(void) {
+    // Com tinyusb_device linkado o stdio_usb pode não ter iniciado a pilha
+    if (!tud_inited()) {
+        tusb_init();
+    }
+    spsc_ring_init(&ring, ring_storage, RECORD_SIZE, TELEMETRY_RING_RECORDS);
+    memset(&stats, 0, sizeof(stats));
+    frame_len = 0;
+    atomic_store_explicit(&enabled, false, memory_order_relaxed);
+}
+
+size_t telemetry_cobs_encode(const uint8_t *in, size_t len, uint8_t *out) {
+    size_t code_pos = 0;
+    size_t o = 1;
+    uint8_t code = 1;
+    for (size_t i = 0; i < len; i++) {
+        if (in[i] != 0) {
+            out[o++] = in[i];
+            code++;
+        }
+        if (in[i] == 0 || code == 0xFF) {
+            out[code_pos] = code;
+            code_pos = o++;
+            code = 1;
+        }
+    }
+    out[code_pos] = code;
+    return o;
+}
+
+static bool record_begin(telemetry_record_t *rec, telemetry_type_t type, uint8_t arg) {
+    if (!atomic_load_explicit(&enabled, memory_order_relaxed)) {
+        return false;
+    }
+    memset(rec, 0, sizeof(*rec));
+    rec->type = (uint8_t)type;
+    rec->arg = arg;
+    rec->time_us = hal_time_us();
+    return true;
+}
+
+// Descartado com a fila cheia: a sequência avança mesmo assim e o host vê o buraco
+static void record_push(telemetry_record_t *rec) {
+    rec->seq = next_seq++;
+    spsc_ring_push(&ring, rec);
+}
+
+void telemetry_imu(const int16_t accel[3], const int16_t gyro[3]) {
+    telemetry_record_t rec;
+    if (record_begin(&rec, TELEMETRY_IMU, 0)) {
+        memcpy(&rec.v[0], accel, 3 * sizeof(int16_t));
+        memcpy(&rec.v[3], gyro, 3 * sizeof(int16_t));
+        record_push(&rec);
+    }
+}
+
+void telemetry_adc(uint8_t channel, uint16_t raw) {
+    telemetry_record_t rec;
+    if (record_begin(&rec, TELEMETRY_ADC, channel)) {
+        rec.v[0] = (int16_t)raw;
+        record_push(&rec);
+    }
+}
+
+void telemetry_relay(uint8_t zone, bool on) {
+    telemetry_record_t rec;
+    if (record_begin(&rec, TELEMETRY_RELAY, zone)) {
+        rec.v[0] = on ? 1 : 0;
+        record_push(&rec);
+    }
+}
+
+// Valores de 32 bits ocupam dois campos (parte baixa primeiro)
+static void put_u32(int16_t *v, uint32_t value) {
+    v[0] = (int16_t)(value & 0xFFFF);
+    v[1] = (int16_t)(value >> 16);
+}
+
+void telemetry_timing(uint8_t task, uint32_t exec_us, uint32_t jitter_us) {
+    telemetry_record_t rec;
+    if (record_begin(&rec, TELEMETRY_TIMING, task)) {
+        put_u32(&rec.v[0], exec_us);
+        put_u32(&rec.v[2], jitter_us);
+        record_push(&rec);
+    }
+}
+
+// Registro + CRC-32 -> COBS -> 0x00 (o RP2350 é little-endian: o registro
+// vai como está na memória)
+static void frame_build(const telemetry_record_t *rec) {
+    uint8_t raw[RECORD_SIZE + 4];
+    memcpy(raw, rec, RECORD_SIZE);
+    uint32_t crc = kv_crc32(rec, RECORD_SIZE);
+    raw[RECORD_SIZE + 0] = (uint8_t)crc;
+    raw[RECORD_SIZE + 1] = (uint8_t)(crc >> 8);
+    raw[RECORD_SIZE + 2] = (uint8_t)(crc >> 16);
+    raw[RECORD_SIZE + 3] = (uint8_t)(crc >> 24);
+    size_t n = telemetry_cobs_encode(raw, sizeof(raw), frame);
+    frame[n++] = 0x00;
+    frame_len = (uint8_t)n;
+}
+
+static void stats_frame(uint32_t now_ms) {
+    telemetry_record_t rec;
+    memset(&rec, 0, sizeof(rec));
+    rec.type = TELEMETRY_STATS;
+    rec.time_us = hal_time_us();
+    put_u32(&rec.v[0], stats.records_sent);
+    put_u32(&rec.v[2], spsc_ring_dropped(&ring));
+    rec.v[4] = (int16_t)stats.ring_peak;
+    frame_build(&rec);
+    last_stats_ms = now_ms;
+}
+
+void telemetry_poll(void) {
+    // TinyUSB não é reentrante e o stdio_usb também chama tud_task() dentro
+    // do printf. Só o core 0 usa o USB, fora de IRQ: o console do core 1 (e
+    // de IRQs) passa pelo logger, drenado pela tarefa "log" deste mesmo laço
+    tud_task();
+
+    bool connected = tud_cdc_n_connected(TELEMETRY_CDC_ITF);
+    if (connected != atomic_load_explicit(&enabled, memory_order_relaxed)) {
+        atomic_store_explicit(&enabled, connected, memory_order_relaxed);
+        if (!connected) {
+            // Host fechou a porta: o que sobrou na fila não tem mais destino
+            telemetry_record_t rec;
+            while (spsc_ring_pop(&ring, &rec)) {
+            }
+            frame_len = 0;
+        }
+    }
+    stats.connected = connected;
+    if (!connected) {
+        return;
+    }
+
+    PROF_SCOPE("telemetry");
+    uint32_t pending = spsc_ring_count(&ring);
+    if (pending > stats.ring_peak) {
+        stats.ring_peak = (uint16_t)pending;
+    }
+
+    uint32_t now_ms = hal_time_ms();
+    bool wrote = false;
+    while (true) {
+        if (frame_len == 0) {
+            telemetry_record_t rec;
+            if (now_ms - last_stats_ms >= TELEMETRY_STATS_MS) {
+                stats_frame(now_ms);
+            } else if (spsc_ring_pop(&ring, &rec)) {
+                frame_build(&rec);
+            } else {
+                break;
+            }
+        }
+        // Quadro inteiro ou nada: o host nunca recebe meio quadro seguido de outro
+        if (tud_cdc_n_write_available(TELEMETRY_CDC_ITF) < frame_len) {
+            break;
+        }
+        tud_cdc_n_write(TELEMETRY_CDC_ITF, frame, frame_len);
+        stats.records_sent++;
+        stats.bytes_sent += frame_len;
+        frame_len = 0;
+        wrote = true;
+    }
+    if (wrote) {
+        tud_cdc_n_write_flush(TELEMETRY_CDC_ITF);
+    }
+}
+
+void telemetry_get_stats(telemetry_stats_t *out) {
+    *out = stats;
+    out->records_dropped = spsc_ring_dropped(&ring);
+}
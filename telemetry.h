@@ -0,0 +1,68 @@
+#ifndef TELEMETRY_H
+#define TELEMETRY_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+// Telemetria binária pela segunda interface CDC do USB
+// O core 1 grava registros de tamanho fixo (IMU, ADC, relés, tempos das
+// tarefas) numa fila SPSC no momento em que acontecem; o core 0 os
+// empacota em quadros e escreve na CDC 1 só o que o host já consegue
+// receber. A CDC 0 continua sendo o console (printf/stdio), usado só pelo
+// core 0 fora de IRQ - o core 1 escreve no console pelo logger (LOG_x).
+//
+// Quadro: COBS(registro || CRC-32 do registro, little-endian) + 0x00.
+// O 0x00 só aparece como delimitador, então o host se ressincroniza no
+// próximo quadro depois de qualquer byte perdido.
+//
+// Pressão de volta: sem host com a porta aberta (DTR) nada é gravado. Com
+// o host lento a fila enche e os registros novos são descartados e
+// contados; o número de sequência de cada registro mostra onde houve perda
+// e um registro TELEMETRY_STATS por segundo traz os contadores.
+
+#define TELEMETRY_CDC_ITF 1            // CDC 0 = console
+#define TELEMETRY_RING_RECORDS 256     // 5 KB
+#define TELEMETRY_STATS_MS 1000
+
+typedef enum {
+    TELEMETRY_IMU = 1,                 // v = accel x/y/z, gyro x/y/z (brutos)
+    TELEMETRY_ADC,                     // arg = canal; v[0] = leitura de 12 bits
+    TELEMETRY_RELAY,                   // arg = zona; v[0] = 1 ligado / 0 desligado
+    TELEMETRY_TIMING,                  // arg = tarefa do core 1; v[0..1] = execução (µs), v[2..3] = atraso (µs)
+    TELEMETRY_STATS,                   // v[0..1] = enviados, v[2..3] = descartados, v[4] = pico da fila
+} telemetry_type_t;
+
+// Registro (20 bytes, little-endian no fio)
+typedef struct {
+    uint8_t type;                      // telemetry_type_t
+    uint8_t arg;
+    uint16_t seq;                      // Contínuo entre registros da fila
+    uint32_t time_us;                  // time_us_32() na origem
+    int16_t v[6];
+} telemetry_record_t;
+
+typedef struct {
+    bool connected;                    // Host com a CDC 1 aberta
+    uint32_t records_sent;
+    uint32_t records_dropped;          // Fila cheia
+    uint32_t bytes_sent;
+    uint16_t ring_peak;                // Maior ocupação da fila
+} telemetry_stats_t;
+
+// Funções públicas
+void telemetry_init(void);                     // Core 0, antes de lançar o core 1
+void telemetry_poll(void);                     // Core 0, loop principal: USB + envio
+
+// Core 1 (produtor único); sem host conectado retornam logo
+void telemetry_imu(const int16_t accel[3], const int16_t gyro[3]);
+void telemetry_adc(uint8_t channel, uint16_t raw);
+void telemetry_relay(uint8_t zone, bool on);
+void telemetry_timing(uint8_t task, uint32_t exec_us, uint32_t jitter_us);
+
+void telemetry_get_stats(telemetry_stats_t *stats);
+
+// COBS sem o 0x00 final; out precisa de len + len / 254 + 1 bytes
+size_t telemetry_cobs_encode(const uint8_t *in, size_t len, uint8_t *out);
+
+#endif // TELEMETRY_H
@@ -0,0 +1,95 @@
+// Gerador de quadros da telemetria para test_telemetry_decode.py
+// Passa registros de padrão conhecido pelo telemetry.c de verdade (fila,
+// CRC, COBS e envio em telemetry_poll) com a porta USB trocada por um
+// arquivo, e codifica com telemetry_cobs_encode() vetores nas bordas do
+// COBS (zeros, sequências de 253/254/255 bytes sem zero) - blocos de
+// 254 bytes não cabem num quadro de 24, então só aparecem aqui.
+//
+// ./ibag_test_telemetry_frames <quadros.bin> <cobs.bin> [iterações]
+// O padrão dos valores (e a ordem imu, adc, relay, timing em cada
+// iteração) está repetido em test_telemetry_decode.py.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "tusb.h"
+#include "telemetry.h"
+
+static FILE *out;
+
+static uint32_t write_out(const void *buf, uint32_t len) {
+    return (uint32_t)fwrite(buf, 1, len, out);
+}
+
+static void frames(uint32_t iterations) {
+    telemetry_init();
+    host_cdc_write = write_out;
+    telemetry_poll();   // Porta aberta: o core 1 passa a gravar (e sai um registro stats)
+
+    for (uint32_t i = 0; i < iterations; i++) {
+        // Zeros, 0xFF e os extremos do int16 nos bytes do registro
+        const int16_t accel[3] = { 0, (int16_t)i, -1 };
+        const int16_t gyro[3] = { INT16_MIN, INT16_MAX, 0x0100 };
+        telemetry_imu(accel, gyro);
+        telemetry_adc((uint8_t)(i % 3), (uint16_t)(i * 37 % 4096));
+        telemetry_relay((uint8_t)(i % 2), i & 1);
+        telemetry_timing((uint8_t)(i % 4), i * 65537u, 0xFFFFFFFFu - i);
+        telemetry_poll();   // Esvazia a fila antes de encher (TELEMETRY_RING_RECORDS)
+    }
+    host_cdc_write = NULL;
+    telemetry_poll();
+}
+
+// Vetor n: tamanho e posição dos zeros; bytes não nulos = (k % 255) + 1
+static size_t cobs_vector(int n, uint8_t *buf) {
+    static const size_t sizes[] = { 0, 1, 2, 2, 253, 254, 255, 508, 509, 600 };
+    size_t len = sizes[n];
+    for (size_t k = 0; k < len; k++) {
+        buf[k] = (uint8_t)(k % 255 + 1);
+    }
+    switch (n) {
+    case 1: buf[0] = 0; break;                  // Só um zero
+    case 2: buf[0] = buf[1] = 0; break;         // Dois zeros
+    case 3: buf[1] = 0; break;                  // Zero no fim
+    case 8: buf[254] = 0; break;                // Zero logo depois de um bloco de 254
+    case 9: buf[0] = buf[599] = 0; break;       // Zeros nas pontas, 598 no meio
+    default: break;
+    }
+    return len;
+}
+
+static void cobs(void) {
+    uint8_t in[600];
+    uint8_t enc[600 + 600 / 254 + 1];
+    for (int n = 0; n < 10; n++) {
+        size_t len = cobs_vector(n, in);
+        size_t m = telemetry_cobs_encode(in, len, enc);
+        fwrite(enc, 1, m, out);
+        fputc(0x00, out);
+    }
+}
+
+int main(int argc, char **argv) {
+    if (argc < 3) {
+        fprintf(stderr, "uso: %s <quadros.bin> <cobs.bin> [iterações]\n", argv[0]);
+        return 2;
+    }
+    uint32_t iterations = argc > 3 ? (uint32_t)strtoul(argv[3], NULL, 0) : 300;
+
+    out = fopen(argv[1], "wb");
+    if (out == NULL) {
+        perror(argv[1]);
+        return 1;
+    }
+    frames(iterations);
+    fclose(out);
+
+    out = fopen(argv[2], "wb");
+    if (out == NULL) {
+        perror(argv[2]);
+        return 1;
+    }
+    cobs();
+    fclose(out);
+    return 0;
+}
@@ -0,0 +1,406 @@
+// Testes da tabela de leases do DHCP (dhcp_leases.c)
+// Dezenas de clientes intercalando DISCOVER/REQUEST/RELEASE/DECLINE contra a
+// tabela de tamanho fixo: OFFER que vence, quarentena do DECLINE, MACs que
+// caem no mesmo slot do hash, tabela e pool cheios e o relógio em ms dando
+// a volta. Depois de cada passo confere os invariantes da tabela (nenhum
+// endereço com dois donos ativos, tudo dentro do pool).
+//
+// ./ibag_test_dhcp_leases [semente] - sai com 1 se alguma verificação falhar
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "dhcp_leases.h"
+
+#define LEASE_MS (DHCP_LEASE_TIME_S * 1000u)
+
+static int failures;
+
+#define CHECK(cond) do { \
+    if (!(cond)) { \
+        printf("FALHA %s:%d: %s\n", __FILE__, __LINE__, #cond); \
+        failures++; \
+    } \
+} while (0)
+
+static void mac_of(uint32_t id, uint8_t mac[6]) {
+    mac[0] = 0x02;   // Administrado localmente
+    mac[1] = 0x00;
+    mac[2] = (uint8_t)(id >> 24);
+    mac[3] = (uint8_t)(id >> 16);
+    mac[4] = (uint8_t)(id >> 8);
+    mac[5] = (uint8_t)id;
+}
+
+// Mesmo FNV-1a do dhcp_leases.c, para montar MACs que colidem
+static uint32_t mac_bucket(const uint8_t mac[6]) {
+    uint32_t h = 2166136261u;
+    for (int i = 0; i < 6; i++) {
+        h = (h ^ mac[i]) * 16777619u;
+    }
+    return h & (DHCP_LEASE_SLOTS - 1);
+}
+
+static const dhcp_lease_t *lease_of(const uint8_t mac[6]) {
+    for (int i = 0; i < DHCP_LEASE_SLOTS; i++) {
+        const dhcp_lease_t *lease = dhcp_lease_slot(i);
+        if (lease->state != DHCP_LEASE_UNUSED && memcmp(lease->mac, mac, 6) == 0) {
+            return lease;
+        }
+    }
+    return NULL;
+}
+
+// Nenhum endereço com dois donos ativos e nenhum fora do pool
+static void check_table(uint32_t now_ms) {
+    uint8_t owners[256] = {0};
+    for (int i = 0; i < DHCP_LEASE_SLOTS; i++) {
+        const dhcp_lease_t *lease = dhcp_lease_slot(i);
+        if (!dhcp_lease_active(lease, now_ms)) {
+            continue;
+        }
+        CHECK(lease->host >= DHCP_POOL_FIRST && lease->host <= DHCP_POOL_LAST);
+        CHECK(owners[lease->host] == 0);
+        owners[lease->host]++;
+        for (int j = 0; j < i; j++) {
+            const dhcp_lease_t *other = dhcp_lease_slot(j);
+            CHECK(other->state == DHCP_LEASE_UNUSED || memcmp(other->mac, lease->mac, 6) != 0);
+        }
+    }
+}
+
+// DISCOVER + REQUEST
+static uint8_t join(const uint8_t mac[6], uint32_t now_ms) {
+    uint8_t host = dhcp_lease_offer(mac, 0, now_ms);
+    if (host != 0 && !dhcp_lease_commit(mac, host, now_ms)) {
+        return 0;
+    }
+    return host;
+}
+
+static void test_many_clients(void) {
+    dhcp_leases_init();
+    uint32_t now = 1000;
+    uint8_t hosts[24];
+    uint8_t mac[6];
+
+    // OFFERs de todos antes de qualquer REQUEST, como numa sala ligando junto
+    for (uint32_t c = 0; c < 24; c++) {
+        mac_of(c, mac);
+        hosts[c] = dhcp_lease_offer(mac, 0, now + c);
+        CHECK(hosts[c] != 0);
+        check_table(now + c);
+    }
+    for (uint32_t c = 0; c < 24; c++) {
+        for (uint32_t d = 0; d < c; d++) {
+            CHECK(hosts[c] != hosts[d]);
+        }
+    }
+    // REQUESTs em ordem inversa; retransmissão do DISCOVER mantém o endereço
+    for (int c = 23; c >= 0; c--) {
+        mac_of((uint32_t)c, mac);
+        CHECK(dhcp_lease_offer(mac, 0, now + 100) == hosts[c]);
+        CHECK(dhcp_lease_commit(mac, hosts[c], now + 100));
+        const dhcp_lease_t *lease = lease_of(mac);
+        CHECK(lease != NULL && lease->state == DHCP_LEASE_BOUND && lease->host == hosts[c]);
+    }
+    check_table(now + 100);
+
+    // Pedir o endereço de outro cliente ativo: NAK
+    mac_of(0, mac);
+    CHECK(!dhcp_lease_commit(mac, hosts[1], now + 200));
+    // Opção 50 com endereço alheio é ignorada no OFFER
+    mac_of(100, mac);
+    uint8_t host = dhcp_lease_offer(mac, hosts[2], now + 200);
+    CHECK(host != 0 && host != hosts[2]);
+
+    // Só a primeira página depois do bind conta
+    uint32_t join_ms = 0;
+    CHECK(dhcp_lease_first_page(hosts[5], now + 1100, &join_ms));
+    CHECK(join_ms == 1000);
+    CHECK(!dhcp_lease_first_page(hosts[5], now + 1200, &join_ms));
+    // Renovação não reinicia a associação
+    mac_of(5, mac);
+    CHECK(dhcp_lease_commit(mac, hosts[5], now + LEASE_MS / 2));
+    CHECK(!dhcp_lease_first_page(hosts[5], now + LEASE_MS / 2, &join_ms));
+    check_table(now + LEASE_MS / 2);
+}
+
+static void test_offer_timeout(void) {
+    dhcp_leases_init();
+    uint8_t a[6], b[6];
+    mac_of(1, a);
+    mac_of(2, b);
+
+    uint8_t host = dhcp_lease_offer(a, 0, 0);
+    CHECK(host != 0);
+    // Ainda reservado para 'a' durante o timeout do OFFER
+    CHECK(dhcp_lease_offer(b, host, DHCP_OFFER_TIMEOUT_MS - 1) != host);
+    CHECK(!dhcp_lease_commit(b, host, DHCP_OFFER_TIMEOUT_MS - 1));
+    // Vencido: 'b' pode pedir o mesmo endereço e 'a' perde a reserva
+    CHECK(dhcp_lease_commit(b, host, DHCP_OFFER_TIMEOUT_MS));
+    CHECK(!dhcp_lease_commit(a, host, DHCP_OFFER_TIMEOUT_MS + 1));
+    uint8_t other = dhcp_lease_offer(a, 0, DHCP_OFFER_TIMEOUT_MS + 1);
+    CHECK(other != 0 && other != host);
+    check_table(DHCP_OFFER_TIMEOUT_MS + 1);
+}
+
+static void test_release(void) {
+    dhcp_leases_init();
+    uint8_t a[6], b[6];
+    mac_of(1, a);
+    mac_of(2, b);
+
+    uint8_t host = join(a, 0);
+    CHECK(host != 0);
+    // RELEASE com endereço errado é ignorado
+    dhcp_lease_release(a, (uint8_t)(host + 1));
+    CHECK(lease_of(a)->state == DHCP_LEASE_BOUND);
+
+    dhcp_lease_release(a, host);
+    CHECK(lease_of(a)->state == DHCP_LEASE_FREE);
+    CHECK(!dhcp_lease_first_page(host, 10, &(uint32_t){0}));
+    // O cliente volta e recebe o mesmo endereço
+    CHECK(join(a, 20) == host);
+    // Liberado de novo, o endereço pode ir para outro
+    dhcp_lease_release(a, host);
+    CHECK(dhcp_lease_offer(b, host, 30) == host);
+    CHECK(dhcp_lease_commit(b, host, 30));
+    // E 'a' recebe outro, sem tomar o de 'b'
+    uint8_t again = join(a, 40);
+    CHECK(again != 0 && again != host);
+    check_table(40);
+}
+
+static void test_decline_quarantine(void) {
+    dhcp_leases_init();
+    uint8_t a[6], b[6];
+    mac_of(1, a);
+    mac_of(2, b);
+
+    uint8_t host = dhcp_lease_offer(a, 0, 0);
+    CHECK(dhcp_lease_commit(a, host, 0));
+    // Conflito ARP: o endereço fica em quarentena para todos
+    dhcp_lease_decline(a, host, 100);
+    CHECK(lease_of(a)->state == DHCP_LEASE_FREE && lease_of(a)->host == 0);
+    CHECK(dhcp_lease_offer(a, host, 200) != host);
+    CHECK(!dhcp_lease_commit(b, host, 200));
+    CHECK(!dhcp_lease_commit(b, host, 100 + DHCP_DECLINE_QUARANTINE_MS - 1));
+    // Fim da quarentena
+    CHECK(dhcp_lease_commit(b, host, 100 + DHCP_DECLINE_QUARANTINE_MS));
+
+    // DECLINE fora do pool não quebra nada
+    dhcp_lease_decline(a, 0, 300);
+    dhcp_lease_decline(a, 255, 300);
+
+    // Pool inteiro em quarentena: sem OFFER até a primeira sair
+    dhcp_leases_init();
+    for (int h = DHCP_POOL_FIRST; h <= DHCP_POOL_LAST; h++) {
+        dhcp_lease_decline(a, (uint8_t)h, (uint32_t)h);
+    }
+    CHECK(dhcp_lease_offer(b, 0, 1000) == 0);
+    CHECK(dhcp_lease_offer(b, 0, DHCP_POOL_FIRST + DHCP_DECLINE_QUARANTINE_MS) == DHCP_POOL_FIRST);
+}
+
+// MACs diferentes no mesmo slot inicial: sondagem linear até o próximo livre
+static void test_collisions(void) {
+    dhcp_leases_init();
+    uint8_t macs[8][6];
+    int found = 0;
+    uint8_t first[6];
+    mac_of(0, first);
+    uint32_t bucket = mac_bucket(first);
+    memcpy(macs[found++], first, 6);
+    for (uint32_t id = 1; found < 8; id++) {
+        uint8_t mac[6];
+        mac_of(id, mac);
+        if (mac_bucket(mac) == bucket) {
+            memcpy(macs[found++], mac, 6);
+        }
+    }
+
+    uint8_t hosts[8];
+    for (int i = 0; i < 8; i++) {
+        hosts[i] = join(macs[i], (uint32_t)i);
+        CHECK(hosts[i] != 0);
+        for (int j = 0; j < i; j++) {
+            CHECK(hosts[i] != hosts[j]);
+        }
+    }
+    // Todos em slots distintos, em sequência a partir do mesmo início
+    for (int i = 0; i < 8; i++) {
+        const dhcp_lease_t *lease = dhcp_lease_slot((int)((bucket + (uint32_t)i) & (DHCP_LEASE_SLOTS - 1)));
+        CHECK(memcmp(lease->mac, macs[i], 6) == 0);
+    }
+    // Liberar um do meio não corta a cadeia: os seguintes continuam achados
+    dhcp_lease_release(macs[3], hosts[3]);
+    for (int i = 4; i < 8; i++) {
+        CHECK(dhcp_lease_offer(macs[i], 0, 100) == hosts[i]);
+        CHECK(dhcp_lease_commit(macs[i], hosts[i], 100));
+    }
+    CHECK(join(macs[3], 100) == hosts[3]);
+    check_table(100);
+}
+
+static void test_table_full(void) {
+    dhcp_leases_init();
+    uint8_t mac[6];
+    uint8_t hosts[DHCP_LEASE_SLOTS];
+    for (uint32_t c = 0; c < DHCP_LEASE_SLOTS; c++) {
+        mac_of(c, mac);
+        hosts[c] = join(mac, 0);
+        CHECK(hosts[c] != 0);
+    }
+    check_table(0);
+
+    // Todas as entradas ativas: o próximo cliente fica sem OFFER e leva NAK
+    uint8_t extra[6];
+    mac_of(1000, extra);
+    CHECK(dhcp_lease_offer(extra, 0, 10) == 0);
+    CHECK(!dhcp_lease_commit(extra, DHCP_POOL_LAST, 10));
+    // Os que já estão na tabela continuam renovando
+    mac_of(7, mac);
+    CHECK(dhcp_lease_commit(mac, hosts[7], 20));
+
+    // Um cliente libera: a entrada dele é reaproveitada
+    mac_of(3, mac);
+    dhcp_lease_release(mac, hosts[3]);
+    uint8_t host = join(extra, 30);
+    CHECK(host != 0);
+    CHECK(lease_of(mac) == NULL);
+    check_table(30);
+
+    // Leases vencidas também liberam entradas (todas menos a 7, renovada em 20)
+    uint8_t late[6];
+    mac_of(2000, late);
+    CHECK(dhcp_lease_offer(late, 0, LEASE_MS - 1) == 0);
+    CHECK(join(late, LEASE_MS) != 0);
+    check_table(LEASE_MS);
+}
+
+// Relógio em ms dando a volta em ~49 dias no meio das leases
+static void test_clock_wrap(void) {
+    dhcp_leases_init();
+    uint8_t a[6], b[6];
+    mac_of(1, a);
+    mac_of(2, b);
+    uint32_t t0 = 0xFFFFFFFFu - 1000;
+
+    uint8_t host = join(a, t0);
+    CHECK(host != 0);
+    // Depois da volta a lease ainda vale
+    CHECK(dhcp_lease_active(lease_of(a), t0 + 5000));
+    CHECK(!dhcp_lease_commit(b, host, t0 + 5000));
+    // E vence no prazo certo
+    CHECK(!dhcp_lease_active(lease_of(a), t0 + LEASE_MS));
+    CHECK(dhcp_lease_commit(b, host, t0 + LEASE_MS));
+
+    // Quarentena atravessando a volta
+    dhcp_lease_decline(b, host, t0);
+    CHECK(!dhcp_lease_commit(a, host, t0 + 5000));
+    CHECK(dhcp_lease_commit(a, host, t0 + DHCP_DECLINE_QUARANTINE_MS));
+}
+
+// Passos aleatórios de 48 clientes (mais que DHCP_LEASE_SLOTS) com os
+// invariantes conferidos a cada passo
+static uint32_t rng_state;
+
+static uint32_t rng(void) {
+    rng_state ^= rng_state << 13;
+    rng_state ^= rng_state >> 17;
+    rng_state ^= rng_state << 5;
+    return rng_state;
+}
+
+static void test_random(uint32_t seed) {
+    enum { CLIENTS = 48, STEPS = 200000 };
+    uint8_t offered[CLIENTS] = {0};
+    uint8_t bound[CLIENTS] = {0};
+    uint32_t bound_until[CLIENTS] = {0};
+    uint32_t now = 0xFFFFFFFFu - 600000;   // Passa pela volta do relógio
+    rng_state = seed ? seed : 1;
+    dhcp_leases_init();
+
+    for (int step = 0; step < STEPS; step++) {
+        uint32_t c = rng() % CLIENTS;
+        uint8_t mac[6];
+        mac_of(c, mac);
+        now += rng() % 2000;
+
+        switch (rng() % 8) {
+        case 0:
+        case 1:
+        case 2:
+            // DISCOVER: o cliente recomeçou e esquece a lease (opção 50 às vezes aleatória)
+            offered[c] = dhcp_lease_offer(mac, (uint8_t)(rng() % 4 == 0 ? rng() : bound[c]), now);
+            bound[c] = 0;
+            break;
+        case 3:
+        case 4:
+            if (offered[c] != 0 && dhcp_lease_commit(mac, offered[c], now)) {
+                bound[c] = offered[c];
+                bound_until[c] = now + LEASE_MS;
+            }
+            break;
+        case 5:
+            if (bound[c] != 0) {
+                dhcp_lease_release(mac, bound[c]);
+                bound[c] = 0;
+            }
+            break;
+        case 6:
+            if (offered[c] != 0 && rng() % 16 == 0) {
+                dhcp_lease_decline(mac, offered[c], now);
+                if (bound[c] == offered[c]) {
+                    bound[c] = 0;
+                }
+                offered[c] = 0;
+            }
+            break;
+        default:
+            // INIT-REBOOT com o endereço que o cliente lembra
+            if (bound[c] != 0 && dhcp_lease_commit(mac, bound[c], now)) {
+                bound_until[c] = now + LEASE_MS;
+            }
+            break;
+        }
+        check_table(now);
+
+        // Um cliente com lease válida no modelo tem a entrada ativa com o endereço dele
+        for (uint32_t k = 0; k < CLIENTS; k++) {
+            if (bound[k] != 0 && (int32_t)(bound_until[k] - now) > 0) {
+                uint8_t kmac[6];
+                mac_of(k, kmac);
+                const dhcp_lease_t *lease = lease_of(kmac);
+                CHECK(lease != NULL);
+                if (lease != NULL && lease->state == DHCP_LEASE_BOUND) {
+                    CHECK(lease->host == bound[k]);
+                }
+            }
+        }
+        if (failures > 20) {
+            printf("seed %lu, passo %d: parando\n", (unsigned long)seed, step);
+            return;
+        }
+    }
+}
+
+int main(int argc, char **argv) {
+    uint32_t seed = argc > 1 ? (uint32_t)strtoul(argv[1], NULL, 0) : 12345;
+
+    test_many_clients();
+    test_offer_timeout();
+    test_release();
+    test_decline_quarantine();
+    test_collisions();
+    test_table_full();
+    test_clock_wrap();
+    test_random(seed);
+
+    if (failures) {
+        printf("%d falha(s)\n", failures);
+        return 1;
+    }
+    printf("dhcp_leases: ok (seed %lu)\n", (unsigned long)seed);
+    return 0;
+}
@@ -0,0 +1,388 @@
+// Testes do histórico comprimido (history.c) sobre a flash simulada
+// Linhas aleatórias que voltam iguais depois de passar pelos blocos da RAM e
+// da flash, o custo em bits de cada faixa de delta nas fronteiras (±8, ±128,
+// ±2048 e 32 bits), um bloco cheio de linhas do pior caso
+// (HISTORY_ROW_MAX_BITS) e history_init() depois de um reboot limpo e com o
+// bloco mais novo cortado no meio da gravação (CRC errado).
+//
+// ./ibag_test_history [semente] - sai com 1 se alguma verificação falhar
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "pico/stdlib.h"
+#include "hal.h"
+#include "history.h"
+
+#define HISTORY_MAGIC 0x54534948       // Mesmo do history.c
+#define PAYLOAD_BITS (int)(sizeof(((history_block_t *)0)->payload) * 8)
+
+static int failures;
+
+#define CHECK(cond) do { \
+    if (!(cond)) { \
+        printf("FALHA %s:%d: %s\n", __FILE__, __LINE__, #cond); \
+        failures++; \
+    } \
+} while (0)
+
+static uint32_t rng_state;
+
+static uint32_t rng(void) {
+    rng_state ^= rng_state << 13;
+    rng_state ^= rng_state >> 17;
+    rng_state ^= rng_state << 5;
+    return rng_state;
+}
+
+// Flash inteira apagada e histórico vazio, como numa placa nova
+static void fresh_history(void) {
+    memset(host_flash, 0xFF, PICO_FLASH_SIZE_BYTES);
+    history_init();
+}
+
+static bool row_equal(const history_row_t *a, const history_row_t *b) {
+    return a->time_s == b->time_s && a->heater == b->heater && a->conservative == b->conservative &&
+           a->vibration_mg == b->vibration_mg && a->relays == b->relays && a->shakes == b->shakes;
+}
+
+// Bits de um delta em cada faixa (0 | 10+4 | 110+8 | 1110+12 | 1111+32)
+static int signed_bits(int32_t v) {
+    if (v == 0) return 1;
+    if (v >= -8 && v < 8) return 6;
+    if (v >= -128 && v < 128) return 11;
+    if (v >= -2048 && v < 2048) return 16;
+    return 36;
+}
+
+// Todas as linhas ainda guardadas, do bloco mais antigo ao aberto
+static int read_all(history_row_t *out, int max) {
+    int n = 0;
+    for (uint32_t seq = history_oldest_seq(); (int32_t)(seq - history_open_seq()) <= 0; seq++) {
+        const history_block_t *b = history_block(seq);
+        if (b == NULL) {
+            continue;
+        }
+        history_reader_t reader;
+        history_row_t row;
+        history_reader_init(&reader, b);
+        while (history_reader_next(&reader, &row) && n < max) {
+            out[n++] = row;
+        }
+    }
+    return n;
+}
+
+// Copia os blocos fechados para a flash (uma etapa por execução da tarefa)
+static void spill_all(void) {
+    history_stats_t st;
+    for (int i = 0; i < 10000; i++) {
+        history_get_stats(&st);
+        if (st.blocks_spilled == st.blocks_sealed) {
+            return;
+        }
+        history_task(NULL);
+    }
+    CHECK(st.blocks_spilled == st.blocks_sealed);
+}
+
+// Bloco de sequência seq gravado na flash (NULL se não houver)
+static history_block_t *flash_find(uint32_t seq) {
+    for (size_t off = 0; off + HISTORY_BLOCK_SIZE <= PICO_FLASH_SIZE_BYTES; off += HISTORY_BLOCK_SIZE) {
+        history_block_t *b = (history_block_t *)&host_flash[off];
+        if (b->hdr.magic == HISTORY_MAGIC && b->hdr.seq == seq && b->hdr.count != 0xFFFF) {
+            return b;
+        }
+    }
+    return NULL;
+}
+
+// Relógio do histórico retomado no boot (history_now_s sem o tempo desde o boot)
+static uint32_t time_base(void) {
+    uint32_t up = (uint32_t)((hal_time_us64() + 500000) / 1000000);
+    return history_now_s() - up;
+}
+
+static bool time_base_is(uint32_t expected) {
+    uint32_t base = time_base();
+    return base == expected || base == expected + 1;   // O segundo pode virar entre as leituras
+}
+
+// --- Linhas aleatórias: tudo que entra sai igual ---
+
+static int32_t random_delta(void) {
+    switch (rng() % 6) {
+    case 0: return 0;
+    case 1: return (int32_t)(rng() % 16) - 8;
+    case 2: return (int32_t)(rng() % 256) - 128;
+    case 3: return (int32_t)(rng() % 4096) - 2048;
+    case 4: return (int32_t)(rng() % 60000) - 30000;
+    default: return (int32_t)(rng() % 3) - 1;
+    }
+}
+
+static int16_t random_temp(int16_t prev) {
+    if (rng() % 50 == 0) {
+        return HISTORY_NO_TEMP;
+    }
+    int32_t v = (prev == HISTORY_NO_TEMP ? 250 : prev) + random_delta();
+    if (v <= INT16_MIN || v > INT16_MAX) {
+        v = (int32_t)(rng() % 2000) - 500;
+    }
+    return (int16_t)v;
+}
+
+static void test_round_trip(uint32_t seed) {
+    enum { ROWS = 6000 };
+    static history_row_t expected[ROWS];
+    static history_row_t got[ROWS + 1];
+    rng_state = seed ? seed : 1;
+    fresh_history();
+
+    history_row_t row = { .time_s = 1000, .heater = 250, .conservative = 80 };
+    for (int i = 0; i < ROWS; i++) {
+        switch (rng() % 8) {
+        case 0: row.time_s += rng() % 100000; break;   // Desligado por um tempo
+        case 1: row.time_s += 2; break;
+        default: row.time_s += 1; break;
+        }
+        row.heater = random_temp(row.heater);
+        row.conservative = random_temp(row.conservative);
+        int32_t vib = (int32_t)row.vibration_mg + random_delta() * HISTORY_VIB_STEP_MG + (int32_t)(rng() % 8);
+        row.vibration_mg = (uint16_t)(vib < 0 ? 0 : vib > UINT16_MAX ? UINT16_MAX : vib);
+        row.relays = (uint8_t)(rng() % 4 == 0 ? rng() & 3 : row.relays);
+        row.shakes = (uint8_t)(rng() % 10 == 0 ? rng() : 0);
+
+        history_append(&row);
+        expected[i] = row;
+        expected[i].vibration_mg -= row.vibration_mg % HISTORY_VIB_STEP_MG;
+        history_task(NULL);   // Mais linhas que o anel da RAM: parte sai da flash
+    }
+
+    history_stats_t st;
+    history_get_stats(&st);
+    CHECK(st.rows == ROWS);
+    CHECK(st.blocks_sealed > HISTORY_RAM_BLOCKS);
+    CHECK(st.blocks_lost == 0);
+
+    int n = read_all(got, ROWS + 1);
+    CHECK(n == ROWS);
+    for (int i = 0; i < n && i < ROWS; i++) {
+        if (!row_equal(&got[i], &expected[i])) {
+            printf("seed %lu, linha %d: t=%lu/%lu heater=%d/%d cons=%d/%d vib=%u/%u\n", (unsigned long)seed, i,
+                   (unsigned long)got[i].time_s, (unsigned long)expected[i].time_s, got[i].heater, expected[i].heater,
+                   got[i].conservative, expected[i].conservative, got[i].vibration_mg, expected[i].vibration_mg);
+            CHECK(row_equal(&got[i], &expected[i]));
+            break;
+        }
+    }
+}
+
+// --- Fronteiras das faixas de delta ---
+
+static const int32_t boundaries[] = {
+    0, 1, -1, 7, -8, 8, -9, 127, -128, 128, -129, 2047, -2048, 2048, -2049, 4000, -4000,
+};
+
+// Acrescenta e devolve os bits que a linha ocupou no bloco aberto
+static int append_bits(const history_row_t *row) {
+    uint32_t seq = history_open_seq();
+    const history_block_t *b = history_block(seq);
+    int before = b ? b->hdr.bits : 0;
+    history_append(row);
+    CHECK(history_open_seq() == seq);   // Nenhuma linha deste teste fecha o bloco
+    b = history_block(seq);
+    return b ? b->hdr.bits - before : -1;
+}
+
+enum { FIELD_TIME, FIELD_HEATER, FIELD_CONSERVATIVE, FIELD_VIBRATION, FIELD_COUNT };
+
+static void test_boundaries(void) {
+    static const char *const names[FIELD_COUNT] = { "tempo", "heater", "cons", "vib" };
+    for (int field = 0; field < FIELD_COUNT; field++) {
+        fresh_history();
+        history_row_t base = { .time_s = 100000, .heater = 0, .conservative = 0, .vibration_mg = 4096 * HISTORY_VIB_STEP_MG };
+        history_row_t expected[1 + 2 * sizeof(boundaries) / sizeof(boundaries[0])];
+        int count = 0;
+        history_append(&base);   // Primeira linha: crua no cabeçalho
+        expected[count++] = base;
+
+        history_row_t row = base;
+        for (size_t k = 0; k < sizeof(boundaries) / sizeof(boundaries[0]); k++) {
+            int32_t v = boundaries[k];
+            // Ida com delta v e volta com -v; no tempo o delta-do-delta é v e depois -v
+            for (int leg = 0; leg < 2; leg++) {
+                int32_t d = leg == 0 ? v : -v;
+                row.time_s += 1;
+                switch (field) {
+                case FIELD_TIME: row.time_s += (uint32_t)(leg == 0 ? v : 0); break;
+                case FIELD_HEATER: row.heater = (int16_t)(row.heater + d); break;
+                case FIELD_CONSERVATIVE: row.conservative = (int16_t)(row.conservative + d); break;
+                default: row.vibration_mg = (uint16_t)(row.vibration_mg + d * HISTORY_VIB_STEP_MG); break;
+                }
+                // Tempo, três deltas, relés e viradas: 1 bit cada quando não mudam
+                int bits = append_bits(&row);
+                if (bits != signed_bits(d) + 5) {
+                    printf("%s: delta %ld ocupou %d bits (esperado %d)\n", names[field], (long)d, bits,
+                           signed_bits(d) + 5);
+                }
+                CHECK(bits == signed_bits(d) + 5);
+                expected[count++] = row;
+            }
+        }
+
+        history_row_t got[1 + 2 * sizeof(boundaries) / sizeof(boundaries[0]) + 1];
+        int n = read_all(got, count + 1);
+        CHECK(n == count);
+        for (int i = 0; i < n && i < count; i++) {
+            CHECK(row_equal(&got[i], &expected[i]));
+        }
+    }
+
+    // Extremos de 32 bits no tempo (saltos grandes) e de 16 bits nas temperaturas
+    fresh_history();
+    history_row_t a = { .time_s = 10, .heater = INT16_MIN + 1, .conservative = INT16_MAX, .vibration_mg = 0 };
+    history_row_t b = { .time_s = 0xF0000000u, .heater = INT16_MAX, .conservative = INT16_MIN + 1,
+                        .vibration_mg = UINT16_MAX - UINT16_MAX % HISTORY_VIB_STEP_MG, .relays = 3, .shakes = 255 };
+    history_append(&a);
+    CHECK(append_bits(&b) == HISTORY_ROW_MAX_BITS);
+    history_row_t got[3];
+    CHECK(read_all(got, 3) == 2);
+    CHECK(row_equal(&got[0], &a));
+    CHECK(row_equal(&got[1], &b));
+}
+
+// --- Bloco cheio de linhas do pior caso ---
+
+static void test_full_block(void) {
+    enum { ROWS = 80 };
+    static history_row_t expected[ROWS];
+    static history_row_t got[ROWS + 1];
+    fresh_history();
+
+    // Cada linha muda tudo o mais longe possível: 4 deltas de 36 bits,
+    // relés trocando e viradas. Nenhum intervalo é de 1 s, então nem a
+    // segunda linha de um bloco (delta anterior = 1 s) sai barata
+    uint32_t t = 1000;
+    for (int i = 0; i < ROWS; i++) {
+        bool odd = i & 1;
+        t += odd ? 1000000 : 3000000;
+        history_row_t row = {
+            .time_s = t,
+            .heater = odd ? 30000 : -30000,
+            .conservative = odd ? -30000 : 30000,
+            .vibration_mg = odd ? UINT16_MAX - UINT16_MAX % HISTORY_VIB_STEP_MG : 0,
+            .relays = odd ? 3 : 0,
+            .shakes = (uint8_t)(odd ? 255 : 1),
+        };
+        uint32_t seq = history_open_seq();
+        const history_block_t *b = history_block(seq);
+        int before = b ? b->hdr.bits : 0;
+        int count_before = b ? b->hdr.count : 0;
+        history_append(&row);
+        expected[i] = row;
+
+        if (history_open_seq() != seq) {
+            // Fechou só quando mais uma linha do pior caso não caberia
+            CHECK(before + HISTORY_ROW_MAX_BITS > PAYLOAD_BITS);
+            CHECK(count_before == 1 + PAYLOAD_BITS / HISTORY_ROW_MAX_BITS);
+            CHECK(history_block(history_open_seq())->hdr.bits == 0);   // Linha crua no cabeçalho
+        } else if (count_before > 0) {
+            CHECK(b->hdr.bits - before == HISTORY_ROW_MAX_BITS);
+            CHECK(b->hdr.bits <= PAYLOAD_BITS);
+        }
+    }
+
+    history_stats_t st;
+    history_get_stats(&st);
+    CHECK(st.blocks_sealed == (uint32_t)(ROWS / (1 + PAYLOAD_BITS / HISTORY_ROW_MAX_BITS)));
+    int n = read_all(got, ROWS + 1);
+    CHECK(n == ROWS);
+    for (int i = 0; i < n && i < ROWS; i++) {
+        CHECK(row_equal(&got[i], &expected[i]));
+    }
+}
+
+// --- Reboot: limpo e com o bloco mais novo cortado ---
+
+static void test_init_after_reboot(void) {
+    fresh_history();
+    history_stats_t st;
+    history_get_stats(&st);
+    uint16_t boot = st.boot;
+
+    // Alguns blocos na flash; o aberto (na RAM) se perde no reboot
+    history_row_t row = { .time_s = 5000, .heater = 400, .conservative = 90, .vibration_mg = 64 };
+    rng_state = 99;
+    while (history_open_seq() < 5) {
+        row.time_s++;
+        row.heater = (int16_t)(400 + (int32_t)(rng() % 200) - 100);
+        row.vibration_mg = (uint16_t)((rng() % 64) * HISTORY_VIB_STEP_MG);
+        history_append(&row);
+    }
+    spill_all();
+    uint32_t newest = history_open_seq() - 1;
+
+    history_block_t *torn = flash_find(newest);
+    CHECK(torn != NULL);
+    if (torn == NULL) {
+        return;
+    }
+    history_reader_t reader;
+    history_row_t last;
+    history_reader_init(&reader, torn);
+    while (history_reader_next(&reader, &last)) {
+    }
+    uint32_t first_time = torn->hdr.first.time_s;
+
+    // Reboot limpo: continua depois da última linha gravada
+    history_init();
+    history_get_stats(&st);
+    CHECK(st.boot == (uint16_t)(boot + 1));
+    CHECK(st.flash_blocks == newest + 1);
+    CHECK(history_open_seq() == newest + 1);
+    CHECK(history_block(newest) != NULL);
+    CHECK(time_base_is(last.time_s + 1));
+
+    // Queda no meio da gravação: a segunda metade do bloco ficou apagada
+    memset((uint8_t *)torn + HISTORY_BLOCK_SIZE / 2, 0xFF, HISTORY_BLOCK_SIZE / 2);
+    history_init();
+    history_get_stats(&st);
+    CHECK(st.boot == (uint16_t)(boot + 1));   // O cabeçalho ainda é legível
+    CHECK(history_open_seq() == newest + 1);
+    CHECK(history_block(newest) == NULL);     // CRC não fecha
+    CHECK(time_base_is(first_time + 1));
+
+    // Os anteriores continuam legíveis e as linhas novas vão para o próximo bloco
+    const history_block_t *prev = history_block(newest - 1);
+    CHECK(prev != NULL);
+    if (prev != NULL) {
+        history_reader_init(&reader, prev);
+        int rows = 0;
+        while (history_reader_next(&reader, &last)) {
+            rows++;
+        }
+        CHECK(rows == prev->hdr.count);
+    }
+    row.time_s = history_now_s();
+    history_append(&row);
+    const history_block_t *open = history_block(newest + 1);
+    CHECK(open != NULL);
+    CHECK(open != NULL && open->hdr.boot == (uint16_t)(boot + 1) && open->hdr.count == 1);
+}
+
+int main(int argc, char **argv) {
+    uint32_t seed = argc > 1 ? (uint32_t)strtoul(argv[1], NULL, 0) : 12345;
+
+    test_round_trip(seed);
+    test_boundaries();
+    test_full_block();
+    test_init_after_reboot();
+
+    if (failures) {
+        printf("%d falha(s)\n", failures);
+        return 1;
+    }
+    printf("history: ok (seed %lu)\n", (unsigned long)seed);
+    return 0;
+}
@@ -0,0 +1,179 @@
+#!/usr/bin/env python3
+"""Quadros do telemetry.c (build do host) pelo tools/telemetry_decode.py.
+
+Uso: test_telemetry_decode.py <ibag_test_telemetry_frames> <gravação.bin>
+
+1. Roda o gerador (test/telemetry_frames.c), decodifica os quadros que o
+   telemetry.c escreveu e confere contagens e cada valor contra o padrão.
+2. Confere o cobs_decode() do Python contra os vetores de borda (zeros,
+   blocos de 254 bytes) codificados pelo telemetry_cobs_encode() do C.
+3. Decodifica a gravação guardada em test/data/ (saída do gerador com lixo
+   inicial, quadros descartados, CRC trocado, quadro cortado e um pedaço
+   sem delimitador no fim) pelo mesmo caminho do --out e confere os CSV.
+
+Sai com 1 se alguma verificação falhar.
+"""
+
+import csv
+import os
+import subprocess
+import sys
+import tempfile
+
+sys.path.insert(0, os.path.join(os.path.dirname(os.path.abspath(__file__)), '..', 'tools'))
+import telemetry_decode as td  # noqa: E402
+
+ITERATIONS = 300
+failures = 0
+
+
+def check(name, got, want):
+    global failures
+    if got != want:
+        failures += 1
+        print('FALHA %s: obtido %.80r, esperado %.80r' % (name, got, want))
+
+
+def s16(x):
+    x &= 0xFFFF
+    return x - 0x10000 if x > 0x7FFF else x
+
+
+def expected(kind, i):
+    """Linha (sem o tempo) do registro da iteração i - mesmo padrão do telemetry_frames.c."""
+    seq = 4 * i + ['imu', 'adc', 'relay', 'timing'].index(kind)
+    if kind == 'imu':
+        return [seq, 0, s16(i), -1, -0x8000, 0x7FFF, 0x0100]
+    if kind == 'adc':
+        return [seq, i % 3, i * 37 % 4096]
+    if kind == 'relay':
+        return [seq, i % 2, i & 1]
+    return [seq, i % 4, i * 65537 & 0xFFFFFFFF, 0xFFFFFFFF - i]
+
+
+def check_rows(label, rows, skip=()):
+    """rows: {tipo: [linha, ...]}; skip: sequências descartadas de propósito."""
+    for kind in ('imu', 'adc', 'relay', 'timing'):
+        want = [expected(kind, i) for i in range(ITERATIONS)]
+        want = [w for w in want if w[0] not in skip]
+        got = [r[1:] for r in rows.get(kind, [])]
+        check('%s: registros %s' % (label, kind), len(got), len(want))
+        bad = [(g, w) for g, w in zip(got, want) if g != w]
+        check('%s: valores %s' % (label, kind), bad[:1], [])
+    # Tempo desdobrado para 64 bits: nunca volta na ordem da sequência
+    times = [r[0] for _, r in sorted((r[1], r) for kind in rows if kind != 'stats' for r in rows[kind])]
+    check('%s: tempo em ordem' % label, all(a <= b for a, b in zip(times, times[1:])), True)
+
+
+def frames_from_generator(generator, tmp):
+    frames = os.path.join(tmp, 'quadros.bin')
+    vectors = os.path.join(tmp, 'cobs.bin')
+    subprocess.run([generator, frames, vectors, str(ITERATIONS)], check=True)
+    with open(frames, 'rb') as f:
+        stream = f.read()
+    with open(vectors, 'rb') as f:
+        cobs = f.read()
+    return stream, cobs
+
+
+def test_frames(stream):
+    dec = td.Decoder()
+    rows = {}
+    for kind, row in dec.feed(stream):
+        rows.setdefault(kind, []).append(row)
+    check('quadros: inválidos', dec.bad_frames, 0)
+    check('quadros: perdidos', dec.lost, 0)
+    check('quadros: resto no buffer', len(dec.buf), 0)
+    stats = rows.get('stats', [])
+    check('quadros: stats', len(stats) >= 1, True)
+    check('quadros: primeiro stats', stats[0][1:3] if stats else None, [0, 0])
+    check('quadros: total', dec.frames, 4 * ITERATIONS + len(stats))
+    check_rows('quadros', rows)
+
+
+def cobs_vector(n):
+    sizes = [0, 1, 2, 2, 253, 254, 255, 508, 509, 600]
+    buf = bytearray((k % 255) + 1 for k in range(sizes[n]))
+    zeros = {1: [0], 2: [0, 1], 3: [1], 8: [254], 9: [0, 599]}
+    for k in zeros.get(n, []):
+        buf[k] = 0
+    return bytes(buf)
+
+
+def test_cobs(cobs):
+    chunks = cobs.split(b'\x00')
+    check('cobs: vetores', len(chunks), 10 + 1)   # + o vazio depois do último 0x00
+    for n, chunk in enumerate(chunks[:10]):
+        vec = cobs_vector(n)
+        check('cobs: vetor %d (%d bytes) decodificado' % (n, len(vec)), td.cobs_decode(chunk), vec)
+        check('cobs: vetor %d igual ao encoder do Python' % n, chunk, td.cobs_encode(vec))
+
+
+def test_recording(path, tmp):
+    out = os.path.join(tmp, 'out')
+    with open(path, 'rb') as src:
+        dec, counts = td.decode(src, td.CsvSink(out))
+    rows = {}
+    for kind in td.COLUMNS:
+        with open(os.path.join(out, kind + '.csv')) as f:
+            lines = list(csv.reader(f))
+        check('gravação: cabeçalho %s' % kind, lines[0], td.COLUMNS[kind])
+        rows[kind] = [[int(x) for x in line] for line in lines[1:]]
+
+    # Descartados de propósito ao montar a gravação (ver make_recording):
+    # 3 omitidos, 1 com CRC trocado e 1 cortado
+    skip = {100, 101, 102, 500, 900}
+    check('gravação: quadros válidos', dec.frames, 4 * ITERATIONS + counts['stats'] - len(skip))
+    check('gravação: inválidos', dec.bad_frames, 3)   # Lixo inicial + CRC + cortado
+    check('gravação: perdidos', dec.lost, len(skip))
+    check('gravação: stats', counts['stats'], 1)
+    check('gravação: resto sem delimitador', len(dec.buf) > 0, True)
+    check_rows('gravação', rows, skip)
+
+
+def make_recording(stream, path):
+    """Monta a gravação de test/data/ a partir da saída do gerador.
+
+    Só com IBAG_MAKE_RECORDING=1: a gravação fica guardada para que uma
+    mudança no formato do quadro não passe despercebida.
+    """
+    frames = [f + b'\x00' for f in stream.split(b'\x00')[:-1]]
+    if len(frames) != 4 * ITERATIONS + 1:
+        sys.exit('gerador mandou %d stats; rode de novo' % (len(frames) - 4 * ITERATIONS))
+    out = bytearray(b'\x13\x37lixo antes do primeiro quadro\x00')
+    # frames[0] é o stats; o registro de sequência s é frames[s + 1]
+    for i, f in enumerate(frames):
+        seq = i - 1
+        if seq in (100, 101, 102):
+            continue
+        if seq == 500:
+            f = f[:5] + bytes([f[5] ^ 0x40 or 1]) + f[6:]
+        if seq == 900:
+            f = f[:10] + b'\x00'
+        out += f
+    out += frames[1][:7]   # Porta fechada no meio de um quadro
+    with open(path, 'wb') as f:
+        f.write(out)
+
+
+def main():
+    if len(sys.argv) < 3:
+        sys.stderr.write(__doc__)
+        return 2
+    generator, recording = sys.argv[1], sys.argv[2]
+    with tempfile.TemporaryDirectory() as tmp:
+        stream, cobs = frames_from_generator(generator, tmp)
+        if os.environ.get('IBAG_MAKE_RECORDING'):
+            make_recording(stream, recording)
+        test_frames(stream)
+        test_cobs(cobs)
+        test_recording(recording, tmp)
+    if failures:
+        print('%d falha(s)' % failures)
+        return 1
+    print('telemetry_decode: ok')
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
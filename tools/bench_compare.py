@@ -0,0 +1,68 @@
+#!/usr/bin/env python3
+"""Compara duas execuções do ibag_bench (host ou alvo).
+
+Uso:
+  ibag_bench > antes.txt            (host; no alvo, salve o log do USB serial)
+  ... mudança ...
+  ibag_bench > depois.txt
+  tools/bench_compare.py antes.txt depois.txt
+
+Lê as linhas "bench,plataforma,grupo,caso,iters,ns_mediana,ns_min,ciclos,disp%"
+de cada arquivo (o resto do log é ignorado) e imprime, por caso, ns/op e
+ciclos/op dos dois lados e a razão depois/antes. Diferenças menores que a
+dispersão medida (intervalo interquartil) são marcadas com "~": ruído, não
+ganho. Também serve para comparar host com alvo (razão = quantas vezes o
+M33 é mais lento).
+"""
+
+import sys
+
+
+def load(path):
+    rows = {}
+    platform = None
+    with open(path, errors='replace') as f:
+        for line in f:
+            parts = line.strip().split(',')
+            if len(parts) != 9 or parts[0] != 'bench':
+                continue
+            platform = parts[1]
+            key = parts[2] + '/' + parts[3]
+            rows[key] = {
+                'ns': float(parts[5]),
+                'cycles': float(parts[7]),
+                'spread': float(parts[8]),
+            }
+    return platform, rows
+
+
+def main():
+    if len(sys.argv) != 3:
+        sys.stderr.write(__doc__)
+        return 2
+    pa, a = load(sys.argv[1])
+    pb, b = load(sys.argv[2])
+    if not a or not b:
+        sys.stderr.write('nenhuma linha "bench," em %s\n' % (sys.argv[1] if not a else sys.argv[2]))
+        return 1
+
+    print('antes: %s (%s)   depois: %s (%s)' % (sys.argv[1], pa, sys.argv[2], pb))
+    print('%-34s %10s %10s %8s   %10s %10s' % ('caso', 'ns antes', 'ns depois', 'razão', 'cic antes', 'cic depois'))
+    for key in list(a) + [k for k in b if k not in a]:
+        ra, rb = a.get(key), b.get(key)
+        if ra is None or rb is None:
+            only = 'só depois' if ra is None else 'só antes'
+            r = rb or ra
+            print('%-34s %10s %10s %8s' % (key, '-' if ra is None else '%.1f' % r['ns'],
+                                         '-' if rb is None else '%.1f' % r['ns'], only))
+            continue
+        ratio = rb['ns'] / ra['ns'] if ra['ns'] > 0 else float('inf')
+        noise = max(ra['spread'], rb['spread']) / 100.0
+        mark = '~' if pa == pb and abs(ratio - 1.0) <= noise else ' '
+        print('%-34s %10.1f %10.1f %7.2fx%s  %10.1f %10.1f' % (
+            key, ra['ns'], rb['ns'], ratio, mark, ra['cycles'], rb['cycles']))
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
@@ -0,0 +1,270 @@
+#!/usr/bin/env python3
+"""Relatório de memória por módulo a partir do mapa do linker (GNU ld).
+
+Uso: mem_report.py iBagPico2W.elf.map [--all]
+     mem_report.py --stack <diretório dos objetos> [função ...]
+
+Cada seção de entrada é somada ao módulo de origem (arquivo .c do projeto,
+ou biblioteca/componente do SDK) conforme a seção de saída onde caiu:
+  flash = código e constantes (.text, .rodata, ...) + imagem de carga de .data
+  data  = variáveis inicializadas (RAM, copiadas da flash no boot)
+  bss   = variáveis zeradas e não inicializadas (RAM)
+Seções na RAM com "load address" contam como data; as demais, como bss.
+
+Com --stack, lê os grafos de chamadas que o gcc grava com
+-fcallgraph-info=su (um .ci ao lado de cada objeto) e imprime o pior caso
+de pilha a partir de cada função pedida - por padrão, os callbacks do lwIP,
+que rodam na IRQ do cyw43 sobre a pilha de 2 KB do core 0. Chamadas por
+ponteiro usam os alvos de INDIRECT; funções sem .ci (newlib, SDK sem a
+opção) contam 0 e aparecem com '?' no caminho.
+"""
+
+import fnmatch
+import glob
+import os
+import re
+import sys
+from collections import defaultdict
+
+RAM_START = 0x20000000
+RAM_END = 0x20082000          # SRAM do RP2350 (incluindo scratch X/Y)
+
+OUTPUT_RE = re.compile(r'^(\.\S+|\S+)\s+0x([0-9a-fA-F]+)\s+0x([0-9a-fA-F]+)(?:\s+load address 0x([0-9a-fA-F]+))?')
+OUTPUT_NAME_RE = re.compile(r'^(\.\S+)\s*$')
+INPUT_RE = re.compile(r'^ (\S+)?\s+0x([0-9a-fA-F]+)\s+0x([0-9a-fA-F]+)\s+(\S.*)$')
+INPUT_NAME_RE = re.compile(r'^ (\S+)\s*$')
+
+# Seções que não ocupam memória no alvo
+IGNORED = ('.debug', '.comment', '.ARM.attributes', '.stab', '.note', '.gnu')
+
+
+def module_name(path):
+    """Nome curto do módulo: arquivo do projeto ou componente do SDK."""
+    path = path.strip()
+    archive = re.match(r'(.*)\((.*)\)$', path)
+    if archive:
+        lib = os.path.basename(archive.group(1))
+        return 'lib:' + re.sub(r'^lib|\.a$', '', lib)
+    base = os.path.basename(path)
+    base = re.sub(r'\.(c|cpp|S|s)\.(obj|o)$', r'.\1', base)
+    # Fontes do projeto ficam direto em CMakeFiles/<alvo>.dir/; as do SDK
+    # compiladas junto com o alvo carregam o caminho completo abaixo dele
+    if re.search(r'CMakeFiles/[^/]+\.dir/[^/]+$', path):
+        return base
+    for comp in ('lwip', 'cyw43', 'btstack', 'mbedtls', 'tinyusb'):
+        if comp in path:
+            return 'sdk:' + comp
+    comp = re.search(r'/src/\w+/([^/]+)/', path)
+    return 'sdk:' + (comp.group(1) if comp else base)
+
+
+def classify(addr, load):
+    if RAM_START <= addr < RAM_END:
+        return 'data' if load is not None and load != addr else 'bss'
+    return 'flash'
+
+
+def parse(lines):
+    totals = defaultdict(lambda: {'flash': 0, 'data': 0, 'bss': 0})
+    in_map = False
+    section = None          # (nome, classe)
+    pending_input = None    # Nome de seção de entrada quebrado na linha seguinte
+    pending_output = None
+
+    for line in lines:
+        line = line.rstrip('\n')
+        if not in_map:
+            in_map = line.startswith('Linker script and memory map')
+            continue
+
+        if pending_output is not None:
+            m = re.match(r'^\s+0x([0-9a-fA-F]+)\s+0x([0-9a-fA-F]+)(?:\s+load address 0x([0-9a-fA-F]+))?', line)
+            name = pending_output
+            pending_output = None
+            if m:
+                load = int(m.group(3), 16) if m.group(3) else None
+                section = (name, classify(int(m.group(1), 16), load))
+                continue
+
+        if line and not line[0].isspace():
+            m = OUTPUT_RE.match(line)
+            if m:
+                load = int(m.group(4), 16) if m.group(4) else None
+                section = (m.group(1), classify(int(m.group(2), 16), load))
+                continue
+            m = OUTPUT_NAME_RE.match(line)
+            if m:
+                pending_output = m.group(1)
+                continue
+            section = None
+            continue
+
+        if section is None or section[0].startswith(IGNORED):
+            continue
+
+        if pending_input is not None:
+            m = re.match(r'^\s+0x([0-9a-fA-F]+)\s+0x([0-9a-fA-F]+)\s+(\S.*)$', line)
+            pending_input = None
+            if m:
+                size = int(m.group(2), 16)
+                add(totals, section, m.group(3), size)
+                continue
+
+        m = INPUT_RE.match(line)
+        if m and m.group(1) != '*fill*':
+            add(totals, section, m.group(4), int(m.group(3), 16))
+            continue
+        m = INPUT_NAME_RE.match(line)
+        if m and m.group(1).startswith(('.', 'COMMON')):
+            pending_input = m.group(1)
+    return totals
+
+
+def add(totals, section, path, size):
+    if size == 0 or path.startswith('load address'):
+        return
+    kind = section[1]
+    mod = totals[module_name(path)]
+    mod[kind] += size
+    if kind == 'data':
+        mod['flash'] += size     # Imagem de carga
+
+
+# --- Pilha (--stack) ---
+
+STACK_CORE0 = 2048            # PICO_STACK_SIZE padrão; a IRQ usa a mesma pilha
+
+# Callbacks registrados no lwIP (tcp_*/udp_recv/sys_timeout/netif)
+LWIP_ROOTS = ('http_accept', 'http_recv', 'http_sent', 'http_poll', 'http_err',
+              'redirect_accept', 'redirect_recv', 'dns_recv', 'dhcp_recv',
+              'mdns_recv', 'mdns_announce', 'netif_status_callback')
+
+# Chamadas por ponteiro: função que chama -> alvos possíveis (fnmatch)
+INDIRECT = {
+    'http_body_fill': ('metrics_render', 'prof_render', 'history_stream'),
+    'metrics_render': ('s_*',),
+}
+
+NODE_RE = re.compile(r'node: \{ title: "([^"]+)" label: "([^"\\]+)(?:\\n[^"]*?(\d+) bytes \(([^)]*)\))?')
+EDGE_RE = re.compile(r'edge: \{ sourcename: "([^"]+)" targetname: "([^"]+)"')
+
+
+def parse_callgraph(paths):
+    frames = {}               # título -> bytes (None = sem dados)
+    names = {}                # título -> nome da função
+    calls = defaultdict(set)
+    for path in paths:
+        with open(path, encoding='utf-8', errors='replace') as f:
+            for line in f:
+                m = NODE_RE.match(line)
+                if m:
+                    title = m.group(1)
+                    names[title] = m.group(2)
+                    if m.group(3) is not None:
+                        frames[title] = int(m.group(3))
+                        if 'dynamic' in m.group(4) and 'bounded' not in m.group(4):
+                            frames[title] = None     # alloca/VLA: sem limite conhecido
+                    else:
+                        frames.setdefault(title, None)
+                    continue
+                m = EDGE_RE.match(line)
+                if m:
+                    calls[m.group(1)].add(m.group(2))
+    return frames, names, calls
+
+
+def worst_stack(root, frames, names, calls, unknown):
+    """(bytes, caminho) do pior caso a partir de root; ciclos são cortados.
+    Funções alcançadas sem dados de pilha vão para 'unknown'."""
+    memo = {}
+
+    def targets(title):
+        for t in calls.get(title, ()):
+            if t != '__indirect_call':
+                yield t
+                continue
+            for pattern in INDIRECT.get(names.get(title, ''), ()):
+                for cand, name in names.items():
+                    if fnmatch.fnmatch(name, pattern) and frames.get(cand) is not None:
+                        yield cand
+
+    def visit(title, active):
+        if title in memo:
+            return memo[title]
+        if title in active:
+            return 0, [names.get(title, title) + '(ciclo)']
+        active.add(title)
+        best = (0, [])
+        for t in targets(title):
+            best = max(best, visit(t, active), key=lambda r: r[0])
+        active.discard(title)
+        frame = frames.get(title)
+        if frame is None:
+            unknown.add(names.get(title, title))
+        label = '%s(%s)' % (names.get(title, title), '?' if frame is None else frame)
+        memo[title] = ((frame or 0) + best[0], [label] + best[1])
+        return memo[title]
+
+    return visit(root, set())
+
+
+def stack_report(objdir, roots):
+    paths = glob.glob(os.path.join(objdir, '**', '*.ci'), recursive=True)
+    if not paths:
+        print('nenhum .ci em %s (compilar com -fcallgraph-info=su)' % objdir, file=sys.stderr)
+        return 1
+    frames, names, calls = parse_callgraph(paths)
+    print('%-24s %7s  pior caminho (pilha do core 0: %d bytes)' % ('função', 'bytes', STACK_CORE0))
+    worst = 0
+    unknown = set()
+    for root in roots:
+        titles = [t for t, n in names.items() if n == root and frames.get(t) is not None]
+        if not titles:
+            print('%-24s %7s' % (root, '-'))
+            continue
+        total, path = max((worst_stack(t, frames, names, calls, unknown) for t in titles),
+                          key=lambda r: r[0])
+        worst = max(worst, total)
+        print('%-24s %7d  %s' % (root, total, ' > '.join(path)))
+    print('%-24s %7d  (%d%% da pilha)' % ('PIOR CASO', worst, 100 * worst // STACK_CORE0))
+    if unknown:
+        print('sem dados (contam 0): %s' % ', '.join(sorted(unknown)))
+    return 0 if worst <= STACK_CORE0 else 1
+
+
+def main():
+    if '--stack' in sys.argv:
+        args = [a for a in sys.argv[1:] if a != '--stack']
+        if not args:
+            print(__doc__.strip().splitlines()[3], file=sys.stderr)
+            return 2
+        return stack_report(args[0], args[1:] or LWIP_ROOTS)
+
+    args = [a for a in sys.argv[1:] if not a.startswith('--')]
+    show_all = '--all' in sys.argv
+    if len(args) != 1:
+        print(__doc__.strip().splitlines()[2], file=sys.stderr)
+        return 2
+    with open(args[0], encoding='utf-8', errors='replace') as f:
+        totals = parse(f)
+
+    rows = sorted(totals.items(), key=lambda kv: -(kv[1]['data'] + kv[1]['bss']))
+    sdk = {'flash': 0, 'data': 0, 'bss': 0}
+    print('%-28s %9s %9s %9s %9s' % ('módulo', 'flash', 'data', 'bss', 'RAM'))
+    for name, t in rows:
+        if name.startswith(('sdk:', 'lib:')) and not show_all:
+            for k in sdk:
+                sdk[k] += t[k]
+            continue
+        print('%-28s %9d %9d %9d %9d' % (name, t['flash'], t['data'], t['bss'], t['data'] + t['bss']))
+    if not show_all:
+        print('%-28s %9d %9d %9d %9d' % ('(SDK e bibliotecas)', sdk['flash'], sdk['data'], sdk['bss'],
+                                         sdk['data'] + sdk['bss']))
+    total = {k: sum(t[k] for t in totals.values()) for k in ('flash', 'data', 'bss')}
+    print('%-28s %9d %9d %9d %9d' % ('TOTAL', total['flash'], total['data'], total['bss'],
+                                     total['data'] + total['bss']))
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
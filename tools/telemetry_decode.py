@@ -0,0 +1,315 @@
+#!/usr/bin/env python3
+"""Decodificador da telemetria binária do USB (CDC 1, ver telemetry.h).
+
+Uso:
+  telemetry_decode.py /dev/ttyACM1 --out dados/        # CSV por tipo de registro
+  telemetry_decode.py /dev/ttyACM1 --record sessao.bin # NDJSON no stdout + gravação crua
+  telemetry_decode.py sessao.bin --out dados/ --parquet
+  telemetry_decode.py --selftest
+
+Cada quadro é COBS(registro de 20 bytes || CRC-32 little-endian) seguido de
+0x00. Quadros com tamanho ou CRC errado são descartados e contados; buracos
+na sequência dos registros indicam descartes no firmware (fila cheia) ou
+bytes perdidos no caminho. O tempo (time_us, 32 bits no fio) é desdobrado
+para 64 bits.
+
+Com --out sai um CSV por tipo (imu.csv, adc.csv, relay.csv, timing.csv,
+stats.csv), colunas fixas e tipadas - carregam direto em pandas/Arrow; com
+--parquet (precisa de pyarrow) cada CSV também vira .parquet. A gravação
+crua (--record) pode ser decodificada de novo depois, sem o hardware.
+"""
+
+import argparse
+import csv
+import json
+import os
+import struct
+import sys
+import tempfile
+import zlib
+
+RECORD = struct.Struct('<BBHI6h')    # type, arg, seq, time_us, v[6]
+FRAME_PAYLOAD = RECORD.size + 4      # + CRC-32
+
+TYPES = {1: 'imu', 2: 'adc', 3: 'relay', 4: 'timing', 5: 'stats'}
+COLUMNS = {
+    'imu': ['time_us', 'seq', 'ax', 'ay', 'az', 'gx', 'gy', 'gz'],
+    'adc': ['time_us', 'seq', 'channel', 'raw'],
+    'relay': ['time_us', 'seq', 'zone', 'on'],
+    'timing': ['time_us', 'seq', 'task', 'exec_us', 'jitter_us'],
+    'stats': ['time_us', 'sent', 'dropped', 'ring_peak'],
+}
+
+
+def cobs_decode(data):
+    out = bytearray()
+    i = 0
+    while i < len(data):
+        code = data[i]
+        if code == 0 or i + code > len(data):
+            return None
+        out += data[i + 1:i + code]
+        i += code
+        if code < 0xFF and i < len(data):
+            out.append(0)
+    return bytes(out)
+
+
+def cobs_encode(data):
+    """Mesmo algoritmo de telemetry_cobs_encode() (usado no --selftest)."""
+    out = bytearray([0])
+    code_pos = 0
+    code = 1
+    for b in data:
+        if b:
+            out.append(b)
+            code += 1
+        if b == 0 or code == 0xFF:
+            out[code_pos] = code
+            code_pos = len(out)
+            out.append(0)
+            code = 1
+    out[code_pos] = code
+    return bytes(out)
+
+
+def u32(lo, hi):
+    return (lo & 0xFFFF) | ((hi & 0xFFFF) << 16)
+
+
+class Decoder:
+    def __init__(self):
+        self.buf = bytearray()
+        self.frames = 0
+        self.bad_frames = 0
+        self.lost = 0
+        self.last_seq = None
+        self.time_high = 0
+        self.last_time = None
+
+    def feed(self, data):
+        """Devolve (tipo, linha) de cada registro válido em data."""
+        self.buf += data
+        rows = []
+        while True:
+            end = self.buf.find(b'\x00')
+            if end < 0:
+                break
+            chunk = bytes(self.buf[:end])
+            del self.buf[:end + 1]
+            if not chunk:
+                continue
+            row = self.frame(chunk)
+            if row is not None:
+                rows.append(row)
+        return rows
+
+    def frame(self, chunk):
+        payload = cobs_decode(chunk)
+        if payload is None or len(payload) != FRAME_PAYLOAD:
+            self.bad_frames += 1
+            return None
+        body, crc = payload[:RECORD.size], struct.unpack('<I', payload[RECORD.size:])[0]
+        if zlib.crc32(body) != crc:
+            self.bad_frames += 1
+            return None
+        self.frames += 1
+        rtype, arg, seq, time_us, *v = RECORD.unpack(body)
+        name = TYPES.get(rtype)
+        if name is None:
+            self.bad_frames += 1
+            return None
+
+        if self.last_time is not None and time_us < self.last_time and self.last_time - time_us > 1 << 31:
+            self.time_high += 1 << 32
+        self.last_time = time_us
+        t = self.time_high + time_us
+
+        if name == 'stats':
+            return name, [t, u32(v[0], v[1]), u32(v[2], v[3]), v[4] & 0xFFFF]
+        if self.last_seq is not None:
+            self.lost += (seq - self.last_seq - 1) & 0xFFFF
+        self.last_seq = seq
+        if name == 'imu':
+            return name, [t, seq] + v
+        if name == 'adc':
+            return name, [t, seq, arg, v[0] & 0xFFFF]
+        if name == 'relay':
+            return name, [t, seq, arg, v[0]]
+        return name, [t, seq, arg, u32(v[0], v[1]), u32(v[2], v[3])]
+
+
+def open_source(path):
+    if path == '-':
+        return sys.stdin.buffer
+    f = open(path, 'rb', buffering=0)
+    if os.isatty(f.fileno()):
+        import termios
+        import tty
+        tty.setraw(f.fileno())
+        attrs = termios.tcgetattr(f.fileno())
+        attrs[6][termios.VMIN] = 1
+        attrs[6][termios.VTIME] = 0
+        termios.tcsetattr(f.fileno(), termios.TCSANOW, attrs)
+    return f
+
+
+class CsvSink:
+    def __init__(self, out_dir):
+        os.makedirs(out_dir, exist_ok=True)
+        self.out_dir = out_dir
+        self.files = {}
+        self.writers = {}
+        for name, cols in COLUMNS.items():
+            f = open(os.path.join(out_dir, name + '.csv'), 'w', newline='')
+            w = csv.writer(f)
+            w.writerow(cols)
+            self.files[name] = f
+            self.writers[name] = w
+
+    def write(self, name, row):
+        self.writers[name].writerow(row)
+
+    def close(self):
+        for f in self.files.values():
+            f.close()
+
+
+class JsonSink:
+    def write(self, name, row):
+        cols = COLUMNS[name]
+        obj = {'type': name}
+        obj.update(zip(cols, row))
+        sys.stdout.write(json.dumps(obj) + '\n')
+
+    def close(self):
+        sys.stdout.flush()
+
+
+def to_parquet(out_dir):
+    try:
+        import pyarrow.csv as pacsv
+        import pyarrow.parquet as pq
+    except ImportError:
+        sys.stderr.write('pyarrow não instalado: ficam só os CSV\n')
+        return
+    for name in COLUMNS:
+        path = os.path.join(out_dir, name + '.csv')
+        pq.write_table(pacsv.read_csv(path), os.path.join(out_dir, name + '.parquet'))
+
+
+def decode(source, sink, record=None):
+    dec = Decoder()
+    counts = dict.fromkeys(COLUMNS, 0)
+    try:
+        while True:
+            data = source.read(4096)
+            if not data:
+                break
+            if record is not None:
+                record.write(data)
+            for name, row in dec.feed(data):
+                sink.write(name, row)
+                counts[name] += 1
+    except KeyboardInterrupt:
+        pass
+    finally:
+        sink.close()
+    return dec, counts
+
+
+def report(dec, counts):
+    sys.stderr.write('quadros %d, inválidos %d, registros perdidos %d, %s\n' % (
+        dec.frames, dec.bad_frames, dec.lost,
+        ', '.join('%s %d' % kv for kv in counts.items())))
+
+
+def selftest():
+    """Grava um fluxo sintético com erros conhecidos e decodifica do arquivo."""
+    records = []
+    seq = 0
+    t = 0xFFFF0000                   # Passa pela volta dos 32 bits
+    for i in range(2000):
+        t = (t + 997) & 0xFFFFFFFF
+        kind = 1 + i % 4
+        if kind == 1:
+            v = [i % 3 - 1, 0, 16384, -i, 0, 255]   # Zeros e 0xFF nos bytes
+        elif kind == 2:
+            v = [i % 4096, 0, 0, 0, 0, 0]
+        elif kind == 3:
+            v = [i % 2, 0, 0, 0, 0, 0]
+        else:
+            v = [i * 13 & 0xFFFF, 0, 50, 0, 0, 0]
+            v = [x - 0x10000 if x > 0x7FFF else x for x in v]
+        records.append(RECORD.pack(kind, i % 3, seq & 0xFFFF, t, *v))
+        seq += 1
+
+    frames = [cobs_encode(r + struct.pack('<I', zlib.crc32(r))) + b'\x00' for r in records]
+    dropped = {100, 101, 102, 777}                 # Fila cheia no firmware: buraco na sequência
+    corrupt = 500                                  # Byte trocado: CRC falha
+    truncated = 900                                # Quadro cortado pelo meio
+    stream = bytearray(b'\x13\x37lixo antes do primeiro quadro\x00')
+    for i, f in enumerate(frames):
+        if i in dropped:
+            continue
+        if i == corrupt:
+            f = f[:5] + bytes([f[5] ^ 0x40 or 1]) + f[6:]
+        if i == truncated:
+            f = f[:10] + b'\x00'
+        stream += f
+
+    with tempfile.TemporaryDirectory() as tmp:
+        path = os.path.join(tmp, 'gravacao.bin')
+        with open(path, 'wb') as f:
+            f.write(stream)
+        with open(path, 'rb') as src:
+            dec, counts = decode(src, CsvSink(os.path.join(tmp, 'out')))
+        with open(os.path.join(tmp, 'out', 'imu.csv')) as f:
+            imu = list(csv.reader(f))
+
+    valid = len(records) - len(dropped) - 2
+    checks = [
+        ('registros válidos', sum(counts.values()), valid),
+        ('quadros inválidos', dec.bad_frames, 3),   # Lixo inicial + CRC + cortado
+        ('registros perdidos', dec.lost, len(dropped) + 2),
+        ('linhas do imu.csv', len(imu) - 1, counts['imu']),
+        ('tempo desdobrado', int(imu[-1][0]) > 1 << 32, True),
+    ]
+    ok = True
+    for name, got, want in checks:
+        status = 'ok' if got == want else 'FALHOU'
+        ok &= got == want
+        print('%-20s %-8s (obtido %s, esperado %s)' % (name, status, got, want))
+    return 0 if ok else 1
+
+
+def main():
+    ap = argparse.ArgumentParser(description='Decodifica a telemetria USB do iBag.')
+    ap.add_argument('source', nargs='?', help='porta (/dev/ttyACM1), arquivo gravado ou - (stdin)')
+    ap.add_argument('--out', help='diretório para os CSV por tipo (padrão: NDJSON no stdout)')
+    ap.add_argument('--parquet', action='store_true', help='converter os CSV para Parquet (pyarrow)')
+    ap.add_argument('--record', help='gravar os bytes crus recebidos neste arquivo')
+    ap.add_argument('--selftest', action='store_true', help='decodificar um fluxo gravado sintético')
+    args = ap.parse_args()
+
+    if args.selftest:
+        return selftest()
+    if not args.source:
+        ap.error('informe a porta ou o arquivo')
+
+    sink = CsvSink(args.out) if args.out else JsonSink()
+    record = open(args.record, 'wb') if args.record else None
+    source = open_source(args.source)
+    try:
+        dec, counts = decode(source, sink, record)
+    finally:
+        if record is not None:
+            record.close()
+    report(dec, counts)
+    if args.out and args.parquet:
+        to_parquet(args.out)
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
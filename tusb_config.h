@@ -0,0 +1,25 @@
+#ifndef TUSB_CONFIG_H
+#define TUSB_CONFIG_H
+
+// TinyUSB: dispositivo composto com duas CDC (usb_descriptors.c)
+//   CDC 0: console (stdio_usb do SDK)
+//   CDC 1: telemetria binária (telemetry.h)
+
+#ifndef CFG_TUSB_RHPORT0_MODE
+#define CFG_TUSB_RHPORT0_MODE OPT_MODE_DEVICE
+#endif
+
+#define CFG_TUD_ENABLED 1
+#define CFG_TUD_ENDPOINT0_SIZE 64
+
+#define CFG_TUD_CDC 2
+#define CFG_TUD_MSC 0
+#define CFG_TUD_HID 0
+#define CFG_TUD_MIDI 0
+#define CFG_TUD_VENDOR 0
+
+#define CFG_TUD_CDC_RX_BUFSIZE 256
+#define CFG_TUD_CDC_TX_BUFSIZE 1024    // ~40 quadros de telemetria entre duas chamadas de telemetry_poll()
+#define CFG_TUD_CDC_EP_BUFSIZE 64
+
+#endif // TUSB_CONFIG_H
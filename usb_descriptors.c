@@ -0,0 +1,99 @@
+#include "tusb.h"
+#include "pico/unique_id.h"
+
+// Descritores do dispositivo USB: duas CDC (console e telemetria)
+// Com o tinyusb_device linkado, o stdio_usb do SDK não usa os descritores
+// dele e continua escrevendo na CDC 0.
+
+#define USBD_VID 0x2E8A                // Raspberry Pi (o mesmo do stdio_usb)
+#define USBD_PID 0x0009
+#define USBD_CDC_CMD_SIZE 8
+#define USBD_CDC_DATA_SIZE 64
+
+enum {
+    ITF_CONSOLE = 0,
+    ITF_CONSOLE_DATA,
+    ITF_TELEMETRY,
+    ITF_TELEMETRY_DATA,
+    ITF_COUNT
+};
+
+enum {
+    STR_LANGID = 0,
+    STR_MANUFACTURER,
+    STR_PRODUCT,
+    STR_SERIAL,
+    STR_CONSOLE,
+    STR_TELEMETRY,
+};
+
+#define CONFIG_TOTAL_LEN (TUD_CONFIG_DESC_LEN + 2 * TUD_CDC_DESC_LEN)
+
+static const tusb_desc_device_t device_descriptor = {
+    .bLength = sizeof(tusb_desc_device_t),
+    .bDescriptorType = TUSB_DESC_DEVICE,
+    .bcdUSB = 0x0200,
+    // Composto com IAD, uma por CDC
+    .bDeviceClass = TUSB_CLASS_MISC,
+    .bDeviceSubClass = MISC_SUBCLASS_COMMON,
+    .bDeviceProtocol = MISC_PROTOCOL_IAD,
+    .bMaxPacketSize0 = CFG_TUD_ENDPOINT0_SIZE,
+    .idVendor = USBD_VID,
+    .idProduct = USBD_PID,
+    .bcdDevice = 0x0100,
+    .iManufacturer = STR_MANUFACTURER,
+    .iProduct = STR_PRODUCT,
+    .iSerialNumber = STR_SERIAL,
+    .bNumConfigurations = 1,
+};
+
+static const uint8_t config_descriptor[] = {
+    TUD_CONFIG_DESCRIPTOR(1, ITF_COUNT, 0, CONFIG_TOTAL_LEN, 0, 250),
+    TUD_CDC_DESCRIPTOR(ITF_CONSOLE, STR_CONSOLE, 0x81, USBD_CDC_CMD_SIZE, 0x02, 0x82, USBD_CDC_DATA_SIZE),
+    TUD_CDC_DESCRIPTOR(ITF_TELEMETRY, STR_TELEMETRY, 0x83, USBD_CDC_CMD_SIZE, 0x04, 0x84, USBD_CDC_DATA_SIZE),
+};
+
+static const char *const strings[] = {
+    [STR_MANUFACTURER] = "iBag",
+    [STR_PRODUCT] = "iBag Pico 2 W",
+    [STR_SERIAL] = NULL,               // ID único da flash
+    [STR_CONSOLE] = "iBag Console",
+    [STR_TELEMETRY] = "iBag Telemetria",
+};
+
+const uint8_t *tud_descriptor_device_cb(void) {
+    return (const uint8_t *)&device_descriptor;
+}
+
+const uint8_t *tud_descriptor_configuration_cb(uint8_t index) {
+    (void)index;
+    return config_descriptor;
+}
+
+const uint16_t *tud_descriptor_string_cb(uint8_t index, uint16_t langid) {
+    (void)langid;
+    static uint16_t desc[33];
+    static char serial[2 * PICO_UNIQUE_BOARD_ID_SIZE_BYTES + 1];
+    uint8_t len;
+
+    if (index == STR_LANGID) {
+        desc[1] = 0x0409;              // Inglês (EUA)
+        len = 1;
+    } else {
+        if (index >= sizeof(strings) / sizeof(strings[0])) {
+            return NULL;
+        }
+        const char *str = strings[index];
+        if (index == STR_SERIAL) {
+            pico_get_unique_board_id_string(serial, sizeof(serial));
+            str = serial;
+        }
+        len = 0;
+        while (str[len] && len < 32) {
+            desc[1 + len] = (uint8_t)str[len];
+            len++;
+        }
+    }
+    desc[0] = (uint16_t)((TUSB_DESC_STRING << 8) | (2 * len + 2));
+    return desc;
+}
@@ -149,6 +149,9 @@ const char html_content[] =
 "            max-width: 400px;\n"
 "        }\n"
 "        .popup-icon { font-size: 4rem; margin-bottom: 16px; }\n"
+"        .autotune-row { display: flex; gap: 12px; margin-bottom: 12px; }\n"
+"        .autotune-row select { flex: 1; padding: 8px; border-radius: 8px; border: 2px solid var(--border-color); }\n"
+"        .autotune-progress { margin-top: 12px; font-family: monospace; color: var(--text-secondary); }\n"
 "    </style>\n"
 "</head>\n"
 "<body>\n"
@@ -203,6 +206,17 @@ const char html_content[] =
 "                </div>\n"
 "            </div>\n"
 "        </section>\n"
+"        <section>\n"
+"            <h2>Autotune do Controlador</h2>\n"
+"            <div class=\"autotune-row\">\n"
+"                <select id=\"autotuneZone\">\n"
+"                    <option value=\"heater\">🔥 Aquecedor</option>\n"
+"                    <option value=\"freezer\">🌡️ Conservador</option>\n"
+"                </select>\n"
+"            </div>\n"
+"            <button class=\"btn btn-info\" onclick=\"startAutotune()\">🎛️ Iniciar Autotune</button>\n"
+"            <div id=\"autotuneProgress\" class=\"autotune-progress\"></div>\n"
+"        </section>\n"
 "    </div>\n"
 "    <div id=\"popup\" class=\"popup hidden\">\n"
 "        <div class=\"popup-content\">\n"
@@ -295,6 +309,8 @@ const char html_content[] =
 "                clearTimeout(timeoutId);\n"
 "                const data = await resp.json();\n"
 "                if(data.status === 'ok') {\n"
+"                    // Resposta imediata: a calibração segue no dispositivo\n"
+"                    await new Promise(resolve => setTimeout(resolve, data.calibration_ms || 10000));\n"
 "                    isCalibrating = false;\n"
 "                    showPopup('✅', 'Resetado!', 'Estado balançado foi resetado e sensor recalibrado!');\n"
 "                    setTimeout(() => checkStatus(), 500);\n"
@@ -307,6 +323,41 @@ const char html_content[] =
 "                setTimeout(() => checkStatus(), 500);\n"
 "            }\n"
 "        }\n"
+"        let autotuneTimer = null;\n"
+"        async function startAutotune() {\n"
+"            const zone = document.getElementById('autotuneZone').value;\n"
+"            const input = zone === 'heater' ? 'heaterTemp' : 'freezerTemp';\n"
+"            const setpoint = parseFloat(document.getElementById(input).value);\n"
+"            try {\n"
+"                const resp = await fetch('/api/autotune?zone=' + zone + '&setpoint=' + setpoint, {method: 'POST'});\n"
+"                const data = await resp.json();\n"
+"                if(data.status === 'ok') {\n"
+"                    showPopup('🎛️', 'Autotune iniciado', 'O relé vai oscilar em torno de ' + setpoint + ' °C. Isso pode levar algumas horas.');\n"
+"                    if(!autotuneTimer) autotuneTimer = setInterval(pollAutotune, 2000);\n"
+"                } else {\n"
+"                    showPopup('❌', 'Erro', data.status === 'busy' ? 'Autotune já em andamento' : 'Defina um setpoint válido');\n"
+"                }\n"
+"            } catch(e) {\n"
+"                showPopup('❌', 'Erro', 'Falha na comunicação: ' + e.message);\n"
+"            }\n"
+"        }\n"
+"        async function pollAutotune() {\n"
+"            try {\n"
+"                const resp = await fetch('/api/autotune');\n"
+"                const d = await resp.json();\n"
+"                const el = document.getElementById('autotuneProgress');\n"
+"                el.textContent = d.zone + ': ' + d.state + ' | ciclos ' + d.cycles + '/' + d.cycles_target +\n"
+"                    ' | a=' + d.amplitude.toFixed(2) + '°C Tu=' + d.period.toFixed(0) + 's | ' + Math.round(d.elapsed / 1000) + 's';\n"
+"                if(d.state === 'done' || d.state === 'failed') {\n"
+"                    clearInterval(autotuneTimer);\n"
+"                    autotuneTimer = null;\n"
+"                    if(d.state === 'done') el.textContent += ' | Kp=' + d.kp.toFixed(2) + ' banda=±' + d.hysteresis.toFixed(2) + '°C';\n"
+"                    else el.textContent += ' | ' + d.message;\n"
+"                }\n"
+"            } catch(e) {\n"
+"                console.log('Erro ao consultar autotune:', e);\n"
+"            }\n"
+"        }\n"
 "        // Auto-atualizar status a cada 5 segundos se o display estiver visível\n"
 "        setInterval(() => {\n"
 "            if(!isCalibrating && !document.getElementById('statusDisplay').classList.contains('hidden')) {\n"